@@ -56,6 +56,7 @@
 #include <seqan/bam_io/bam_io_context.h>
 #include <seqan/bam_io/cigar.h>
 #include <seqan/bam_io/bam_alignment_record.h>
+#include <seqan/bam_io/bam_sequence_codec.h>
 #include <seqan/bam_io/bam_header_record.h>
 #include <seqan/bam_io/bam_sam_conversion.h>
 #include <seqan/bam_io/bam_tags_dict.h>
@@ -81,19 +82,17 @@
 
 #include <seqan/bam_io/bam_alignment_record_util.h> 
 
-// Not included by default, requires C++11
-// #include <seqan/bam_io/bam_scanner_cache.h>
-
 // ===========================================================================
 // BAM Index Related.
 // ===========================================================================
 
 #include <seqan/hts_io.h>
+#include <seqan/bam_io/bam_scanner_cache.h>
 
 // BAM indices are only available when ZLIB is available.
-// #if SEQAN_HAS_ZLIB
-// #include <seqan/bam_io/bam_index_bai.h>
-// #endif  // #if SEQAN_HAS_ZLIB*/
+#if SEQAN_HAS_ZLIB
+#include <seqan/bam_io/bam_index_bai.h>
+#endif  // #if SEQAN_HAS_ZLIB
 
 
 
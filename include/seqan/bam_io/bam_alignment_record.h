@@ -297,6 +297,33 @@ clear(BamAlignmentRecord & record)
     clear(record.tags);
 }
 
+// ----------------------------------------------------------------------------
+// Function swap()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn BamAlignmentRecord#swap
+ * @brief Swap two BamAlignmentRecords without copying their strings.
+ *
+ * @signature void swap(lhs, rhs);
+ *
+ * @param[in,out] lhs The first BamAlignmentRecord.
+ * @param[in,out] rhs The second BamAlignmentRecord.
+ */
+
+inline void
+swap(BamAlignmentRecord & lhs, BamAlignmentRecord & rhs)
+{
+    std::swap(static_cast<BamAlignmentRecordCore &>(lhs), static_cast<BamAlignmentRecordCore &>(rhs));
+    std::swap(lhs._qID, rhs._qID);
+    swap(lhs.cigar, rhs.cigar);
+    swap(lhs.qName, rhs.qName);
+    swap(lhs.seq, rhs.seq);
+    swap(lhs.qual, rhs.qual);
+    swap(lhs.tags, rhs.tags);
+    swap(lhs._buffer, rhs._buffer);
+}
+
 // ----------------------------------------------------------------------------
 // Function hasFlagMultiple()
 // ----------------------------------------------------------------------------
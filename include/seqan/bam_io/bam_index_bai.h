@@ -61,6 +61,11 @@
 #ifndef INCLUDE_SEQAN_BAM_IO_BAM_INDEX_BAI_H_
 #define INCLUDE_SEQAN_BAM_IO_BAM_INDEX_BAI_H_
 
+#include <map>
+#include <set>
+
+#include <seqan/hts_io/hts_file.h>
+
 namespace seqan {
 
 // ============================================================================
@@ -104,6 +109,10 @@ typedef Tag<Bai_> Bai;
 struct BaiBamIndexBinData_
 {
     String<Pair<__uint64, __uint64> > chunkBegEnds;
+    __uint64 loffset;   // CSI only: smallest virtual offset of an alignment overlapping the bin
+
+    BaiBamIndexBinData_() : loffset(0)
+    {}
 };
 
 // ----------------------------------------------------------------------------
@@ -116,6 +125,9 @@ struct BaiBamIndexBinData_
  * @extends BamIndex
  * @brief Access to BAI (samtools-style).
  *
+ * CSI indices, which have a configurable minimal bin size and number of levels for references longer than 2^29 bp,
+ * are loaded and saved by the same class.
+ *
  * @signature template <>
  *            class BamIndex<Bai>;
  */
@@ -139,6 +151,9 @@ public:
     typedef String<__uint64> TLinearIndex_;
 
     __uint64 _unalignedCount;
+    __int32 _minShift;      // log2 of the size of the minimum bin (14 for BAI)
+    __int32 _depth;         // Number of levels of the binning index (5 for BAI)
+    bool _csi;              // True for the CSI format, which has no linear index but a min offset per bin
 
     // 1<<14 is the size of the minimum bin.
     static const __int32 BAM_LIDX_SHIFT = 14;
@@ -146,7 +161,7 @@ public:
     String<TBinIndex_> _binIndices;
     String<TLinearIndex_> _linearIndices;
 
-    BamIndex() : _unalignedCount(maxValue<__uint64>())
+    BamIndex() : _unalignedCount(maxValue<__uint64>()), _minShift(BAM_LIDX_SHIFT), _depth(5), _csi(false)
     {}
 };
 
@@ -182,47 +197,42 @@ public:
  * This function fails if <tt>refID</tt>/<tt>pos</tt> are invalid.
  */
 
+// Bins of all levels overlapping [beg, end), for a binning index with 2^minShift bp leaves and depth levels below
+// the root. minShift = 14 and depth = 5 is the fixed BAI layout.
 static inline void
-_baiReg2bins(String<__uint16> & list, __uint32 beg, __uint32 end)
+_baiReg2bins(String<__uint32> & list, __uint64 beg, __uint64 end, __int32 minShift, __int32 depth)
 {
-    unsigned k;
     if (beg >= end) return;
-    if (end >= 1u<<29) end = 1u<<29;
+    __int32 s = minShift + depth * 3;
+    if (end >= 1ull<<s) end = 1ull<<s;
     --end;
-    appendValue(list, 0);
-    for (k =    1 + (beg>>26); k <=    1 + (end>>26); ++k) appendValue(list, k);
-    for (k =    9 + (beg>>23); k <=    9 + (end>>23); ++k) appendValue(list, k);
-    for (k =   73 + (beg>>20); k <=   73 + (end>>20); ++k) appendValue(list, k);
-    for (k =  585 + (beg>>17); k <=  585 + (end>>17); ++k) appendValue(list, k);
-    for (k = 4681 + (beg>>14); k <= 4681 + (end>>14); ++k) appendValue(list, k);
+    __uint64 t = 0;
+    for (__int32 l = 0; l <= depth; ++l, s -= 3, t += 1ull<<(l * 3 - 3))
+        for (__uint64 k = t + (beg>>s); k <= t + (end>>s); ++k)
+            appendValue(list, static_cast<__uint32>(k));
 }
 
-template <typename TSpec>
-inline bool
-jumpToRegion(FormattedFile<Bam, Input, TSpec> & bamFile,
-             bool & hasAlignments,
-             __int32 refId,
-             __int32 pos,
-             __int32 posEnd,
-             BamIndex<Bai> const & index)
+// Smallest virtual offset of an alignment overlapping position pos on reference refId.
+inline __uint64
+_baiMinOffset(BamIndex<Bai> const & index, __int32 refId, __int32 pos)
 {
-    if (!isEqual(format(bamFile), Bam()))
-        return false;
+    typedef BamIndex<Bai>::TBinIndex_::const_iterator TMapIter;
 
-    hasAlignments = false;
-    if (refId < 0)
-        return false;  // Cannot seek to invalid reference.
-    if (static_cast<unsigned>(refId) >= length(index._binIndices))
-        return false;  // Cannot seek to invalid reference.
-
-    // ------------------------------------------------------------------------
-    // Compute offset in BGZF file.
-    // ------------------------------------------------------------------------
-    __uint64 offset = MaxValue<__uint64>::VALUE;
-
-    // Retrieve the candidate bin identifiers for [pos, posEnd).
-    String<__uint16> candidateBins;
-    _baiReg2bins(candidateBins, pos, posEnd);
+    if (index._csi)
+    {
+        // Walk from the leaf bin of pos to the root, the first existing bin knows the min offset.
+        __uint32 bin = static_cast<__uint32>(((1ull<<(index._depth * 3)) - 1) / 7 +
+                                             (static_cast<__uint64>(pos)>>index._minShift));
+        while (true)
+        {
+            TMapIter mIt = index._binIndices[refId].find(bin);
+            if (mIt != index._binIndices[refId].end())
+                return mIt->second.loffset;
+            if (bin == 0)
+                return 0;
+            bin = (bin - 1) >> 3;
+        }
+    }
 
     // Retrieve the smallest required offset from the linear index.
     unsigned windowIdx = pos >> 14;  // Linear index consists of 16kb windows.
@@ -266,23 +276,69 @@ jumpToRegion(FormattedFile<Bam, Input, TSpec> & bamFile,
     {
         linearMinOffset = index._linearIndices[refId][windowIdx];
     }
+    return linearMinOffset;
+}
+
+// Virtual offsets of the chunks that may hold the first alignment overlapping [pos, posEnd) on reference refId.
+inline bool
+_baiRegionOffsets(std::set<__uint64> & offsetCandidates,
+                  __int32 refId,
+                  __int32 pos,
+                  __int32 posEnd,
+                  BamIndex<Bai> const & index)
+{
+    if (refId < 0)
+        return false;  // Cannot seek to invalid reference.
+    if (static_cast<unsigned>(refId) >= length(index._binIndices))
+        return false;  // Cannot seek to invalid reference.
+
+    // Retrieve the candidate bin identifiers for [pos, posEnd).
+    String<__uint32> candidateBins;
+    _baiReg2bins(candidateBins, pos, posEnd, index._minShift, index._depth);
+
+    // Retrieve the smallest required offset from the linear index (BAI) or the bins (CSI).
+    __uint64 linearMinOffset = _baiMinOffset(index, refId, pos);
 
     // Combine candidate bins and smallest required offset from linear index into candidate offset.
-    typedef std::set<__uint64> TOffsetCandidates;
-    TOffsetCandidates offsetCandidates;
-    typedef typename Iterator<String<__uint16>, Rooted>::Type TCandidateIter;
+    typedef Iterator<String<__uint32>, Rooted>::Type TCandidateIter;
     for (TCandidateIter it = begin(candidateBins, Rooted()); !atEnd(it); goNext(it))
     {
-        typedef typename std::map<__uint32, BaiBamIndexBinData_>::const_iterator TMapIter;
+        typedef std::map<__uint32, BaiBamIndexBinData_>::const_iterator TMapIter;
         TMapIter mIt = index._binIndices[refId].find(*it);
         if (mIt == index._binIndices[refId].end())
             continue;  // Candidate is not in index!
 
-        typedef typename Iterator<String<Pair<__uint64, __uint64> > const, Rooted>::Type TBegEndIter;
+        typedef Iterator<String<Pair<__uint64, __uint64> > const, Rooted>::Type TBegEndIter;
         for (TBegEndIter it2 = begin(mIt->second.chunkBegEnds, Rooted()); !atEnd(it2); goNext(it2))
             if (it2->i2 >= linearMinOffset)
                 offsetCandidates.insert(it2->i1);
     }
+    return true;
+}
+
+template <typename TSpec>
+inline bool
+jumpToRegion(FormattedFile<Bam, Input, TSpec> & bamFile,
+             bool & hasAlignments,
+             __int32 refId,
+             __int32 pos,
+             __int32 posEnd,
+             BamIndex<Bai> const & index)
+{
+    if (!isEqual(format(bamFile), Bam()))
+        return false;
+
+    hasAlignments = false;
+
+    // ------------------------------------------------------------------------
+    // Compute offset in BGZF file.
+    // ------------------------------------------------------------------------
+    __uint64 offset = MaxValue<__uint64>::VALUE;
+
+    typedef std::set<__uint64> TOffsetCandidates;
+    TOffsetCandidates offsetCandidates;
+    if (!_baiRegionOffsets(offsetCandidates, refId, pos, posEnd, index))
+        return false;
 
     // Search through candidate offsets, find rightmost possible.
     //
@@ -319,6 +375,67 @@ jumpToRegion(FormattedFile<Bam, Input, TSpec> & bamFile,
     return true;
 }
 
+/*!
+ * @fn HtsFile#jumpToRegion
+ * @brief Seek in a BAM HtsFile using a BamIndex.
+ *
+ * @signature bool jumpToRegion(htsFile, hasAlignments, refID, pos, posEnd, index);
+ *
+ * Like jumpToRegion of a BamFileIn, the next record read with readRecord is the first alignment in the region
+ * <tt>[pos, posEnd)</tt>, if any.  The index may be a BAI or a CSI index.
+ */
+
+inline bool
+jumpToRegion(HtsFile & file,
+             bool & hasAlignments,
+             __int32 refId,
+             __int32 pos,
+             __int32 posEnd,
+             BamIndex<Bai> const & index)
+{
+    if (file.fp == nullptr || hts_get_format(file.fp)->format != bam)
+        return false;
+
+    hasAlignments = false;
+    __uint64 offset = MaxValue<__uint64>::VALUE;
+
+    typedef std::set<__uint64> TOffsetCandidates;
+    TOffsetCandidates offsetCandidates;
+    if (!_baiRegionOffsets(offsetCandidates, refId, pos, posEnd, index))
+        return false;
+
+    // Search through candidate offsets, find rightmost possible.
+    BamAlignmentRecord record;
+    for (TOffsetCandidates::const_iterator candIt = offsetCandidates.begin(); candIt != offsetCandidates.end(); ++candIt)
+    {
+        if (bgzf_seek(file.fp->fp.bgzf, *candIt, SEEK_SET) < 0)
+            return false;  // Error while seeking.
+        if (!readRecord(record, file))
+            continue;  // Chunk at the end of the file.
+
+        if (record.rID != refId)
+            continue;  // Wrong contig.
+        if (!hasAlignments || record.beginPos <= pos)
+        {
+            // Found a valid alignment.
+            hasAlignments = true;
+            offset = *candIt;
+        }
+
+        if (record.beginPos >= posEnd)
+            break;  // Cannot find overlapping any more.
+    }
+
+    if (offset != MaxValue<__uint64>::VALUE && bgzf_seek(file.fp->fp.bgzf, offset, SEEK_SET) < 0)
+        return false;  // Error while seeking.
+
+    file.at_end = false;
+    file.read_all = true;
+
+    // Finding no overlapping alignment is not an error, hasAlignments is false.
+    return true;
+}
+
 // ----------------------------------------------------------------------------
 // Function jumpToOrphans()
 // ----------------------------------------------------------------------------
@@ -334,6 +451,40 @@ jumpToRegion(FormattedFile<Bam, Input, TSpec> & bamFile,
  * @param[in]     index          The @link BamIndex @endlink to use for jumping.
  */
 
+// Virtual offset to start the search for orphans at, MaxValue if the index has no alignments.
+inline __uint64
+_baiOrphansSearchOffset(BamIndex<Bai> const & index)
+{
+    typedef BamIndex<Bai>::TBinIndex_::const_iterator TBinIter;
+
+    // The pseudo bin of CSI holds the offset range of the reference and the counts of mapped and unmapped
+    // alignments, its chunks are no alignment chunks.
+    __uint32 const metaBin = static_cast<__uint32>(((1ull << (index._depth * 3 + 3)) - 1) / 7 + 1);
+
+    // Search linear indices for the largest entry of all references. CSI has no linear index, the largest chunk
+    // begin of the last indexed reference is used instead.
+    for (int i = length(index._linearIndices) - 1; i >= 0; --i)
+        if (!empty(index._linearIndices[i]))
+        {
+            return back(index._linearIndices[i]);
+        }
+        else if (index._csi && !index._binIndices[i].empty())
+        {
+            __uint64 aliOffset = MaxValue<__uint64>::VALUE;
+            for (TBinIter it = index._binIndices[i].begin(); it != index._binIndices[i].end(); ++it)
+            {
+                if (it->first == metaBin)
+                    continue;
+                for (unsigned k = 0; k < length(it->second.chunkBegEnds); ++k)
+                    if (aliOffset == MaxValue<__uint64>::VALUE || it->second.chunkBegEnds[k].i1 > aliOffset)
+                        aliOffset = it->second.chunkBegEnds[k].i1;
+            }
+            if (aliOffset != MaxValue<__uint64>::VALUE)
+                return aliOffset;
+        }
+    return MaxValue<__uint64>::VALUE;
+}
+
 template <typename TSpec>
 bool jumpToOrphans(FormattedFile<Bam, Input, TSpec> & bamFile,
                    bool & hasAlignments,
@@ -344,14 +495,7 @@ bool jumpToOrphans(FormattedFile<Bam, Input, TSpec> & bamFile,
 
     hasAlignments = false;
 
-    // Search linear indices for the largest entry of all references.
-    __uint64 aliOffset = MaxValue<__uint64>::VALUE;
-    for (int i = length(index._linearIndices) - 1; i >= 0; --i)
-        if (!empty(index._linearIndices[i]))
-        {
-            aliOffset = back(index._linearIndices[i]);
-            break;
-        }
+    __uint64 aliOffset = _baiOrphansSearchOffset(index);
     if (aliOffset == MaxValue<__uint64>::VALUE)
         return false;  // No offset found.
 
@@ -385,6 +529,59 @@ bool jumpToOrphans(FormattedFile<Bam, Input, TSpec> & bamFile,
     return true;
 }
 
+/*!
+ * @fn HtsFile#jumpToOrphans
+ * @brief Seek to orphans block in a BAM HtsFile using a BamIndex.
+ *
+ * @signature bool jumpToOrphans(htsFile, hasAlignments, index);
+ *
+ * The index may be a BAI or a CSI index.
+ */
+
+inline bool
+jumpToOrphans(HtsFile & file,
+              bool & hasAlignments,
+              BamIndex<Bai> const & index)
+{
+    if (file.fp == nullptr || hts_get_format(file.fp)->format != bam)
+        return false;
+
+    hasAlignments = false;
+
+    __uint64 aliOffset = _baiOrphansSearchOffset(index);
+    if (aliOffset == MaxValue<__uint64>::VALUE)
+        return false;  // No offset found.
+
+    // Get the offset of the first orphan alignment by reading from the last alignment chunk.
+    BamAlignmentRecord record;
+    __uint64 offset = MaxValue<__uint64>::VALUE;
+    if (bgzf_seek(file.fp->fp.bgzf, aliOffset, SEEK_SET) < 0)
+        return false;  // Error while seeking.
+    while (true)
+    {
+        __uint64 result = bgzf_tell(file.fp->fp.bgzf);
+        if (!readRecord(record, file))
+            break;
+        if (record.rID == -1)
+        {
+            // Found alignment.
+            hasAlignments = true;
+            offset = result;
+            break;
+        }
+    }
+
+    // Jump back to the first alignment.
+    if (offset != MaxValue<__uint64>::VALUE && bgzf_seek(file.fp->fp.bgzf, offset, SEEK_SET) < 0)
+        return false;  // Error while seeking.
+
+    file.at_end = !hasAlignments;
+    file.read_all = true;
+
+    // Finding no orphan alignment is not an error, hasAlignments is false then.
+    return true;
+}
+
 // ----------------------------------------------------------------------------
 // Function getUnalignedCount()
 // ----------------------------------------------------------------------------
@@ -405,6 +602,83 @@ getUnalignedCount(BamIndex<Bai> const & index)
     return index._unalignedCount;
 }
 
+// ----------------------------------------------------------------------------
+// Function _openCsi()
+// ----------------------------------------------------------------------------
+
+// Load a BGZF compressed CSI index.  Unlike BAI, CSI stores a min offset per bin instead of a linear index.
+inline bool
+_openCsi(BamIndex<Bai> & index, char const * filename)
+{
+    typedef VirtualStream<char, Input> TInStream;
+
+    std::ifstream file(filename, std::ios::binary | std::ios::in);
+    TInStream csi;
+    if (!file.good() || !open(csi, file, BgzfFile()))
+        return false;  // Could not open file.
+
+    DirectionIterator<TInStream, Input>::Type iter = directionIterator(csi, Input());
+
+    // Read magic header.
+    String<char, Array<4> > magic;
+    read(magic, iter, 4);
+    if (magic != "CSI\1")
+        return false;  // Magic number is wrong.
+
+    // Read parameters and skip the auxiliary data.
+    __int32 lAux = 0;
+    readRawPod(index._minShift, iter);
+    readRawPod(index._depth, iter);
+    readRawPod(lAux, iter);
+    // Bin numbers are 32 bit, deeper binning indices cannot be stored.
+    if (index._minShift < 0 || index._depth < 0 || index._depth > 10 || index._minShift + 3 * index._depth >= 64)
+        return false;
+    CharString aux;
+    read(aux, iter, lAux);
+
+    __int32 nRef = 0;
+    readRawPod(nRef, iter);
+
+    clear(index._linearIndices);
+    clear(index._binIndices);
+    resize(index._linearIndices, nRef);
+    resize(index._binIndices, nRef);
+
+    BaiBamIndexBinData_ data;
+    for (int i = 0; i < nRef; ++i)  // For each reference.
+    {
+        __int32 nBin = 0;
+        readRawPod(nBin, iter);
+
+        for (int j = 0; j < nBin; ++j)  // For each bin.
+        {
+            __uint32 bin = 0;
+            __int32 nChunk = 0;
+            readRawPod(bin, iter);
+            readRawPod(data.loffset, iter);
+            readRawPod(nChunk, iter);
+
+            resize(data.chunkBegEnds, nChunk);
+            for (int k = 0; k < nChunk; ++k)  // For each chunk;
+            {
+                readRawPod(data.chunkBegEnds[k].i1, iter);
+                readRawPod(data.chunkBegEnds[k].i2, iter);
+            }
+
+            // Copy bin data into index.
+            index._binIndices[i][bin] = data;
+        }
+    }
+
+    // Read (optional) number of alignments without coordinate.
+    index._unalignedCount = 0;
+    if (!atEnd(iter))
+        readRawPod(index._unalignedCount, iter);
+
+    index._csi = true;
+    return true;
+}
+
 // ----------------------------------------------------------------------------
 // Function open()
 // ----------------------------------------------------------------------------
@@ -415,7 +689,7 @@ getUnalignedCount(BamIndex<Bai> const & index)
  * @signature bool open(index, filename);
 
  * @param[in,out] index    Target data structure.
- * @param[in]     filename Path to file to load. Types: char const *
+ * @param[in]     filename Path to file to load, a BAI or a CSI index. Types: char const *
  *
  * @return        bool     Returns <tt>true</tt> on success, false otherwise.
  */
@@ -433,9 +707,21 @@ open(BamIndex<Bai> & index, char const * filename)
     fin.read(&buffer[0], 4);
     if (!fin.good())
         return false;
+
+    // CSI indices are BGZF compressed, BAI indices are not.
+    if (buffer[0] == '\x1f' && buffer[1] == '\x8b')
+    {
+        fin.close();
+        return _openCsi(index, filename);
+    }
+
     if (buffer != "BAI\1")
         return false;  // Magic number is wrong.
 
+    index._minShift = BamIndex<Bai>::BAM_LIDX_SHIFT;
+    index._depth = 5;
+    index._csi = false;
+
     __int32 nRef = 0;
     fin.read(reinterpret_cast<char *>(&nRef), 4);
     if (!fin.good())
@@ -537,10 +823,59 @@ open(BamIndex<Bai> & index, char * filename)
  * @param[in] baiFileName The name of the BAI file to write to.
  *
  * @return bool <tt>true</tt> on success, <tt>false</tt> otherwise.
+ *
+ * @section Remarks
+ *
+ * An index that was loaded from a CSI file is written as BGZF compressed CSI file.
  */
 
+inline bool _saveCsi(BamIndex<Bai> const & index, char const * csiFilename)
+{
+    typedef BamIndex<Bai>::TBinIndex_::const_iterator TBinIter;
+
+    // Serialize the index into a buffer, written in one go to the compressed stream.
+    CharString buffer;
+    append(buffer, "CSI\1");
+    appendRawPod(buffer, index._minShift);
+    appendRawPod(buffer, index._depth);
+    appendRawPod(buffer, static_cast<__int32>(0));  // No auxiliary data.
+
+    __int32 numRefSeqs = length(index._binIndices);
+    appendRawPod(buffer, numRefSeqs);
+    for (int i = 0; i < numRefSeqs; ++i)
+    {
+        appendRawPod(buffer, static_cast<__int32>(index._binIndices[i].size()));
+        for (TBinIter itB = index._binIndices[i].begin(); itB != index._binIndices[i].end(); ++itB)
+        {
+            appendRawPod(buffer, itB->first);
+            appendRawPod(buffer, itB->second.loffset);
+            appendRawPod(buffer, static_cast<__int32>(length(itB->second.chunkBegEnds)));
+            for (unsigned k = 0; k < length(itB->second.chunkBegEnds); ++k)
+            {
+                appendRawPod(buffer, itB->second.chunkBegEnds[k].i1);
+                appendRawPod(buffer, itB->second.chunkBegEnds[k].i2);
+            }
+        }
+    }
+
+    if (index._unalignedCount != maxValue<__uint64>())
+        appendRawPod(buffer, index._unalignedCount);
+
+    std::ofstream file(csiFilename, std::ios::binary | std::ios::out);
+    VirtualStream<char, Output> out;
+    if (!file.good() || !open(out, file, BgzfFile()))
+        return false;
+
+    out.write(&buffer[0], length(buffer));
+    close(out);
+    return file.good();
+}
+
 inline bool save(BamIndex<Bai> const & index, char const * baiFilename)
 {
+    if (index._csi)
+        return _saveCsi(index, baiFilename);
+
     // Open output file.
     std::ofstream out(baiFilename, std::ios::binary | std::ios::out);
 
@@ -35,6 +35,10 @@
 #ifndef INCLUDE_SEQAN_BAM_IO_BAM_SCANNER_CACHE_H_
 #define INCLUDE_SEQAN_BAM_IO_BAM_SCANNER_CACHE_H_
 
+#include <algorithm>
+
+#include <seqan/hts_io/hts_file.h>
+
 #ifdef SEQAN_CXX11_STANDARD
 #include <functional>
 #include <unordered_map>
@@ -89,6 +93,16 @@ struct BamScannerCacheHash_ :
     }
 };
 
+// A sorted run of spilled records in the spill file and the read buffer used to merge it back.
+struct BamScannerSpillRun_
+{
+    __int64             filePos;
+    __int64             fileEnd;
+    CharString          buffer;
+    unsigned            bufferPos;
+    BamAlignmentRecord  record;
+};
+
 class BamScannerCache
 {
 public:
@@ -106,7 +120,47 @@ public:
     TMap                map;
     BamAlignmentRecord  tmpRecord;
 
+    // Maximal number of cached records before the oldest are spilled to disk, 0 means unlimited.
+    TRecordId           maxRecords;
+
+    // Insertion stamp of each cached record (0 for unused ids) and the cached ids in insertion order.
+    String<__uint64>    stamps;
+    String<Pair<TRecordId, __uint64> > ageQueue;
+    TRecordId           ageBegin;
+    __uint64            nextStamp;
+
+    // Records waiting to be written as the next sorted run, the spill file and its runs.
+    TRecords            spillBuffer;
+    File<Sync<> >       spillFile;
+    __int64             spillFileSize;
+    String<BamScannerSpillRun_> spillRuns;
+    String<unsigned>    spillHeap;
+    bool                merging;
+    CharString          buffer;
+
+    // Contig names of the input, used to parse spilled records and to print records without mate.
+    StringSet<CharString>                   contigNames;
+    NameStoreCache<StringSet<CharString> >  contigNamesCache;
+    BamIOContext<>      context;
+
     static const TRecordId INVALID_ID = (TRecordId)-1;
+
+    BamScannerCache() :
+        maxRecords(0), ageBegin(0), nextStamp(1), spillFileSize(0), merging(false),
+        contigNamesCache(contigNames), context(contigNames, contigNamesCache)
+    {}
+
+    explicit
+    BamScannerCache(TRecordId maxRecords) :
+        maxRecords(maxRecords), ageBegin(0), nextStamp(1), spillFileSize(0), merging(false),
+        contigNamesCache(contigNames), context(contigNames, contigNamesCache)
+    {}
+
+    ~BamScannerCache()
+    {
+        if (spillFileSize != 0)
+            spillFile.close();
+    }
 };
 
 
@@ -156,6 +210,7 @@ insertRecord(BamScannerCache &cache, seqan::BamAlignmentRecord const &record)
     {
         _id = length(cache.records);
         appendValue(cache.records, record);
+        appendValue(cache.stamps, 0u);
     }
     else
     {
@@ -166,6 +221,22 @@ insertRecord(BamScannerCache &cache, seqan::BamAlignmentRecord const &record)
 
     BamScannerCache::TKey key = { record.rID, record.beginPos, _suffixHash(record.qName) };
     cache.map.insert(std::make_pair(key, _id));
+
+    // remember the insertion order to find the coldest records
+    if (cache.maxRecords != 0)
+    {
+        cache.stamps[_id] = cache.nextStamp;
+        appendValue(cache.ageQueue, Pair<BamScannerCache::TRecordId, __uint64>(_id, cache.nextStamp++));
+    }
+}
+
+// remove a record from the map and free its id
+inline void
+_releaseRecord(BamScannerCache &cache, BamScannerCache::TMapIter it)
+{
+    cache.stamps[it->second] = 0;
+    appendValue(cache.unusedIds, it->second);
+    cache.map.erase(it);
 }
 
 template <typename TQName1, typename TQName2>
@@ -216,8 +287,7 @@ _recursivelyFindSegmentGraph(
                 resize(records, segmentNo + 2);
                 records[segmentNo + 1] = records[0];
                 records[segmentNo] = record;
-                appendValue(cache.unusedIds, it->second);
-                cache.map.erase(it);
+                _releaseRecord(cache, it);
                 return true;
             }
         }
@@ -239,8 +309,7 @@ _recursivelyFindSegmentGraph(
             if (_recursivelyFindSegmentGraph(records, newSearchKey, segmentNo + 1, cache))
             {
                 records[segmentNo] = record;
-                appendValue(cache.unusedIds, range.first->second);
-                cache.map.erase(range.first);
+                _releaseRecord(cache, range.first);
                 return true;
             }
         }
@@ -250,19 +319,315 @@ _recursivelyFindSegmentGraph(
 }
 
 
+// ----------------------------------------------------------------------------
+// Spilling to disk
+// ----------------------------------------------------------------------------
+
+// length of the part of the qName that is equal for all segments, see _qNamesEqual()
+template <typename TQName>
+inline unsigned
+_qNameKeyLength(TQName const &name)
+{
+    unsigned len = length(name);
+    if (len > 2 && (name[len - 2] == ':' || name[len - 2] == '/'))
+        return len - 1;
+    return len;
+}
+
+// compare the template names of two records, returns <0, 0 or >0
+inline int
+_compareTemplateNames(BamAlignmentRecord const &a, BamAlignmentRecord const &b)
+{
+    typedef Iterator<CharString const, Standard>::Type TIter;
+
+    TIter aBegin = begin(a.qName, Standard());
+    TIter bBegin = begin(b.qName, Standard());
+    TIter aEnd = aBegin + _qNameKeyLength(a.qName);
+    TIter bEnd = bBegin + _qNameKeyLength(b.qName);
+    for (; aBegin != aEnd && bBegin != bEnd; ++aBegin, ++bBegin)
+        if (*aBegin != *bBegin)
+            return (unsigned char)*aBegin < (unsigned char)*bBegin ? -1 : 1;
+    if (aBegin != aEnd)
+        return 1;
+    return (bBegin != bEnd) ? -1 : 0;
+}
+
+// order records by template name and segments of the same template by position
+inline bool
+_spillLess(BamAlignmentRecord const &a, BamAlignmentRecord const &b)
+{
+    int res = _compareTemplateNames(a, b);
+    if (res != 0)
+        return res < 0;
+
+    if (a.rID != b.rID)
+        return (__uint32)a.rID < (__uint32)b.rID;
+    return (__uint32)a.beginPos < (__uint32)b.beginPos;
+}
+
+struct BamScannerSpillIdLess_
+{
+    BamScannerCache::TRecords const &records;
+
+    BamScannerSpillIdLess_(BamScannerCache::TRecords const &records) :
+        records(records)
+    {}
+
+    bool operator() (unsigned a, unsigned b) const
+    {
+        return _spillLess(records[a], records[b]);
+    }
+};
+
+// inverse order of the current records of the runs, to be used as a min-heap
+struct BamScannerSpillRunGreater_
+{
+    String<BamScannerSpillRun_> const &runs;
+
+    BamScannerSpillRunGreater_(String<BamScannerSpillRun_> const &runs) :
+        runs(runs)
+    {}
+
+    bool operator() (unsigned a, unsigned b) const
+    {
+        return _spillLess(runs[b].record, runs[a].record);
+    }
+};
+
+inline bool
+_hasSpilled(BamScannerCache const &cache)
+{
+    return !empty(cache.spillRuns) || !empty(cache.spillBuffer);
+}
+
+// sort the spill buffer by name and append it as a new run to the spill file
+inline void
+_writeSpillRun(BamScannerCache &cache)
+{
+    typedef BamScannerCache::TRecordId TRecordId;
+
+    if (empty(cache.spillBuffer))
+        return;
+
+    if (cache.spillFileSize == 0 && !openTemp(cache.spillFile))
+        SEQAN_THROW(IOError("Could not open temporary file to spill BAM records."));
+
+    String<unsigned> order;
+    resize(order, length(cache.spillBuffer), Exact());
+    for (unsigned i = 0; i < length(order); ++i)
+        order[i] = i;
+    std::sort(begin(order, Standard()), end(order, Standard()), BamScannerSpillIdLess_(cache.spillBuffer));
+
+    clear(cache.buffer);
+    for (TRecordId i = 0; i < length(order); ++i)
+    {
+        BamAlignmentRecord const &record = cache.spillBuffer[order[i]];
+        appendRawPod(cache.buffer, updateLengths(record));
+        _writeBamRecord(cache.buffer, record, Bam());
+    }
+
+    if (!writeAt(cache.spillFile, begin(cache.buffer, Standard()), length(cache.buffer), cache.spillFileSize))
+        SEQAN_THROW(IOError("Could not write BAM records to temporary file."));
+
+    resize(cache.spillRuns, length(cache.spillRuns) + 1);
+    back(cache.spillRuns).filePos = cache.spillFileSize;
+    cache.spillFileSize += length(cache.buffer);
+    back(cache.spillRuns).fileEnd = cache.spillFileSize;
+    clear(cache.spillBuffer);
+}
+
+// move a record into the spill buffer, the buffer is written if it holds half as many records as the cache
+inline void
+_spillRecord(BamScannerCache &cache, BamAlignmentRecord &record)
+{
+    resize(cache.spillBuffer, length(cache.spillBuffer) + 1);
+    swap(back(cache.spillBuffer), record);
+
+    if (length(cache.spillBuffer) >= std::max(cache.maxRecords / 2, (BamScannerCache::TRecordId)1))
+        _writeSpillRun(cache);
+}
+
+// spill the least recently inserted records until the cache holds at most maxRecords records
 inline void
-readMultiRecords(String<BamAlignmentRecord> &records, BamFileIn &bamFile, BamScannerCache &cache)
+_spillColdRecords(BamScannerCache &cache)
+{
+    typedef BamScannerCache::TMapIter TMapIter;
+
+    while (cache.map.size() > cache.maxRecords)
+    {
+        Pair<BamScannerCache::TRecordId, __uint64> entry = cache.ageQueue[cache.ageBegin++];
+        if (cache.stamps[entry.i1] != entry.i2)
+            continue;   // already joined with its mate
+
+        BamAlignmentRecord &record = cache.records[entry.i1];
+        BamScannerCache::TKey key = { record.rID, record.beginPos, _suffixHash(record.qName) };
+        std::pair<TMapIter, TMapIter> range = cache.map.equal_range(key);
+        for (; range.first != range.second; ++range.first)
+            if (range.first->second == entry.i1)
+                break;
+        SEQAN_ASSERT(range.first != range.second);
+
+        _spillRecord(cache, record);
+        _releaseRecord(cache, range.first);
+    }
+
+    // drop the entries of joined records from the age queue
+    if (cache.ageBegin > length(cache.ageQueue) / 2)
+    {
+        erase(cache.ageQueue, 0, cache.ageBegin);
+        cache.ageBegin = 0;
+    }
+    else if (length(cache.ageQueue) - cache.ageBegin > 2 * cache.map.size() + 1024)
+    {
+        BamScannerCache::TRecordId j = 0;
+        for (BamScannerCache::TRecordId i = cache.ageBegin; i < length(cache.ageQueue); ++i)
+            if (cache.stamps[cache.ageQueue[i].i1] == cache.ageQueue[i].i2)
+                cache.ageQueue[j++] = cache.ageQueue[i];
+        resize(cache.ageQueue, j);
+        cache.ageBegin = 0;
+    }
+}
+
+// read the next record of a run, returns false at the end of the run
+inline bool
+_readSpilledRecord(BamScannerSpillRun_ &run, BamScannerCache &cache)
+{
+    const unsigned CHUNK_SIZE = 64 * 1024;
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        unsigned available = length(run.buffer) - run.bufferPos;
+        __int32 recordLen = 0;
+        if (available >= 4)
+        {
+            arrayCopyForward(begin(run.buffer, Standard()) + run.bufferPos,
+                             begin(run.buffer, Standard()) + run.bufferPos + 4,
+                             reinterpret_cast<char *>(&recordLen));
+            if (available >= 4 + (unsigned)recordLen)
+            {
+                _parseBamRecord(run.record, cache.context, begin(run.buffer, Standard()) + run.bufferPos + 4,
+                                recordLen);
+                run.bufferPos += 4 + recordLen;
+                return true;
+            }
+        }
+
+        if (pass == 1 || run.filePos == run.fileEnd)
+            break;
+
+        // keep the incomplete record and refill the buffer from the spill file
+        erase(run.buffer, 0, run.bufferPos);
+        run.bufferPos = 0;
+        unsigned chunkSize = std::max(CHUNK_SIZE, 4 + (unsigned)recordLen);
+        chunkSize = std::min((__int64)chunkSize, run.fileEnd - run.filePos);
+        resize(run.buffer, available + chunkSize);
+        if (!readAt(cache.spillFile, begin(run.buffer, Standard()) + available, chunkSize, run.filePos))
+            SEQAN_THROW(IOError("Could not read BAM records from temporary file."));
+        run.filePos += chunkSize;
+    }
+
+    if (run.bufferPos != length(run.buffer))
+        SEQAN_THROW(ParseError("Truncated BAM record in temporary file."));
+    return false;
+}
+
+// spill the remaining records and start merging the runs
+inline void
+_startSpillMerge(BamScannerCache &cache)
+{
+    typedef BamScannerCache::TMapIter TMapIter;
+
+    // the remaining records could be mates of spilled records
+    for (TMapIter it = cache.map.begin(); it != cache.map.end(); ++it)
+    {
+        resize(cache.spillBuffer, length(cache.spillBuffer) + 1);
+        swap(back(cache.spillBuffer), cache.records[it->second]);
+    }
+    cache.map.clear();
+    clear(cache.records);
+    clear(cache.unusedIds);
+    clear(cache.stamps);
+    clear(cache.ageQueue);
+    cache.ageBegin = 0;
+    _writeSpillRun(cache);
+
+    clear(cache.spillHeap);
+    for (unsigned i = 0; i < length(cache.spillRuns); ++i)
+    {
+        cache.spillRuns[i].bufferPos = 0;
+        if (_readSpilledRecord(cache.spillRuns[i], cache))
+            appendValue(cache.spillHeap, i);
+    }
+    std::make_heap(begin(cache.spillHeap, Standard()), end(cache.spillHeap, Standard()),
+                   BamScannerSpillRunGreater_(cache.spillRuns));
+    cache.merging = true;
+}
+
+// get all records of the next template name from the spilled runs
+inline void
+_readSpilledMultiRecords(String<BamAlignmentRecord> &records, BamScannerCache &cache)
+{
+    BamScannerSpillRunGreater_ greater(cache.spillRuns);
+
+    clear(records);
+    while (!empty(cache.spillHeap))
+    {
+        BamScannerSpillRun_ &run = cache.spillRuns[front(cache.spillHeap)];
+        if (!empty(records) && _compareTemplateNames(run.record, records[0]) != 0)
+            break;
+
+        resize(records, length(records) + 1);
+        swap(back(records), run.record);
+
+        std::pop_heap(begin(cache.spillHeap, Standard()), end(cache.spillHeap, Standard()), greater);
+        if (_readSpilledRecord(run, cache))
+            std::push_heap(begin(cache.spillHeap, Standard()), end(cache.spillHeap, Standard()), greater);
+        else
+            eraseBack(cache.spillHeap);
+    }
+
+    if (empty(cache.spillHeap))
+    {
+        // all runs are merged, release the spill file
+        clear(cache.spillRuns);
+        close(cache.spillFile);
+        cache.spillFileSize = 0;
+        cache.merging = false;
+    }
+}
+
+// take over the contig names of the file's header
+inline void
+_updateContigNames(BamScannerCache &cache, HtsFile const &file)
+{
+    if (file.hdr == nullptr || length(cache.contigNames) == (unsigned)file.hdr->n_targets)
+        return;
+
+    clear(cache.contigNames);
+    for (__int32 i = 0; i < file.hdr->n_targets; ++i)
+        appendValue(cache.contigNames, file.hdr->target_name[i]);
+    refresh(cache.contigNamesCache);
+}
+
+inline void
+readMultiRecords(String<BamAlignmentRecord> &records, HtsFile &bamFile, BamScannerCache &cache)
 {
     typedef BamScannerCacheSearchKey_::TFlag TFlag;
 
+    if (cache.merging)
+    {
+        _readSpilledMultiRecords(records, cache);
+        return;
+    }
+
+    _updateContigNames(cache, bamFile);
+
     if (empty(records))
         resize(records, 1);
 
-    while (!atEnd(bamFile))
+    while (readRecord(records[0], bamFile))
     {
-        // read next record
         BamAlignmentRecord &record = records[0];
-        readRecord(record, bamFile);
 
         // is this a single-end read or single alignment?
         if (!hasFlagMultiple(record) ||
@@ -279,6 +644,8 @@ readMultiRecords(String<BamAlignmentRecord> &records, BamFileIn &bamFile, BamSca
         {
             // store record to retrieve it later
             insertRecord(cache, record);
+            if (cache.maxRecords != 0)
+                _spillColdRecords(cache);
             continue;
         }
 
@@ -304,12 +671,28 @@ readMultiRecords(String<BamAlignmentRecord> &records, BamFileIn &bamFile, BamSca
             // hence, insert our record to be retrieved by the second.
             if (records[0].beginPos != records[0].pNext)
             {
+                // the mate might have been spilled, join them at the end
+                if (_hasSpilled(cache))
+                {
+                    _spillRecord(cache, records[0]);
+                    continue;
+                }
                 std::cerr << "WARNING: Mate could not be found for:\n";
-                write(std::cerr, records[0], context(bamFile), seqan::Sam());
+                write(std::cerr, records[0], cache.context, seqan::Sam());
             }
             insertRecord(cache, records[0]);
+            if (cache.maxRecords != 0)
+                _spillColdRecords(cache);
         }
     }
+
+    // join the spilled records by name
+    if (_hasSpilled(cache))
+    {
+        _startSpillMerge(cache);
+        _readSpilledMultiRecords(records, cache);
+        return;
+    }
     clear(records);
 }
 
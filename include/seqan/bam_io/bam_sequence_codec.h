@@ -0,0 +1,307 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Bulk conversion between the packed 4-bit BAM sequence / raw BAM qualities
+// and their SeqAn representation.
+//
+// The BAM 4-bit codes "=ACMGRSVTWYHKDBN" have the same order as the Iupac
+// alphabet, so decoding into an IupacString is a pure nibble unpack.  With
+// SSE2 (and SSSE3 for the table lookup into characters) 32 bases are
+// converted per loop iteration, the remainder is converted scalar.
+// ==========================================================================
+
+#ifndef INCLUDE_SEQAN_BAM_IO_BAM_SEQUENCE_CODEC_H_
+#define INCLUDE_SEQAN_BAM_IO_BAM_SEQUENCE_CODEC_H_
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#endif
+
+namespace seqan {
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function _decodeBamSeq()
+// ----------------------------------------------------------------------------
+
+// Unpacks len 4-bit codes into one byte per base (Iupac ordinal values).
+inline void
+_decodeBamSeq(unsigned char * SEQAN_RESTRICT target, unsigned char const * SEQAN_RESTRICT packed, size_t len)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    __m128i const lowNibble = _mm_set1_epi8(0x0f);
+    for (; i + 32 <= len; i += 32)
+    {
+        __m128i p  = _mm_loadu_si128(reinterpret_cast<__m128i const *>(packed + (i >> 1)));
+        __m128i hi = _mm_and_si128(_mm_srli_epi16(p, 4), lowNibble);
+        __m128i lo = _mm_and_si128(p, lowNibble);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+
+    for (; i + 2 <= len; i += 2)
+    {
+        unsigned char x = packed[i >> 1];
+        target[i] = x >> 4;
+        target[i + 1] = x & 0x0f;
+    }
+    if (i < len)
+        target[i] = packed[i >> 1] >> 4;
+}
+
+// ----------------------------------------------------------------------------
+// Function _decodeBamSeqChars()
+// ----------------------------------------------------------------------------
+
+// Unpacks len 4-bit codes into IUPAC characters.
+inline void
+_decodeBamSeqChars(char * SEQAN_RESTRICT target, unsigned char const * SEQAN_RESTRICT packed, size_t len)
+{
+    static char const CODE_TO_CHAR[17] = "=ACMGRSVTWYHKDBN";
+    size_t i = 0;
+
+#if defined(__SSSE3__)
+    __m128i const table = _mm_loadu_si128(reinterpret_cast<__m128i const *>(CODE_TO_CHAR));
+    __m128i const lowNibble = _mm_set1_epi8(0x0f);
+    for (; i + 32 <= len; i += 32)
+    {
+        __m128i p  = _mm_loadu_si128(reinterpret_cast<__m128i const *>(packed + (i >> 1)));
+        __m128i hi = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(p, 4), lowNibble));
+        __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(p, lowNibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+
+    for (; i + 2 <= len; i += 2)
+    {
+        unsigned char x = packed[i >> 1];
+        target[i] = CODE_TO_CHAR[x >> 4];
+        target[i + 1] = CODE_TO_CHAR[x & 0x0f];
+    }
+    if (i < len)
+        target[i] = CODE_TO_CHAR[packed[i >> 1] >> 4];
+}
+
+// ----------------------------------------------------------------------------
+// Function _decodeBamQual()
+// ----------------------------------------------------------------------------
+
+// Converts raw PHRED values into printable PHRED+33 characters.
+inline void
+_decodeBamQual(char * SEQAN_RESTRICT target, unsigned char const * SEQAN_RESTRICT qual, size_t len)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    __m128i const offset = _mm_set1_epi8('!');
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i q = _mm_loadu_si128(reinterpret_cast<__m128i const *>(qual + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i), _mm_add_epi8(q, offset));
+    }
+#endif
+
+    for (; i < len; ++i)
+        target[i] = static_cast<char>(qual[i] + '!');
+}
+
+// ----------------------------------------------------------------------------
+// Function _encodeBamSeq()
+// ----------------------------------------------------------------------------
+
+// Packs len Iupac ordinal values into (len + 1) / 2 bytes of 4-bit codes.
+inline void
+_encodeBamSeq(unsigned char * SEQAN_RESTRICT packed, unsigned char const * SEQAN_RESTRICT source, size_t len)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    __m128i const lowByte = _mm_set1_epi16(0x00ff);
+    for (; i + 32 <= len; i += 32)
+    {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(source + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(source + i + 16));
+        __m128i even = _mm_packus_epi16(_mm_and_si128(a, lowByte), _mm_and_si128(b, lowByte));
+        __m128i odd  = _mm_packus_epi16(_mm_srli_epi16(a, 8), _mm_srli_epi16(b, 8));
+        // codes are < 16, so a 16 bit shift does not carry bits into the neighbouring byte
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(packed + (i >> 1)), _mm_or_si128(_mm_slli_epi16(even, 4), odd));
+    }
+#endif
+
+    for (; i + 2 <= len; i += 2)
+        packed[i >> 1] = (source[i] << 4) | source[i + 1];
+    if (i < len)
+        packed[i >> 1] = source[i] << 4;
+}
+
+// ----------------------------------------------------------------------------
+// Function _encodeBamQual()
+// ----------------------------------------------------------------------------
+
+// Converts printable PHRED+33 characters into raw PHRED values.
+inline void
+_encodeBamQual(unsigned char * SEQAN_RESTRICT target, char const * SEQAN_RESTRICT qual, size_t len)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    __m128i const offset = _mm_set1_epi8('!');
+    for (; i + 16 <= len; i += 16)
+    {
+        __m128i q = _mm_loadu_si128(reinterpret_cast<__m128i const *>(qual + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i), _mm_sub_epi8(q, offset));
+    }
+#endif
+
+    for (; i < len; ++i)
+        target[i] = static_cast<unsigned char>(qual[i] - '!');
+}
+
+// ----------------------------------------------------------------------------
+// Function decodeBamSeq()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn decodeBamSeq
+ * @headerfile <seqan/bam_io.h>
+ * @brief Decode a packed 4-bit BAM sequence.
+ *
+ * @signature void decodeBamSeq(seq, packed, len);
+ *
+ * @param[out] seq    The resulting sequence, an @link IupacString @endlink or a @link CharString @endlink.
+ * @param[in]  packed Pointer to the <tt>(len + 1) / 2</tt> bytes of the packed sequence.
+ * @param[in]  len    The number of bases.
+ */
+
+template <typename TSpec, typename TPacked, typename TSize>
+inline void
+decodeBamSeq(String<Iupac, Alloc<TSpec> > & seq, TPacked const * packed, TSize len)
+{
+    resize(seq, len, Exact());
+    if (len != 0)
+        _decodeBamSeq(reinterpret_cast<unsigned char *>(begin(seq, Standard())),
+                      reinterpret_cast<unsigned char const *>(packed), len);
+}
+
+template <typename TSpec, typename TPacked, typename TSize>
+inline void
+decodeBamSeq(String<char, Alloc<TSpec> > & seq, TPacked const * packed, TSize len)
+{
+    resize(seq, len, Exact());
+    if (len != 0)
+        _decodeBamSeqChars(begin(seq, Standard()), reinterpret_cast<unsigned char const *>(packed), len);
+}
+
+// ----------------------------------------------------------------------------
+// Function decodeBamQual()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn decodeBamQual
+ * @headerfile <seqan/bam_io.h>
+ * @brief Decode raw BAM base qualities into PHRED+33 characters.
+ *
+ * @signature void decodeBamQual(qual, raw, len);
+ *
+ * @param[out] qual The resulting quality string.
+ * @param[in]  raw  Pointer to the <tt>len</tt> raw PHRED values.
+ * @param[in]  len  The number of qualities.
+ */
+
+template <typename TSpec, typename TRaw, typename TSize>
+inline void
+decodeBamQual(String<char, Alloc<TSpec> > & qual, TRaw const * raw, TSize len)
+{
+    resize(qual, len, Exact());
+    if (len != 0)
+        _decodeBamQual(begin(qual, Standard()), reinterpret_cast<unsigned char const *>(raw), len);
+}
+
+// ----------------------------------------------------------------------------
+// Function encodeBamSeq()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn encodeBamSeq
+ * @headerfile <seqan/bam_io.h>
+ * @brief Pack a sequence into the 4-bit BAM representation.
+ *
+ * @signature void encodeBamSeq(packed, seq);
+ *
+ * @param[out] packed Pointer to at least <tt>(length(seq) + 1) / 2</tt> bytes.
+ * @param[in]  seq    The @link IupacString @endlink to encode.
+ */
+
+template <typename TPacked, typename TSpec>
+inline void
+encodeBamSeq(TPacked * packed, String<Iupac, Alloc<TSpec> > const & seq)
+{
+    if (!empty(seq))
+        _encodeBamSeq(reinterpret_cast<unsigned char *>(packed),
+                      reinterpret_cast<unsigned char const *>(begin(seq, Standard())), length(seq));
+}
+
+// ----------------------------------------------------------------------------
+// Function encodeBamQual()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn encodeBamQual
+ * @headerfile <seqan/bam_io.h>
+ * @brief Convert PHRED+33 characters into raw BAM base qualities.
+ *
+ * @signature void encodeBamQual(raw, qual);
+ *
+ * @param[out] raw  Pointer to at least <tt>length(qual)</tt> bytes.
+ * @param[in]  qual The quality string to encode.
+ */
+
+template <typename TRaw, typename TSpec>
+inline void
+encodeBamQual(TRaw * raw, String<char, Alloc<TSpec> > const & qual)
+{
+    if (!empty(qual))
+        _encodeBamQual(reinterpret_cast<unsigned char *>(raw), begin(qual, Standard()), length(qual));
+}
+
+}  // namespace seqan
+
+#endif  // #ifndef INCLUDE_SEQAN_BAM_IO_BAM_SEQUENCE_CODEC_H_
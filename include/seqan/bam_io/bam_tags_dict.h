@@ -92,6 +92,11 @@ struct Position<BamTagsDict>
  *
  * @signature class BamTagsDict;
  *
+ * Besides the start positions, the index contains a small hash table over the two-character tag keys, such that
+ * @link BamTagsDict#findTagKey @endlink, @link BamTagsDict#setTagValue @endlink and @link BamTagsDict#eraseTag
+ * @endlink do not scan all tags.  Edits keep the index up to date instead of discarding it, and a value of the same
+ * size is overwritten in place.
+ *
  * @section Example
  *
  * @include demos/dox/bam_io/bam_tags_dict.cpp
@@ -119,6 +124,7 @@ public:
 
     Holder<TBamTagsSequence> _host;
     mutable String<TPos> _positions;
+    mutable String<__uint8> _keySlots;  // open addressing hash table of tag ids + 1, 0 marks an empty slot
 
     BamTagsDict() {}
 
@@ -238,6 +244,61 @@ getBamTypeSize(char c)
     }
 }
 
+// ----------------------------------------------------------------------------
+// Function _buildKeyIndex()
+// ----------------------------------------------------------------------------
+
+// The hash table is kept at most half full, so probing ends after a few slots.  Dicts with more than 254 tags don't
+// fit the 8-bit ids and fall back to a linear scan.
+
+inline unsigned
+_bamTagKeyHash(char c0, char c1, unsigned mask)
+{
+    return (static_cast<unsigned char>(c0) * 37u + static_cast<unsigned char>(c1)) & mask;
+}
+
+inline void
+_insertTagKey(BamTagsDict const & bamTags, unsigned id)
+{
+    unsigned mask = length(bamTags._keySlots) - 1;
+    char const * key = &host(bamTags)[bamTags._positions[id]];
+    unsigned slot = _bamTagKeyHash(key[0], key[1], mask);
+    while (bamTags._keySlots[slot] != 0)
+        slot = (slot + 1) & mask;
+    bamTags._keySlots[slot] = id + 1;
+}
+
+inline void
+_buildKeyIndex(BamTagsDict const & bamTags)
+{
+    clear(bamTags._keySlots);
+    if (empty(bamTags._positions))
+        return;
+
+    unsigned numTags = length(bamTags._positions) - 1;
+    if (numTags >= 255u)
+        return;
+
+    unsigned numSlots = 16;
+    while (numSlots < 2 * numTags)
+        numSlots *= 2;
+    resize(bamTags._keySlots, numSlots, 0, Exact());
+
+    for (unsigned id = 0; id < numTags; ++id)
+        _insertTagKey(bamTags, id);
+}
+
+// Registers the tag that was appended last, growing the hash table if it would become more than half full.
+inline void
+_appendTagKey(BamTagsDict const & bamTags)
+{
+    unsigned numTags = length(bamTags._positions) - 1;
+    if (numTags < 255u && 2 * numTags <= length(bamTags._keySlots))
+        _insertTagKey(bamTags, numTags - 1);
+    else
+        _buildKeyIndex(bamTags);
+}
+
 // ----------------------------------------------------------------------------
 // Function buildIndex()
 // ----------------------------------------------------------------------------
@@ -302,6 +363,8 @@ buildIndex(BamTagsDict const & bamTags)
     }
     // if (!empty(value(bamTags._host)))
     //     appendValue(bamTags._positions, length(host(bamTags)) + 1);  // +1 since there is not tab at the end
+
+    _buildKeyIndex(bamTags);
 }
 
 // ----------------------------------------------------------------------------
@@ -331,6 +394,7 @@ setHost(BamTagsDict & me, THost && host_)
 {
     setValue(_dataHost(me), std::forward<THost>(host_));
     clear(me._positions);
+    clear(me._keySlots);
 }
 #else
 template <typename THost>
@@ -340,6 +404,7 @@ setHost(BamTagsDict & me, THost & host_)
     SEQAN_CHECKPOINT;
     setValue(_dataHost(me), host_);
     clear(me._positions);
+    clear(me._keySlots);
 }
 
 template <typename THost>
@@ -349,6 +414,7 @@ setHost(BamTagsDict & me, THost const & host_)
     SEQAN_CHECKPOINT;
     setValue(_dataHost(me), host_);
     clear(me._positions);
+    clear(me._keySlots);
 }
 #endif  // SEQAN_CXX11_STANDARD
 // ----------------------------------------------------------------------------
@@ -444,9 +510,30 @@ template <typename TId, typename TKey>
 inline bool
 findTagKey(TId & id, BamTagsDict const & tags, TKey const & key)
 {
-    for (id = 0; id < (TId)length(tags); ++id)
-        if (getTagKey(tags, id) == key)
+    if (!hasIndex(tags))
+        buildIndex(tags);
+
+    if (empty(tags._keySlots) || length(key) != 2u)
+    {
+        for (id = 0; id < (TId)length(tags); ++id)
+            if (getTagKey(tags, id) == key)
+                return true;
+        return false;
+    }
+
+    // Probe the hash table until the key or an empty slot is found.
+    char c0 = key[0];
+    char c1 = key[1];
+    unsigned mask = length(tags._keySlots) - 1;
+    for (unsigned slot = _bamTagKeyHash(c0, c1, mask); tags._keySlots[slot] != 0; slot = (slot + 1) & mask)
+    {
+        char const * tagKey = &host(tags)[tags._positions[tags._keySlots[slot] - 1]];
+        if (tagKey[0] == c0 && tagKey[1] == c1)
+        {
+            id = tags._keySlots[slot] - 1;
             return true;
+        }
+    }
     return false;
 }
 
@@ -731,18 +818,37 @@ setTagValue(BamTagsDict & tags, TKey const & key, TValue const & val, char typeC
         if (!_toBamTagValue(bamTagVal, val, typeC))
             return false;
 
-        replace(host(tags), tags._positions[id] + 2, tags._positions[id + 1], bamTagVal);
-        clear(tags._positions);
+        typedef BamTagsDict::TPos TPos;
+        TPos valBeg = tags._positions[id] + 2;
+        TPos valEnd = tags._positions[id + 1];
+        if (length(bamTagVal) == valEnd - valBeg)
+        {
+            // Same size, e.g. a new NM or AS value: overwrite in place.
+            arrayCopyForward(begin(bamTagVal, Standard()), end(bamTagVal, Standard()),
+                             begin(host(tags), Standard()) + valBeg);
+            return true;
+        }
+
+        // Shift the positions of the following tags, the ids and thus the hash table stay valid.
+        replace(host(tags), valBeg, valEnd, bamTagVal);
+        for (unsigned i = id + 1; i < length(tags._positions); ++i)
+            tags._positions[i] = tags._positions[i] + length(bamTagVal) - (valEnd - valBeg);
     }
     else
     {
+        if (empty(tags._positions))
+            appendValue(tags._positions, 0);
+
         append(host(tags), key);
         if (!_toBamTagValue(host(tags), val, typeC))
         {
             resize(host(tags), length(host(tags)) - length(key));
+            if (length(tags._positions) == 1u)
+                clear(tags._positions);
             return false;
         }
         appendValue(tags._positions, length(host(tags)));
+        _appendTagKey(tags);
     }
 
     return true;
@@ -797,9 +903,15 @@ template <typename TKey, typename TValue>
 inline bool
 appendTagValue(BamTagsDict & tags, TKey const & key, TValue const & val, char typeC)
 {
+    if (!hasIndex(tags))
+        buildIndex(tags);
+
     if (appendTagValue(host(tags), key, val, typeC))
     {
+        if (empty(tags._positions))
+            appendValue(tags._positions, 0);
         appendValue(tags._positions, length(host(tags)));
+        _appendTagKey(tags);
         return true;
     }
     return false;
@@ -830,22 +942,6 @@ appendTagValue(TDictOrString & tags, TKey const & key, TValue const & val)
  * @return bool <tt>true</tt> if the tag could be erased, <tt>false</tt> if the key wasn't present.
  */
 
-template <typename TKey>
-inline SEQAN_FUNC_DISABLE_IF(Is<IntegerConcept<TKey> >, bool)
-eraseTag(BamTagsDict & tags, TKey const & key)
-{
-    if (!hasIndex(tags))
-        buildIndex(tags);
-
-    Position<BamTagsDict>::Type id = 0;
-    if (!findTagKey(id, tags, key))
-        return false;
-
-    erase(host(tags), tags._positions[id], tags._positions[id + 1]);
-    clear(tags._positions);
-    return true;
-}
-
 template <typename TId>
 inline SEQAN_FUNC_ENABLE_IF(Is<IntegerConcept<TId> >, bool)
 eraseTag(BamTagsDict & tags, TId const & id)
@@ -861,9 +957,26 @@ eraseTag(BamTagsDict & tags, TId const & id)
     TIter itEnd = end(tags._positions, Standard());
     for (; it != itEnd; ++it)
         *it -= delta;
+
+    // The ids of the following tags have changed.
+    _buildKeyIndex(tags);
     return true;
 }
 
+template <typename TKey>
+inline SEQAN_FUNC_DISABLE_IF(Is<IntegerConcept<TKey> >, bool)
+eraseTag(BamTagsDict & tags, TKey const & key)
+{
+    if (!hasIndex(tags))
+        buildIndex(tags);
+
+    Position<BamTagsDict>::Type id = 0;
+    if (!findTagKey(id, tags, key))
+        return false;
+
+    return eraseTag(tags, id);
+}
+
 }  // namespace seqan
 
 #endif  // #ifndef INCLUDE_SEQAN_BAM_IO_BAM_TAGS_DICT_H_
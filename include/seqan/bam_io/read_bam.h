@@ -189,21 +189,16 @@ _readBamRecord(TBuffer & rawRecord, TForwardIter & iter, Bam)
     write(rawRecord, iter, (size_t)recordLen);
 }
 
-template <typename TForwardIter, typename TNameStore, typename TNameStoreCache, typename TStorageSpec>
+// Decodes a raw BAM record (without its size field). The context is only read, so records can be decoded in
+// parallel from different buffers.
+template <typename TCharIter, typename TNameStore, typename TNameStoreCache, typename TStorageSpec>
 inline void
-readRecord(BamAlignmentRecord & record,
-           BamIOContext<TNameStore, TNameStoreCache, TStorageSpec> & context,
-           TForwardIter & iter,
-           Bam const & /* tag */)
+_parseBamRecord(BamAlignmentRecord & record,
+                BamIOContext<TNameStore, TNameStoreCache, TStorageSpec> const & context,
+                TCharIter it,
+                __int32 remainingBytes)
 {
-    typedef typename Iterator<CharString, Standard>::Type                             TCharIter;
     typedef typename Iterator<String<CigarElement<> >, Standard>::Type SEQAN_RESTRICT TCigarIter;
-    typedef typename Iterator<IupacString, Standard>::Type SEQAN_RESTRICT             TSeqIter;
-    typedef typename Iterator<CharString, Standard>::Type SEQAN_RESTRICT              TQualIter;
-
-    // Read size and data of the remaining block in one chunk (fastest).
-    __int32 remainingBytes = _readBamRecordWithoutSize(context.buffer, iter);
-    TCharIter it = begin(context.buffer, Standard());
 
     // BamAlignmentRecordCore.
     arrayCopyForward(it, it + sizeof(BamAlignmentRecordCore), reinterpret_cast<char*>(&record));
@@ -244,28 +239,14 @@ readRecord(BamAlignmentRecord & record,
     }
 
     // query sequence.
-    resize(record.seq, record._l_qseq, Exact());
-    TSeqIter sit = begin(record.seq, Standard());
-    TSeqIter sitEnd = sit + (record._l_qseq & ~1);
-    while (sit != sitEnd)
-    {
-        unsigned char ui = getValue(it);
-        ++it;
-        assignValue(sit, Iupac(ui >> 4));
-        ++sit;
-        assignValue(sit, Iupac(ui & 0x0f));
-        ++sit;
-    }
-    if (record._l_qseq & 1)
-        *sit++ = Iupac((__uint8)*it++ >> 4);
+    decodeBamSeq(record.seq, it, record._l_qseq);
+    it += (record._l_qseq + 1) / 2;
 
     // phred quality
-    resize(record.qual, record._l_qseq, Exact());
+    decodeBamQual(record.qual, it, record._l_qseq);
+    it += record._l_qseq;
     // If qual is a sequence of 0xff (heuristic same as samtools: Only look at first byte) then we clear it, to get the
     // representation of '*';
-    TQualIter qitEnd = end(record.qual, Standard());
-    for (TQualIter qit = begin(record.qual, Standard()); qit != qitEnd;)
-        *qit++ = '!' + *it++;
     if (!empty(record.qual) && record.qual[0] == '\xff')
         clear(record.qual);
 
@@ -274,6 +255,18 @@ readRecord(BamAlignmentRecord & record,
     arrayCopyForward(it, it + remainingBytes, begin(record.tags, Standard()));
 }
 
+template <typename TForwardIter, typename TNameStore, typename TNameStoreCache, typename TStorageSpec>
+inline void
+readRecord(BamAlignmentRecord & record,
+           BamIOContext<TNameStore, TNameStoreCache, TStorageSpec> & context,
+           TForwardIter & iter,
+           Bam const & /* tag */)
+{
+    // Read size and data of the remaining block in one chunk (fastest).
+    __int32 remainingBytes = _readBamRecordWithoutSize(context.buffer, iter);
+    _parseBamRecord(record, context, begin(context.buffer, Standard()), remainingBytes);
+}
+
 }  // namespace seqan
 
 #endif  // #ifndef INCLUDE_SEQAN_BAM_IO_READ_BAM_H_
@@ -37,6 +37,12 @@
 #ifndef INCLUDE_SEQAN_BAM_IO_READ_SAM_H_
 #define INCLUDE_SEQAN_BAM_IO_READ_SAM_H_
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace seqan {
 
 // ============================================================================
@@ -246,10 +252,89 @@ _readBamRecord(TBuffer & rawRecord, TForwardIter & iter, Sam)
     readLine(rawRecord, iter);
 }
 
+// ----------------------------------------------------------------------------
+// Function _findSamFieldEnds()
+// ----------------------------------------------------------------------------
+
+// Stores the positions of the first maxEnds tabs of a line in ends and returns their number.  With SSE2/AVX2 the
+// line is compared against '\t' 16/32 characters at a time and the tabs are extracted from the resulting bit mask.
+inline unsigned
+_findSamFieldEnds(size_t * ends, unsigned maxEnds, char const * line, size_t len)
+{
+    unsigned numEnds = 0;
+    size_t i = 0;
+
+#if defined(__AVX2__)
+    __m256i const tab = _mm256_set1_epi8('\t');
+    for (; i + 32 <= len && numEnds < maxEnds; i += 32)
+    {
+        __m256i chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(line + i));
+        __uint32 mask = static_cast<__uint32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, tab)));
+        for (; mask != 0u && numEnds < maxEnds; mask &= mask - 1)
+            ends[numEnds++] = i + bitScanForward(mask);
+    }
+#elif defined(__SSE2__)
+    __m128i const tab = _mm_set1_epi8('\t');
+    for (; i + 16 <= len && numEnds < maxEnds; i += 16)
+    {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<__m128i const *>(line + i));
+        __uint32 mask = static_cast<__uint32>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, tab)));
+        for (; mask != 0u && numEnds < maxEnds; mask &= mask - 1)
+            ends[numEnds++] = i + bitScanForward(mask);
+    }
+#endif
+
+    for (; i < len && numEnds < maxEnds; ++i)
+        if (line[i] == '\t')
+            ends[numEnds++] = i;
+
+    return numEnds;
+}
+
+// ----------------------------------------------------------------------------
+// Function _parseSamInteger()
+// ----------------------------------------------------------------------------
+
+// Parses a decimal number in [first, last).  Anything but an optional minus sign followed by at most 18 digits that
+// fit into TInteger is left to lexicalCast(), which throws the usual errors.
+template <typename TInteger>
+inline TInteger
+_parseSamInteger(char const * first, char const * last)
+{
+    char const * it = first;
+    bool negative = (it != last && *it == '-');
+    if (negative)
+        ++it;
+
+    __int64 result = 0;
+    if (it != last && last - it <= 18)
+    {
+        for (; it != last && static_cast<unsigned>(*it - '0') < 10u; ++it)
+            result = result * 10 + (*it - '0');
+    }
+
+    if (negative)
+        result = -result;
+
+    if (SEQAN_UNLIKELY(it != last || it == first + negative ||
+                       result < static_cast<__int64>(MinValue<TInteger>::VALUE) ||
+                       result > static_cast<__int64>(MaxValue<TInteger>::VALUE)))
+    {
+        CharString buffer;
+        for (; first != last; ++first)
+            appendValue(buffer, *first);
+        return lexicalCast<TInteger>(buffer);
+    }
+
+    return static_cast<TInteger>(result);
+}
+
 // ----------------------------------------------------------------------------
 // Function readRecord()                                     BamAlignmentRecord
 // ----------------------------------------------------------------------------
 
+// The line is read at once and split at its first 11 tabs by _findSamFieldEnds(), so the fields are parsed from
+// memory instead of character by character through the stream iterator.
 template <typename TForwardIter, typename TNameStore, typename TNameStoreCache, typename TStorageSpec>
 inline void
 readRecord(BamAlignmentRecord & record,
@@ -261,137 +346,108 @@ readRecord(BamAlignmentRecord & record,
     if (nextIs(iter, SamHeader()))
         SEQAN_THROW(ParseError("Unexpected SAM header encountered."));
 
-    OrFunctor<IsTab, AssertFunctor<NotFunctor<IsNewline>, ParseError, Sam> > nextEntry;
-
     clear(record);
     CharString &buffer = context.buffer;
+    clear(buffer);
+    readLine(buffer, iter);
+
+    // ends[i] is the tab after field i, the last field (QUAL) ends at the first tag or at the end of the line
+    size_t ends[11];
+    char const * line = begin(buffer, Standard());
+    size_t const len = length(buffer);
+    unsigned const numEnds = _findSamFieldEnds(ends, 11, line, len);
+
+    if (numEnds < 10)
+        SEQAN_THROW(ParseError("Unexpected end of line in SAM record."));
+    if (numEnds == 10)
+        ends[10] = len;
 
     // QNAME
-    readUntil(record.qName, iter, nextEntry);
-    skipOne(iter, IsTab());
+    assign(record.qName, infix(buffer, 0, ends[0]));
 
     // FLAG
     // TODO(holtgrew): Interpret hex and char as c-samtools -X does?
-    clear(buffer);
-    readUntil(buffer, iter, nextEntry);
-    record.flag = lexicalCast<__uint16>(buffer);
-    skipOne(iter, IsTab());
+    record.flag = _parseSamInteger<__uint16>(line + ends[0] + 1, line + ends[1]);
 
-    // RNAME
-    clear(buffer);
-    readUntil(buffer, iter, nextEntry);
-    if (buffer == "*")
+    // RNAME, looked up through record.tags, which is only filled at the end
+    if (ends[2] - ends[1] == 2 && line[ends[1] + 1] == '*')
+    {
         record.rID = BamAlignmentRecord::INVALID_REFID;
+    }
     else
-        record.rID = nameToId(contigNamesCache(context), buffer);
-    skipOne(iter, IsTab());
+    {
+        assign(record.tags, infix(buffer, ends[1] + 1, ends[2]));
+        record.rID = nameToId(contigNamesCache(context), record.tags);
+    }
 
     // POS
-    clear(buffer);
     SEQAN_ASSERT_EQ((__int32)0 - 1, (__int32)BamAlignmentRecord::INVALID_POS);
-    readUntil(buffer, iter, nextEntry);
-    record.beginPos = (__int32)lexicalCast<__uint32>(buffer) - 1;
-    skipOne(iter, IsTab());
+    record.beginPos = (__int32)_parseSamInteger<__uint32>(line + ends[2] + 1, line + ends[3]) - 1;
 
     // MAPQ
-    clear(buffer);
-    if (value(iter) == '*')
-    {
+    if (line[ends[3] + 1] == '*')
         record.mapQ = 255;
-        skipOne(iter);
-    }
     else
-    {
-        readUntil(buffer, iter, nextEntry);
-        record.mapQ = lexicalCast<__uint16>(buffer);
-    }
-    skipOne(iter, IsTab());
+        record.mapQ = _parseSamInteger<__uint16>(line + ends[3] + 1, line + ends[4]);
 
     // CIGAR
-    CigarElement<> element;
-    if (value(iter) == '*')
-        skipOne(iter);
-    else
+    if (line[ends[4] + 1] != '*')
     {
-        do
+        CigarElement<> element;
+        char const * it = line + ends[4] + 1;
+        char const * itEnd = line + ends[5];
+        while (it != itEnd)
         {
-            clear(buffer);
-            readUntil(buffer, iter, OrFunctor<IsAlpha, AssertFunctor<NotFunctor<IsNewline>, ParseError, Sam> >());
-            element.count = lexicalCast<__uint32>(buffer);
-            element.operation = value(iter);
-            skipOne(iter);
+            char const * opIt = it;
+            while (opIt != itEnd && static_cast<unsigned>(*opIt - '0') < 10u)
+                ++opIt;
+            if (opIt == itEnd)
+                SEQAN_THROW(ParseError("Missing CIGAR operation in SAM record."));
+            element.count = _parseSamInteger<__uint32>(it, opIt);
+            element.operation = *opIt;
             appendValue(record.cigar, element);
-        } while (value(iter) != '\t');
+            it = opIt + 1;
+        }
     }
-    skipOne(iter, IsTab());
 
     // RNEXT
-    clear(buffer);
-    readUntil(buffer, iter, nextEntry);
-    if (buffer == "*")
+    if (ends[6] - ends[5] == 2 && line[ends[5] + 1] == '*')
         record.rNextId = BamAlignmentRecord::INVALID_REFID;
-    else if (buffer == "=")
+    else if (ends[6] - ends[5] == 2 && line[ends[5] + 1] == '=')
         record.rNextId = record.rID;
     else
-        record.rNextId = nameToId(contigNamesCache(context), buffer);
-    skipOne(iter, IsTab());
+    {
+        assign(record.tags, infix(buffer, ends[5] + 1, ends[6]));
+        record.rNextId = nameToId(contigNamesCache(context), record.tags);
+    }
 
     // PNEXT
-    if (value(iter) == '*')
-    {
+    if (line[ends[6] + 1] == '*')
         record.pNext = BamAlignmentRecord::INVALID_POS;
-        skipOne(iter);
-    }
     else
-    {
-        clear(buffer);
-        readUntil(buffer, iter, nextEntry);
-        record.pNext = (__int32)lexicalCast<__uint32>(buffer) - 1;
-    }
-    skipOne(iter, IsTab());
+        record.pNext = (__int32)_parseSamInteger<__uint32>(line + ends[6] + 1, line + ends[7]) - 1;
 
     // TLEN
-    if (value(iter) == '*')
-    {
+    if (line[ends[7] + 1] == '*')
         record.tLen = MaxValue<__int32>::VALUE;
-        skipOne(iter);
-    }
     else
-    {
-        clear(buffer);
-        readUntil(buffer, iter, nextEntry);
-        record.tLen = lexicalCast<__int32>(buffer);
-    }
-    skipOne(iter, IsTab());
+        record.tLen = _parseSamInteger<__int32>(line + ends[7] + 1, line + ends[8]);
 
     // SEQ
-    readUntil(record.seq, iter, nextEntry);
     // Handle case of missing sequence:  Clear seq string as documented.
-    if (record.seq == "*")
-        clear(record.seq);
-    skipOne(iter, IsTab());
+    if (!(ends[9] - ends[8] == 2 && line[ends[8] + 1] == '*'))
+        assign(record.seq, infix(buffer, ends[8] + 1, ends[9]));
 
     // QUAL
-    readUntil(record.qual, iter, OrFunctor<IsTab, IsNewline>());
-
     // Handle case of missing quality:  Clear qual string as documented.
-    if (record.qual == "*")
-        clear(record.qual);
-
-    // The following list of tags is optional.  A line break or EOF could also follow.
-    if (atEnd(iter))
-        return;
-    if (value(iter) != '\t')
-    {
-        skipLine(iter);
-        return;
-    }
-    skipOne(iter, IsTab());
+    if (!(ends[10] - ends[9] == 2 && line[ends[9] + 1] == '*'))
+        assign(record.qual, infix(buffer, ends[9] + 1, ends[10]));
 
     // TAGS
-    clear(buffer);
-    readLine(buffer, iter);
-    appendTagsSamToBam(record.tags, buffer);
+    // The following list of tags is optional.
+    clear(record.tags);
+    if (ends[10] < len)
+        appendTagsSamToBam(record.tags, infix(buffer, ends[10] + 1, len));
 }
 
 }  // namespace seqan
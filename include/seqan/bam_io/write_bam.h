@@ -131,6 +131,52 @@ updateLengths(BamAlignmentRecord const & record)
 }
 
 
+template <typename TTarget>
+inline void
+_writeBamSeqAndQual(TTarget & target, BamAlignmentRecord const & record)
+{
+    typedef typename Iterator<IupacString const, Standard>::Type SEQAN_RESTRICT TSeqIter;
+    typedef typename Iterator<CharString const, Standard>::Type SEQAN_RESTRICT  TQualIter;
+
+    // seq
+    TSeqIter sit = begin(record.seq, Standard());
+    TSeqIter sitEnd = sit + (record._l_qseq & ~1);
+    while (sit != sitEnd)
+    {
+        unsigned char x = (ordValue(getValue(sit++)) << 4);
+        writeValue(target, x | ordValue(getValue(sit++)));
+    }
+    if (record._l_qseq & 1)
+        writeValue(target, ordValue(getValue(sit++)) << 4);
+
+    // qual
+    SEQAN_ASSERT_LEQ(length(record.qual), length(record.seq));
+    TQualIter qit = begin(record.qual, Standard());
+    TQualIter qitEnd = end(record.qual, Standard());
+    TQualIter qitVirtEnd = qit + record._l_qseq;
+    while (qit != qitEnd)
+        writeValue(target, *qit++ - '!');
+    for (; qit != qitVirtEnd; ++qit)
+        writeValue(target, '\xff');     // fill with zero qualities
+}
+
+// Contiguous output chunk, use the bulk encoders.
+template <typename TValue>
+inline void
+_writeBamSeqAndQual(TValue * & target, BamAlignmentRecord const & record)
+{
+    // seq
+    encodeBamSeq(target, record.seq);
+    target += (record._l_qseq + 1) / 2;
+
+    // qual
+    SEQAN_ASSERT_LEQ(length(record.qual), length(record.seq));
+    encodeBamQual(target, record.qual);
+    target += length(record.qual);
+    for (__int32 i = length(record.qual); i < record._l_qseq; ++i)
+        *target++ = '\xff';     // fill with zero qualities
+}
+
 template <typename TTarget>
 inline void
 _writeBamRecord(TTarget & target,
@@ -138,8 +184,6 @@ _writeBamRecord(TTarget & target,
                 Bam const & /*tag*/)
 {
     typedef typename Iterator<String<CigarElement<> > const, Standard>::Type SEQAN_RESTRICT TCigarIter;
-    typedef typename Iterator<IupacString const, Standard>::Type SEQAN_RESTRICT             TSeqIter;
-    typedef typename Iterator<CharString const, Standard>::Type SEQAN_RESTRICT              TQualIter;
 
     // bin_mq_nl
     unsigned l = 0;
@@ -177,26 +221,8 @@ _writeBamRecord(TTarget & target,
     for (TCigarIter cit = begin(record.cigar, Standard()); cit != citEnd; ++cit)
         appendRawPod(target, ((__uint32)cit->count << 4) | MAP[(unsigned char)cit->operation]);
 
-    // seq
-    TSeqIter sit = begin(record.seq, Standard());
-    TSeqIter sitEnd = sit + (record._l_qseq & ~1);
-    while (sit != sitEnd)
-    {
-        unsigned char x = (ordValue(getValue(sit++)) << 4);
-        writeValue(target, x | ordValue(getValue(sit++)));
-    }
-    if (record._l_qseq & 1)
-        writeValue(target, ordValue(getValue(sit++)) << 4);
-
-    // qual
-    SEQAN_ASSERT_LEQ(length(record.qual), length(record.seq));
-    TQualIter qit = begin(record.qual, Standard());
-    TQualIter qitEnd = end(record.qual, Standard());
-    TQualIter qitVirtEnd = qit + record._l_qseq;
-    while (qit != qitEnd)
-        writeValue(target, *qit++ - '!');
-    for (; qit != qitVirtEnd; ++qit)
-        writeValue(target, '\xff');     // fill with zero qualities
+    // seq and qual
+    _writeBamSeqAndQual(target, record);
 
     // tags
     write(target, record.tags);
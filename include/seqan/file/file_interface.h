@@ -133,6 +133,10 @@ class File;
  * @val FileOpenMode OPEN_TEMPORARY
  * @brief (Internal) Open automatically delete the file after close.  Use the <tt>openTemp</tt> methods to open
  *        temporary files.
+ *
+ * @val FileOpenMode OPEN_MMAP
+ * @brief Map an uncompressed input file into memory and read it without copying.  Ignored for compressed files,
+ *        pipes, and output files.
  */
 
 // --------------------------------------------------------------------------
@@ -148,6 +152,7 @@ enum FileOpenMode {
     OPEN_APPEND     = 8,
     OPEN_ASYNC      = 16,
     OPEN_TEMPORARY    = 32,
+    OPEN_MMAP         = 64,
     OPEN_QUIET        = 128
 }; //IOREV is it intended that two labels share the same value? What is OPEN_MASK anyway?
 
@@ -12,7 +12,16 @@
 // ===========================================================================
 
 #include <seqan/hts_io/hts_alignment_record.h>
+#include <seqan/hts_io/hts_thread_pool.h>
+#include <seqan/hts_io/hts_record_view.h>
 #include <seqan/hts_io/hts_file.h>
+#include <seqan/hts_io/hts_region_reader.h>
+#include <seqan/hts_io/hts_async_writer.h>
+#include <seqan/hts_io/hts_batch_reader.h>
+#include <seqan/hts_io/hts_record_batch.h>
+#include <seqan/hts_io/hts_pileup.h>
+#include <seqan/hts_io/hts_sort.h>
+#include <seqan/hts_io/hts_duplicate_marker.h>
 #include <seqan/hts_io/hts_alignment_record_utils.h>
 
 #endif // INCLUDE_SEQAN_HTS_IO_H_
@@ -89,151 +89,304 @@ join(std::vector<std::string> const & splitted_str, char const & delimiter)
 }
 
 
-template<typename TTagType>
-inline void
-printTag(TTagType & read_int, CharString const & tags, unsigned & i, std::stringstream & ss)
+/**
+ * @brief Writes the decimal representation of an integer, two digits at a time.
+ *
+ * @param out Output position, must have room for at least 20 characters.
+ * @param value The integer to write.
+ * @returns The position after the last written character.
+ */
+inline char *
+_formatSamInt(char * out, int64_t value)
 {
-  memcpy(&read_int, &tags[i], sizeof(TTagType));
-  ss << static_cast<int64_t>(read_int);
-  i += sizeof(TTagType);
-}
+  static char const DIGIT_PAIRS[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
 
+  uint64_t u = static_cast<uint64_t>(value);
 
-inline std::string
-toString(BamAlignmentRecord const & record, bam_hdr_t * hdr)
-{
-  std::stringstream ss;
-
-  if (!hdr)
+  if (value < 0)
   {
-    std::cerr << "ERROR: No header. Did you forget to read header?" << std::endl;
-    std::exit(1);
+    *out++ = '-';
+    u = ~u + 1;
   }
-  else if (record.rID >= hdr->n_targets)
+
+  char digits[20];
+  char * d = digits + sizeof(digits);
+
+  while (u >= 100)
   {
-    std::cerr << "ERROR: Invalid contig in BamAlignmentRecord with rID " << record.rID << std::endl;
-    std::exit(1);
+    unsigned const pair = static_cast<unsigned>(u % 100) * 2;
+    u /= 100;
+    *--d = DIGIT_PAIRS[pair + 1];
+    *--d = DIGIT_PAIRS[pair];
   }
 
-  std::string const chrom = record.rID == -1 ? "*" : hdr->target_name[record.rID];
-  ss << record.qName << '\t' << record.flag << '\t' << chrom << '\t' << record.beginPos+1 << '\t' << record.mapQ << '\t';
-
-  if (length(record.cigar) > 0)
+  if (u >= 10)
   {
-    for (auto print_it = begin(record.cigar); print_it != end(record.cigar); ++ print_it)
-      ss << print_it->count << print_it->operation;
+    *--d = DIGIT_PAIRS[u * 2 + 1];
+    *--d = DIGIT_PAIRS[u * 2];
   }
   else
   {
-    ss << "*";
+    *--d = static_cast<char>('0' + u);
   }
 
-  if (record.rNextId == -1)
-    ss << "\t*\t";
-  else if (record.rNextId == record.rID)
-    ss << "\t=\t";
-  else
-    ss << '\t' << hdr->target_name[record.rNextId] << '\t';
+  size_t const len = digits + sizeof(digits) - d;
+  memcpy(out, d, len);
+  return out + len;
+}
+
+
+inline char *
+_formatSamString(char * out, char const * str, size_t len)
+{
+  memcpy(out, str, len);
+  return out + len;
+}
+
+
+template <typename TInt>
+inline char *
+_emitSamIntTag(char * out, char const * & raw)
+{
+  TInt value;
+  memcpy(&value, raw, sizeof(TInt));
+  raw += sizeof(TInt);
+  return _formatSamInt(out, static_cast<int64_t>(value));
+}
+
+
+inline char *
+_emitSamFloatTag(char * out, char const * & raw)
+{
+  float value;
+  memcpy(&value, raw, sizeof(float));
+  raw += sizeof(float);
+  // "%g" is the default formatting of floats by std::ostream
+  return out + snprintf(out, 32, "%g", value);
+}
+
+
+inline char *
+_emitSamCharTag(char * out, char const * & raw)
+{
+  *out++ = *raw++;
+  return out;
+}
+
+
+inline char *
+_emitSamStringTag(char * out, char const * & raw)
+{
+  while (*raw != '\0' && *raw != '\t' && *raw != '\n')
+    *out++ = *raw++;
+
+  ++raw;
+  return out;
+}
+
+
+inline char *
+_emitSamArrayTag(char * out, char const * & raw)
+{
+  char const subtype = *raw++;
+  uint32_t count;
+  memcpy(&count, raw, sizeof(uint32_t));
+  raw += sizeof(uint32_t);
 
-  ss << record.pNext+1 << '\t' << record.tLen << '\t' << record.seq << '\t' << record.qual;
+  *out++ = subtype;
 
-  for (unsigned i = 0; i < length(record.tags);)
+  for (uint32_t i = 0; i < count; ++i)
   {
-    ss << '\t' << record.tags[i] << record.tags[i+1] << ':';
-    i += 3;
+    *out++ = ',';
 
-    switch(record.tags[i-1])
+    switch (subtype)
     {
-      case 'A':
-      {
-        /* A printable character */
-        ss << "A:" << record.tags[i];
-        ++i;
-        break;
-      }
+      case 'c': out = _emitSamIntTag<int8_t>(out, raw); break;
+      case 'C': out = _emitSamIntTag<uint8_t>(out, raw); break;
+      case 's': out = _emitSamIntTag<int16_t>(out, raw); break;
+      case 'S': out = _emitSamIntTag<uint16_t>(out, raw); break;
+      case 'i': out = _emitSamIntTag<int32_t>(out, raw); break;
+      case 'I': out = _emitSamIntTag<uint32_t>(out, raw); break;
+      case 'f': out = _emitSamFloatTag(out, raw); break;
+      default: SEQAN_THROW(ParseError("Unknown subtype of BAM array tag."));
+    }
+  }
 
-      case 'Z':
-      {
-        ss << "Z:";
+  return out;
+}
 
-        /* A string! Let's loop it until qNULL */
-        while (record.tags[i] != '\0' && record.tags[i] != '\t' && record.tags[i] != '\n')
-        {
-          ss << record.tags[i];
-          ++i;
-        }
 
-        ++i;
-        break;
-      }
+/**
+ * @brief Formats the value of a BAM tag of one type as SAM text.
+ */
+struct SamTagEmitter
+{
+  char const * prefix;  /** @brief SAM type and separator, e.g. "i:". nullptr for unsupported types. */
+  char * (*emit)(char * out, char const * & raw);  /** @brief Writes the value and advances the raw tag pointer. */
+};
 
-      case 'c':
-      {
-        ss << "i:";
-        int8_t read_int8 = 0;
-        printTag(read_int8, record.tags, i, ss);
-        break;
-      }
 
-      case 'C':
-      {
-        ss << "i:";
-        uint8_t read_uint8 = 0;
-        printTag(read_uint8, record.tags, i, ss);
-        break;
-      }
+/**
+ * @brief Returns the SAM tag emitters indexed by BAM tag type character.
+ */
+inline SamTagEmitter const *
+_samTagEmitters()
+{
+  struct Table
+  {
+    SamTagEmitter emitters[256];
 
-      case 's':
+    Table()
+    {
+      for (unsigned i = 0; i < 256; ++i)
       {
-        ss << "i:";
-        int16_t read_int16 = 0;
-        printTag(read_int16, record.tags, i, ss);
-        break;
+        emitters[i].prefix = nullptr;
+        emitters[i].emit = nullptr;
       }
 
-      case 'S':
-      {
-        ss << "i:";
-        uint16_t read_uint16 = 0;
-        printTag(read_uint16, record.tags, i, ss);
-        break;
-      }
+      set('A', "A:", &_emitSamCharTag);
+      set('Z', "Z:", &_emitSamStringTag);
+      set('H', "H:", &_emitSamStringTag);
+      set('B', "B:", &_emitSamArrayTag);
+      set('c', "i:", &_emitSamIntTag<int8_t>);
+      set('C', "i:", &_emitSamIntTag<uint8_t>);
+      set('s', "i:", &_emitSamIntTag<int16_t>);
+      set('S', "i:", &_emitSamIntTag<uint16_t>);
+      set('i', "i:", &_emitSamIntTag<int32_t>);
+      set('I', "I:", &_emitSamIntTag<uint32_t>);
+      set('f', "f:", &_emitSamFloatTag);
+    }
 
-      case 'i':
-      {
-        ss << "i:";
-        int32_t read_int32 = 0;
-        printTag(read_int32, record.tags, i, ss);
-        break;
-      }
+    void set(unsigned char type, char const * prefix, char * (*emit)(char *, char const * &))
+    {
+      emitters[type].prefix = prefix;
+      emitters[type].emit = emit;
+    }
+  };
 
-      case 'I':
-      {
-        ss << "I:";
-        uint32_t read_uint32 = 0;
-        printTag(read_uint32, record.tags, i, ss);
-        break;
-      }
+  static Table const table;
+  return table.emitters;
+}
 
-      case 'f':
-      {
-        ss << "f:";
-        float read_float = 0.0;
-        memcpy(&read_float, &record.tags[i], sizeof(float));
-        ss << read_float;
-        i += sizeof(float);
-        break;
-      }
 
-      default:
-      {
-        i = length(record.tags); // Unkown tag, stop
-        break;
-      }
+/**
+ * @brief Appends a record as a line of SAM text (without newline) to a buffer.
+ *
+ * The buffer is resized once to an upper bound of the line length and then written directly, so no allocations are
+ * made when a buffer is reused for many records. The text is the same as the one returned by toString().
+ *
+ * @param buffer The buffer to append to, e.g. a CharString or std::string.
+ * @param record The record to format.
+ * @param hdr The header of the file the record belongs to. Used to look up the contig names.
+ * @returns The number of appended characters.
+ * @throw IOError If hdr is nullptr.
+ * @throw ParseError If the record refers to a contig that is not in the header or has a malformed array tag.
+ */
+template <typename TBuffer>
+inline size_t
+appendSamRecord(TBuffer & buffer, BamAlignmentRecord const & record, bam_hdr_t * hdr)
+{
+  if (!hdr)
+    SEQAN_THROW(IOError("No header. Did you forget to read the header?"));
+  else if (record.rID >= hdr->n_targets || record.rNextId >= hdr->n_targets)
+    SEQAN_THROW(ParseError("Invalid contig id in BamAlignmentRecord."));
+
+  char const * chrom = record.rID == -1 ? "*" : hdr->target_name[record.rID];
+  char const * nextChrom = "*";
+
+  if (record.rNextId == record.rID && record.rNextId != -1)
+    nextChrom = "=";
+  else if (record.rNextId != -1)
+    nextChrom = hdr->target_name[record.rNextId];
+
+  size_t const chromLength = strlen(chrom);
+  size_t const nextChromLength = strlen(nextChrom);
+
+  // Integers have at most 20 characters, a tag value grows at most by a factor of 5 (e.g. ",-128" of a B:c array)
+  size_t const oldLength = length(buffer);
+  size_t const maxLength = length(record.qName) + chromLength + nextChromLength + 7 * 21 +
+                           11 * length(record.cigar) + 1 + length(record.seq) + length(record.qual) +
+                           5 * length(record.tags) + 32;
+
+  resize(buffer, oldLength + maxLength);
+  char * const first = &buffer[0] + oldLength;
+  char * out = first;
+
+  out = _formatSamString(out, toCString(record.qName), length(record.qName));
+  *out++ = '\t';
+  out = _formatSamInt(out, record.flag);
+  *out++ = '\t';
+  out = _formatSamString(out, chrom, chromLength);
+  *out++ = '\t';
+  out = _formatSamInt(out, static_cast<int64_t>(record.beginPos) + 1);
+  *out++ = '\t';
+  out = _formatSamInt(out, record.mapQ);
+  *out++ = '\t';
+
+  if (length(record.cigar) > 0)
+  {
+    for (auto cig = begin(record.cigar, Standard()); cig != end(record.cigar, Standard()); ++cig)
+    {
+      out = _formatSamInt(out, cig->count);
+      *out++ = cig->operation;
     }
   }
+  else
+  {
+    *out++ = '*';
+  }
 
-  return ss.str();
+  *out++ = '\t';
+  out = _formatSamString(out, nextChrom, nextChromLength);
+  *out++ = '\t';
+  out = _formatSamInt(out, static_cast<int64_t>(record.pNext) + 1);
+  *out++ = '\t';
+  out = _formatSamInt(out, record.tLen);
+  *out++ = '\t';
+
+  for (auto it = begin(record.seq, Standard()); it != end(record.seq, Standard()); ++it)
+    *out++ = convert<char>(*it);
+
+  *out++ = '\t';
+  out = _formatSamString(out, begin(record.qual, Standard()), length(record.qual));
+
+  SamTagEmitter const * emitters = _samTagEmitters();
+  char const * raw = begin(record.tags, Standard());
+  char const * rawEnd = end(record.tags, Standard());
+
+  while (raw < rawEnd)
+  {
+    *out++ = '\t';
+    *out++ = raw[0];
+    *out++ = raw[1];
+    *out++ = ':';
+
+    SamTagEmitter const & emitter = emitters[static_cast<unsigned char>(raw[2])];
+    raw += 3;
+
+    if (emitter.emit == nullptr)
+      break; // Unknown tag, stop
+
+    *out++ = emitter.prefix[0];
+    *out++ = emitter.prefix[1];
+    out = emitter.emit(out, raw);
+  }
+
+  size_t const appended = out - first;
+  resize(buffer, oldLength + appended);
+  return appended;
+}
+
+
+inline std::string
+toString(BamAlignmentRecord const & record, bam_hdr_t * hdr)
+{
+  std::string str;
+  appendSamRecord(str, record, hdr);
+  return str;
 }
 
 
@@ -261,22 +414,11 @@ parse(BamAlignmentRecord & record, bam1_t * hts_record)
   }
 
   // Parse sequence
-  resize(record.seq, record._l_qseq, Exact());
-
-  for (int i = 0; i < record._l_qseq; ++i)
-  {
-    record.seq[i] = "=ACMGRSVTWYHKDBN"[bam_seqi(it, i)];
-  }
-
+  decodeBamSeq(record.seq, it, record._l_qseq);
   it += (hts_record->core.l_qseq + 1) >> 1;
 
   // Parse qualities
-  resize(record.qual, record._l_qseq, Exact());
-
-  for (int i = 0; i < record._l_qseq; ++i, ++it)
-  {
-    record.qual[i] = static_cast<char>(*it + 33);
-  }
+  decodeBamQual(record.qual, it, record._l_qseq);
 
   it = bam_get_aux(hts_record);
   resize(record.tags, bam_get_l_aux(hts_record), Exact());
@@ -289,18 +431,21 @@ parse(BamAlignmentRecord & record, bam1_t * hts_record)
 inline bool
 parse(bam1_t * hts_record, bam_hdr_t * hdr, BamAlignmentRecord const & record)
 {
-  kstring_t * s = static_cast<kstring_t*>(calloc(1, sizeof(kstring_t)));
-  std::string str = toString(record, hdr);
-  ksprintf(s, "%s", str.data());
-  int ret = sam_parse1(s, hdr, hts_record);
+  // Let htslib parse the SAM text in place, sam_parse1 does not take ownership of the kstring
+  CharString str;
+  appendSamRecord(str, record, hdr);
+  appendValue(str, '\0');
 
-  free(s->s);
-  free(s);
+  kstring_t s;
+  s.l = length(str) - 1;
+  s.m = capacity(str);
+  s.s = begin(str, Standard());
+  int ret = sam_parse1(&s, hdr, hts_record);
 
   if (ret != 0)
   {
     std::cerr << "[seqan::hts_io.bam_alignment_record] ERROR parsing record:\n";
-    std::cerr << str << std::endl;
+    std::cerr << toCString(str) << std::endl;
     return false;
   }
 
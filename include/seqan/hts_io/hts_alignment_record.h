@@ -2,6 +2,7 @@
 #define SEQAN_HTS_IO_HTS_ALIGNMENT_RECORD_H_
 
 #include <seqan/basic.h>
+#include <seqan/bam_io/bam_sequence_codec.h>
 
 #include <cstdio>
 
@@ -35,21 +36,8 @@ class HtsSequenceRecord
     {
         qName = bam_get_qname(hts_record);
         int32_t lqseq = hts_record->core.l_qseq;
-        resize(seq, lqseq, Exact());
-        uint8_t* seqptr = bam_get_seq(hts_record);
-
-        for (int i = 0; i < lqseq; ++i)
-        {
-          seq[i] = "=ACMGRSVTWYHKDBN"[bam_seqi(seqptr, i)];
-        }
-
-        uint8_t* qualptr = bam_get_qual(hts_record);
-        resize(qual, lqseq, Exact());
-
-        for (int i = 0; i < lqseq; ++i, ++qualptr)
-        {
-            qual[i] = static_cast<char>(*qualptr + 33);
-        }
+        decodeBamSeq(seq, bam_get_seq(hts_record), lqseq);
+        decodeBamQual(qual, bam_get_qual(hts_record), lqseq);
     }
 };
 
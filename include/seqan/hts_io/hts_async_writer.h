@@ -0,0 +1,183 @@
+#ifndef SEQAN_HTS_IO_HTS_ASYNC_WRITER_H_
+#define SEQAN_HTS_IO_HTS_ASYNC_WRITER_H_
+
+#include <algorithm>
+#include <atomic>
+
+#include <seqan/basic.h>
+#include <seqan/parallel.h>
+#include <seqan/system.h>
+
+#include <htslib/hts.h>
+#include <htslib/sam.h>
+
+#include <seqan/hts_io/hts_file.h>
+
+
+namespace seqan
+{
+
+/**
+ * @brief Writes records of an opened HTS file on a background thread.
+ *
+ * Records are copied into a fixed number of record slots and handed to a writer thread through a bounded queue,
+ * which converts them to bam1_t and writes them with sam_write1. Records are written in the order they were
+ * submitted, also when several threads submit records. If all slots are in use the submitting thread waits, so the
+ * memory use is capped by the number of slots. The slots are reused, so no allocations are made once every slot has
+ * seen a record of typical size.
+ *
+ * The header has to be written before the writer is created and the file must not be used directly until the writer
+ * is closed.
+ */
+class HtsAsyncWriter
+{
+public:
+  typedef ConcurrentQueue<size_t, Suspendable<Limit> > TQueue;
+
+  HtsFile & file;                       /** @brief The file to write to. */
+  String<BamAlignmentRecord> records;   /** @brief The record slots. */
+  TQueue jobQueue;                      /** @brief Ids of slots to write, in the order of submission. */
+  TQueue idleQueue;                     /** @brief Ids of free slots. */
+  std::atomic<bool> ok;                 /** @brief False if any record could not be written. */
+  bool is_open;                         /** @brief True until the writer has been closed. */
+
+
+  struct WriterThread
+  {
+    HtsAsyncWriter * writer;
+
+    void operator()()
+    {
+      ScopedReadLock<TQueue> readLock(writer->jobQueue);
+      ScopedWriteLock<TQueue> writeLock(writer->idleQueue);
+
+      size_t slot;
+
+      // popFront returns false when the queue is empty and the writer has been closed
+      while (popFront(slot, writer->jobQueue))
+      {
+        if (writer->ok && !writeRecord(writer->file, writer->records[slot]))
+          writer->ok = false;
+
+        appendValue(writer->idleQueue, slot);
+      }
+    }
+  };
+
+  Thread<WriterThread> thread;          /** @brief The writer thread. */
+
+
+  /**
+   * @brief Starts a writer thread for an opened HTS file.
+   *
+   * @param f The opened HTS file, with its header already written.
+   * @param num_records Maximum number of records that are queued at the same time.
+   */
+  HtsAsyncWriter(HtsFile & f, size_t num_records = 1024)
+    : file(f), jobQueue(std::max<size_t>(1, num_records)), idleQueue(std::max<size_t>(1, num_records)), ok(true),
+    is_open(true)
+  {
+    num_records = std::max<size_t>(1, num_records);
+    resize(records, num_records, Exact());
+
+    lockWriting(jobQueue);
+    lockReading(idleQueue);
+    setReaderWriterCount(jobQueue, 1, 1);
+    setReaderWriterCount(idleQueue, 1, 1);
+
+    for (size_t i = 0; i < num_records; ++i)
+      appendValue(idleQueue, i);
+
+    thread.worker.writer = this;
+    run(thread);
+  }
+
+
+  /**
+   * @brief Writes all pending records and stops the writer thread.
+   */
+  ~HtsAsyncWriter()
+  {
+    close();
+  }
+
+
+  inline bool
+  close()
+  {
+    if (!is_open)
+      return ok;
+
+    unlockWriting(jobQueue);
+    waitFor(thread);
+    unlockReading(idleQueue);
+
+    is_open = false;
+    return ok;
+  }
+
+
+private:
+  HtsAsyncWriter(HtsAsyncWriter const &);
+  HtsAsyncWriter & operator=(HtsAsyncWriter const &);
+};
+
+
+/**
+ * @brief Queues a record to be written by the writer thread. Waits while the queue is full.
+ *
+ * May be called concurrently by several threads.
+ *
+ * @param writer The asynchronous writer.
+ * @param record The record to write. It is copied into a reused record slot.
+ * @returns False if the writer is closed or a previous record could not be written, otherwise true.
+ */
+inline bool
+writeRecord(HtsAsyncWriter & writer, BamAlignmentRecord const & record)
+{
+  size_t slot;
+
+  if (!writer.is_open || !writer.ok || !popFront(slot, writer.idleQueue))
+    return false;
+
+  writer.records[slot] = record;
+  return appendValue(writer.jobQueue, slot);
+}
+
+
+/**
+ * @brief Queues a record to be written by the writer thread, taking over its content instead of copying it.
+ *
+ * @param writer The asynchronous writer.
+ * @param record The record to write. It is left in a valid but unspecified state.
+ * @returns False if the writer is closed or a previous record could not be written, otherwise true.
+ */
+inline bool
+writeRecord(HtsAsyncWriter & writer, BamAlignmentRecord && record)
+{
+  size_t slot;
+
+  if (!writer.is_open || !writer.ok || !popFront(slot, writer.idleQueue))
+    return false;
+
+  swap(writer.records[slot], record);
+  return appendValue(writer.jobQueue, slot);
+}
+
+
+/**
+ * @brief Writes all queued records and stops the writer thread. The file can be used directly afterwards.
+ *
+ * @param writer The asynchronous writer.
+ * @returns True if every record was written successfully, otherwise false.
+ */
+inline bool
+close(HtsAsyncWriter & writer)
+{
+  return writer.close();
+}
+
+
+} // namespace seqan
+
+#endif // SEQAN_HTS_IO_HTS_ASYNC_WRITER_H_
@@ -0,0 +1,153 @@
+#ifndef SEQAN_HTS_IO_HTS_BATCH_READER_H_
+#define SEQAN_HTS_IO_HTS_BATCH_READER_H_
+
+#include <algorithm>
+
+#include <seqan/basic.h>
+#include <seqan/parallel.h>
+#include <seqan/system.h>
+
+#include <htslib/hts.h>
+#include <htslib/sam.h>
+
+#include <seqan/hts_io/hts_file.h>
+
+
+namespace seqan
+{
+
+/**
+ * @brief Reads batches of alignment records of an opened HTS file on a background thread.
+ *
+ * While the caller processes one batch, the reader thread already reads the next one into a second buffer (double
+ * buffering). Batches are handed over by swapping strings, so the records of a processed batch are reused for a
+ * later batch instead of being reallocated.
+ *
+ * The file must not be read directly while the batch reader exists.
+ */
+class HtsBatchReader
+{
+public:
+  typedef ConcurrentQueue<size_t, Suspendable<Limit> > TQueue;
+
+  HtsFile & file;                                   /** @brief The file to read from. */
+  size_t max_records;                               /** @brief Maximum number of records per batch. */
+  String<String<BamAlignmentRecord> > batches;      /** @brief The prefetch buffers. */
+  String<size_t> batch_sizes;                       /** @brief Number of records read into each prefetch buffer. */
+  TQueue emptyQueue;                                /** @brief Ids of buffers to read into. */
+  TQueue fullQueue;                                 /** @brief Ids of read buffers, in file order. */
+  bool is_open;                                     /** @brief True until the reader thread has been stopped. */
+
+
+  struct ReaderThread
+  {
+    HtsBatchReader * reader;
+
+    void operator()()
+    {
+      ScopedReadLock<TQueue> readLock(reader->emptyQueue);
+      ScopedWriteLock<TQueue> writeLock(reader->fullQueue);
+
+      size_t id;
+
+      // popFront returns false when the batch reader is closed before the end of the file
+      while (popFront(id, reader->emptyQueue))
+      {
+        size_t const numRecords = readRecords(reader->batches[id], reader->file, reader->max_records);
+        reader->batch_sizes[id] = numRecords;
+        appendValue(reader->fullQueue, id);
+
+        if (numRecords < reader->max_records)
+          return;
+      }
+    }
+  };
+
+  Thread<ReaderThread> thread;                      /** @brief The reader thread. */
+
+
+  /**
+   * @brief Starts reading batches of an opened HTS file.
+   *
+   * @param f The opened HTS file, with its header already read.
+   * @param num_records Number of records per batch.
+   * @param num_prefetched Number of batches that are read ahead of the batch being processed.
+   */
+  HtsBatchReader(HtsFile & f, size_t num_records, size_t num_prefetched = 1)
+    : file(f), max_records(num_records), emptyQueue(std::max<size_t>(1, num_prefetched)),
+    fullQueue(std::max<size_t>(1, num_prefetched)), is_open(true)
+  {
+    num_prefetched = std::max<size_t>(1, num_prefetched);
+    resize(batches, num_prefetched, Exact());
+    resize(batch_sizes, num_prefetched, 0, Exact());
+
+    lockWriting(emptyQueue);
+    lockReading(fullQueue);
+    setReaderWriterCount(emptyQueue, 1, 1);
+    setReaderWriterCount(fullQueue, 1, 1);
+
+    for (size_t i = 0; i < num_prefetched; ++i)
+      appendValue(emptyQueue, i);
+
+    thread.worker.reader = this;
+    run(thread);
+  }
+
+
+  /**
+   * @brief Stops the reader thread, after it has finished the batch it is currently reading.
+   */
+  ~HtsBatchReader()
+  {
+    close();
+  }
+
+
+  inline void
+  close()
+  {
+    if (!is_open)
+      return;
+
+    unlockWriting(emptyQueue);
+    waitFor(thread);
+    unlockReading(fullQueue);
+
+    is_open = false;
+  }
+
+
+private:
+  HtsBatchReader(HtsBatchReader const &);
+  HtsBatchReader & operator=(HtsBatchReader const &);
+};
+
+
+/**
+ * @brief Gets the next batch of records from a batch reader, and starts reading the following batch.
+ *
+ * The given records are swapped with the prefetched batch, i.e. their strings are reused for reading a later batch.
+ * Like readRecords() of an HtsFile, records has a length of at least the batch size.
+ *
+ * @param records The records to write to.
+ * @param reader The batch reader.
+ * @returns The number of records of the batch. 0 if the end of the file has been reached.
+ */
+inline size_t
+readRecords(String<BamAlignmentRecord> & records, HtsBatchReader & reader)
+{
+  size_t id;
+
+  if (!reader.is_open || !popFront(id, reader.fullQueue))
+    return 0;
+
+  swap(records, reader.batches[id]);
+  size_t const numRecords = reader.batch_sizes[id];
+  appendValue(reader.emptyQueue, id);
+  return numRecords;
+}
+
+
+} // namespace seqan
+
+#endif // SEQAN_HTS_IO_HTS_BATCH_READER_H_
@@ -0,0 +1,1035 @@
+#ifndef SEQAN_HTS_IO_HTS_DUPLICATE_MARKER_H_
+#define SEQAN_HTS_IO_HTS_DUPLICATE_MARKER_H_
+
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+#include <seqan/bam_io.h>
+
+#include <htslib/hts.h>
+#include <htslib/sam.h>
+
+#include <seqan/hts_io/hts_file.h>
+
+
+namespace seqan
+{
+
+/**
+ * @brief The 5' end of a read, including its clipped bases.
+ */
+struct HtsDupEnd_
+{
+  int32_t rID;
+  int32_t pos;
+  bool reverse;
+
+  bool operator==(HtsDupEnd_ const & other) const
+  {
+    return rID == other.rID && pos == other.pos && reverse == other.reverse;
+  }
+
+  bool operator<(HtsDupEnd_ const & other) const
+  {
+    if (rID != other.rID)
+      return static_cast<uint32_t>(rID) < static_cast<uint32_t>(other.rID);
+
+    if (pos != other.pos)
+      return pos < other.pos;
+
+    return reverse < other.reverse;
+  }
+};
+
+
+/**
+ * @brief Key of a group of duplicates: the library and the 5' ends of a fragment (end2 unused) or of a pair.
+ */
+struct HtsDupKey_
+{
+  uint32_t library;
+  HtsDupEnd_ end1;
+  HtsDupEnd_ end2;
+
+  bool operator==(HtsDupKey_ const & other) const
+  {
+    return library == other.library && end1 == other.end1 && end2 == other.end2;
+  }
+};
+
+
+struct HtsDupKeyHash_
+{
+  size_t operator()(HtsDupKey_ const & key) const
+  {
+    uint64_t h = key.library;
+    h = h * 0x9E3779B97F4A7C15ull + static_cast<uint32_t>(key.end1.rID);
+    h = h * 0x9E3779B97F4A7C15ull + static_cast<uint32_t>(key.end1.pos) * 2 + key.end1.reverse;
+    h = h * 0x9E3779B97F4A7C15ull + static_cast<uint32_t>(key.end2.rID);
+    h = h * 0x9E3779B97F4A7C15ull + static_cast<uint32_t>(key.end2.pos) * 2 + key.end2.reverse;
+    return static_cast<size_t>(h ^ (h >> 32));
+  }
+};
+
+
+/**
+ * @brief Key of a first mate waiting for its mate, like the key of a BamScannerCache.
+ */
+struct HtsDupMateKey_
+{
+  int32_t rID;
+  int32_t beginPos;
+  uint64_t qnameHash;
+
+  bool operator==(HtsDupMateKey_ const & other) const
+  {
+    return rID == other.rID && beginPos == other.beginPos && qnameHash == other.qnameHash;
+  }
+};
+
+
+struct HtsDupMateKeyHash_
+{
+  size_t operator()(HtsDupMateKey_ const & key) const
+  {
+    return std::hash<int32_t>()(key.rID) ^ std::hash<int32_t>()(key.beginPos) ^ std::hash<uint64_t>()(key.qnameHash);
+  }
+};
+
+
+/**
+ * @brief Reads with the same fragment key. They are duplicates of each other and of any pair with a read at this end.
+ */
+struct HtsDupFragmentGroup_
+{
+  String<uint64_t> members;   /** @brief Record numbers of the reads. */
+  uint64_t best;              /** @brief Record number of the read with the highest score. */
+  int64_t bestScore;
+  uint32_t numPaired;         /** @brief Number of reads with a mapped mate at this end. */
+  uint32_t numWaiting;        /** @brief Number of first mates at this end whose mates have not arrived yet. */
+  bool closing;               /** @brief True if the group is closed as soon as no first mate is waiting. */
+
+  HtsDupFragmentGroup_()
+    : best(0), bestScore(-1), numPaired(0), numWaiting(0), closing(false) {}
+};
+
+
+/**
+ * @brief Pairs with the same pair key.
+ */
+struct HtsDupPairGroup_
+{
+  String<Pair<uint64_t> > members;  /** @brief Record numbers of the first and second mates of the pairs. */
+  size_t best;                      /** @brief Index of the pair with the highest score. */
+  int64_t bestScore;
+
+  HtsDupPairGroup_()
+    : best(0), bestScore(-1) {}
+};
+
+
+/**
+ * @brief Fate of a distant first mate, which is passed on to its mate.
+ */
+struct HtsDupDistantMate_
+{
+  bool decided;
+  bool duplicate;
+  uint64_t waiting;   /** @brief Record number of the second mate waiting for the decision, or HTS_DUP_NONE. */
+  uint64_t first;     /** @brief Record number of the first mate. */
+};
+
+
+/**
+ * @brief An event of the sweep over the reference, which fires as soon as the input has passed (rID, pos).
+ */
+struct HtsDupEvent_
+{
+  enum Type
+  {
+    CLOSE_FRAGMENT_GROUP,
+    CLOSE_PAIR_GROUP,
+    CLOSE_DISTANT_GROUP,
+    EXPIRE_MATE,
+    EXPIRE_DISTANT_MATE
+  };
+
+  int32_t rID;
+  int32_t pos;
+  Type type;
+  HtsDupKey_ key;           /** @brief The group to close. */
+  HtsDupMateKey_ mateKey;   /** @brief The cache key of the first mate to expire. */
+  uint64_t record;          /** @brief The record number of the first mate to expire. */
+  std::string qName;        /** @brief The query name of the distant first mate to expire. */
+};
+
+
+struct HtsDupEventGreater_
+{
+  bool operator()(HtsDupEvent_ const & a, HtsDupEvent_ const & b) const
+  {
+    if (a.rID != b.rID)
+      return static_cast<uint32_t>(a.rID) > static_cast<uint32_t>(b.rID);
+
+    return a.pos > b.pos;
+  }
+};
+
+
+struct HtsDupPending_
+{
+  BamAlignmentRecord record;
+  HtsDupEnd_ end;
+  int64_t score;
+  bool decided;
+};
+
+
+static const uint64_t HTS_DUP_NONE = std::numeric_limits<uint64_t>::max();
+
+
+/**
+ * @brief Marks duplicate reads of a coordinate sorted stream of records in a single pass.
+ *
+ * Reads are duplicates if they come from the same library and their 5' ends, including clipped bases, are at the
+ * same reference position and strand. For pairs both 5' ends must match. Of each group of duplicates the read or pair
+ * with the highest sum of base qualities >= 15 is kept. Reads without a mapped mate are also duplicates if a read of
+ * a pair has the same 5' end. The duplicate flag (0x400) is set on the others and cleared on the kept reads.
+ * Secondary, supplementary and unmapped records are passed through unchanged.
+ *
+ * Records are handed out in input order once their group cannot get any further reads, so only a sliding window of
+ * records is kept in memory. A first mate is kept until its mate arrives, like in a BamScannerCache. Pairs with mates
+ * on different references or more than max_mate_distance bases apart are instead decided at their first mate, using
+ * the mate's position, strand and MC tag, and the second mate gets the same flag. This keeps the window bounded by
+ * max_mate_distance.
+ */
+class HtsDuplicateMarker
+{
+public:
+  typedef std::unordered_map<HtsDupKey_, HtsDupFragmentGroup_, HtsDupKeyHash_> TFragmentGroups;
+  typedef std::unordered_map<HtsDupKey_, HtsDupPairGroup_, HtsDupKeyHash_> TPairGroups;
+  typedef std::unordered_multimap<HtsDupMateKey_, uint64_t, HtsDupMateKeyHash_> TMateCache;
+  typedef std::priority_queue<HtsDupEvent_, std::vector<HtsDupEvent_>, HtsDupEventGreater_> TEvents;
+
+  std::deque<HtsDupPending_> pending;     /** @brief Records which have not been handed out yet, in input order. */
+  uint64_t first_record;                  /** @brief Record number of the first pending record. */
+  TFragmentGroups fragment_groups;
+  TPairGroups pair_groups;                /** @brief Groups of pairs with both mates in the window. */
+  TPairGroups distant_groups;             /** @brief Groups of pairs with distant mates, keyed by the first mate's end. */
+  TMateCache mate_cache;                  /** @brief First mates waiting for their mates. */
+  std::unordered_map<std::string, HtsDupDistantMate_> distant_mates;
+  TEvents events;
+  std::map<std::string, uint32_t> libraries;  /** @brief Library number of each read group of the header. */
+  int32_t rID;                            /** @brief Position of the last record. */
+  int32_t pos;
+  int32_t max_query_length;               /** @brief Longest read seen so far, including hard clipped bases. */
+  int32_t max_mate_distance;
+  uint64_t num_duplicates;                /** @brief Number of records marked as duplicates so far. */
+
+
+  /**
+   * @brief Constructs a duplicate marker.
+   *
+   * @param hdr The header of the input file. Libraries are read from the LB fields of its @RG lines.
+   * @param maxMateDistance Pairs with mates further apart are decided at the first mate.
+   */
+  HtsDuplicateMarker(bam_hdr_t const * hdr, int32_t maxMateDistance = 1000)
+    : first_record(0), rID(0), pos(std::numeric_limits<int32_t>::min()), max_query_length(0),
+    max_mate_distance(maxMateDistance), num_duplicates(0)
+  {
+    if (hdr != nullptr && hdr->text != nullptr)
+      _parseLibraries(std::string(hdr->text, hdr->l_text));
+  }
+
+
+private:
+  inline void
+  _parseLibraries(std::string const & text)
+  {
+    std::map<std::string, uint32_t> libraryIds;
+    size_t lineBegin = 0;
+
+    while (lineBegin < text.size())
+    {
+      size_t lineEnd = text.find('\n', lineBegin);
+
+      if (lineEnd == std::string::npos)
+        lineEnd = text.size();
+
+      if (text.compare(lineBegin, 4, "@RG\t") == 0)
+      {
+        std::string id;
+        std::string library;
+
+        for (size_t field = lineBegin + 4; field < lineEnd;)
+        {
+          size_t fieldEnd = std::min(text.find('\t', field), lineEnd);
+
+          if (text.compare(field, 3, "ID:") == 0)
+            id = text.substr(field + 3, fieldEnd - field - 3);
+          else if (text.compare(field, 3, "LB:") == 0)
+            library = text.substr(field + 3, fieldEnd - field - 3);
+
+          field = fieldEnd + 1;
+        }
+
+        // Read groups without a library share the library of reads without a read group
+        uint32_t libraryId = 0;
+
+        if (!library.empty())
+          libraryId = libraryIds.insert(std::make_pair(library, libraryIds.size() + 1)).first->second;
+
+        libraries[id] = libraryId;
+      }
+
+      lineBegin = lineEnd + 1;
+    }
+  }
+
+
+  HtsDuplicateMarker(HtsDuplicateMarker const &);
+  HtsDuplicateMarker & operator=(HtsDuplicateMarker const &);
+};
+
+
+/**
+ * @brief Returns the number of reference bases and the leading and trailing clipped bases of a CIGAR string.
+ */
+inline void
+_htsDupCigarLengths(int32_t & refLength, int32_t & leadingClip, int32_t & trailingClip, int32_t & queryLength,
+                    String<CigarElement<> > const & cigar)
+{
+  refLength = leadingClip = trailingClip = queryLength = 0;
+  bool aligned = false;
+
+  for (CigarElement<> const & element : cigar)
+  {
+    switch (element.operation)
+    {
+    case 'M': case '=': case 'X':
+      queryLength += element.count;
+      // fall through
+    case 'D': case 'N':
+      refLength += element.count;
+      aligned = true;
+      trailingClip = 0;
+      break;
+    case 'S': case 'H':
+      queryLength += element.count;
+      (aligned ? trailingClip : leadingClip) += element.count;
+      break;
+    case 'I':
+      queryLength += element.count;
+      break;
+    }
+  }
+}
+
+
+/**
+ * @brief Parses the CIGAR string of an MC tag.
+ */
+inline bool
+_htsDupParseCigar(String<CigarElement<> > & cigar, CharString const & str)
+{
+  clear(cigar);
+  uint32_t count = 0;
+
+  for (char c : str)
+  {
+    if (c >= '0' && c <= '9')
+    {
+      count = count * 10 + (c - '0');
+    }
+    else
+    {
+      appendValue(cigar, CigarElement<>(c, count));
+      count = 0;
+    }
+  }
+
+  return count == 0 && !empty(cigar);
+}
+
+
+/**
+ * @brief Returns the 5' end of an aligned read, including its clipped bases.
+ */
+inline HtsDupEnd_
+_htsDupEnd(int32_t rID, int32_t beginPos, bool reverse, String<CigarElement<> > const & cigar,
+           int32_t & queryLength)
+{
+  int32_t refLength, leadingClip, trailingClip;
+  _htsDupCigarLengths(refLength, leadingClip, trailingClip, queryLength, cigar);
+
+  HtsDupEnd_ end = {rID, reverse ? beginPos + std::max(refLength, 1) - 1 + trailingClip : beginPos - leadingClip,
+                    reverse};
+  return end;
+}
+
+
+/**
+ * @brief Returns the sum of the base qualities >= 15 of a read.
+ */
+inline int64_t
+_htsDupScore(BamAlignmentRecord const & record)
+{
+  int64_t score = 0;
+
+  for (char q : record.qual)
+  {
+    if (q - 33 >= 15)
+      score += q - 33;
+  }
+
+  return score;
+}
+
+
+inline uint64_t
+_htsDupNameHash(CharString const & qName)
+{
+  uint64_t hash = 14695981039346656037ull;
+
+  for (char c : qName)
+    hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+
+  return hash;
+}
+
+
+inline HtsDupPending_ &
+_pendingRecord(HtsDuplicateMarker & marker, uint64_t record)
+{
+  return marker.pending[record - marker.first_record];
+}
+
+
+/**
+ * @brief Sets the duplicate flag of a pending record and hands it out.
+ */
+inline void
+_decide(HtsDuplicateMarker & marker, uint64_t record, bool duplicate)
+{
+  HtsDupPending_ & entry = _pendingRecord(marker, record);
+
+  if (duplicate)
+  {
+    entry.record.flag |= BAM_FLAG_DUPLICATE;
+    ++marker.num_duplicates;
+  }
+
+  entry.decided = true;
+}
+
+
+/**
+ * @brief Returns the last position at which a read with the given 5' end can start.
+ */
+inline int32_t
+_htsDupLastBegin(HtsDuplicateMarker const & marker, HtsDupEnd_ const & end)
+{
+  // Reverse reads start before their 5' end, forward reads at most their clipped bases after it
+  return end.reverse ? end.pos : end.pos + marker.max_query_length;
+}
+
+
+/**
+ * @brief Schedules closing a group once the input has passed the given position.
+ */
+inline void
+_pushEvent(HtsDuplicateMarker & marker, HtsDupEvent_::Type type, HtsDupKey_ const & key, int32_t rID, int32_t pos)
+{
+  HtsDupEvent_ event;
+  event.rID = rID;
+  event.pos = pos;
+  event.type = type;
+  event.key = key;
+  event.mateKey.rID = event.mateKey.beginPos = 0;
+  event.mateKey.qnameHash = 0;
+  event.record = HTS_DUP_NONE;
+  marker.events.push(event);
+}
+
+
+inline HtsDupFragmentGroup_ &
+_fragmentGroup(HtsDuplicateMarker & marker, HtsDupKey_ const & key)
+{
+  auto inserted = marker.fragment_groups.insert(std::make_pair(key, HtsDupFragmentGroup_()));
+
+  if (inserted.second)
+    _pushEvent(marker, HtsDupEvent_::CLOSE_FRAGMENT_GROUP, key, key.end1.rID, _htsDupLastBegin(marker, key.end1));
+
+  return inserted.first->second;
+}
+
+
+inline void
+_addFragment(HtsDuplicateMarker & marker, uint32_t library, uint64_t record)
+{
+  HtsDupPending_ const & entry = _pendingRecord(marker, record);
+  HtsDupKey_ key = {library, entry.end, {0, 0, false}};
+  HtsDupFragmentGroup_ & group = _fragmentGroup(marker, key);
+
+  if (entry.score > group.bestScore)
+  {
+    group.best = record;
+    group.bestScore = entry.score;
+  }
+
+  appendValue(group.members, record);
+}
+
+
+inline void
+_addPairedEnd(HtsDuplicateMarker & marker, uint32_t library, HtsDupEnd_ const & end)
+{
+  HtsDupKey_ key = {library, end, {0, 0, false}};
+  ++_fragmentGroup(marker, key).numPaired;
+}
+
+
+/**
+ * @brief Adds a first mate whose mate is expected in the window. It counts as paired once its mate has arrived.
+ */
+inline void
+_addWaitingEnd(HtsDuplicateMarker & marker, uint32_t library, HtsDupEnd_ const & end)
+{
+  HtsDupKey_ key = {library, end, {0, 0, false}};
+  ++_fragmentGroup(marker, key).numWaiting;
+}
+
+
+inline void _closeFragmentGroup(HtsDuplicateMarker & marker, HtsDupKey_ const & key);
+
+
+/**
+ * @brief Resolves a waiting first mate, which is paired if its mate has arrived.
+ */
+inline void
+_resolveWaitingEnd(HtsDuplicateMarker & marker, uint32_t library, HtsDupEnd_ const & end, bool paired)
+{
+  HtsDupKey_ key = {library, end, {0, 0, false}};
+  auto it = marker.fragment_groups.find(key);
+
+  // A group is not closed while a first mate is waiting
+  SEQAN_ASSERT(it != marker.fragment_groups.end());
+  SEQAN_ASSERT_GT(it->second.numWaiting, 0u);
+  HtsDupFragmentGroup_ & group = it->second;
+  --group.numWaiting;
+
+  if (paired)
+    ++group.numPaired;
+
+  if (group.closing && group.numWaiting == 0)
+    _closeFragmentGroup(marker, key);
+}
+
+
+inline void
+_addPair(HtsDuplicateMarker::TPairGroups & groups, bool & inserted, HtsDupKey_ const & key, uint64_t first,
+         uint64_t second, int64_t score)
+{
+  auto it = groups.insert(std::make_pair(key, HtsDupPairGroup_()));
+  HtsDupPairGroup_ & group = it.first->second;
+  inserted = it.second;
+
+  if (score > group.bestScore)
+  {
+    group.best = length(group.members);
+    group.bestScore = score;
+  }
+
+  appendValue(group.members, Pair<uint64_t>(first, second));
+}
+
+
+inline void
+_closeFragmentGroup(HtsDuplicateMarker & marker, HtsDupKey_ const & key)
+{
+  auto it = marker.fragment_groups.find(key);
+
+  if (it == marker.fragment_groups.end())
+    return;
+
+  HtsDupFragmentGroup_ & group = it->second;
+
+  // Whether the fragments are duplicates of a pair is only known once the waiting first mates have their mates
+  if (group.numWaiting > 0)
+  {
+    group.closing = true;
+    return;
+  }
+
+  for (uint64_t record : group.members)
+    _decide(marker, record, group.numPaired > 0 || record != group.best);
+
+  marker.fragment_groups.erase(it);
+}
+
+
+inline void
+_closePairGroup(HtsDuplicateMarker & marker, HtsDuplicateMarker::TPairGroups & groups, HtsDupKey_ const & key)
+{
+  auto it = groups.find(key);
+
+  if (it == groups.end())
+    return;
+
+  HtsDupPairGroup_ const & group = it->second;
+
+  for (size_t i = 0; i < length(group.members); ++i)
+  {
+    bool const duplicate = i != group.best;
+    _decide(marker, group.members[i].i1, duplicate);
+
+    if (group.members[i].i2 != HTS_DUP_NONE)
+    {
+      _decide(marker, group.members[i].i2, duplicate);
+      continue;
+    }
+
+    // Pass the decision on to the distant mate
+    std::string const qName = toCString(_pendingRecord(marker, group.members[i].i1).record.qName);
+    auto mate = marker.distant_mates.find(qName);
+
+    if (mate == marker.distant_mates.end())
+      continue;
+
+    if (mate->second.waiting != HTS_DUP_NONE)
+    {
+      _decide(marker, mate->second.waiting, duplicate);
+      marker.distant_mates.erase(mate);
+    }
+    else
+    {
+      mate->second.decided = true;
+      mate->second.duplicate = duplicate;
+    }
+  }
+
+  groups.erase(it);
+}
+
+
+/**
+ * @brief Turns a first mate whose mate has not been found into a read without a mate.
+ */
+inline void
+_expireMate(HtsDuplicateMarker & marker, HtsDupEvent_ const & event)
+{
+  auto range = marker.mate_cache.equal_range(event.mateKey);
+
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    if (it->second != event.record)
+      continue;
+
+    marker.mate_cache.erase(it);
+    HtsDupPending_ const & entry = _pendingRecord(marker, event.record);
+    uint32_t const library = event.key.library;
+    _addFragment(marker, library, event.record);
+    _resolveWaitingEnd(marker, library, entry.end, false);
+    return;
+  }
+}
+
+
+/**
+ * @brief Forgets a distant first mate whose mate has not been found at its position.
+ */
+inline void
+_expireDistantMate(HtsDuplicateMarker & marker, HtsDupEvent_ const & event)
+{
+  auto mate = marker.distant_mates.find(event.qName);
+
+  // A mate that arrived is still waiting for the decision of its group
+  if (mate != marker.distant_mates.end() && mate->second.first == event.record &&
+      mate->second.waiting == HTS_DUP_NONE)
+    marker.distant_mates.erase(mate);
+}
+
+
+/**
+ * @brief Schedules a close event again if its group can still get reads.
+ *
+ * How far after its 5' end a forward read can start depends on the longest read seen so far. If a longer read has
+ * been seen since the event was scheduled, the group is closed later.
+ *
+ * @returns True if the event has been scheduled again.
+ */
+inline bool
+_postponeClose(HtsDuplicateMarker & marker, HtsDupEvent_ const & event)
+{
+  int32_t lastBegin = _htsDupLastBegin(marker, event.key.end1);
+
+  if (event.type == HtsDupEvent_::CLOSE_PAIR_GROUP)
+    lastBegin = std::max(lastBegin, _htsDupLastBegin(marker, event.key.end2));
+
+  if (lastBegin <= event.pos)
+    return false;
+
+  _pushEvent(marker, event.type, event.key, event.rID, lastBegin);
+  return true;
+}
+
+
+/**
+ * @brief Fires the events the input has passed.
+ */
+inline void
+_fireEvents(HtsDuplicateMarker & marker)
+{
+  while (!marker.events.empty())
+  {
+    HtsDupEvent_ const event = marker.events.top();
+
+    if (static_cast<uint32_t>(event.rID) > static_cast<uint32_t>(marker.rID) ||
+        (event.rID == marker.rID && event.pos >= marker.pos))
+      return;
+
+    marker.events.pop();
+
+    if (event.type != HtsDupEvent_::EXPIRE_MATE && event.type != HtsDupEvent_::EXPIRE_DISTANT_MATE &&
+        _postponeClose(marker, event))
+      continue;
+
+    switch (event.type)
+    {
+    case HtsDupEvent_::CLOSE_FRAGMENT_GROUP:
+      _closeFragmentGroup(marker, event.key);
+      break;
+    case HtsDupEvent_::CLOSE_PAIR_GROUP:
+      _closePairGroup(marker, marker.pair_groups, event.key);
+      break;
+    case HtsDupEvent_::CLOSE_DISTANT_GROUP:
+      _closePairGroup(marker, marker.distant_groups, event.key);
+      break;
+    case HtsDupEvent_::EXPIRE_MATE:
+      _expireMate(marker, event);
+      break;
+    case HtsDupEvent_::EXPIRE_DISTANT_MATE:
+      _expireDistantMate(marker, event);
+      break;
+    }
+  }
+}
+
+
+/**
+ * @brief Returns the library of a record from its RG tag.
+ */
+inline uint32_t
+_htsDupLibrary(HtsDuplicateMarker const & marker, BamAlignmentRecord const & record)
+{
+  if (marker.libraries.empty())
+    return 0;
+
+  BamTagsDict tags(const_cast<CharString &>(record.tags));
+  unsigned id;
+  CharString readGroup;
+
+  if (!findTagKey(id, tags, "RG") || !extractTagValue(readGroup, tags, id))
+    return 0;
+
+  auto it = marker.libraries.find(toCString(readGroup));
+  return it != marker.libraries.end() ? it->second : 0;
+}
+
+
+/**
+ * @brief Returns the cached first mate of a record, or the end of the cache.
+ */
+inline HtsDuplicateMarker::TMateCache::iterator
+_findFirstMate(HtsDuplicateMarker & marker, BamAlignmentRecord const & record, HtsDupMateKey_ const & mateKey)
+{
+  auto range = marker.mate_cache.equal_range(mateKey);
+
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    BamAlignmentRecord const & firstMate = _pendingRecord(marker, it->second).record;
+
+    if (firstMate.qName == record.qName && (firstMate.flag & BAM_FLAG_LAST) != (record.flag & BAM_FLAG_LAST))
+      return it;
+  }
+
+  return marker.mate_cache.end();
+}
+
+
+/**
+ * @brief Returns true if the mate of a record lies before it in the coordinate sorted input.
+ *
+ * If both mates start at the same position, the one that comes first in the input is the first mate, so the record
+ * is the second mate if its mate is already cached.
+ */
+inline bool
+_isSecondMate(HtsDuplicateMarker & marker, BamAlignmentRecord const & record, HtsDupMateKey_ const & mateKey)
+{
+  if (record.rNextId != record.rID)
+    return static_cast<uint32_t>(record.rNextId) < static_cast<uint32_t>(record.rID);
+
+  if (record.pNext != record.beginPos)
+    return record.pNext < record.beginPos;
+
+  return _findFirstMate(marker, record, mateKey) != marker.mate_cache.end();
+}
+
+
+/**
+ * @brief Adds a record to a duplicate marker.
+ *
+ * @param marker The duplicate marker.
+ * @param record The next record of the coordinate sorted input. Its content is taken over by the marker.
+ * @returns False if the record is not sorted after the previous one, otherwise true.
+ */
+inline bool
+pushRecord(HtsDuplicateMarker & marker, BamAlignmentRecord & record)
+{
+  if (static_cast<uint32_t>(record.rID) < static_cast<uint32_t>(marker.rID) ||
+      (record.rID == marker.rID && record.beginPos < marker.pos))
+  {
+    SEQAN_FAIL("Records are not sorted by coordinate");
+    return false;
+  }
+
+  marker.rID = record.rID;
+  marker.pos = record.beginPos;
+
+  bool const marked = (record.flag & (BAM_FLAG_UNMAPPED | BAM_FLAG_SECONDARY | BAM_FLAG_SUPPLEMENTARY)) == 0 &&
+                      record.rID >= 0 && !empty(record.cigar);
+  HtsDupEnd_ end = {0, 0, false};
+
+  // The record may start later after its 5' end than the reads before, which keeps the groups at its end open
+  if (marked)
+  {
+    int32_t queryLength;
+    end = _htsDupEnd(record.rID, record.beginPos, (record.flag & BAM_FLAG_RC) != 0, record.cigar, queryLength);
+    marker.max_query_length = std::max(marker.max_query_length, queryLength);
+  }
+
+  _fireEvents(marker);
+
+  uint64_t const id = marker.first_record + marker.pending.size();
+  marker.pending.emplace_back();
+  HtsDupPending_ & entry = marker.pending.back();
+  using std::swap;
+  swap(entry.record, record);
+  entry.decided = true;
+
+  if (!marked)
+    return true;
+
+  BamAlignmentRecord & rec = entry.record;
+  entry.end = end;
+  entry.score = _htsDupScore(rec);
+  entry.decided = false;
+  rec.flag &= ~BAM_FLAG_DUPLICATE;
+
+  uint32_t const library = _htsDupLibrary(marker, rec);
+
+  if ((rec.flag & BAM_FLAG_MULTIPLE) == 0 || (rec.flag & BAM_FLAG_NEXT_UNMAPPED) != 0 || rec.rNextId < 0)
+  {
+    _addFragment(marker, library, id);
+    return true;
+  }
+
+  bool const distant = rec.rNextId != rec.rID || std::abs(rec.pNext - rec.beginPos) > marker.max_mate_distance;
+  HtsDupMateKey_ mateKey = {rec.rNextId, rec.pNext, _htsDupNameHash(rec.qName)};
+
+  if (_isSecondMate(marker, rec, mateKey))
+  {
+    if (distant)
+    {
+      auto mate = marker.distant_mates.find(toCString(rec.qName));
+
+      if (mate != marker.distant_mates.end())
+      {
+        _addPairedEnd(marker, library, entry.end);
+
+        if (mate->second.decided)
+        {
+          _decide(marker, id, mate->second.duplicate);
+          marker.distant_mates.erase(mate);
+        }
+        else
+        {
+          mate->second.waiting = id;
+        }
+
+        return true;
+      }
+    }
+    else
+    {
+      auto it = _findFirstMate(marker, rec, mateKey);
+
+      if (it != marker.mate_cache.end())
+      {
+        uint64_t const firstId = it->second;
+        HtsDupPending_ const & firstMate = _pendingRecord(marker, firstId);
+        marker.mate_cache.erase(it);
+        _addPairedEnd(marker, library, entry.end);
+        _resolveWaitingEnd(marker, library, firstMate.end, true);
+
+        HtsDupKey_ key = {library, std::min(firstMate.end, entry.end), std::max(firstMate.end, entry.end)};
+        bool inserted;
+        _addPair(marker.pair_groups, inserted, key, firstId, id, firstMate.score + entry.score);
+
+        if (inserted)
+          _pushEvent(marker, HtsDupEvent_::CLOSE_PAIR_GROUP, key, rec.rID,
+                     std::max(_htsDupLastBegin(marker, key.end1), _htsDupLastBegin(marker, key.end2)));
+
+        return true;
+      }
+    }
+
+    // The first mate is missing from the input
+    _addFragment(marker, library, id);
+    return true;
+  }
+
+  if (distant)
+  {
+    // The pair is decided now, whether or not the mate is in the input
+    _addPairedEnd(marker, library, entry.end);
+
+    // Take the mate's 5' end from its position, strand and CIGAR string in the MC tag, if there is one
+    HtsDupEnd_ mateEnd = {rec.rNextId, rec.pNext, (rec.flag & BAM_FLAG_NEXT_RC) != 0};
+    BamTagsDict tags(rec.tags);
+    unsigned tagId;
+    CharString mateCigarStr;
+    String<CigarElement<> > mateCigar;
+
+    if (findTagKey(tagId, tags, "MC") && extractTagValue(mateCigarStr, tags, tagId) &&
+        _htsDupParseCigar(mateCigar, mateCigarStr))
+    {
+      int32_t mateQueryLength;
+      mateEnd = _htsDupEnd(rec.rNextId, rec.pNext, mateEnd.reverse, mateCigar, mateQueryLength);
+    }
+
+    HtsDupKey_ key = {library, entry.end, mateEnd};
+    bool inserted;
+    _addPair(marker.distant_groups, inserted, key, id, HTS_DUP_NONE, 2 * entry.score);
+
+    if (inserted)
+      _pushEvent(marker, HtsDupEvent_::CLOSE_DISTANT_GROUP, key, rec.rID, _htsDupLastBegin(marker, entry.end));
+
+    HtsDupDistantMate_ mate = {false, false, HTS_DUP_NONE, id};
+    marker.distant_mates[toCString(rec.qName)] = mate;
+
+    // Forget the first mate if its mate is missing from the input
+    HtsDupEvent_ event;
+    event.rID = rec.rNextId;
+    event.pos = rec.pNext;
+    event.type = HtsDupEvent_::EXPIRE_DISTANT_MATE;
+    event.mateKey = mateKey;
+    event.record = id;
+    event.qName = toCString(rec.qName);
+    marker.events.push(event);
+    return true;
+  }
+
+  // Keep the first mate until its mate arrives
+  _addWaitingEnd(marker, library, entry.end);
+  HtsDupMateKey_ cacheKey = {rec.rID, rec.beginPos, mateKey.qnameHash};
+  marker.mate_cache.insert(std::make_pair(cacheKey, id));
+
+  HtsDupEvent_ event;
+  event.rID = rec.rNextId;
+  event.pos = rec.pNext;
+  event.type = HtsDupEvent_::EXPIRE_MATE;
+  event.key.library = library;
+  event.mateKey = cacheKey;
+  event.record = id;
+  marker.events.push(event);
+  return true;
+}
+
+
+/**
+ * @brief Decides all remaining records at the end of the input.
+ *
+ * @param marker The duplicate marker.
+ */
+inline void
+flush(HtsDuplicateMarker & marker)
+{
+  // Pass all positions, which fires all events including those scheduled while firing
+  marker.rID = -1;
+  marker.pos = std::numeric_limits<int32_t>::max();
+  _fireEvents(marker);
+}
+
+
+/**
+ * @brief Takes the next record whose duplicate flag has been decided out of a duplicate marker.
+ *
+ * @param record The record to write to.
+ * @param marker The duplicate marker.
+ * @returns True if a record was taken, false if the next record is not decided yet or there are none.
+ */
+inline bool
+popRecord(BamAlignmentRecord & record, HtsDuplicateMarker & marker)
+{
+  if (marker.pending.empty() || !marker.pending.front().decided)
+    return false;
+
+  using std::swap;
+  swap(record, marker.pending.front().record);
+  marker.pending.pop_front();
+  ++marker.first_record;
+  return true;
+}
+
+
+/**
+ * @brief Copies a coordinate sorted HTS file and marks its duplicate reads. See HtsDuplicateMarker.
+ *
+ * @param out The output file, with its header already written.
+ * @param in The input file, with its header already read.
+ * @param maxMateDistance Pairs with mates further apart are decided at the first mate.
+ * @returns True on success, false if the input is not sorted or a record could not be written.
+ */
+inline bool
+markDuplicates(HtsFile & out, HtsFile & in, int32_t maxMateDistance = 1000)
+{
+  HtsDuplicateMarker marker(in.hdr, maxMateDistance);
+  BamAlignmentRecord record;
+
+  while (readRecord(record, in))
+  {
+    if (!pushRecord(marker, record))
+      return false;
+
+    while (popRecord(record, marker))
+    {
+      if (!writeRecord(out, record))
+        return false;
+    }
+  }
+
+  flush(marker);
+
+  while (popRecord(record, marker))
+  {
+    if (!writeRecord(out, record))
+      return false;
+  }
+
+  return true;
+}
+
+
+} // namespace seqan
+
+#endif // SEQAN_HTS_IO_HTS_DUPLICATE_MARKER_H_
@@ -7,9 +7,11 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <iostream>
+#include <string>
 #include <sys/types.h>
 
 #include <seqan/basic.h>
+#include <seqan/parallel.h>
 
 #include <htslib/hfile.h>
 #include <htslib/hts.h>
@@ -19,6 +21,8 @@
 
 #include <seqan/hts_io/bam_alignment_record.h>
 #include <seqan/hts_io/hts_alignment_record.h>
+#include <seqan/hts_io/hts_record_view.h>
+#include <seqan/hts_io/hts_thread_pool.h>
 
 
 namespace seqan
@@ -34,15 +38,18 @@ public:
   hts_idx_t * hts_index;    /** @brief The index of the file. */
   hts_itr_t * hts_iter;     /** @brief An iterator that iterates through a certain region in the HTS file. */
   const char * file_mode;   /** @brief Which file mode to use. E.g. "r" for reading and "wb" for writing binaries. */
+  HtsThreadPool * thread_pool; /** @brief A shared (de)compression thread pool or nullptr to (de)compress on the caller's thread. */
   bool at_end = false;
   bool read_all = true;
+  std::string index_filename; /** @brief Filename of an index that is built while writing, or empty if none is built. */
+  String<bam1_t *> record_pool; /** @brief HTS records that readRecords() reads into before decoding them. */
 
   /**
    * @brief Empty HTS file constructor
    */
   HtsFile(const char * mode = "r")
     : filename(""), fp(nullptr), hdr(nullptr), hts_record(nullptr), hts_index(nullptr), hts_iter(nullptr), file_mode(
-      mode), at_end(false)
+      mode), thread_pool(nullptr), at_end(false)
   {
     // Don't call open() yet, file name is not known
   }
@@ -58,7 +65,24 @@ public:
    */
   HtsFile(const char * f, const char * mode, const char * reference = "")
     : filename(f), fp(nullptr), hdr(nullptr), hts_record(nullptr), hts_index(nullptr), hts_iter(nullptr),
-    file_mode(mode), at_end(false)
+    file_mode(mode), thread_pool(nullptr), at_end(false)
+  {
+    open(reference);
+  }
+
+
+  /**
+   * @brief Constructs a new HtsFile object which (de)compresses using a shared thread pool.
+   *
+   * @param f The filename of the file.
+   * @param mode The file mode to use when opening the file.
+   * @param pool The thread pool to use. It must outlive the file.
+   * @param reference Reference FASTA file. Used for reading CRAM files.
+   * @return A new HtsFile object.
+   */
+  HtsFile(const char * f, const char * mode, HtsThreadPool & pool, const char * reference = "")
+    : filename(f), fp(nullptr), hdr(nullptr), hts_record(nullptr), hts_index(nullptr), hts_iter(nullptr),
+    file_mode(mode), thread_pool(&pool), at_end(false)
   {
     open(reference);
   }
@@ -69,20 +93,59 @@ public:
    */
   ~HtsFile()
   {
+    close();
+  }
+
+
+  /**
+   * @brief Closes the file and frees the header, record, iterator and index.
+   *
+   * If an index is built while writing, it is saved before the file is closed.
+   *
+   * @returns True on success, otherwise false.
+   */
+  inline bool
+  close()
+  {
+    bool ok = true;
+
+    if (fp && !index_filename.empty())
+    {
+      if (sam_idx_save(fp) < 0)
+      {
+        std::cerr << "[seqan::hts_io::HtsFile] ERROR: Could not save index " << index_filename << std::endl;
+        ok = false;
+      }
+
+      index_filename.clear();
+    }
+
     if (hdr)
       bam_hdr_destroy(hdr);
 
     if (hts_record)
       bam_destroy1(hts_record);
 
+    for (unsigned i = 0; i < length(record_pool); ++i)
+      bam_destroy1(record_pool[i]);
+
+    clear(record_pool);
+
     if (hts_iter)
       hts_itr_destroy(hts_iter);
 
     if (hts_index)
       hts_idx_destroy(hts_index);
 
-    if (fp)
-      hts_close(fp);
+    if (fp && hts_close(fp) < 0)
+      ok = false;
+
+    hdr = nullptr;
+    hts_record = nullptr;
+    hts_iter = nullptr;
+    hts_index = nullptr;
+    fp = nullptr;
+    return ok;
   }
 
 
@@ -98,6 +161,16 @@ public:
       return false;
     }
 
+    // Attach the shared thread pool before the header is read, such that BGZF blocks are already inflated by it
+    if (thread_pool != nullptr && isOpen(*thread_pool))
+    {
+      if (hts_set_thread_pool(fp, &thread_pool->pool) < 0)
+      {
+        SEQAN_FAIL("Could not attach thread pool to file with filename %s", filename);
+        return false;
+      }
+    }
+
     // Use a specific reference FASTA file (needed for reading CRAM with no reference in @SQ tags in header)
     if (reference != nullptr && reference[0] != '\0')
     {
@@ -137,6 +210,9 @@ public:
 
   HtsFileIn(const char * f)
     : HtsFile(f, "r") {}
+
+  HtsFileIn(const char * f, HtsThreadPool & pool)
+    : HtsFile(f, "r", pool) {}
 };
 
 class HtsFileOut : public HtsFile
@@ -147,6 +223,9 @@ public:
 
   HtsFileOut(const char * f, const char * mode = "wb")
     : HtsFile(f, mode) {}
+
+  HtsFileOut(const char * f, HtsThreadPool & pool, const char * mode = "wb")
+    : HtsFile(f, mode, pool) {}
 };
 
 
@@ -169,6 +248,45 @@ open(HtsFile & target, const char * f, const char * reference = nullptr)
 }
 
 
+/**
+ * @brief Opens a HTS file from filename and (de)compresses it using a shared thread pool.
+ *
+ * @param target An empty HtsFile object.
+ * @param f The filename to open from.
+ * @param pool The thread pool to use. It must outlive the file and may be shared with other files.
+ * @param reference Reference FASTA file. Used for reading CRAM files.
+ */
+inline bool
+open(HtsFile & target, const char * f, HtsThreadPool & pool, const char * reference = nullptr)
+{
+  target.filename = f;
+  target.thread_pool = &pool;
+  return target.open(reference);
+}
+
+
+/**
+ * @brief Attaches a shared thread pool to a HTS file.
+ *
+ * If the file is already open the pool is used for all following blocks, otherwise it is attached when the file is
+ * opened.
+ *
+ * @param file The HTS file.
+ * @param pool The thread pool to use. It must outlive the file and may be shared with other files.
+ * @returns True on success, otherwise false.
+ */
+inline bool
+setThreadPool(HtsFile & file, HtsThreadPool & pool)
+{
+  file.thread_pool = &pool;
+
+  if (file.fp == nullptr || !isOpen(pool))
+    return true;
+
+  return hts_set_thread_pool(file.fp, &pool.pool) >= 0;
+}
+
+
 /**
  * @brief Opens a HTS from stream (e.g. std::cin).
  *
@@ -272,6 +390,65 @@ buildIndex(HtsFile & file, const char * indexFileName, int min_shift = 0)
 }
 
 
+/**
+ * @brief Builds an index of an output file while its records are written.
+ *
+ * The index is built from the BGZF offsets of the records as they are written, and saved when the file is closed,
+ * so the file does not need to be read again by buildIndex(). Call it after writeHeader() and before the first
+ * record is written. The records have to be written in coordinate order.
+ *
+ * @param file The output file, with its header already written.
+ * @param indexFileName The filename of the index.
+ * @param min_shift 0 builds a BAI index, a positive value builds a CSI index with 2^min_shift bp linear bins.
+ *                  SAM and VCF based formats only support CSI.
+ * @returns True on success, otherwise false.
+ */
+inline bool
+initIndex(HtsFile & file, const char * indexFileName, int min_shift = 0)
+{
+  // htslib keeps the pointer to the index filename until the index is saved
+  file.index_filename = indexFileName;
+
+  if (sam_idx_init(file.fp, file.hdr, min_shift, file.index_filename.c_str()) < 0)
+  {
+    SEQAN_FAIL("Could not initialize index %s", indexFileName);
+    file.index_filename.clear();
+    return false;
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief Builds an index of an output file while its records are written, using the default index filename.
+ *
+ * @param file The output file, with its header already written.
+ * @param min_shift 0 builds a BAI index (<file>.bai), a positive value builds a CSI index (<file>.csi).
+ * @returns True on success, otherwise false.
+ */
+inline bool
+initIndex(HtsFile & file, int min_shift = 0)
+{
+  std::string indexFileName(file.filename);
+  indexFileName += min_shift > 0 ? ".csi" : ".bai";
+  return initIndex(file, indexFileName.c_str(), min_shift);
+}
+
+
+/**
+ * @brief Closes a HTS file. Saves the index if it has been built while writing.
+ *
+ * @param file The file to close.
+ * @returns True on success, otherwise false.
+ */
+inline bool
+close(HtsFile & file)
+{
+  return file.close();
+}
+
+
 /**
  * @brief Uses the index to go to a certain region of the HTS file.
  *
@@ -416,6 +593,69 @@ readRecord(BamAlignmentRecord & record, HtsFile & file)
 }
 
 
+/**
+ * @brief Reads the next record without decoding it.
+ *
+ * The view points into the file's record buffer and is invalidated by the next read from the file.
+ *
+ * @param view The view to point to the new record.
+ * @param file The file to read from.
+ * @returns True on success, otherwise false.
+ */
+inline bool
+readRecord(HtsRecordView & view, HtsFile & file)
+{
+  if (readRecord(file))
+  {
+    view.hts_record = file.hts_record;
+    return true;
+  }
+
+  view.hts_record = nullptr;
+  return false;
+}
+
+
+/**
+ * @brief Reads up to maxRecords alignment records.
+ *
+ * The HTS records are read serially into a pool of the file that is reused by subsequent calls, and are then decoded
+ * in parallel. Each record is decoded into its own slot, so the records keep the order of the file.
+ *
+ * Like readRecords() of a BamFileIn, the records string is only grown and never shrunk, such that the strings of the
+ * records are reused by subsequent calls.
+ *
+ * @param records The records to write to. Resized to at least maxRecords.
+ * @param file The file to read from.
+ * @param maxRecords Maximum number of records to read.
+ * @returns The number of records read. Less than maxRecords if the end of the file has been reached.
+ */
+template <typename TSpec, typename TSize>
+inline TSize
+readRecords(String<BamAlignmentRecord, TSpec> & records, HtsFile & file, TSize maxRecords)
+{
+  if (static_cast<TSize>(length(records)) < maxRecords)
+    resize(records, maxRecords, Exact());
+
+  while (static_cast<TSize>(length(file.record_pool)) < maxRecords)
+    appendValue(file.record_pool, bam_init1());
+
+  TSize numRecords = 0;
+
+  while (numRecords < maxRecords && sam_read1(file.fp, file.hdr, file.record_pool[numRecords]) >= 0)
+    ++numRecords;
+
+  if (numRecords < maxRecords)
+    file.at_end = true;
+
+  SEQAN_OMP_PRAGMA(parallel for schedule(static))
+  for (int i = 0; i < static_cast<int>(numRecords); ++i)
+    parse(records[i], file.record_pool[i]);
+
+  return numRecords;
+}
+
+
 /**
  * @brief Read the next record from a region and parse it to a sequence record.
  *
@@ -473,6 +713,38 @@ readRegion(BamAlignmentRecord & record, HtsFile & file)
 }
 
 
+/**
+ * @brief Reads the next record of the current region without decoding it.
+ *
+ * The view points into the file's record buffer and is invalidated by the next read from the file.
+ *
+ * @param view The view to point to the new record.
+ * @param file The file to read from.
+ * @returns True on success, otherwise false.
+ */
+inline bool
+readRegion(HtsRecordView & view, HtsFile & file)
+{
+  if (file.read_all)
+    return readRecord(view, file);
+
+  int ret = sam_itr_next(file.fp, file.hts_iter, file.hts_record);
+
+  if (ret >= 0)
+  {
+    view.hts_record = file.hts_record;
+    return true;
+  }
+
+  view.hts_record = nullptr;
+
+  if (ret < -1)
+    SEQAN_FAIL("Encountered a htslib error when reading file %s", file.filename);
+
+  return false;
+}
+
+
 /**
  * @brief Writes a HTS header to disk.
  *
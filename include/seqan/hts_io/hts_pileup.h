@@ -0,0 +1,467 @@
+#ifndef SEQAN_HTS_IO_HTS_PILEUP_H_
+#define SEQAN_HTS_IO_HTS_PILEUP_H_
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/parallel.h>
+#include <seqan/sequence.h>
+
+#include <htslib/hts.h>
+#include <htslib/sam.h>
+
+#include <seqan/hts_io/hts_file.h>
+#include <seqan/hts_io/hts_region_reader.h>
+
+
+namespace seqan
+{
+
+/**
+ * @brief Flags of a read at a pileup column.
+ */
+enum PileupFlags
+{
+  PILEUP_REVERSE    = 0x01,  /** @brief The read is mapped to the reverse strand. */
+  PILEUP_READ_BEGIN = 0x02,  /** @brief The column is the first reference position of the read. */
+  PILEUP_READ_END   = 0x04   /** @brief The column is the last reference position of the read. */
+};
+
+
+/**
+ * @brief Base code of a read which has a deletion at a pileup column. The other base codes are Iupac ordinals.
+ */
+static const uint8_t PILEUP_DELETION = 16;
+
+/**
+ * @brief Number of distinct base codes, i.e. the 16 Iupac codes and PILEUP_DELETION.
+ */
+static const uint8_t PILEUP_NUM_CODES = 17;
+
+
+/**
+ * @brief The reads covering one reference position.
+ *
+ * The i-th read of the column is described by the i-th entry of each string.
+ */
+class PileupColumn
+{
+public:
+  int32_t rID;                                  /** @brief Reference id of the column. */
+  int32_t pos;                                  /** @brief 0-based reference position of the column. */
+  String<uint8_t> bases;                        /** @brief Iupac ordinal of each read's base, or PILEUP_DELETION. */
+  String<uint8_t> quals;                        /** @brief PHRED base quality of each read, 0 for deletions. */
+  String<uint8_t> flags;                        /** @brief PileupFlags of each read. */
+  String<int32_t> indels;                       /** @brief Length of an insertion (> 0) or deletion (< 0) following
+                                                           the column in each read, 0 if there is none. */
+  String<BamAlignmentRecord const *> records;   /** @brief The reads. Valid until the next column is read. */
+
+  PileupColumn()
+    : rID(-1), pos(-1) {}
+};
+
+
+/**
+ * @brief Number of reads of a pileup column.
+ */
+inline size_t
+length(PileupColumn const & column)
+{
+  return length(column.bases);
+}
+
+
+/**
+ * @brief Counts the base codes of a pileup column.
+ *
+ * Each code is counted in its own pass over the contiguous bases of the column. The passes are branch free and are
+ * vectorized by the compiler, which is faster than a scattered histogram update for typical column depths.
+ *
+ * @param counts Resized to PILEUP_NUM_CODES. counts[ordValue(Iupac(c))] is the number of reads with base c,
+ *               counts[PILEUP_DELETION] the number of reads with a deletion.
+ * @param column The column to count.
+ */
+template <typename TSpec>
+inline void
+countBases(String<uint32_t, TSpec> & counts, PileupColumn const & column)
+{
+  resize(counts, PILEUP_NUM_CODES, Exact());
+
+  uint8_t const * bases = begin(column.bases, Standard());
+  size_t const n = length(column.bases);
+
+  for (uint8_t code = 0; code < PILEUP_NUM_CODES; ++code)
+  {
+    uint32_t count = 0;
+
+    for (size_t i = 0; i < n; ++i)
+      count += bases[i] == code;
+
+    counts[code] = count;
+  }
+}
+
+
+/**
+ * @brief Walks over the reads of a coordinate sorted HTS file and produces one column per covered reference position.
+ *
+ * Only the reads overlapping the current position are kept in memory, up to a maximum depth. Reads starting at a
+ * position which is already covered by the maximum number of reads are skipped. The memory of finished reads is
+ * reused for the following reads.
+ *
+ * The pileup reads with readRegion(), so it covers the current region of the file if one has been set with
+ * setRegion(). The file must not be read directly while the pileup is used.
+ */
+class HtsPileup
+{
+public:
+  struct ActiveRead
+  {
+    BamAlignmentRecord record;
+    unsigned cigarIdx;      /** @brief Current CIGAR operation. */
+    uint32_t opOffset;      /** @brief Offset of the current position in the current CIGAR operation. */
+    int32_t queryPos;       /** @brief Current position in the read sequence. */
+    bool finished;          /** @brief True if the read does not cover any further position. */
+  };
+
+  HtsFile & file;                       /** @brief The file to read from. */
+  String<ActiveRead> reads;             /** @brief Reads covering the current position, followed by unused slots. */
+  size_t numActive;                     /** @brief Number of reads covering the current position. */
+  BamAlignmentRecord next;              /** @brief The next read from the file that is not active yet. */
+  bool hasNext;                         /** @brief False if the end of the file or region has been reached. */
+  int32_t rID;                          /** @brief Reference id of the next column. */
+  int32_t pos;                          /** @brief Reference position of the next column. */
+  size_t max_depth;                     /** @brief Maximum number of reads of a column. */
+  uint16_t flag_mask;                   /** @brief Reads with any of these flags are skipped. */
+  int32_t region_begin;                 /** @brief Columns before this position are skipped. */
+  int32_t region_end;                   /** @brief Columns from this position on are skipped. */
+
+
+  /**
+   * @brief Starts a pileup of an opened HTS file.
+   *
+   * @param f The opened HTS file, with its header already read and optionally a region set.
+   * @param maxDepth Maximum number of reads of a column.
+   * @param flagMask Reads with any of these flags are skipped. Defaults to unmapped, secondary, QC failed and
+   *                 duplicate reads.
+   */
+  HtsPileup(HtsFile & f,
+            size_t maxDepth = 8000,
+            uint16_t flagMask = BAM_FLAG_UNMAPPED | BAM_FLAG_SECONDARY | BAM_FLAG_QC_NO_PASS | BAM_FLAG_DUPLICATE)
+    : file(f), numActive(0), hasNext(false), rID(-1), pos(0), max_depth(maxDepth), flag_mask(flagMask),
+    region_begin(0), region_end(std::numeric_limits<int32_t>::max())
+  {}
+
+private:
+  HtsPileup(HtsPileup const &);
+  HtsPileup & operator=(HtsPileup const &);
+};
+
+
+/**
+ * @brief Swaps two active reads without copying their records.
+ */
+inline void
+_swapActiveRead(HtsPileup::ActiveRead & lhs, HtsPileup::ActiveRead & rhs)
+{
+  using std::swap;
+  swap(lhs.record, rhs.record);
+  std::swap(lhs.cigarIdx, rhs.cigarIdx);
+  std::swap(lhs.opOffset, rhs.opOffset);
+  std::swap(lhs.queryPos, rhs.queryPos);
+  std::swap(lhs.finished, rhs.finished);
+}
+
+
+/**
+ * @brief Reads the next record that passes the flag mask into the lookahead record of a pileup.
+ */
+inline void
+_pileupReadNext(HtsPileup & pileup)
+{
+  while ((pileup.hasNext = readRegion(pileup.next, pileup.file)))
+  {
+    if ((pileup.next.flag & pileup.flag_mask) == 0 && pileup.next.rID >= 0 && !empty(pileup.next.cigar))
+      return;
+  }
+}
+
+
+/**
+ * @brief Skips the CIGAR operations of a read that do not consume the reference.
+ */
+inline void
+_pileupSkipToReference(HtsPileup::ActiveRead & read)
+{
+  String<CigarElement<> > const & cigar = read.record.cigar;
+
+  for (; read.cigarIdx < length(cigar); ++read.cigarIdx)
+  {
+    char const op = cigar[read.cigarIdx].operation;
+
+    if (cigar[read.cigarIdx].count > 0 && (op == 'M' || op == '=' || op == 'X' || op == 'D' || op == 'N'))
+      return;
+
+    if (op == 'I' || op == 'S')
+      read.queryPos += cigar[read.cigarIdx].count;
+  }
+
+  read.finished = true;
+}
+
+
+/**
+ * @brief Moves a read to the next reference position.
+ */
+inline void
+_pileupAdvance(HtsPileup::ActiveRead & read)
+{
+  CigarElement<> const & element = read.record.cigar[read.cigarIdx];
+
+  if (element.operation != 'D' && element.operation != 'N')
+    ++read.queryPos;
+
+  if (++read.opOffset == element.count)
+  {
+    ++read.cigarIdx;
+    read.opOffset = 0;
+    _pileupSkipToReference(read);
+  }
+}
+
+
+/**
+ * @brief Appends the state of a read at the current position to a column and moves the read to the next position.
+ */
+inline void
+_pileupAppendRead(PileupColumn & column, HtsPileup::ActiveRead & read, int32_t pos)
+{
+  BamAlignmentRecord const & record = read.record;
+  CigarElement<> const & element = record.cigar[read.cigarIdx];
+
+  if (element.operation == 'N')
+  {
+    // Reference skips, e.g. introns, are not part of the column
+    _pileupAdvance(read);
+    return;
+  }
+
+  uint8_t base = PILEUP_DELETION;
+  uint8_t qual = 0;
+
+  if (element.operation != 'D')
+  {
+    base = read.queryPos < static_cast<int32_t>(length(record.seq)) ? ordValue(record.seq[read.queryPos])
+                                                                   : ordValue(Iupac('N'));
+
+    if (length(record.qual) == length(record.seq) && read.queryPos < static_cast<int32_t>(length(record.qual)))
+      qual = static_cast<uint8_t>(record.qual[read.queryPos] - 33);
+  }
+
+  // An insertion or deletion following the last base of a match
+  int32_t indel = 0;
+
+  if (read.opOffset + 1 == element.count && read.cigarIdx + 1 < length(record.cigar))
+  {
+    CigarElement<> const & following = record.cigar[read.cigarIdx + 1];
+
+    if (following.operation == 'I')
+      indel = following.count;
+    else if (following.operation == 'D' && element.operation != 'D')
+      indel = -static_cast<int32_t>(following.count);
+  }
+
+  uint8_t flags = (record.flag & BAM_FLAG_RC) ? PILEUP_REVERSE : 0;
+
+  if (pos == record.beginPos)
+    flags |= PILEUP_READ_BEGIN;
+
+  _pileupAdvance(read);
+
+  if (read.finished)
+    flags |= PILEUP_READ_END;
+
+  appendValue(column.bases, base);
+  appendValue(column.quals, qual);
+  appendValue(column.flags, flags);
+  appendValue(column.indels, indel);
+  appendValue(column.records, &record);
+}
+
+
+/**
+ * @brief Reads the next column of a pileup.
+ *
+ * Columns without reads are skipped, so the positions of consecutive columns may have gaps.
+ *
+ * @param column The column to write to. Its strings are reused.
+ * @param pileup The pileup to read from.
+ * @returns True if a column was read, false at the end of the file or region.
+ */
+inline bool
+readColumn(PileupColumn & column, HtsPileup & pileup)
+{
+  if (pileup.rID == -1)
+  {
+    _pileupReadNext(pileup);
+    pileup.rID = pileup.hasNext ? pileup.next.rID : -1;
+  }
+
+  while (true)
+  {
+    // Drop the reads that ended at the previous column, keeping the order of the others and their memory.
+    size_t numActive = 0;
+
+    for (size_t i = 0; i < pileup.numActive; ++i)
+    {
+      if (pileup.reads[i].finished)
+        continue;
+
+      if (numActive != i)
+        _swapActiveRead(pileup.reads[numActive], pileup.reads[i]);
+
+      ++numActive;
+    }
+
+    pileup.numActive = numActive;
+
+    if (pileup.numActive == 0)
+    {
+      if (!pileup.hasNext)
+        return false;
+
+      pileup.rID = pileup.next.rID;
+      pileup.pos = std::max(pileup.next.beginPos, pileup.region_begin);
+    }
+
+    if (pileup.pos >= pileup.region_end)
+      return false;
+
+    // Activate the reads starting at the current column
+    while (pileup.hasNext && pileup.next.rID == pileup.rID && pileup.next.beginPos <= pileup.pos)
+    {
+      if (pileup.numActive < pileup.max_depth)
+      {
+        if (length(pileup.reads) == pileup.numActive)
+          resize(pileup.reads, pileup.numActive + 1);
+
+        HtsPileup::ActiveRead & read = pileup.reads[pileup.numActive];
+        using std::swap;
+        swap(read.record, pileup.next);
+        read.cigarIdx = 0;
+        read.opOffset = 0;
+        read.queryPos = 0;
+        read.finished = false;
+        _pileupSkipToReference(read);
+
+        // Reads starting before the current column, e.g. at the begin of a region, are moved to it
+        for (int32_t p = read.record.beginPos; p < pileup.pos && !read.finished; ++p)
+          _pileupAdvance(read);
+
+        if (!read.finished)
+          ++pileup.numActive;
+      }
+
+      _pileupReadNext(pileup);
+    }
+
+    clear(column.bases);
+    clear(column.quals);
+    clear(column.flags);
+    clear(column.indels);
+    clear(column.records);
+    column.rID = pileup.rID;
+    column.pos = pileup.pos;
+
+    for (size_t i = 0; i < pileup.numActive; ++i)
+      _pileupAppendRead(column, pileup.reads[i], pileup.pos);
+
+    ++pileup.pos;
+
+    if (!empty(column.bases))
+      return true;
+  }
+}
+
+
+/**
+ * @brief Computes the pileup of a list of regions of an indexed BAM/CRAM file using several threads.
+ *
+ * Like readRegions(), every thread reads through its own file handle and the index is shared. The callback is called
+ * as callback(regionId, column) for each column inside a region. It may be called concurrently from different
+ * threads, but never concurrently for the same region. Columns of one region are passed in position order.
+ *
+ * @param file An opened HTS file.
+ * @param regions A sequence of regions, each on one of these formats: chrX, chrX:A, or chrX:A-B.
+ * @param callback Functor called for each column.
+ * @param numThreads Number of worker threads. Without OpenMP the regions are processed one after another.
+ * @param maxDepth Maximum number of reads of a column.
+ * @param reference Reference FASTA file. Used for reading CRAM files.
+ * @returns True on success, otherwise false.
+ */
+template <typename TRegions, typename TCallback>
+inline bool
+pileupRegions(HtsFile & file,
+              TRegions const & regions,
+              TCallback && callback,
+              unsigned numThreads = 1,
+              size_t maxDepth = 8000,
+              const char * reference = nullptr)
+{
+  if (file.hts_index == nullptr && !loadIndex(file))
+  {
+    SEQAN_FAIL("Could not load index of file with filename %s", file.filename);
+    return false;
+  }
+
+  int const numRegions = length(regions);
+  String<bool> regionOk;
+  resize(regionOk, numRegions, true, Exact());
+
+  numThreads = std::max(1u, numThreads);
+  std::vector<std::unique_ptr<HtsFile> > workers(numThreads);
+
+  SEQAN_OMP_PRAGMA(parallel for schedule(dynamic) num_threads(numThreads))
+  for (int i = 0; i < numRegions; ++i)
+  {
+    HtsFile * worker = _openRegionWorker(workers[omp_get_thread_num()], file, reference);
+
+    if (worker == nullptr || !setRegion(*worker, toCString(regions[i])))
+    {
+      regionOk[i] = false;
+      continue;
+    }
+
+    // Columns of reads overlapping the region boundaries are clipped to the region
+    HtsPileup pileup(*worker, maxDepth);
+
+    if (!worker->read_all)
+    {
+      pileup.region_begin = worker->hts_iter->beg;
+      pileup.region_end = std::min<int64_t>(worker->hts_iter->end, std::numeric_limits<int32_t>::max());
+    }
+
+    PileupColumn column;
+
+    while (readColumn(column, pileup))
+      callback(i, static_cast<PileupColumn const &>(column));
+  }
+
+  _closeRegionWorkers(workers, file);
+
+  for (int i = 0; i < numRegions; ++i)
+  {
+    if (!regionOk[i])
+      return false;
+  }
+
+  return true;
+}
+
+
+} // namespace seqan
+
+#endif // SEQAN_HTS_IO_HTS_PILEUP_H_
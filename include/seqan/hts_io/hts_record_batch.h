@@ -0,0 +1,387 @@
+#ifndef SEQAN_HTS_IO_HTS_RECORD_BATCH_H_
+#define SEQAN_HTS_IO_HTS_RECORD_BATCH_H_
+
+#include <cstring>
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+#include <seqan/bam_io/bam_alignment_record.h>
+#include <seqan/bam_io/bam_sequence_codec.h>
+
+#include <htslib/hts.h>
+#include <htslib/sam.h>
+
+#include <seqan/hts_io/hts_file.h>
+
+
+namespace seqan
+{
+
+class BamRecordBatch;
+inline void clear(BamRecordBatch & batch);
+
+
+/**
+ * @brief A batch of alignment records stored column by column.
+ *
+ * The fixed length fields of all records are stored in one array per field. The variable length fields are
+ * concatenated into one string per field, and the i-th record's part is [begins[i], begins[i + 1]). Sequences are
+ * stored packed with two bases per byte like in BAM, qualities as raw PHRED values and tags in their binary BAM
+ * representation.
+ *
+ * A batch allocates only when one of its strings has to grow, so reading many batches into the same object does not
+ * allocate per record.
+ */
+class BamRecordBatch
+{
+public:
+  /* Fixed length fields, one entry per record */
+  String<int32_t> rID;              /** @brief Reference ids. */
+  String<int32_t> beginPos;         /** @brief 0-based begin positions. */
+  String<uint16_t> flag;            /** @brief Flags. */
+  String<uint8_t> mapQ;             /** @brief Mapping qualities. */
+  String<uint16_t> bin;             /** @brief BAI bins. */
+  String<int32_t> rNextId;          /** @brief Reference ids of the next segments. */
+  String<int32_t> pNext;            /** @brief Positions of the next segments. */
+  String<int32_t> tLen;             /** @brief Template lengths. */
+  String<int32_t> seqLength;        /** @brief Read lengths in bases. */
+
+  /* Variable length fields, concatenated */
+  CharString qNames;                /** @brief Query names, without terminating zeros. */
+  String<size_t> qNameBegins;       /** @brief Begin of each query name, plus the total length. */
+  String<uint32_t> cigars;          /** @brief CIGAR operations in BAM encoding (length << 4 | op). */
+  String<size_t> cigarBegins;       /** @brief Begin of each CIGAR string, plus the total length. */
+  String<uint8_t> seqs;             /** @brief Sequences, two 4-bit BAM base codes per byte. */
+  String<size_t> seqBegins;         /** @brief Byte offset of each sequence, plus the total size. */
+  String<uint8_t> quals;            /** @brief Base qualities as PHRED values, seqLength per record. */
+  String<size_t> qualBegins;        /** @brief Begin of each quality string, plus the total length. */
+  String<uint8_t> tags;             /** @brief Raw BAM tags. */
+  String<size_t> tagBegins;         /** @brief Begin of each tag block, plus the total size. */
+
+
+  BamRecordBatch()
+  {
+    clear(*this);
+  }
+};
+
+
+/**
+ * @brief Removes all records of a batch. The memory of the batch is kept for reuse.
+ */
+inline void
+clear(BamRecordBatch & batch)
+{
+  // clear() keeps the capacity of the strings
+  clear(batch.rID);
+  clear(batch.beginPos);
+  clear(batch.flag);
+  clear(batch.mapQ);
+  clear(batch.bin);
+  clear(batch.rNextId);
+  clear(batch.pNext);
+  clear(batch.tLen);
+  clear(batch.seqLength);
+  clear(batch.qNames);
+  clear(batch.cigars);
+  clear(batch.seqs);
+  clear(batch.quals);
+  clear(batch.tags);
+
+  resize(batch.qNameBegins, 1, 0);
+  resize(batch.cigarBegins, 1, 0);
+  resize(batch.seqBegins, 1, 0);
+  resize(batch.qualBegins, 1, 0);
+  resize(batch.tagBegins, 1, 0);
+}
+
+
+/**
+ * @brief Number of records in a batch.
+ */
+inline size_t
+length(BamRecordBatch const & batch)
+{
+  return length(batch.rID);
+}
+
+
+/**
+ * @brief Appends n values to a string with a single copy.
+ */
+template <typename TValue>
+inline void
+_appendBatchColumn(String<TValue> & target, TValue const * source, size_t n)
+{
+  size_t const oldLength = length(target);
+  resize(target, oldLength + n);
+
+  if (n > 0)
+    memcpy(&target[oldLength], source, n * sizeof(TValue));
+}
+
+
+/**
+ * @brief Appends a HTS record to a batch.
+ *
+ * @param batch The batch to append to.
+ * @param hts_record The record to copy.
+ */
+inline void
+appendRecord(BamRecordBatch & batch, bam1_t const * hts_record)
+{
+  bam1_core_t const & core = hts_record->core;
+
+  appendValue(batch.rID, core.tid);
+  appendValue(batch.beginPos, core.pos);
+  appendValue(batch.flag, core.flag);
+  appendValue(batch.mapQ, core.qual);
+  appendValue(batch.bin, core.bin);
+  appendValue(batch.rNextId, core.mtid);
+  appendValue(batch.pNext, core.mpos);
+  appendValue(batch.tLen, core.isize);
+  appendValue(batch.seqLength, core.l_qseq);
+
+  char const * qName = bam_get_qname(hts_record);
+  _appendBatchColumn(batch.qNames, qName, strlen(qName));
+  appendValue(batch.qNameBegins, length(batch.qNames));
+
+  _appendBatchColumn(batch.cigars, static_cast<uint32_t const *>(bam_get_cigar(hts_record)), core.n_cigar);
+  appendValue(batch.cigarBegins, length(batch.cigars));
+
+  _appendBatchColumn(batch.seqs, static_cast<uint8_t const *>(bam_get_seq(hts_record)), (core.l_qseq + 1) >> 1);
+  appendValue(batch.seqBegins, length(batch.seqs));
+
+  _appendBatchColumn(batch.quals, static_cast<uint8_t const *>(bam_get_qual(hts_record)), core.l_qseq);
+  appendValue(batch.qualBegins, length(batch.quals));
+
+  _appendBatchColumn(batch.tags, static_cast<uint8_t const *>(bam_get_aux(hts_record)), bam_get_l_aux(hts_record));
+  appendValue(batch.tagBegins, length(batch.tags));
+}
+
+
+/**
+ * @brief Fills a HTS record with the i-th record of a batch.
+ *
+ * @param hts_record The record to write to. Its data buffer is grown by htslib if needed.
+ * @param batch The batch to read from.
+ * @param i The id of the record in the batch.
+ * @returns True on success, false if the record data could not be allocated.
+ */
+inline bool
+assignRecord(bam1_t * hts_record, BamRecordBatch const & batch, size_t i)
+{
+  size_t const qNameLength = batch.qNameBegins[i + 1] - batch.qNameBegins[i];
+  size_t const nCigar = batch.cigarBegins[i + 1] - batch.cigarBegins[i];
+  size_t const seqBytes = batch.seqBegins[i + 1] - batch.seqBegins[i];
+  size_t const qualLength = batch.qualBegins[i + 1] - batch.qualBegins[i];
+  size_t const tagsLength = batch.tagBegins[i + 1] - batch.tagBegins[i];
+  // Like bam_set1() of htslib, the query name is padded with 1 to 4 NULs so that the CIGAR is 4-byte aligned
+  size_t const qNameNuls = 4 - qNameLength % 4;
+  size_t const dataLength = qNameLength + qNameNuls + nCigar * 4 + seqBytes + qualLength + tagsLength;
+
+  if (hts_record->m_data < dataLength && sam_realloc_bam_data(hts_record, dataLength) < 0)
+    return false;
+
+  bam1_core_t & core = hts_record->core;
+  core.tid = batch.rID[i];
+  core.pos = batch.beginPos[i];
+  core.flag = batch.flag[i];
+  core.qual = batch.mapQ[i];
+  core.bin = batch.bin[i];
+  core.mtid = batch.rNextId[i];
+  core.mpos = batch.pNext[i];
+  core.isize = batch.tLen[i];
+  core.l_qseq = batch.seqLength[i];
+  core.l_qname = qNameLength + qNameNuls;
+  core.l_extranul = qNameNuls - 1;
+  core.n_cigar = nCigar;
+  hts_record->l_data = dataLength;
+
+  // The data of a BAM record is the query name, CIGAR, sequence, qualities and tags, in this order
+  uint8_t * out = hts_record->data;
+  memcpy(out, begin(batch.qNames, Standard()) + batch.qNameBegins[i], qNameLength);
+  out += qNameLength;
+  memset(out, '\0', qNameNuls);
+  out += qNameNuls;
+
+  if (nCigar > 0)
+    memcpy(out, begin(batch.cigars, Standard()) + batch.cigarBegins[i], nCigar * 4);
+  out += nCigar * 4;
+
+  if (seqBytes > 0)
+    memcpy(out, begin(batch.seqs, Standard()) + batch.seqBegins[i], seqBytes);
+  out += seqBytes;
+
+  if (qualLength > 0)
+    memcpy(out, begin(batch.quals, Standard()) + batch.qualBegins[i], qualLength);
+  out += qualLength;
+
+  if (tagsLength > 0)
+    memcpy(out, begin(batch.tags, Standard()) + batch.tagBegins[i], tagsLength);
+
+  return true;
+}
+
+
+/**
+ * @brief Reads up to maxRecords alignment records into a batch, replacing its previous records.
+ *
+ * The records are copied from the HTS records without decoding them.
+ *
+ * @param batch The batch to write to.
+ * @param file The file to read from.
+ * @param maxRecords Maximum number of records to read.
+ * @returns The number of records read. Less than maxRecords if the end of the file has been reached.
+ */
+template <typename TSize>
+inline TSize
+readRecords(BamRecordBatch & batch, HtsFile & file, TSize maxRecords)
+{
+  clear(batch);
+
+  TSize numRecords = 0;
+
+  while (numRecords < maxRecords && readRecord(file))
+  {
+    appendRecord(batch, file.hts_record);
+    ++numRecords;
+  }
+
+  return numRecords;
+}
+
+
+/**
+ * @brief Writes all records of a batch.
+ *
+ * @param file The file to write to, with its header already written.
+ * @param batch The records to write.
+ * @returns True on success, otherwise false.
+ */
+inline bool
+writeRecords(HtsFile & file, BamRecordBatch const & batch)
+{
+  for (size_t i = 0; i < length(batch); ++i)
+  {
+    if (!assignRecord(file.hts_record, batch, i) || sam_write1(file.fp, file.hdr, file.hts_record) < 0)
+      return false;
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief The query name of the i-th record of a batch.
+ */
+inline Infix<CharString const>::Type
+getQName(BamRecordBatch const & batch, size_t i)
+{
+  return infix(batch.qNames, batch.qNameBegins[i], batch.qNameBegins[i + 1]);
+}
+
+
+/**
+ * @brief Decodes the CIGAR string of the i-th record of a batch.
+ *
+ * @param target CIGAR string to write to.
+ * @param batch The batch to read from.
+ * @param i The id of the record in the batch.
+ */
+template <typename TSpec>
+inline void
+assignCigar(String<CigarElement<>, TSpec> & target, BamRecordBatch const & batch, size_t i)
+{
+  resize(target, batch.cigarBegins[i + 1] - batch.cigarBegins[i], Exact());
+
+  for (size_t j = 0; j < length(target); ++j)
+  {
+    uint32_t const op = batch.cigars[batch.cigarBegins[i] + j];
+    target[j] = CigarElement<>(BAM_CIGAR_STR[bam_cigar_op(op)], bam_cigar_oplen(op));
+  }
+}
+
+
+/**
+ * @brief Decodes the read sequence of the i-th record of a batch.
+ *
+ * Iupac and char strings are decoded by decodeBamSeq(), other sequences are converted from an Iupac string.
+ *
+ * @param target Sequence to write to.
+ * @param batch The batch to read from.
+ * @param i The id of the record in the batch.
+ */
+template <typename TSpec>
+inline void
+assignSeq(String<Iupac, Alloc<TSpec> > & target, BamRecordBatch const & batch, size_t i)
+{
+  decodeBamSeq(target, begin(batch.seqs, Standard()) + batch.seqBegins[i], batch.seqLength[i]);
+}
+
+
+template <typename TSpec>
+inline void
+assignSeq(String<char, Alloc<TSpec> > & target, BamRecordBatch const & batch, size_t i)
+{
+  decodeBamSeq(target, begin(batch.seqs, Standard()) + batch.seqBegins[i], batch.seqLength[i]);
+}
+
+
+template <typename TTarget>
+inline void
+assignSeq(TTarget & target, BamRecordBatch const & batch, size_t i)
+{
+  IupacString seq;
+  decodeBamSeq(seq, begin(batch.seqs, Standard()) + batch.seqBegins[i], batch.seqLength[i]);
+  assign(target, seq);
+}
+
+
+/**
+ * @brief Decodes the base qualities of the i-th record of a batch.
+ *
+ * @param target String to write the PHRED+33 encoded qualities to.
+ * @param batch The batch to read from.
+ * @param i The id of the record in the batch.
+ */
+template <typename TSpec>
+inline void
+assignQual(String<char, Alloc<TSpec> > & target, BamRecordBatch const & batch, size_t i)
+{
+  decodeBamQual(target, begin(batch.quals, Standard()) + batch.qualBegins[i],
+                batch.qualBegins[i + 1] - batch.qualBegins[i]);
+}
+
+
+template <typename TTarget>
+inline void
+assignQual(TTarget & target, BamRecordBatch const & batch, size_t i)
+{
+  CharString qual;
+  decodeBamQual(qual, begin(batch.quals, Standard()) + batch.qualBegins[i],
+                batch.qualBegins[i + 1] - batch.qualBegins[i]);
+  assign(target, qual);
+}
+
+
+/**
+ * @brief Copies the raw BAM tags of the i-th record of a batch, e.g. to be used with a BamTagsDict.
+ *
+ * @param target String to copy into.
+ * @param batch The batch to read from.
+ * @param i The id of the record in the batch.
+ */
+template <typename TTarget>
+inline void
+assignTags(TTarget & target, BamRecordBatch const & batch, size_t i)
+{
+  resize(target, batch.tagBegins[i + 1] - batch.tagBegins[i], Exact());
+  uint8_t const * tags = begin(batch.tags, Standard()) + batch.tagBegins[i];
+  arrayCopyForward(tags, tags + length(target), begin(target, Standard()));
+}
+
+
+} // namespace seqan
+
+#endif  // SEQAN_HTS_IO_HTS_RECORD_BATCH_H_
@@ -0,0 +1,337 @@
+#ifndef SEQAN_HTS_IO_HTS_RECORD_VIEW_H_
+#define SEQAN_HTS_IO_HTS_RECORD_VIEW_H_
+
+#include <seqan/basic.h>
+#include <seqan/bam_io/bam_alignment_record.h>
+#include <seqan/bam_io/bam_sequence_codec.h>
+
+#include <htslib/hts.h>
+#include <htslib/sam.h>
+
+
+namespace seqan
+{
+
+/**
+ * @brief A non-owning view of a bam1_t record that decodes its fields on demand.
+ *
+ * The accessors are named like the members of BamAlignmentRecord, but nothing is copied until a variable length
+ * field is explicitly requested. A view is only valid as long as the underlying bam1_t is not modified, i.e. a view
+ * obtained with readRecord(HtsRecordView &, HtsFile &) is invalidated by the next read from the same file.
+ */
+class HtsRecordView
+{
+public:
+  bam1_t const * hts_record;  /** @brief The viewed HTS record. */
+
+  HtsRecordView()
+    : hts_record(nullptr) {}
+
+  explicit HtsRecordView(bam1_t const * r)
+    : hts_record(r) {}
+
+
+  /* Fixed length fields */
+  inline int32_t rID() const { return hts_record->core.tid; }
+  inline int32_t beginPos() const { return hts_record->core.pos; }
+  inline uint16_t flag() const { return hts_record->core.flag; }
+  inline uint8_t mapQ() const { return hts_record->core.qual; }
+  inline uint16_t bin() const { return hts_record->core.bin; }
+  inline int32_t rNextId() const { return hts_record->core.mtid; }
+  inline int32_t pNext() const { return hts_record->core.mpos; }
+  inline int32_t tLen() const { return hts_record->core.isize; }
+
+
+  /**
+   * @brief The zero-terminated query name, pointing into the record buffer.
+   */
+  inline char const *
+  qName() const
+  {
+    return bam_get_qname(hts_record);
+  }
+
+
+  /**
+   * @brief Number of CIGAR operations.
+   */
+  inline uint32_t
+  cigarLength() const
+  {
+    return hts_record->core.n_cigar;
+  }
+
+
+  /**
+   * @brief Decodes the i-th CIGAR operation.
+   */
+  inline CigarElement<>
+  cigarAt(uint32_t i) const
+  {
+    uint32_t const op = bam_get_cigar(hts_record)[i];
+    return CigarElement<>(BAM_CIGAR_STR[bam_cigar_op(op)], bam_cigar_oplen(op));
+  }
+
+
+  /**
+   * @brief Length of the read sequence (and qualities).
+   */
+  inline int32_t
+  seqLength() const
+  {
+    return hts_record->core.l_qseq;
+  }
+
+
+  /**
+   * @brief Decodes the i-th base of the read sequence. BAM 4-bit codes and Iupac share the same ordering.
+   */
+  inline Iupac
+  seqAt(int32_t i) const
+  {
+    return Iupac(static_cast<uint8_t>(bam_seqi(bam_get_seq(hts_record), i)));
+  }
+
+
+  /**
+   * @brief Decodes the i-th base quality as a printable (PHRED+33) character.
+   */
+  inline char
+  qualAt(int32_t i) const
+  {
+    return static_cast<char>(bam_get_qual(hts_record)[i] + 33);
+  }
+
+
+  /**
+   * @brief Pointer to the raw BAM tags of the record. Use tagsLength() to get their size.
+   */
+  inline char const *
+  tags() const
+  {
+    return reinterpret_cast<char const *>(bam_get_aux(hts_record));
+  }
+
+
+  /**
+   * @brief Length of the raw BAM tags in bytes.
+   */
+  inline int32_t
+  tagsLength() const
+  {
+    return bam_get_l_aux(hts_record);
+  }
+};
+
+
+/**
+ * @brief Checks if a view points to a record.
+ */
+inline bool
+empty(HtsRecordView const & view)
+{
+  return view.hts_record == nullptr;
+}
+
+
+/**
+ * @brief Copies the query name of a viewed record.
+ *
+ * @param target String to copy into.
+ * @param view The record view.
+ */
+template <typename TTarget>
+inline void
+assignQName(TTarget & target, HtsRecordView const & view)
+{
+  assign(target, view.qName());
+}
+
+
+/**
+ * @brief Decodes the CIGAR string of a viewed record.
+ *
+ * @param target CIGAR string to write to.
+ * @param view The record view.
+ */
+template <typename TSpec>
+inline void
+assignCigar(String<CigarElement<>, TSpec> & target, HtsRecordView const & view)
+{
+  resize(target, view.cigarLength(), Exact());
+
+  for (uint32_t i = 0; i < view.cigarLength(); ++i)
+    target[i] = view.cigarAt(i);
+}
+
+
+/**
+ * @brief Decodes the read sequence of a viewed record.
+ *
+ * Iupac and char strings are decoded by decodeBamSeq(), other sequences are converted from an Iupac string.
+ *
+ * @param target Sequence to write to.
+ * @param view The record view.
+ */
+template <typename TSpec>
+inline void
+assignSeq(String<Iupac, Alloc<TSpec> > & target, HtsRecordView const & view)
+{
+  decodeBamSeq(target, bam_get_seq(view.hts_record), view.seqLength());
+}
+
+
+template <typename TSpec>
+inline void
+assignSeq(String<char, Alloc<TSpec> > & target, HtsRecordView const & view)
+{
+  decodeBamSeq(target, bam_get_seq(view.hts_record), view.seqLength());
+}
+
+
+template <typename TTarget>
+inline void
+assignSeq(TTarget & target, HtsRecordView const & view)
+{
+  IupacString seq;
+  decodeBamSeq(seq, bam_get_seq(view.hts_record), view.seqLength());
+  assign(target, seq);
+}
+
+
+/**
+ * @brief Decodes the base qualities of a viewed record.
+ *
+ * @param target String to write the PHRED+33 encoded qualities to.
+ * @param view The record view.
+ */
+template <typename TSpec>
+inline void
+assignQual(String<char, Alloc<TSpec> > & target, HtsRecordView const & view)
+{
+  decodeBamQual(target, bam_get_qual(view.hts_record), view.seqLength());
+}
+
+
+template <typename TTarget>
+inline void
+assignQual(TTarget & target, HtsRecordView const & view)
+{
+  CharString qual;
+  decodeBamQual(qual, bam_get_qual(view.hts_record), view.seqLength());
+  assign(target, qual);
+}
+
+
+/**
+ * @brief Copies the raw BAM tags of a viewed record, e.g. to be used with a BamTagsDict.
+ *
+ * @param target String to copy into.
+ * @param view The record view.
+ */
+template <typename TTarget>
+inline void
+assignTags(TTarget & target, HtsRecordView const & view)
+{
+  resize(target, view.tagsLength(), Exact());
+  arrayCopyForward(view.tags(), view.tags() + view.tagsLength(), begin(target, Standard()));
+}
+
+
+inline bool
+hasFlagMultiple(HtsRecordView const & view)
+{
+  return (view.flag() & BAM_FLAG_MULTIPLE) == BAM_FLAG_MULTIPLE;
+}
+
+
+inline bool
+hasFlagAllProper(HtsRecordView const & view)
+{
+  return (view.flag() & BAM_FLAG_ALL_PROPER) == BAM_FLAG_ALL_PROPER;
+}
+
+
+inline bool
+hasFlagUnmapped(HtsRecordView const & view)
+{
+  return (view.flag() & BAM_FLAG_UNMAPPED) == BAM_FLAG_UNMAPPED;
+}
+
+
+inline bool
+hasFlagNextUnmapped(HtsRecordView const & view)
+{
+  return (view.flag() & BAM_FLAG_NEXT_UNMAPPED) == BAM_FLAG_NEXT_UNMAPPED;
+}
+
+
+inline bool
+hasFlagRC(HtsRecordView const & view)
+{
+  return (view.flag() & BAM_FLAG_RC) == BAM_FLAG_RC;
+}
+
+
+inline bool
+hasFlagNextRC(HtsRecordView const & view)
+{
+  return (view.flag() & BAM_FLAG_NEXT_RC) == BAM_FLAG_NEXT_RC;
+}
+
+
+inline bool
+hasFlagFirst(HtsRecordView const & view)
+{
+  return (view.flag() & BAM_FLAG_FIRST) == BAM_FLAG_FIRST;
+}
+
+
+inline bool
+hasFlagLast(HtsRecordView const & view)
+{
+  return (view.flag() & BAM_FLAG_LAST) == BAM_FLAG_LAST;
+}
+
+
+inline bool
+hasFlagSecondary(HtsRecordView const & view)
+{
+  return (view.flag() & BAM_FLAG_SECONDARY) == BAM_FLAG_SECONDARY;
+}
+
+
+inline bool
+hasFlagQCNoPass(HtsRecordView const & view)
+{
+  return (view.flag() & BAM_FLAG_QC_NO_PASS) == BAM_FLAG_QC_NO_PASS;
+}
+
+
+inline bool
+hasFlagDuplicate(HtsRecordView const & view)
+{
+  return (view.flag() & BAM_FLAG_DUPLICATE) == BAM_FLAG_DUPLICATE;
+}
+
+
+inline bool
+hasFlagSupplementary(HtsRecordView const & view)
+{
+  return (view.flag() & BAM_FLAG_SUPPLEMENTARY) == BAM_FLAG_SUPPLEMENTARY;
+}
+
+
+/**
+ * @brief Returns the length of the alignment on the reference, computed from the raw CIGAR.
+ */
+inline unsigned
+getAlignmentLengthInRef(HtsRecordView const & view)
+{
+  return bam_cigar2rlen(view.hts_record->core.n_cigar, bam_get_cigar(view.hts_record));
+}
+
+
+} // namespace seqan
+
+#endif // SEQAN_HTS_IO_HTS_RECORD_VIEW_H_
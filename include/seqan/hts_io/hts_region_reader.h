@@ -0,0 +1,212 @@
+#ifndef SEQAN_HTS_IO_HTS_REGION_READER_H_
+#define SEQAN_HTS_IO_HTS_REGION_READER_H_
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/parallel.h>
+
+#include <htslib/hts.h>
+#include <htslib/sam.h>
+
+#include <seqan/hts_io/hts_file.h>
+
+
+namespace seqan
+{
+
+/**
+ * @brief Opens the private file handle of a region worker thread.
+ *
+ * Every worker reads through its own htsFile. BAM workers share the index of the source file, while a CRAM index is
+ * bound to the file descriptor it was loaded for, so every CRAM worker loads its own index. A worker that could not be
+ * opened is not kept, such that the next region on the same thread tries again. Failures are not reported here, as
+ * the workers run in parallel, but returned to the caller, which fails the regions of the worker.
+ *
+ * @returns The worker's file, or nullptr if it could not be opened.
+ */
+inline HtsFile *
+_openRegionWorker(std::unique_ptr<HtsFile> & worker, HtsFile const & file, const char * reference)
+{
+  if (worker)
+    return worker.get();
+
+  worker.reset(new HtsFile("r"));
+  worker->filename = file.filename;
+  worker->thread_pool = file.thread_pool;
+
+  // Opened like HtsFile::open(), which would fail hard
+  worker->fp = hts_open(file.filename, "r");
+  bool ok = worker->fp != nullptr;
+
+  if (ok && worker->thread_pool != nullptr && isOpen(*worker->thread_pool))
+    ok = hts_set_thread_pool(worker->fp, &worker->thread_pool->pool) >= 0;
+
+  if (ok && reference != nullptr && reference[0] != '\0')
+    ok = hts_set_fai_filename(worker->fp, reference) >= 0;
+
+  if (ok)
+    ok = (worker->hdr = sam_hdr_read(worker->fp)) != nullptr;
+
+  if (ok)
+  {
+    worker->hts_record = bam_init1();
+
+    if (hts_get_format(worker->fp)->format == bam)
+      worker->hts_index = file.hts_index;
+    else
+      ok = loadIndex(*worker);
+  }
+
+  if (!ok)
+  {
+    worker.reset();
+    return nullptr;
+  }
+
+  return worker.get();
+}
+
+
+/**
+ * @brief Closes all region worker handles without destroying the shared index.
+ */
+inline void
+_closeRegionWorkers(std::vector<std::unique_ptr<HtsFile> > & workers, HtsFile const & file)
+{
+  for (auto & worker : workers)
+  {
+    if (worker && worker->hts_index == file.hts_index)
+      worker->hts_index = nullptr;
+  }
+
+  workers.clear();
+}
+
+
+/**
+ * @brief Reads a list of regions of an indexed BAM/CRAM file using several threads.
+ *
+ * The index of a BAM file is loaded only once (or the already loaded index is used) and shared by all threads, the
+ * threads reading a CRAM file load one index each. Each thread reads through its own file handle, so regions are processed independently and in no particular order.
+ * The callback is called as callback(regionId, record) for each record, where regionId is the position of the region
+ * in the list. It may be called concurrently from different threads, but never concurrently for the same region.
+ * Records of one region are passed in file order.
+ *
+ * @param file An opened HTS file. Its filename is used to open the per-thread handles and its thread pool (if any)
+ *             is shared by them.
+ * @param regions A sequence of regions, each on one of these formats: chrX, chrX:A, or chrX:A-B.
+ * @param callback Functor called for each record.
+ * @param numThreads Number of worker threads. Without OpenMP the regions are read one after another.
+ * @param reference Reference FASTA file. Used for reading CRAM files.
+ * @returns True on success. False if a region could not be read, e.g. because it names an unknown contig; the other
+ *          regions are still read.
+ */
+template <typename TRegions, typename TCallback>
+inline bool
+readRegions(HtsFile & file,
+            TRegions const & regions,
+            TCallback && callback,
+            unsigned numThreads = 1,
+            const char * reference = nullptr)
+{
+  if (file.hts_index == nullptr && !loadIndex(file))
+  {
+    SEQAN_FAIL("Could not load index of file with filename %s", file.filename);
+    return false;
+  }
+
+  int const numRegions = length(regions);
+  String<bool> regionOk;
+  resize(regionOk, numRegions, true, Exact());
+
+  numThreads = std::max(1u, numThreads);
+  std::vector<std::unique_ptr<HtsFile> > workers(numThreads);
+
+  SEQAN_OMP_PRAGMA(parallel for schedule(dynamic) num_threads(numThreads))
+  for (int i = 0; i < numRegions; ++i)
+  {
+    HtsFile * worker = _openRegionWorker(workers[omp_get_thread_num()], file, reference);
+
+    if (worker == nullptr)
+    {
+      regionOk[i] = false;
+      continue;
+    }
+
+    hts_itr_t * iter = sam_itr_querys(worker->hts_index, worker->hdr, toCString(regions[i]));
+
+    if (iter == nullptr)
+    {
+      regionOk[i] = false;
+      continue;
+    }
+
+    BamAlignmentRecord record;
+    int ret;
+
+    while ((ret = sam_itr_next(worker->fp, iter, worker->hts_record)) >= 0)
+    {
+      parse(record, worker->hts_record);
+      callback(i, static_cast<BamAlignmentRecord const &>(record));
+    }
+
+    // -1 is the regular end of the region, everything below is a htslib error
+    if (ret < -1)
+      regionOk[i] = false;
+
+    hts_itr_destroy(iter);
+  }
+
+  _closeRegionWorkers(workers, file);
+
+  for (int i = 0; i < numRegions; ++i)
+  {
+    if (!regionOk[i])
+      return false;
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief Reads a list of regions of an indexed BAM/CRAM file into one batch of records per region, using several
+ *        threads.
+ *
+ * @param batches Resized to the number of regions, the i-th batch contains the records of the i-th region.
+ * @param file An opened HTS file.
+ * @param regions A sequence of regions, each on one of these formats: chrX, chrX:A, or chrX:A-B.
+ * @param numThreads Number of worker threads.
+ * @param reference Reference FASTA file. Used for reading CRAM files.
+ * @returns True on success, otherwise false.
+ */
+template <typename TRegions>
+inline bool
+readRegions(String<String<BamAlignmentRecord> > & batches,
+            HtsFile & file,
+            TRegions const & regions,
+            unsigned numThreads = 1,
+            const char * reference = nullptr)
+{
+  resize(batches, length(regions), Exact());
+
+  for (unsigned i = 0; i < length(batches); ++i)
+    clear(batches[i]);
+
+  return readRegions(file,
+                     regions,
+                     [&batches](int regionId, BamAlignmentRecord const & record)
+                     {
+                       appendValue(batches[regionId], record);
+                     },
+                     numThreads,
+                     reference);
+}
+
+
+} // namespace seqan
+
+#endif // SEQAN_HTS_IO_HTS_REGION_READER_H_
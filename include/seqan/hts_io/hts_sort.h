@@ -0,0 +1,558 @@
+#ifndef SEQAN_HTS_IO_HTS_SORT_H_
+#define SEQAN_HTS_IO_HTS_SORT_H_
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <seqan/basic.h>
+#include <seqan/misc/priority_type_base.h>
+#include <seqan/misc/priority_type_heap.h>
+#include <seqan/parallel.h>
+#include <seqan/sequence.h>
+
+#include <htslib/hts.h>
+#include <htslib/sam.h>
+
+#include <seqan/hts_io/hts_file.h>
+#include <seqan/hts_io/hts_thread_pool.h>
+
+
+namespace seqan
+{
+
+/**
+ * @brief Orders in which sortRecords() can sort the records of a HTS file.
+ */
+enum HtsSortOrder
+{
+  HTS_SORT_COORDINATE,  /** @brief By reference id, position and strand. Unmapped reads without a position are last. */
+  HTS_SORT_QUERYNAME    /** @brief By read name in natural order like samtools sort -n, then by flags. See _htsSortCompareNames(). */
+};
+
+
+/**
+ * @brief A record of an in-memory chunk of sortRecords().
+ *
+ * The key holds the reference id, position and strand for coordinate sorting. Comparing (key, offset) hence orders
+ * by coordinate and then by input order.
+ */
+struct HtsSortEntry
+{
+  uint64_t key;
+  uint64_t offset;
+};
+
+
+/**
+ * @brief The core of a record in an in-memory chunk, followed by its data.
+ */
+struct HtsSortRecordHeader
+{
+  bam1_core_t core;
+  int32_t l_data;
+};
+
+
+static const uint64_t HTS_SORT_ALIGNMENT = 8;
+static const uint64_t HTS_SORT_HEADER_SIZE =
+  (sizeof(HtsSortRecordHeader) + HTS_SORT_ALIGNMENT - 1) / HTS_SORT_ALIGNMENT * HTS_SORT_ALIGNMENT;
+
+
+/**
+ * @brief Returns the coordinate sort key of a record, which packs the reference id, the position and the strand.
+ *        Records with a reference id of -1 get the largest keys.
+ */
+inline uint64_t
+_htsSortKey(bam1_core_t const & core)
+{
+  return static_cast<uint64_t>(static_cast<uint32_t>(core.tid)) << 32 |
+         static_cast<uint64_t>(static_cast<uint32_t>(core.pos + 1) & 0x7fffffff) << 1 |
+         static_cast<uint64_t>((core.flag & BAM_FREVERSE) != 0);
+}
+
+
+/**
+ * @brief Compares two read names in natural order, like strnum_cmp() of samtools.
+ *
+ * Runs of digits are compared by their numeric value, ignoring leading zeros, so "r9" is before "r10". All other
+ * characters are compared by their byte value.
+ *
+ * @returns A negative value if a is before b, a positive value if b is before a and 0 if they are equivalent.
+ */
+inline int
+_htsSortCompareNatural(char const * a, char const * b)
+{
+  unsigned char const * pa = reinterpret_cast<unsigned char const *>(a);
+  unsigned char const * pb = reinterpret_cast<unsigned char const *>(b);
+
+  while (*pa != '\0' && *pb != '\0')
+  {
+    if (!isdigit(*pa) || !isdigit(*pb))
+    {
+      if (*pa != *pb)
+        return static_cast<int>(*pa) - static_cast<int>(*pb);
+
+      ++pa;
+      ++pb;
+      continue;
+    }
+
+    while (*pa == '0')
+      ++pa;
+
+    while (*pb == '0')
+      ++pb;
+
+    while (isdigit(*pa) && *pa == *pb)
+    {
+      ++pa;
+      ++pb;
+    }
+
+    // The longer number is larger, numbers of the same length differ at their first different digit
+    int const diff = static_cast<int>(*pa) - static_cast<int>(*pb);
+
+    while (isdigit(*pa) && isdigit(*pb))
+    {
+      ++pa;
+      ++pb;
+    }
+
+    if (isdigit(*pa))
+      return 1;
+    else if (isdigit(*pb))
+      return -1;
+    else if (diff != 0)
+      return diff;
+  }
+
+  if (*pa != '\0' || *pb != '\0')
+    return *pa != '\0' ? 1 : -1;
+
+  return 0;
+}
+
+
+/**
+ * @brief Compares two records in read name order, like samtools sort -n.
+ *
+ * Names are compared in natural order. Records with the same name are ordered by their mate flags, i.e. unpaired
+ * reads before the first and the second read of a pair, and then primary alignments before secondary and
+ * supplementary ones.
+ *
+ * @returns A negative value if a is before b, a positive value if b is before a and 0 if they are equivalent.
+ */
+inline int
+_htsSortCompareNames(bam1_core_t const & a, char const * qnameA, bam1_core_t const & b, char const * qnameB)
+{
+  int const cmp = _htsSortCompareNatural(qnameA, qnameB);
+
+  if (cmp != 0)
+    return cmp;
+
+  int const mateA = a.flag & (BAM_FREAD1 | BAM_FREAD2);
+  int const mateB = b.flag & (BAM_FREAD1 | BAM_FREAD2);
+
+  if (mateA != mateB)
+    return mateA - mateB;
+
+  return static_cast<int>(a.flag & (BAM_FSECONDARY | BAM_FSUPPLEMENTARY)) -
+         static_cast<int>(b.flag & (BAM_FSECONDARY | BAM_FSUPPLEMENTARY));
+}
+
+
+/**
+ * @brief Compares two records in a sort order.
+ */
+inline int
+_htsSortCompare(bam1_core_t const & a, char const * qnameA, bam1_core_t const & b, char const * qnameB,
+                HtsSortOrder order)
+{
+  if (order == HTS_SORT_QUERYNAME)
+    return _htsSortCompareNames(a, qnameA, b, qnameB);
+
+  uint64_t const keyA = _htsSortKey(a);
+  uint64_t const keyB = _htsSortKey(b);
+  return keyA < keyB ? -1 : static_cast<int>(keyA > keyB);
+}
+
+
+/**
+ * @brief Less-than comparator of the entries of an in-memory chunk. Equivalent records keep their input order.
+ */
+struct HtsSortEntryLess
+{
+  char const * chunk;
+  HtsSortOrder order;
+
+  HtsSortEntryLess(char const * c, HtsSortOrder o)
+    : chunk(c), order(o) {}
+
+  inline bool
+  operator()(HtsSortEntry const & a, HtsSortEntry const & b) const
+  {
+    if (order == HTS_SORT_QUERYNAME)
+    {
+      char const * recordA = chunk + a.offset;
+      char const * recordB = chunk + b.offset;
+      int const cmp = _htsSortCompareNames(reinterpret_cast<HtsSortRecordHeader const *>(recordA)->core,
+                                           recordA + HTS_SORT_HEADER_SIZE,
+                                           reinterpret_cast<HtsSortRecordHeader const *>(recordB)->core,
+                                           recordB + HTS_SORT_HEADER_SIZE);
+
+      if (cmp != 0)
+        return cmp < 0;
+
+      return a.offset < b.offset;
+    }
+
+    return a.key < b.key || (a.key == b.key && a.offset < b.offset);
+  }
+};
+
+
+/**
+ * @brief An in-memory chunk of records of sortRecords().
+ */
+struct HtsSortChunk
+{
+  String<char> data;              /** @brief The records, each an HtsSortRecordHeader followed by the record data. */
+  String<HtsSortEntry> entries;   /** @brief One entry per record, sorted by sortChunk(). */
+};
+
+
+/**
+ * @brief Returns the number of bytes of memory used by the records of a chunk.
+ */
+inline uint64_t
+_memoryUsage(HtsSortChunk const & chunk)
+{
+  return length(chunk.data) + length(chunk.entries) * sizeof(HtsSortEntry);
+}
+
+
+/**
+ * @brief Appends a copy of a record to a chunk.
+ */
+inline void
+_appendRecord(HtsSortChunk & chunk, bam1_t const * record)
+{
+  uint64_t const offset = length(chunk.data);
+  uint64_t const size = (HTS_SORT_HEADER_SIZE + record->l_data + HTS_SORT_ALIGNMENT - 1) / HTS_SORT_ALIGNMENT *
+                        HTS_SORT_ALIGNMENT;
+  resize(chunk.data, offset + size, Generous());
+
+  char * it = begin(chunk.data, Standard()) + offset;
+  HtsSortRecordHeader header;
+  memset(&header, 0, sizeof(header));
+  header.core = record->core;
+  header.l_data = record->l_data;
+  memcpy(it, &header, sizeof(header));
+  memcpy(it + HTS_SORT_HEADER_SIZE, record->data, record->l_data);
+
+  HtsSortEntry entry;
+  entry.key = _htsSortKey(record->core);
+  entry.offset = offset;
+  appendValue(chunk.entries, entry, Generous());
+}
+
+
+/**
+ * @brief Points a record to an entry of a chunk without copying its data.
+ *
+ * The record must not be resized or destroyed with bam_destroy1().
+ */
+inline void
+_assignView(bam1_t & record, HtsSortChunk const & chunk, HtsSortEntry const & entry)
+{
+  char const * it = begin(chunk.data, Standard()) + entry.offset;
+  HtsSortRecordHeader const * header = reinterpret_cast<HtsSortRecordHeader const *>(it);
+
+  memset(&record, 0, sizeof(record));
+  record.core = header->core;
+  record.l_data = header->l_data;
+  record.m_data = header->l_data;
+  record.data = reinterpret_cast<uint8_t *>(const_cast<char *>(it + HTS_SORT_HEADER_SIZE));
+}
+
+
+/**
+ * @brief Sorts the entries of a chunk using several threads.
+ *
+ * The entries are split into one part per thread, the parts are sorted concurrently and then merged pairwise, again
+ * concurrently, in log2(numThreads) rounds.
+ */
+inline void
+sortChunk(HtsSortChunk & chunk, HtsSortOrder order, unsigned numThreads = 1)
+{
+  HtsSortEntryLess const less(begin(chunk.data, Standard()), order);
+  HtsSortEntry * first = begin(chunk.entries, Standard());
+  int64_t const n = length(chunk.entries);
+  int const numParts = std::max<int64_t>(1, std::min<int64_t>(std::max(1u, numThreads), n));
+
+  SEQAN_OMP_PRAGMA(parallel for num_threads(numParts))
+  for (int p = 0; p < numParts; ++p)
+    std::sort(first + p * n / numParts, first + (p + 1) * n / numParts, less);
+
+  for (int width = 1; width < numParts; width *= 2)
+  {
+    SEQAN_OMP_PRAGMA(parallel for num_threads(numParts))
+    for (int p = 0; p < numParts - width; p += 2 * width)
+    {
+      int const last = std::min(p + 2 * width, numParts);
+      std::inplace_merge(first + p * n / numParts, first + (p + width) * n / numParts, first + last * n / numParts,
+                         less);
+    }
+  }
+}
+
+
+/**
+ * @brief Writes the sorted records of a chunk to a file.
+ */
+inline bool
+_writeChunk(HtsFile & file, HtsSortChunk const & chunk)
+{
+  bam1_t view;
+
+  for (HtsSortEntry const & entry : chunk.entries)
+  {
+    _assignView(view, chunk, entry);
+
+    if (sam_write1(file.fp, file.hdr, &view) < 0)
+      return false;
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief Opens a temporary run for writing with the header of the input file.
+ *
+ * Unlike HtsFile::open(), a file that cannot be created is reported to the caller instead of failing hard.
+ */
+inline bool
+_openSortRun(HtsFile & run, HtsFile const & in, HtsThreadPool & pool)
+{
+  run.thread_pool = &pool;
+  run.fp = hts_open(run.filename, run.file_mode);
+
+  if (run.fp == nullptr)
+    return false;
+
+  if (isOpen(pool) && hts_set_thread_pool(run.fp, &pool.pool) < 0)
+    return false;
+
+  run.hdr = bam_hdr_dup(in.hdr);
+  run.hts_record = bam_init1();
+  return run.hdr != nullptr;
+}
+
+
+/**
+ * @brief Opens a sorted output file with the header of the input file and the sort order set in its @HD line.
+ */
+inline bool
+_openSortOutput(HtsFile & out, HtsFile const & in, HtsSortOrder order)
+{
+  if (!out.open())
+    return false;
+
+  out.hdr = bam_hdr_dup(in.hdr);
+
+  if (out.hdr == nullptr ||
+      sam_hdr_change_HD(out.hdr, "SO", order == HTS_SORT_QUERYNAME ? "queryname" : "coordinate") < 0)
+  {
+    SEQAN_FAIL("Could not set the sort order of file with filename %s", out.filename);
+    return false;
+  }
+
+  return writeHeader(out);
+}
+
+
+/**
+ * @brief Heap comparator of the k-way merge. The top of the heap is the run with the smallest current record, ties
+ *        are broken by the run number, which keeps the input order of equivalent records.
+ */
+struct HtsSortRunGreater
+{
+  std::vector<std::unique_ptr<HtsFile> > const * runs;
+  HtsSortOrder order;
+
+  HtsSortRunGreater()
+    : runs(nullptr), order(HTS_SORT_COORDINATE) {}
+
+  HtsSortRunGreater(std::vector<std::unique_ptr<HtsFile> > const & r, HtsSortOrder o)
+    : runs(&r), order(o) {}
+
+  inline bool
+  operator()(unsigned a, unsigned b) const
+  {
+    bam1_t const * recordA = (*runs)[a]->hts_record;
+    bam1_t const * recordB = (*runs)[b]->hts_record;
+    int const cmp = _htsSortCompare(recordA->core, bam_get_qname(recordA), recordB->core, bam_get_qname(recordB),
+                                    order);
+
+    if (cmp != 0)
+      return cmp > 0;
+
+    return a > b;
+  }
+};
+
+
+/**
+ * @brief Merges sorted run files into an output file.
+ */
+inline bool
+_mergeRuns(HtsFile & out, std::vector<std::string> const & runFilenames, HtsSortOrder order,
+           HtsThreadPool & pool)
+{
+  std::vector<std::unique_ptr<HtsFile> > runs(runFilenames.size());
+  PriorityType<unsigned, HtsSortRunGreater, PriorityHeap> heap(HtsSortRunGreater(runs, order));
+
+  for (unsigned i = 0; i < runs.size(); ++i)
+  {
+    runs[i].reset(new HtsFile("r"));
+    runs[i]->filename = runFilenames[i].c_str();
+    runs[i]->thread_pool = &pool;
+
+    if (!runs[i]->open())
+      return false;
+
+    if (readRecord(*runs[i]))
+      push(heap, i);
+  }
+
+  while (!empty(heap))
+  {
+    HtsFile & run = *runs[top(heap)];
+
+    if (sam_write1(out.fp, out.hdr, run.hts_record) < 0)
+      return false;
+
+    if (readRecord(run))
+      adjustTop(heap);
+    else
+      pop(heap);
+  }
+
+  return true;
+}
+
+
+/**
+ * @brief Sorts the records of a HTS file into a new BAM file, using a bounded amount of memory.
+ *
+ * The records are read into chunks of about memoryLimit bytes. Every chunk is sorted in memory with numThreads
+ * threads. If the input does not fit into one chunk, the sorted chunks are written to temporary BGZF compressed BAM
+ * files with fast compression, which are merged in one k-way merge pass and removed afterwards. The temporary and the
+ * output files are (de)compressed by a thread pool with numThreads threads. Equivalent records keep their input order.
+ *
+ * @param in An opened HTS file, with its header read. All remaining records of the file are sorted.
+ * @param outFilename Filename of the sorted BAM file.
+ * @param order The sort order.
+ * @param memoryLimit Approximate number of bytes used for the records of one chunk.
+ * @param numThreads Number of threads for sorting and compression.
+ * @param tmpPrefix Prefix of the temporary files, which are named tmpPrefix.NNNN.bam. Defaults to outFilename.tmp.
+ * @returns True on success, otherwise false.
+ * @throw IOError If a temporary file cannot be opened. The temporary files written before are removed.
+ */
+inline bool
+sortRecords(HtsFile & in,
+            const char * outFilename,
+            HtsSortOrder order = HTS_SORT_COORDINATE,
+            uint64_t memoryLimit = 768ull << 20,
+            unsigned numThreads = 1,
+            const char * tmpPrefix = nullptr)
+{
+  HtsThreadPool pool;
+
+  if (numThreads > 1)
+    pool.open(numThreads);
+
+  std::string const prefix = tmpPrefix != nullptr ? std::string(tmpPrefix) : std::string(outFilename) + ".tmp";
+  std::vector<std::string> runFilenames;
+  HtsSortChunk chunk;
+  bool ok = true;
+
+  while (ok)
+  {
+    bool const hasRecord = readRecord(in);
+
+    // Spill the chunk if it is full or if it is the last one of several
+    if (!empty(chunk.entries) &&
+        (!hasRecord ? !runFilenames.empty() :
+         _memoryUsage(chunk) + HTS_SORT_HEADER_SIZE + in.hts_record->l_data + sizeof(HtsSortEntry) > memoryLimit))
+    {
+      char suffix[16];
+      snprintf(suffix, sizeof(suffix), ".%04u.bam", static_cast<unsigned>(runFilenames.size()));
+      runFilenames.push_back(prefix + suffix);
+
+      HtsFile run("wb1");
+      run.filename = runFilenames.back().c_str();
+
+      if (!_openSortRun(run, in, pool))
+      {
+        run.close();
+
+        for (std::string const & runFilename : runFilenames)
+          std::remove(runFilename.c_str());
+
+        SEQAN_THROW(IOError(("Could not open temporary file " + prefix + suffix).c_str()));
+      }
+
+      sortChunk(chunk, order, numThreads);
+      ok = writeHeader(run) && _writeChunk(run, chunk) && run.close();
+
+      if (!ok)
+        SEQAN_FAIL("Could not write temporary file with filename %s", runFilenames.back().c_str());
+
+      clear(chunk.data);
+      clear(chunk.entries);
+    }
+
+    if (!hasRecord)
+      break;
+
+    _appendRecord(chunk, in.hts_record);
+  }
+
+  if (ok)
+  {
+    HtsFile out("wb");
+    out.filename = outFilename;
+    out.thread_pool = &pool;
+    ok = _openSortOutput(out, in, order);
+
+    if (ok && runFilenames.empty())
+    {
+      // Everything fit into memory
+      sortChunk(chunk, order, numThreads);
+      ok = _writeChunk(out, chunk);
+    }
+    else if (ok)
+    {
+      ok = _mergeRuns(out, runFilenames, order, pool);
+    }
+
+    ok = out.close() && ok;
+  }
+
+  for (std::string const & runFilename : runFilenames)
+    std::remove(runFilename.c_str());
+
+  return ok;
+}
+
+
+} // namespace seqan
+
+#endif // SEQAN_HTS_IO_HTS_SORT_H_
@@ -0,0 +1,126 @@
+#ifndef SEQAN_HTS_IO_HTS_THREAD_POOL_H_
+#define SEQAN_HTS_IO_HTS_THREAD_POOL_H_
+
+#include <seqan/basic.h>
+
+#include <htslib/hts.h>
+#include <htslib/thread_pool.h>
+
+
+namespace seqan
+{
+
+/**
+ * @brief A pool of BGZF (de)compression threads that can be shared by any number of HTS files.
+ *
+ * Attach the pool to a file with open(HtsFile &, const char *, HtsThreadPool &) or setThreadPool().
+ * The pool has to outlive every file it is attached to, i.e. close or destruct the files first.
+ */
+class HtsThreadPool
+{
+public:
+  htsThreadPool pool;       /** @brief The htslib thread pool and its queue size. */
+
+  /**
+   * @brief Constructs an empty thread pool without any threads.
+   */
+  HtsThreadPool()
+  {
+    pool.pool = nullptr;
+    pool.qsize = 0;
+  }
+
+
+  /**
+   * @brief Constructs a new thread pool.
+   *
+   * @param num_threads Number of worker threads.
+   * @param queue_size Number of jobs that may be queued per file. 0 means the htslib default.
+   */
+  HtsThreadPool(int num_threads, int queue_size = 0)
+  {
+    pool.pool = nullptr;
+    pool.qsize = 0;
+    open(num_threads, queue_size);
+  }
+
+
+  /**
+   * @brief Destructs a thread pool and joins its threads.
+   */
+  ~HtsThreadPool()
+  {
+    close();
+  }
+
+
+  inline bool
+  open(int num_threads, int queue_size = 0)
+  {
+    close();
+
+    if (num_threads <= 0)
+      return false;
+
+    pool.pool = hts_tpool_init(num_threads);
+
+    if (pool.pool == nullptr)
+    {
+      SEQAN_FAIL("Could not create a thread pool with %d threads", num_threads);
+      return false;
+    }
+
+    pool.qsize = queue_size;
+    return true;
+  }
+
+
+  inline void
+  close()
+  {
+    if (pool.pool)
+      hts_tpool_destroy(pool.pool);
+
+    pool.pool = nullptr;
+    pool.qsize = 0;
+  }
+
+
+private:
+  HtsThreadPool(HtsThreadPool const &);
+  HtsThreadPool & operator=(HtsThreadPool const &);
+};
+
+
+/**
+ * @brief Checks if a thread pool has running threads.
+ *
+ * @param pool The thread pool.
+ * @returns True if the pool has been opened, otherwise false.
+ */
+inline bool
+isOpen(HtsThreadPool const & pool)
+{
+  return pool.pool.pool != nullptr;
+}
+
+
+/**
+ * @brief Returns the number of worker threads of a thread pool.
+ *
+ * @param pool The thread pool.
+ * @returns The number of threads, or 0 if the pool is not open.
+ */
+inline int
+numThreads(HtsThreadPool const & pool)
+{
+  if (!isOpen(pool))
+    return 0;
+
+  return hts_tpool_size(pool.pool.pool);
+}
+
+
+} // namespace seqan
+
+#endif // SEQAN_HTS_IO_HTS_THREAD_POOL_H_
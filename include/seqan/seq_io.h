@@ -52,12 +52,14 @@
 #include <seqan/seq_io/fasta_fastq.h>
 #include <seqan/seq_io/read_embl.h>
 #include <seqan/seq_io/read_genbank.h>
+#include <seqan/seq_io/two_bit.h>
 
 // ===========================================================================
 // Sequence File
 // ===========================================================================
 
 #include <seqan/seq_io/sequence_file.h>
+#include <seqan/seq_io/seq_batch_reader.h>
 
 // ===========================================================================
 // Genomic Region
@@ -71,4 +73,10 @@
 
 #include <seqan/seq_io/fai_index.h>
 
+// ===========================================================================
+// 2bit Index
+// ===========================================================================
+
+#include <seqan/seq_io/two_bit_index.h>
+
 #endif  // INCLUDE_SEQAN_SEQ_IO_H_
@@ -130,6 +130,8 @@ public:
     CharString fastaFilename;
     // The name of the FAI file.
     CharString faiFilename;
+    // The name of the GZI file, used if the FASTA file is BGZF compressed.
+    CharString gziFilename;
 
     // The index entries.
     String<FaiIndexEntry_> indexEntryStore;
@@ -137,11 +139,26 @@ public:
     StringSet<CharString> seqNameStore;
     // A cache for fast access to the sequence name store.
     NameStoreCache<StringSet<CharString> > seqNameStoreCache;
+    // Compressed and uncompressed file offsets of all BGZF blocks but the first one, as in the GZI file.
+    String<Pair<__uint64, __uint64> > gziEntries;
+    // Whether the FASTA file is BGZF compressed.
+    bool compressed;
+    // The FASTA file mapped into memory, empty unless opened with OPEN_MMAP.
+    String<char, MMap<> > mmapString;
 
     mutable std::ifstream file;
 
+#if SEQAN_HAS_ZLIB
+    // The buffers and inflate context reused by readRegion() on BGZF compressed FASTA files.
+    mutable String<char> compressedBlock;
+    mutable String<char> block;
+    mutable CharString regionBuffer;
+    mutable CompressionContext<BgzfFile> compressionCtx;
+#endif
+
     FaiIndex() :
-        seqNameStoreCache(seqNameStore)
+        seqNameStoreCache(seqNameStore),
+        compressed(false)
     {}
 };
 
@@ -170,9 +187,13 @@ inline void clear(FaiIndex & index)
 {
     clear(index.fastaFilename);
     clear(index.faiFilename);
+    clear(index.gziFilename);
     clear(index.indexEntryStore);
     clear(index.seqNameStore);
     clear(index.seqNameStoreCache);
+    clear(index.gziEntries);
+    index.compressed = false;
+    close(index.mmapString);
 }
 
 // ----------------------------------------------------------------------------
@@ -289,6 +310,197 @@ inline __uint64 numSeqs(FaiIndex const & index)
     return length(index.indexEntryStore);
 }
 
+// ----------------------------------------------------------------------------
+// Function _isBgzfFile()
+// ----------------------------------------------------------------------------
+
+// Checks the first block header of a file and rewinds it.
+
+inline bool _isBgzfFile(std::ifstream & file)
+{
+    bool result = false;
+#if SEQAN_HAS_ZLIB
+    char header[BGZF_BLOCK_HEADER_LENGTH];
+    result = file.read(header, BGZF_BLOCK_HEADER_LENGTH) && _bgzfCheckHeader(header);
+#endif
+    file.clear();
+    file.seekg(0);
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// Function _buildGziEntries()
+// ----------------------------------------------------------------------------
+
+// Collects the block offsets of a BGZF file from the block headers and footers, without decompressing.
+
+inline bool _buildGziEntries(String<Pair<__uint64, __uint64> > & entries, std::ifstream & file)
+{
+    clear(entries);
+#if SEQAN_HAS_ZLIB
+    __uint64 fileOfs = 0;
+    __uint64 uncompressedOfs = 0;
+    char header[BGZF_BLOCK_HEADER_LENGTH];
+
+    file.clear();
+    file.seekg(0);
+    while (file.read(header, BGZF_BLOCK_HEADER_LENGTH))
+    {
+        if (!_bgzfCheckHeader(header))
+            return false;
+
+        size_t blockSize = _bgzfUnpack16(header + 16) + 1u;
+        char footer[BGZF_BLOCK_FOOTER_LENGTH];
+        file.seekg(fileOfs + blockSize - BGZF_BLOCK_FOOTER_LENGTH);
+        if (!file.read(footer, BGZF_BLOCK_FOOTER_LENGTH))
+            return false;
+
+        unsigned blockLength = _bgzfUnpack32(footer + 4);
+        if (fileOfs != 0 && blockLength != 0)
+            appendValue(entries, Pair<__uint64, __uint64>(fileOfs, uncompressedOfs));
+
+        fileOfs += blockSize;
+        uncompressedOfs += blockLength;
+    }
+    file.clear();
+    file.seekg(0);
+#else
+    ignoreUnusedVariableWarning(file);
+#endif
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function _gziUncompressedOffset()
+// ----------------------------------------------------------------------------
+
+// Translates a BGZF virtual offset (block offset << 16 | offset in block) into an offset in the uncompressed file.
+// Returns false if no block starts at the block offset.
+
+inline bool _gziUncompressedOffset(__uint64 & uncompressedOfs, FaiIndex const & index, __uint64 virtualOfs)
+{
+    __uint64 fileOfs = virtualOfs >> 16;
+    if (fileOfs == 0)
+    {
+        uncompressedOfs = virtualOfs & 0xffff;      // first block
+        return true;
+    }
+
+    size_t lo = 0, hi = length(index.gziEntries);
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (index.gziEntries[mid].i1 < fileOfs)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    if (lo == length(index.gziEntries) || index.gziEntries[lo].i1 != fileOfs)
+        return false;
+    uncompressedOfs = index.gziEntries[lo].i2 + (virtualOfs & 0xffff);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function _readBgzfRange()
+// ----------------------------------------------------------------------------
+
+// Decompresses the bytes [beginOfs, endOfs) of the uncompressed file.  Only the blocks holding these bytes are read,
+// the first one is found by a binary search in the GZI entries.  Reading stops at the end of the file.  The buffers
+// of the index are reused between calls.
+
+#if SEQAN_HAS_ZLIB
+inline void _readBgzfRange(CharString & buffer, FaiIndex const & index, __uint64 beginOfs, __uint64 endOfs)
+{
+    clear(buffer);
+
+    // find the last block starting at or before beginOfs
+    size_t lo = 0, hi = length(index.gziEntries);
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (index.gziEntries[mid].i2 <= beginOfs)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    __uint64 fileOfs = (lo == 0) ? 0 : index.gziEntries[lo - 1].i1;
+    __uint64 uncompressedOfs = (lo == 0) ? 0 : index.gziEntries[lo - 1].i2;
+
+    String<char> & compressedBlock = index.compressedBlock;
+    String<char> & block = index.block;
+    resize(compressedBlock, BGZF_MAX_BLOCK_SIZE, Exact());
+    resize(block, BGZF_MAX_BLOCK_SIZE, Exact());
+
+    index.file.clear();
+    index.file.seekg(fileOfs);
+    while (uncompressedOfs < endOfs)
+    {
+        char *header = &compressedBlock[0];
+        if (!index.file.read(header, BGZF_BLOCK_HEADER_LENGTH))
+            return;
+        if (!_bgzfCheckHeader(header))
+            SEQAN_THROW(IOError("Invalid BGZF block header."));
+
+        size_t blockSize = _bgzfUnpack16(header + 16) + 1u;
+        if (!index.file.read(header + BGZF_BLOCK_HEADER_LENGTH, blockSize - BGZF_BLOCK_HEADER_LENGTH))
+            return;
+
+        // empty blocks, e.g. the EOF markers of concatenated files, are skipped, the loop ends at the end of the file
+        size_t blockLength = _decompressBlock(&block[0], length(block), header, blockSize, index.compressionCtx);
+        if (blockLength == 0)
+            continue;
+
+        // append the requested part of the block
+        __uint64 blockEnd = uncompressedOfs + blockLength;
+        if (blockEnd > beginOfs)
+        {
+            size_t from = (beginOfs > uncompressedOfs) ? beginOfs - uncompressedOfs : 0;
+            size_t to = (endOfs < blockEnd) ? endOfs - uncompressedOfs : blockLength;
+            append(buffer, infix(block, from, to));
+        }
+        uncompressedOfs = blockEnd;
+    }
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Function _readMappedRegion()
+// ----------------------------------------------------------------------------
+
+// Copies toRead characters starting at beginPos from the memory-mapped FASTA file.  As all lines of a record have the
+// same length, the line breaks are skipped without looking at the characters, and each line is one contiguous copy.
+
+template <typename TValue, typename TSpec, typename TPos, typename TSize>
+inline void _readMappedRegion(String<TValue, TSpec> & str,
+                              FaiIndex const & index,
+                              FaiIndexEntry_ const & entry,
+                              TPos beginPos,
+                              TSize toRead)
+{
+    typedef typename Iterator<String<TValue, TSpec>, Standard>::Type TTargetIter;
+
+    __uint64 lineOfs = entry.offset + (beginPos / entry.lineLength) * (__uint64)entry.overallLineLength;
+    unsigned column = beginPos % entry.lineLength;
+    __uint64 lastOfs = lineOfs + ((column + toRead - 1) / entry.lineLength) * (__uint64)entry.overallLineLength +
+                       (column + toRead - 1) % entry.lineLength;
+    if (lastOfs >= length(index.mmapString))
+        SEQAN_THROW(UnexpectedEnd());
+
+    resize(str, toRead);
+    TTargetIter itTarget = begin(str, Standard());
+    char const * itSource = begin(index.mmapString, Standard()) + lineOfs;
+    while (toRead != 0)
+    {
+        size_t count = std::min((__uint64)toRead, (__uint64)(entry.lineLength - column));
+        itTarget = std::copy(itSource + column, itSource + (column + count), itTarget);
+        toRead -= count;
+        itSource += entry.overallLineLength;
+        column = 0;
+    }
+}
+
 // ----------------------------------------------------------------------------
 // Function readRegion()
 // ----------------------------------------------------------------------------
@@ -298,14 +510,24 @@ inline __uint64 numSeqs(FaiIndex const & index)
  * @brief Read a region through an FaiIndex.
  *
  * @signature void readRegion(str, faiIndex, rID, beginPos, endPos);
- * @signature void readRegion(str, faiIndex, region);
+ * @signature bool readRegion(str, faiIndex, region);
+ * @signature bool readRegion(infix, faiIndex, rID, beginPos, endPos);
+ *
+ * If the FaiIndex was opened with <tt>OPEN_MMAP</tt>, regions are copied line by line from the memory-mapped FASTA
+ * file.  A region that lies on a single line can also be obtained as an infix of the mapped file without any copy.
  *
- * @param[out] str      The @link String @endlink to read the sequence into.
+ * @param[out] str      The @link String @endlink to read the sequence into.  Its capacity is reused.
+ * @param[out] infix    The infix of the mapped FASTA file to set.  Type: <tt>Infix&lt;String&lt;char, MMap&lt;&gt;
+ *                      &gt; const&gt;::Type</tt>.
  * @param[in]  faiIndex The FaiIndex to read from.
  * @param[in]  rID    The id of the sequence to read (Type: <tt>unsigned).
  * @param[in]  beginPos The begin position of the region to read (Type: <tt>unsigned).
  * @param[in]  endPos   The end position of the region to read  (Type: <tt>unsigned).
  * @param[in]  region   The @link GenomicRegion @endlink to read.
+ *
+ * @return bool For <tt>region</tt>, <tt>false</tt> if the sequence name is unknown.  For <tt>infix</tt>,
+ *              <tt>false</tt> if the FASTA file is not mapped or the region spans more than one line, <tt>true</tt>
+ *              otherwise.
  */
 
 template <typename TValue, typename TSpec, typename TSeqId, typename TBeginPos, typename TEndPos>
@@ -327,6 +549,33 @@ inline void readRegion(String<TValue, TSpec> & str,
     if (toRead == 0)
         return;
 
+    if (!empty(index.mmapString))
+    {
+        _readMappedRegion(str, index, entry, beginPos, toRead);
+        return;
+    }
+
+#if SEQAN_HAS_ZLIB
+    if (index.compressed)
+    {
+        // decompress the bytes from the first to the last character of the region
+        CharString & buffer = index.regionBuffer;
+        _readBgzfRange(buffer, index,
+                       entry.offset + (beginPos / entry.lineLength) * entry.overallLineLength +
+                       beginPos % entry.lineLength,
+                       entry.offset + ((endPos - 1) / entry.lineLength) * entry.overallLineLength +
+                       (endPos - 1) % entry.lineLength + 1);
+
+        DirectionIterator<CharString, Input>::Type bufferReader = directionIterator(buffer, Input());
+        CountDownFunctor<NotFunctor<IsWhitespace> > countDownData(toRead);
+        IsWhitespace ignWhiteSpace;
+        readUntil(str, bufferReader, countDownData, ignWhiteSpace);
+        if (!countDownData)
+            SEQAN_THROW(UnexpectedEnd());
+        return;
+    }
+#endif
+
     // seek to start position
     DirectionIterator<std::ifstream, Input>::Type reader = directionIterator(index.file, Input());
     setPosition(
@@ -344,38 +593,45 @@ inline void readRegion(String<TValue, TSpec> & str,
     readUntil(str, reader, countDownData, ignWhiteSpace);
     if (!countDownData)
         SEQAN_THROW(UnexpectedEnd());
-//
-//
-//    typedef typename Iterator<String<char, MMap<> > const, Standard>::Type TSourceIter;
-//    typedef typename Iterator<String<TValue, TSpec>, Standard>::Type TTargetIter;
-//    TSourceIter itSource = begin(index.mmapString, Standard());
-//    __uint64 offset = index.indexEntryStore[rID].offset;
-//    // First, compute offset of the completely filled lines.
-//    unsigned numLines = beginPos / index.indexEntryStore[rID].lineLength;
-//    unsigned numBytes = numLines * index.indexEntryStore[rID].overallLineLength;
-//    // Then, compute overall offset by adding remaining bytes, too.
-//    numBytes += beginPos % index.indexEntryStore[rID].lineLength;
-//    offset += numBytes;
-//    // Advance iterator in MMap file.
-//    itSource += offset;
-//
-//    // Copy out the characters from FASTA file and convert via iterator assignment to target string's type.
-//    resize(str, toRead, TValue());
-//    TTargetIter itTarget = begin(str, Standard());
-//    for (TEndPos i = 0; i < toRead; )
-//    {
-//        if (isspace(*itSource))
-//        {
-//            ++itSource;
-//            continue;  // Skip spaces.
-//        }
-//        *itTarget = *itSource;
-//        ++itTarget;
-//        ++itSource;
-//        ++i;
-//    }
-//
-//    return true;
+}
+
+template <typename TSeqId, typename TBeginPos, typename TEndPos>
+inline bool readRegion(Segment<String<char, MMap<> > const, InfixSegment> & infix,
+                       FaiIndex const & index,
+                       TSeqId rID,
+                       TBeginPos beginPos,
+                       TEndPos endPos)
+{
+    if (empty(index.mmapString))
+        return false;
+
+    FaiIndexEntry_ const & entry = index.indexEntryStore[rID];
+
+    // Limit region to the infix, make sure that beginPos < endPos.
+    TEndPos seqLen = entry.sequenceLength;
+    beginPos = std::min((TEndPos)beginPos, seqLen);
+    endPos = std::min(std::max((TEndPos)beginPos, endPos), seqLen);
+
+    setHost(infix, index.mmapString);
+    if (endPos == beginPos)
+    {
+        setBeginPosition(infix, 0);
+        setEndPosition(infix, 0);
+        return true;
+    }
+
+    // The region must not contain a line break.
+    unsigned column = beginPos % entry.lineLength;
+    if (endPos - beginPos > (TEndPos)(entry.lineLength - column))
+        return false;
+
+    __uint64 beginOfs = entry.offset + (beginPos / entry.lineLength) * (__uint64)entry.overallLineLength + column;
+    if (beginOfs + (endPos - beginPos) > length(index.mmapString))
+        SEQAN_THROW(UnexpectedEnd());
+
+    setBeginPosition(infix, beginOfs);
+    setEndPosition(infix, beginOfs + (endPos - beginPos));
+    return true;
 }
 
 template <typename TValue, typename TSpec>
@@ -471,6 +727,58 @@ readRecord(FaiIndexEntry_ & entry, TFwdIterator & reader, CharString & buffer)
     skipLine(reader);           // Skip over line ending.
 }
 
+// ---------------------------------------------------------------------------
+// Function _readGziFile()
+// ---------------------------------------------------------------------------
+
+// The GZI file stores the number of entries followed by the pairs of compressed and uncompressed offsets, all as
+// little-endian 64 bit integers.
+
+inline bool _readGziFile(String<Pair<__uint64, __uint64> > & entries, char const * gziFilename)
+{
+    clear(entries);
+
+    std::ifstream gziStream(gziFilename, std::ios_base::in | std::ios_base::binary);
+    if (!gziStream.good())
+        return false;
+
+    __uint64 numEntries = 0;
+    if (!gziStream.read(reinterpret_cast<char *>(&numEntries), sizeof(__uint64)))
+        return false;
+
+    resize(entries, numEntries, Exact());
+    for (__uint64 i = 0; i < numEntries; ++i)
+    {
+        if (!gziStream.read(reinterpret_cast<char *>(&entries[i].i1), sizeof(__uint64)) ||
+            !gziStream.read(reinterpret_cast<char *>(&entries[i].i2), sizeof(__uint64)))
+        {
+            clear(entries);
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Function _writeGziFile()
+// ---------------------------------------------------------------------------
+
+inline bool _writeGziFile(char const * gziFilename, String<Pair<__uint64, __uint64> > const & entries)
+{
+    std::ofstream gziStream(gziFilename, std::ios_base::out | std::ios_base::binary);
+    if (!gziStream.good())
+        return false;
+
+    __uint64 numEntries = length(entries);
+    gziStream.write(reinterpret_cast<char const *>(&numEntries), sizeof(__uint64));
+    for (__uint64 i = 0; i < numEntries; ++i)
+    {
+        gziStream.write(reinterpret_cast<char const *>(&entries[i].i1), sizeof(__uint64));
+        gziStream.write(reinterpret_cast<char const *>(&entries[i].i2), sizeof(__uint64));
+    }
+    return gziStream.good();
+}
+
 // ---------------------------------------------------------------------------
 // Function open()
 // ---------------------------------------------------------------------------
@@ -479,21 +787,31 @@ readRecord(FaiIndexEntry_ & entry, TFwdIterator & reader, CharString & buffer)
  * @fn FaiIndex#open
  * @brief Open a FaiIndex object.
  *
- * @signature bool open(faiIndex, fastaFilename [, faiFileName]);
+ * @signature bool open(faiIndex, fastaFilename [, faiFileName[, gziFileName]][, openMode]);
+ *
+ * The FASTA file may be compressed with BGZF (e.g. by <tt>bgzip</tt>).  Regions are then read by decompressing only
+ * the blocks that hold them, which are looked up in the GZI file.  If the GZI file does not exist, the block offsets
+ * are collected from the block headers of the FASTA file.
  *
  * @param[in] faiIndex      The FaiIndex to write out.
  * @param[in] fastaFilename Path to the FASTA file to build an index for.  Type: <tt>char const *</tt>.
  * @param[in] faiFileName   The name of the FAI file to open.  This parameter is optional.  By default, the FAI
  *                          file name is derived from the FASTA file name.  Type: <tt>char const *</tt>.
+ * @param[in] gziFileName   The name of the GZI file to open for BGZF compressed FASTA files.  This parameter is
+ *                          optional.  Default: <tt>"${fastaFilename}.gzi"</tt>.  Type: <tt>char const *</tt>.
+ * @param[in] openMode      <tt>OPEN_RDONLY | OPEN_MMAP</tt> maps an uncompressed FASTA file into memory, so regions
+ *                          are read without any file access.  Default: <tt>OPEN_RDONLY</tt>.  Type: <tt>int</tt>.
  *
  * @return bool <tt>true</tt> on success, <tt>false</tt> otherwise.
  */
 
-inline bool open(FaiIndex & index, char const * fastaFilename, char const * faiFilename)
+inline bool open(FaiIndex & index, char const * fastaFilename, char const * faiFilename, char const * gziFilename,
+                 int openMode = OPEN_RDONLY)
 {
     clear(index);  // Also clears filename, thus backup above and restore below.
     index.fastaFilename = fastaFilename;
     index.faiFilename = faiFilename;
+    index.gziFilename = gziFilename;
 
     if (!open(index.file, toCString(fastaFilename), OPEN_RDONLY))
         return false;  // Could not open file.
@@ -516,14 +834,29 @@ inline bool open(FaiIndex & index, char const * fastaFilename, char const * faiF
 
     // Recreate name store cache.
     refresh(index.seqNameStoreCache);
+
+    // Load the block offsets of a compressed FASTA file.
+    index.compressed = _isBgzfFile(index.file);
+    if (index.compressed)
+        return _readGziFile(index.gziEntries, gziFilename) || _buildGziEntries(index.gziEntries, index.file);
+
+    if (openMode & OPEN_MMAP)
+        return open(index.mmapString, fastaFilename, OPEN_RDONLY);
     return true;
 }
 
-inline bool open(FaiIndex & index, char const * fastaFilename)
+inline bool open(FaiIndex & index, char const * fastaFilename, char const * faiFilename, int openMode = OPEN_RDONLY)
+{
+    std::string gziFilename = fastaFilename;
+    gziFilename += ".gzi";
+    return open(index, fastaFilename, faiFilename, toCString(gziFilename), openMode);
+}
+
+inline bool open(FaiIndex & index, char const * fastaFilename, int openMode = OPEN_RDONLY)
 {
     std::string faiFilename = fastaFilename;
     faiFilename += ".fai";
-    return open(index, fastaFilename, toCString(faiFilename));
+    return open(index, fastaFilename, toCString(faiFilename), openMode);
 }
 
 // ---------------------------------------------------------------------------
@@ -534,13 +867,16 @@ inline bool open(FaiIndex & index, char const * fastaFilename)
  * @fn FaiIndex#save
  * @brief Save a FaiIndex object.
  *
- * @signature bool save(faiIndex[, faiFileName]);
+ * @signature bool save(faiIndex[, faiFileName[, gziFileName]]);
  *
  * @param[in] faiIndex    The FaiIndex to write out.
  * @param[in] faiFileName The name of the FAI file to write to.  This parameter is optional only if the FAI index knows
  *                        the FAI file name from a previous @link FaiIndex#build @endlink call.  By default, the FAI
  *                        file name from the previous call to @link FaiIndex#build @endlink is used.  Type: <tt>char
  *                        const *</tt>.
+ * @param[in] gziFileName The name of the GZI file to write the block offsets of a BGZF compressed FASTA file to.
+ *                        If omitted together with <tt>faiFileName</tt>, the GZI file name from the previous call to
+ *                        @link FaiIndex#build @endlink is used.  Type: <tt>char const *</tt>.
  *
  * @return bool <tt>true</tt> on success, <tt>false</tt> otherwise.
  */
@@ -562,10 +898,23 @@ inline bool save(FaiIndex const & index, char const * faiFilename)
     return true;
 }
 
+inline bool save(FaiIndex const & index, char const * faiFilename, char const * gziFilename)
+{
+    if (!save(index, faiFilename))
+        return false;
+    return !index.compressed || _writeGziFile(gziFilename, index.gziEntries);
+}
+
 inline bool save(FaiIndex const & index)
 {
     if (empty(index.faiFilename))
         return false;  // Cannot write out if faiFilename member is empty.
+    if (index.compressed)
+    {
+        if (empty(index.gziFilename))
+            return false;
+        return save(index, toCString(index.faiFilename), toCString(index.gziFilename));
+    }
     return save(index, toCString(index.faiFilename));
 }
 
@@ -641,38 +990,69 @@ inline void getRecordInfo(FaiIndexEntry_ & entry, TFwdIterator & iter, Fasta)
  * @fn FaiIndex#build
  * @brief Create a FaiIndex from FASTA file.
  *
- * @signature bool build(faiIndex, fastaFilename[, faiFileName]);
+ * @signature bool build(faiIndex, fastaFilename[, faiFileName[, gziFileName]]);
+ *
+ * For BGZF compressed FASTA files, the block offsets for the GZI file are collected as well.
  *
  * @param[out] faiIndex      The FaiIndex to build into.
  * @param[in]  fastaFilename Path to the FASTA file to build an index for.  Type: <tt>char const *</tt>.
  * @param[in]  faiFileName   Path to the FAI file to use as the index file.  Type: <tt>char const *</tt>.
  *                           Default: <tt>"${fastaFilename}.fai"</tt>.
+ * @param[in]  gziFileName   Path to the GZI file to use for BGZF compressed FASTA files.  Type: <tt>char const
+ *                           *</tt>.  Default: <tt>"${fastaFilename}.gzi"</tt>.
  *
  * @return bool <tt>true</tt> on success, <tt>false</tt> otherwise.
  */
 
-inline bool build(FaiIndex & index, char const * fastaFilename, char const * faiFilename)
+inline bool build(FaiIndex & index, char const * fastaFilename, char const * faiFilename, char const * gziFilename)
 {
     index.fastaFilename = fastaFilename;
     index.faiFilename = faiFilename;
+    index.gziFilename = gziFilename;
 
     if (!open(index.file, toCString(fastaFilename), OPEN_RDONLY))
         return false;  // Could not open file.
 
-    DirectionIterator<std::ifstream, Input>::Type iter = directionIterator(index.file, Input());
-
     // Clear everything.
     clear(index.seqNameStore);
     clear(index.seqNameStoreCache);
     clear(index.indexEntryStore);
+    clear(index.gziEntries);
 
     // Create FastaIndex
     FaiIndexEntry_ entry;
-    while (!atEnd(iter))
+    index.compressed = _isBgzfFile(index.file);
+    if (index.compressed)
     {
-        getRecordInfo(entry, iter, Fasta());
-        appendValue(index.seqNameStore, entry.name);
-        appendValue(index.indexEntryStore, entry);
+#if SEQAN_HAS_ZLIB
+        if (!_buildGziEntries(index.gziEntries, index.file))
+            return false;
+
+        // The offsets of the decompressing stream are BGZF virtual offsets.
+        {
+            basic_bgzf_istream<char> bgzfStream(index.file);
+            DirectionIterator<basic_bgzf_istream<char>, Input>::Type iter = directionIterator(bgzfStream, Input());
+            while (!atEnd(iter))
+            {
+                getRecordInfo(entry, iter, Fasta());
+                if (!_gziUncompressedOffset(entry.offset, index, entry.offset))
+                    return false;  // The GZI entries do not match the file.
+                appendValue(index.seqNameStore, entry.name);
+                appendValue(index.indexEntryStore, entry);
+            }
+        }
+        index.file.clear();
+#endif
+    }
+    else
+    {
+        DirectionIterator<std::ifstream, Input>::Type iter = directionIterator(index.file, Input());
+        while (!atEnd(iter))
+        {
+            getRecordInfo(entry, iter, Fasta());
+            appendValue(index.seqNameStore, entry.name);
+            appendValue(index.indexEntryStore, entry);
+        }
     }
 
     // Recreate name store cache.
@@ -681,6 +1061,13 @@ inline bool build(FaiIndex & index, char const * fastaFilename, char const * fai
     return true;
 }
 
+inline bool build(FaiIndex & index, char const * fastaFilename, char const * faiFilename)
+{
+    CharString gziFilename(fastaFilename);
+    append(gziFilename, ".gzi");
+    return build(index, fastaFilename, faiFilename, toCString(gziFilename));
+}
+
 inline bool build(FaiIndex & index, char const * seqFilename)
 {
     CharString faiFilename(seqFilename);
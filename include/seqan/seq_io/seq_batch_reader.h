@@ -0,0 +1,458 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Reads batches of records from a SeqFileIn with a reader thread and
+// several parser threads.
+// ==========================================================================
+
+#ifndef SEQAN_SEQ_IO_SEQ_BATCH_READER_H_
+#define SEQAN_SEQ_IO_SEQ_BATCH_READER_H_
+
+namespace seqan {
+
+// ============================================================================
+// Classes
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class SeqBatchReader
+// ----------------------------------------------------------------------------
+
+/*!
+ * @class SeqBatchReader
+ * @headerfile <seqan/seq_io.h>
+ * @brief Reads batches of records from a @link SeqFileIn @endlink in parallel.
+ *
+ * @signature template <typename TSeqAlphabet, typename TSpec>
+ *            class SeqBatchReader;
+ *
+ * @tparam TSeqAlphabet The alphabet of the sequences, defaults to @link Dna5 @endlink.  If the alphabet has
+ *                      qualities, e.g. @link Dna5Q @endlink, the qualities are also stored in the sequences.
+ * @tparam TSpec        The specialization of the @link SeqFileIn @endlink, defaults to <tt>void</tt>.
+ *
+ * A reader thread reads large chunks of raw text from the file and cuts them at the last record that begins
+ * in the chunk.  The remainder is carried over to the next chunk.  Parser threads convert the chunks into batches
+ * of ids, sequences and qualities, which are returned by @link SeqBatchReader#readBatch @endlink in the order
+ * of the file.
+ *
+ * Records are separated at lines beginning with <tt>&gt;</tt> for FASTA files and at lines beginning with
+ * <tt>@</tt> that are followed by a <tt>+</tt> line two lines further for FASTQ files.  The latter requires the
+ * sequence and the qualities of a FASTQ record to be on one line each, as written by sequencers.  Other formats
+ * are read sequentially by the calling thread.
+ *
+ * The file must not be used directly while the reader exists.
+ *
+ * @section Examples
+ *
+ * @code{.cpp}
+ * SeqFileIn seqFileIn("reads.fq");
+ * SeqBatchReader<Dna5> reader(seqFileIn, 8);
+ *
+ * StringSet<CharString, Owner<ConcatDirect<> > > ids, quals;
+ * StringSet<Dna5String, Owner<ConcatDirect<> > > seqs;
+ * while (readBatch(ids, seqs, quals, reader))
+ * {
+ *     // process the batch
+ * }
+ * @endcode
+ */
+
+template <typename TSeqAlphabet = Dna5, typename TSpec = void>
+class SeqBatchReader
+{
+public:
+    typedef FormattedFile<Fastq, Input, TSpec>                          TFile;
+    typedef typename FileFormat<TFile>::Type                            TFormat;
+    typedef StringSet<CharString, Owner<ConcatDirect<> > >              TIdSet;
+    typedef StringSet<String<TSeqAlphabet>, Owner<ConcatDirect<> > >    TSeqSet;
+    typedef StringSet<CharString, Owner<ConcatDirect<> > >              TQualSet;
+    typedef ConcurrentQueue<size_t, Suspendable<Limit> >                TJobQueue;
+
+    struct Batch
+    {
+        CharString      text;           // the raw records
+        TIdSet          ids;
+        TSeqSet         seqs;
+        TQualSet        quals;
+        std::string     ioError;
+        std::string     parseError;
+
+        CriticalSection cs;
+        Condition       readyEvent;
+        bool            ready;
+
+        Batch() :
+            readyEvent(cs),
+            ready(true)
+        {}
+    };
+
+    struct ReaderThread
+    {
+        SeqBatchReader  *reader;
+
+        void operator()()
+        {
+            reader->readChunks();
+        }
+    };
+
+    struct ParserThread
+    {
+        SeqBatchReader          *reader;
+        CharString              id;
+        String<TSeqAlphabet>    seq;
+        CharString              qual;
+
+        void operator()()
+        {
+            ScopedReadLock<TJobQueue> readLock(reader->parseQueue);
+
+            size_t batchId;
+            while (popFront(batchId, reader->parseQueue))
+            {
+                Batch &batch = reader->batches[batchId];
+                reader->parseChunk(batch, id, seq, qual);
+
+                ScopedLock<CriticalSection> lock(batch.cs);
+                batch.ready = true;
+                signal(batch.readyEvent);
+            }
+        }
+    };
+
+    TFile                   &file;
+    TFormat                 format;
+    bool                    parallel;       // false if the format has no known record separator
+    size_t                  chunkSize;
+    size_t                  numBatches;
+    Batch                   *batches;
+    TJobQueue               idleQueue;      // batches that can be filled by the reader thread
+    TJobQueue               parseQueue;     // batches that wait for a parser thread
+    TJobQueue               orderQueue;     // filled batches in the order of the file
+    CharString              tail;           // beginning of the next record after the last chunk
+    TQualSet                discardedQuals;
+
+    CriticalSection         cs;
+    bool                    closing;
+
+    size_t                  numThreads;
+    Thread<ReaderThread>    readerThread;
+    Thread<ParserThread>    *parserThreads;
+
+    // numBatches chunks of chunkSize bytes are read ahead, they are parsed by numThreads threads
+    SeqBatchReader(TFile & file,
+                   size_t numThreads = 4,
+                   size_t chunkSize = 4 * 1024 * 1024,
+                   size_t numBatches = 0) :
+        file(file),
+        format(file.format),
+        parallel(isEqual(format, Fastq()) || isEqual(format, Fasta()) || isEqual(format, Raw())),
+        chunkSize(std::max(chunkSize, (size_t)1)),
+        numBatches(numBatches != 0 ? numBatches : 2 * std::max(numThreads, (size_t)1)),
+        batches(NULL),
+        idleQueue(this->numBatches),
+        parseQueue(this->numBatches),
+        orderQueue(this->numBatches),
+        closing(false),
+        numThreads(std::max(numThreads, (size_t)1)),
+        parserThreads(NULL)
+    {
+        if (!parallel)
+            return;
+
+        batches = new Batch[this->numBatches];
+
+        lockReading(idleQueue);
+        lockWriting(idleQueue);
+        setReaderWriterCount(idleQueue, 1, 1);
+        lockReading(parseQueue);
+        lockWriting(parseQueue);
+        setReaderWriterCount(parseQueue, this->numThreads, 1);
+        lockReading(orderQueue);
+        lockWriting(orderQueue);
+        setReaderWriterCount(orderQueue, 1, 1);
+
+        for (size_t i = 0; i < this->numBatches; ++i)
+            appendValue(idleQueue, i);
+
+        parserThreads = new Thread<ParserThread>[this->numThreads];
+        for (size_t i = 0; i < this->numThreads; ++i)
+        {
+            parserThreads[i].worker.reader = this;
+            run(parserThreads[i]);
+        }
+        readerThread.worker.reader = this;
+        run(readerThread);
+    }
+
+    ~SeqBatchReader()
+    {
+        if (!parallel)
+            return;
+
+        // stop reading ahead, the reader thread finishes its current chunk
+        {
+            ScopedLock<CriticalSection> lock(cs);
+            closing = true;
+        }
+        unlockWriting(idleQueue);
+        waitFor(readerThread);
+
+        for (size_t i = 0; i < numThreads; ++i)
+            waitFor(parserThreads[i]);
+        unlockReading(orderQueue);
+
+        delete[] parserThreads;
+        delete[] batches;
+    }
+
+    // called by the reader thread
+    void readChunks()
+    {
+        ScopedReadLock<TJobQueue> readLock(idleQueue);
+        ScopedWriteLock<TJobQueue> parseLock(parseQueue);
+        ScopedWriteLock<TJobQueue> orderLock(orderQueue);
+
+        size_t batchId;
+        bool eof = false;
+
+        while (!eof && popFront(batchId, idleQueue))
+        {
+            {
+                ScopedLock<CriticalSection> lock(cs);
+                if (closing)
+                    break;
+            }
+
+            Batch &batch = batches[batchId];
+            clear(batch.ioError);
+            batch.text = tail;
+
+            // read until the chunk contains the beginning of a record other than the first
+            size_t splitPos = 0;
+            while (splitPos == 0)
+            {
+                size_t oldLength = length(batch.text);
+                resize(batch.text, oldLength + chunkSize);
+                file.stream.read(begin(batch.text, Standard()) + oldLength, chunkSize);
+                resize(batch.text, oldLength + file.stream.gcount());
+
+                if (!file.stream.good())
+                {
+                    if (file.stream.bad())
+                        batch.ioError = "Stream read error.";
+                    eof = true;
+                    splitPos = length(batch.text);
+                    break;
+                }
+                splitPos = _findLastRecordBegin(batch.text, format);
+            }
+
+            tail = suffix(batch.text, splitPos);
+            resize(batch.text, splitPos);
+
+            if (eof && empty(batch.text) && empty(batch.ioError))
+                break;
+
+            batch.ready = false;
+            appendValue(parseQueue, batchId);
+            appendValue(orderQueue, batchId);
+        }
+    }
+
+    // called by a parser thread
+    void parseChunk(Batch & batch, CharString & id, String<TSeqAlphabet> & seq, CharString & qual)
+    {
+        typedef typename Iterator<CharString, Rooted>::Type TIter;
+
+        clear(batch.ids);
+        clear(batch.seqs);
+        clear(batch.quals);
+        clear(batch.parseError);
+
+        try
+        {
+            TIter iter = begin(batch.text, Rooted());
+            while (!atEnd(iter))
+            {
+                readRecord(id, seq, qual, iter, format);
+                assignQualities(seq, qual);
+                appendValue(batch.ids, id);
+                appendValue(batch.seqs, seq);
+                appendValue(batch.quals, qual);
+            }
+        }
+        catch (ParseError const & e)
+        {
+            batch.parseError = e.what();
+        }
+    }
+
+private:
+    SeqBatchReader(SeqBatchReader const &);
+    SeqBatchReader & operator=(SeqBatchReader const &);
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function _findLastRecordBegin()
+// ----------------------------------------------------------------------------
+
+// Returns the position of the last record that begins in text after the first
+// one, or 0 if there is none.
+
+template <typename TFormat>
+inline size_t
+_findLastRecordBegin(CharString const & text, TFormat const & format)
+{
+    typedef typename Iterator<CharString const, Standard>::Type TIter;
+
+    TIter textBegin = begin(text, Standard());
+    TIter textEnd = end(text, Standard());
+
+    if (isEqual(format, Raw()))
+    {
+        // one record per line
+        for (TIter it = textEnd; it != textBegin; --it)
+            if (*(it - 1) == '\n')
+                return it - textBegin;
+        return 0;
+    }
+
+    if (isEqual(format, Fasta()))
+    {
+        for (TIter it = textEnd - 1; it > textBegin; --it)
+            if (*it == '>' && *(it - 1) == '\n')
+                return it - textBegin;
+        return 0;
+    }
+
+    // FASTQ: a line starting with '@' and a line starting with '+' two lines further
+    // identify a record, as quality lines can start with '@' or '+' as well
+    TIter lineBegins[2] = { textEnd, textEnd };
+    for (TIter it = textEnd - 1; it > textBegin; --it)
+    {
+        if (*(it - 1) != '\n')
+            continue;
+        if (*it == '@' && lineBegins[1] != textEnd && *lineBegins[1] == '+')
+            return it - textBegin;
+        lineBegins[1] = lineBegins[0];
+        lineBegins[0] = it;
+    }
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Function readBatch()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn SeqBatchReader#readBatch
+ * @brief Read the next batch of records from a @link SeqBatchReader @endlink.
+ *
+ * @signature bool readBatch(ids, seqs[, quals], reader);
+ *
+ * @param[out]    ids    A <tt>StringSet&lt;CharString, Owner&lt;ConcatDirect&lt;&gt; &gt; &gt;</tt> to store the ids in.
+ * @param[out]    seqs   A <tt>StringSet&lt;String&lt;TSeqAlphabet&gt;, Owner&lt;ConcatDirect&lt;&gt; &gt; &gt;</tt> to
+ *                       store the sequences in.
+ * @param[out]    quals  A <tt>StringSet&lt;CharString, Owner&lt;ConcatDirect&lt;&gt; &gt; &gt;</tt> to store the
+ *                       qualities in.
+ * @param[in,out] reader The @link SeqBatchReader @endlink to read from.
+ *
+ * @return bool <tt>false</tt> if there are no more records, <tt>true</tt> otherwise.
+ *
+ * The string sets are exchanged with the buffers of the reader, so their memory is reused for later batches.
+ *
+ * @throw IOError On low-level I/O errors.
+ * @throw ParseError On high-level file format errors.
+ */
+
+template <typename TSeqAlphabet, typename TSpec>
+inline bool
+readBatch(typename SeqBatchReader<TSeqAlphabet, TSpec>::TIdSet & ids,
+          typename SeqBatchReader<TSeqAlphabet, TSpec>::TSeqSet & seqs,
+          typename SeqBatchReader<TSeqAlphabet, TSpec>::TQualSet & quals,
+          SeqBatchReader<TSeqAlphabet, TSpec> & reader)
+{
+    typedef typename SeqBatchReader<TSeqAlphabet, TSpec>::Batch TBatch;
+
+    clear(ids);
+    clear(seqs);
+    clear(quals);
+
+    if (!reader.parallel)
+    {
+        while (!atEnd(reader.file) && lengthSum(ids) + lengthSum(seqs) < reader.chunkSize)
+            readRecords(ids, seqs, quals, reader.file, 1u);
+        return !empty(ids);
+    }
+
+    size_t batchId;
+    while (empty(ids) && popFront(batchId, reader.orderQueue))
+    {
+        TBatch &batch = reader.batches[batchId];
+        {
+            ScopedLock<CriticalSection> lock(batch.cs);
+            while (!batch.ready)
+                waitFor(batch.readyEvent);
+        }
+
+        swap(ids, batch.ids);
+        swap(seqs, batch.seqs);
+        swap(quals, batch.quals);
+        std::string ioError = batch.ioError;
+        std::string parseError = batch.parseError;
+        appendValue(reader.idleQueue, batchId);
+
+        if (!ioError.empty())
+            throw IOError(ioError.c_str());
+        if (!parseError.empty())
+            throw ParseError(parseError);
+    }
+    return !empty(ids);
+}
+
+template <typename TSeqAlphabet, typename TSpec>
+inline bool
+readBatch(typename SeqBatchReader<TSeqAlphabet, TSpec>::TIdSet & ids,
+          typename SeqBatchReader<TSeqAlphabet, TSpec>::TSeqSet & seqs,
+          SeqBatchReader<TSeqAlphabet, TSpec> & reader)
+{
+    return readBatch(ids, seqs, reader.discardedQuals, reader);
+}
+
+}  // namespace seqan
+
+#endif  // SEQAN_SEQ_IO_SEQ_BATCH_READER_H_
@@ -53,7 +53,7 @@ namespace seqan {
  * @signature typedef FormattedFile<Fastq, Input> SeqFileIn;
  * @extends FormattedFileIn
  * @headerfile <seqan/seq_io.h>
- * @brief Class for reading RAW, FASTA, FASTQ, EMBL and GENBANK files containing unaligned sequences.
+ * @brief Class for reading RAW, FASTA, FASTQ, EMBL, GENBANK and 2bit files containing unaligned sequences.
  */
 
 typedef FormattedFile<Fastq, Input>     SeqFileIn;
@@ -63,7 +63,10 @@ typedef FormattedFile<Fastq, Input>     SeqFileIn;
  * @signature typedef FormattedFile<Fastq, Output> SeqFileOut;
  * @extends FormattedFileOut
  * @headerfile <seqan/seq_io.h>
- * @brief Class for writing RAW, FASTA, FASTQ, EMBL and GENBANK files containing unaligned sequences.
+ * @brief Class for writing RAW, FASTA, FASTQ, EMBL, GENBANK and 2bit files containing unaligned sequences.
+ *
+ * The records of a 2bit file are kept in memory and written when the file is closed, as the index at the beginning
+ * of a 2bit file refers to all of them.
  */
 
 typedef FormattedFile<Fastq, Output>    SeqFileOut;
@@ -88,15 +91,17 @@ typedef
     TagList<Fasta,
     TagList<Embl,
     TagList<GenBank,
+    TagList<TwoBit,
     TagList<Raw
-    > > > > >
+    > > > > > >
     SeqInFormats;
 
 typedef
     TagList<Fastq,
     TagList<Fasta,
+    TagList<TwoBit,
     TagList<Raw
-    > > >
+    > > > >
     SeqOutFormats;
 
 typedef TagSelector<SeqInFormats>   SeqInFormat;
@@ -134,12 +139,14 @@ struct SeqFileContext_<Input>
 {
     Tuple<CharString, 3>    buffer;
     Dna5QString             hybrid;
+    TwoBitContext_<Input>   twoBit;
 };
 
 template <>
 struct SeqFileContext_<Output>
 {
     SequenceOutputOptions   options;
+    TwoBitContext_<Output>  twoBit;
 };
 
 // ----------------------------------------------------------------------------
@@ -196,7 +203,10 @@ inline SEQAN_FUNC_ENABLE_IF(And<Is<InputStreamConcept<typename FormattedFile<Fas
                                 Not<HasQualities<typename Value<TSeqString>::Type> > >, void)
 readRecord(TIdString & meta, TSeqString & seq, FormattedFile<Fastq, Input, TSpec> & file)
 {
-    readRecord(meta, seq, file.iter, file.format);
+    if (isEqual(file.format, TwoBit()))
+        _readTwoBitRecord(meta, seq, context(file).twoBit, file.iter);
+    else
+        readRecord(meta, seq, file.iter, file.format);
 }
 
 // ----------------------------------------------------------------------------
@@ -208,6 +218,11 @@ inline SEQAN_FUNC_ENABLE_IF(And<Is<InputStreamConcept<typename FormattedFile<Fas
                                 HasQualities<typename Value<TSeqString>::Type> >, void)
 readRecord(TIdString & meta, TSeqString & seq, FormattedFile<Fastq, Input, TSpec> & file)
 {
+    if (isEqual(file.format, TwoBit()))
+    {
+        _readTwoBitRecord(meta, seq, context(file).twoBit, file.iter);
+        return;
+    }
     readRecord(meta, seq, context(file).buffer[2], file.iter, file.format);
     assignQualities(seq, context(file).buffer[2]);
 }
@@ -220,6 +235,12 @@ template <typename TSpec, typename TIdString, typename TSeqString, typename TQua
 inline SEQAN_FUNC_ENABLE_IF(Is<InputStreamConcept<typename FormattedFile<Fastq, Input, TSpec>::TStream> >, void)
 readRecord(TIdString & meta, TSeqString & seq, TQualString & qual, FormattedFile<Fastq, Input, TSpec> & file)
 {
+    if (isEqual(file.format, TwoBit()))
+    {
+        clear(qual);
+        _readTwoBitRecord(meta, seq, context(file).twoBit, file.iter);
+        return;
+    }
     readRecord(meta, seq, qual, file.iter, file.format);
 }
 
@@ -231,6 +252,11 @@ readRecord(TIdString & meta, TSeqString & seq, TQualString & qual, FormattedFile
  * @fn SeqFileIn#readRecords
  * @brief Read many @link FormattedFileRecordConcept @endlink from a @link SeqFileIn @endlink object.
  * @signature void readRecords(metas, seqs, quals, fileIn, numRecord);
+ *
+ * The records are appended to the string sets.  Use @link StringSet @endlink objects with the <tt>Owner&lt;ConcatDirect&lt;&gt; &gt;</tt>
+ * specialization to avoid allocating one string per record.  Their capacity is kept by @link StringSet#clear @endlink,
+ * so reading batch by batch into the same cleared sets reuses the memory of the previous batch.
+ *
  * @see SeqFileIn#readRecord
  */
 
@@ -249,10 +275,10 @@ swapPtr(TPtrA &a, TPtrB &b)
 }
 
 template <typename TIdStringSet, typename TSeqStringSet, typename TSpec, typename TSize>
-inline void readRecords(TIdStringSet & meta,
-                        TSeqStringSet & seq,
-                        FormattedFile<Fastq, Input, TSpec> & file,
-                        TSize maxRecords)
+inline void _readRecords(TIdStringSet & meta,
+                         TSeqStringSet & seq,
+                         FormattedFile<Fastq, Input, TSpec> & file,
+                         TSize maxRecords)
 {
     typedef typename SeqFileBuffer_<TSeqStringSet, TSpec>::Type TSeqBuffer;
 
@@ -276,6 +302,15 @@ inline void readRecords(TIdStringSet & meta,
     seqBuffer.data_capacity = 0;
 }
 
+template <typename TIdStringSet, typename TSeqStringSet, typename TSpec, typename TSize>
+inline void readRecords(TIdStringSet & meta,
+                        TSeqStringSet & seq,
+                        FormattedFile<Fastq, Input, TSpec> & file,
+                        TSize maxRecords)
+{
+    _readRecords(meta, seq, file, maxRecords);
+}
+
 // ----------------------------------------------------------------------------
 // Function readRecords(); Without max records
 // ----------------------------------------------------------------------------
@@ -293,11 +328,11 @@ inline void readRecords(TIdStringSet & meta,
 // ----------------------------------------------------------------------------
 
 template <typename TIdStringSet, typename TSeqStringSet, typename TQualStringSet, typename TSpec, typename TSize>
-inline void readRecords(TIdStringSet & meta,
-                        TSeqStringSet & seq,
-                        TQualStringSet & qual,
-                        FormattedFile<Fastq, Input, TSpec> & file,
-                        TSize maxRecords)
+inline void _readRecords(TIdStringSet & meta,
+                         TSeqStringSet & seq,
+                         TQualStringSet & qual,
+                         FormattedFile<Fastq, Input, TSpec> & file,
+                         TSize maxRecords)
 {
     typedef typename SeqFileBuffer_<TSeqStringSet, TSpec>::Type TSeqBuffer;
 
@@ -321,6 +356,16 @@ inline void readRecords(TIdStringSet & meta,
     std::swap(seqBuffer.data_capacity, context(file).buffer[1].data_capacity);
 }
 
+template <typename TIdStringSet, typename TSeqStringSet, typename TQualStringSet, typename TSpec, typename TSize>
+inline void readRecords(TIdStringSet & meta,
+                        TSeqStringSet & seq,
+                        TQualStringSet & qual,
+                        FormattedFile<Fastq, Input, TSpec> & file,
+                        TSize maxRecords)
+{
+    _readRecords(meta, seq, qual, file, maxRecords);
+}
+
 // ----------------------------------------------------------------------------
 // Function readRecords(); With separate qualities; Without max records
 // ----------------------------------------------------------------------------
@@ -334,6 +379,57 @@ inline void readRecords(TIdStringSet & meta,
     readRecords(meta, seq, qual, file, MaxValue<__uint64>::VALUE);
 }
 
+// ----------------------------------------------------------------------------
+// Function _reserveRecords()
+// ----------------------------------------------------------------------------
+
+// Reserves the limits of a concatenated string set for the records of a batch.
+// At most 2^20 records are reserved in advance, the limits grow generously beyond.
+
+template <typename TString, typename TSpec, typename TSize>
+inline void
+_reserveRecords(StringSet<TString, Owner<ConcatDirect<TSpec> > > & stringSet, TSize maxRecords)
+{
+    if (maxRecords == MaxValue<TSize>::VALUE)
+        return;
+
+    __uint64 numRecords = std::min((__uint64)maxRecords, (__uint64)1 << 20);
+    reserve(stringSet.limits, length(stringSet.limits) + numRecords, Exact());
+}
+
+// ----------------------------------------------------------------------------
+// Function readRecords(); Concatenated string sets
+// ----------------------------------------------------------------------------
+
+// The records are appended to the concatenation strings of the sets and no string is allocated per record.
+// As clear() keeps the capacity of the sets, reading further batches into the same sets allocates no memory
+// once the sets have grown to the size of a batch.
+
+template <typename TIdString, typename TIdSpec, typename TSeqString, typename TSeqSpec, typename TSpec, typename TSize>
+inline void readRecords(StringSet<TIdString, Owner<ConcatDirect<TIdSpec> > > & meta,
+                        StringSet<TSeqString, Owner<ConcatDirect<TSeqSpec> > > & seq,
+                        FormattedFile<Fastq, Input, TSpec> & file,
+                        TSize maxRecords)
+{
+    _reserveRecords(meta, maxRecords);
+    _reserveRecords(seq, maxRecords);
+    _readRecords(meta, seq, file, maxRecords);
+}
+
+template <typename TIdString, typename TIdSpec, typename TSeqString, typename TSeqSpec,
+          typename TQualString, typename TQualSpec, typename TSpec, typename TSize>
+inline void readRecords(StringSet<TIdString, Owner<ConcatDirect<TIdSpec> > > & meta,
+                        StringSet<TSeqString, Owner<ConcatDirect<TSeqSpec> > > & seq,
+                        StringSet<TQualString, Owner<ConcatDirect<TQualSpec> > > & qual,
+                        FormattedFile<Fastq, Input, TSpec> & file,
+                        TSize maxRecords)
+{
+    _reserveRecords(meta, maxRecords);
+    _reserveRecords(seq, maxRecords);
+    _reserveRecords(qual, maxRecords);
+    _readRecords(meta, seq, qual, file, maxRecords);
+}
+
 // ----------------------------------------------------------------------------
 // Function writeRecord()
 // ----------------------------------------------------------------------------
@@ -359,7 +455,10 @@ writeRecord(FormattedFile<Fastq, Output, TSpec> & file,
             TIdString const & meta,
             TSeqString const & seq)
 {
-    writeRecord(file.iter, meta, seq, file.format, context(file).options);
+    if (isEqual(file.format, TwoBit()))
+        _appendTwoBitRecord(context(file).twoBit, meta, seq);
+    else
+        writeRecord(file.iter, meta, seq, file.format, context(file).options);
 }
 
 // ----------------------------------------------------------------------------
@@ -373,7 +472,10 @@ writeRecord(FormattedFile<Fastq, Output, TSpec> & file,
             TSeqString const & seq,
             TQualString const & qual)
 {
-    writeRecord(file.iter, meta, seq, qual, file.format, context(file).options);
+    if (isEqual(file.format, TwoBit()))
+        _appendTwoBitRecord(context(file).twoBit, meta, seq);
+    else
+        writeRecord(file.iter, meta, seq, qual, file.format, context(file).options);
 }
 
 // ----------------------------------------------------------------------------
@@ -412,6 +514,37 @@ writeRecords(FormattedFile<Fastq, Output, TSpec> & file,
         writeRecord(file, meta[i], seq[i], qual[i]);
 }
 
+// ----------------------------------------------------------------------------
+// Function close()
+// ----------------------------------------------------------------------------
+
+// Resets the 2bit state on reading and writes the buffered 2bit records on writing.
+
+template <typename TSpec>
+inline void
+_closeTwoBit(FormattedFile<Fastq, Input, TSpec> & file)
+{
+    context(file).twoBit = TwoBitContext_<Input>();
+}
+
+template <typename TSpec>
+inline void
+_closeTwoBit(FormattedFile<Fastq, Output, TSpec> & file)
+{
+    if (isEqual(file.format, TwoBit()))
+        _writeTwoBitFile(file.iter, context(file).twoBit);
+    context(file).twoBit = TwoBitContext_<Output>();
+}
+
+template <typename TDirection, typename TSpec>
+inline bool close(FormattedFile<Fastq, TDirection, TSpec> & file)
+{
+    _closeTwoBit(file);
+    setFormat(file, typename FileFormat<FormattedFile<Fastq, TDirection, TSpec> >::Type());
+    file.iter = typename DirectionIterator<FormattedFile<Fastq, TDirection, TSpec>, TDirection>::Type();
+    return close(file.stream);
+}
+
 }  // namespace seqan
 
 #endif // SEQAN_SEQ_IO_SEQUENCE_FILE_H_
@@ -0,0 +1,884 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Input/Output on UCSC 2bit files.
+// ==========================================================================
+// A 2bit file consists of a header, an index with the names and file offsets
+// of all sequences, and one record per sequence.  A record stores the
+// sequence length, the ranges of N characters and of soft-masked (lower
+// case) characters, and the bases packed into 2 bits each (T=0, C=1, A=2,
+// G=3, first base in the highest bits).  All integers are little-endian.
+// ==========================================================================
+
+#ifndef INCLUDE_SEQAN_SEQ_IO_TWO_BIT_H_
+#define INCLUDE_SEQAN_SEQ_IO_TWO_BIT_H_
+
+namespace seqan {
+
+// ============================================================================
+// Tags, Classes, Enums
+// ============================================================================
+
+// --------------------------------------------------------------------------
+// Tag TwoBit
+// --------------------------------------------------------------------------
+
+/*!
+ * @tag FileFormats#TwoBit
+ * @headerfile <seqan/seq_io.h>
+ * @brief UCSC 2bit format for reference sequences.
+ *
+ * @signature typedef Tag<TwoBit_> TwoBit;
+ */
+
+struct TwoBit_;
+typedef Tag<TwoBit_> TwoBit;
+
+// --------------------------------------------------------------------------
+// Class TwoBitSequence
+// --------------------------------------------------------------------------
+
+/*!
+ * @class TwoBitSequence
+ * @headerfile <seqan/seq_io.h>
+ * @brief Read-only view of a sequence record in a 2bit file.
+ *
+ * @signature class TwoBitSequence;
+ *
+ * The view points into the memory holding the record, e.g. a 2bit file mapped by a @link TwoBitIndex @endlink, and
+ * decodes the packed bases on access.  Its values are @link Dna5 @endlink characters, positions inside of N blocks
+ * are <tt>N</tt>.  A view can be iterated and assigned to a @link String @endlink like a <tt>String&lt;Dna5&gt;
+ * const</tt>.
+ *
+ * The ranges of N characters and of soft-masked characters are available through @link TwoBitSequence#numNBlocks
+ * @endlink, @link TwoBitSequence#getNBlock @endlink, @link TwoBitSequence#numMaskBlocks @endlink, and @link
+ * TwoBitSequence#getMaskBlock @endlink.
+ */
+
+class TwoBitSequence
+{
+public:
+    // The packed bases, four per byte.
+    unsigned char const * dna;
+    // The number of bases.
+    __uint32 dnaSize;
+    // The N block starts followed by the N block sizes.
+    unsigned char const * nBlocks;
+    __uint32 nBlockCount;
+    // The mask block starts followed by the mask block sizes.
+    unsigned char const * maskBlocks;
+    __uint32 maskBlockCount;
+
+    TwoBitSequence() :
+        dna(NULL), dnaSize(0), nBlocks(NULL), nBlockCount(0), maskBlocks(NULL), maskBlockCount(0)
+    {}
+
+    template <typename TPos>
+    inline Dna5
+    operator[](TPos pos) const
+    {
+        return getValue(*this, pos);
+    }
+};
+
+// --------------------------------------------------------------------------
+// Class TwoBitContext_
+// --------------------------------------------------------------------------
+
+// The state of a SeqFileIn or SeqFileOut in 2bit format.  The index at the beginning of a 2bit file is kept while
+// reading.  On writing, the records are buffered until the file is closed, as the index precedes them.
+
+template <typename TDirection>
+struct TwoBitContext_;
+
+template <>
+struct TwoBitContext_<Input>
+{
+    StringSet<CharString, Owner<ConcatDirect<> > > names;
+    String<__uint64> offsets;
+    CharString buffer;
+    __uint64 position;
+    unsigned nextId;
+    bool headerRead;
+
+    TwoBitContext_() :
+        position(0), nextId(0), headerRead(false)
+    {}
+};
+
+template <>
+struct TwoBitContext_<Output>
+{
+    StringSet<CharString, Owner<ConcatDirect<> > > names;
+    String<__uint64> offsets;
+    CharString records;
+};
+
+// ============================================================================
+// Metafunctions
+// ============================================================================
+
+// --------------------------------------------------------------------------
+// Metafunction MagicHeader
+// --------------------------------------------------------------------------
+
+template <typename T>
+struct MagicHeader<TwoBit, T>
+{
+    static char const VALUE[4];
+};
+
+template <typename T>
+char const MagicHeader<TwoBit, T>::VALUE[4] = { 0x43, 0x27, 0x41, 0x1a };  // signature 0x1A412743
+
+// --------------------------------------------------------------------------
+// Metafunction FileExtensions
+// --------------------------------------------------------------------------
+
+template <typename T>
+struct FileExtensions<TwoBit, T>
+{
+    static char const * VALUE[1];
+};
+
+template <typename T>
+char const * FileExtensions<TwoBit, T>::VALUE[1] =
+{
+    ".2bit"     // default output extension
+};
+
+// --------------------------------------------------------------------------
+// Metafunctions for TwoBitSequence
+// --------------------------------------------------------------------------
+
+template <>
+struct Value<TwoBitSequence>
+{
+    typedef Dna5 Type;
+};
+
+template <>
+struct Value<TwoBitSequence const> : Value<TwoBitSequence> {};
+
+template <>
+struct GetValue<TwoBitSequence> : Value<TwoBitSequence> {};
+
+template <>
+struct GetValue<TwoBitSequence const> : Value<TwoBitSequence> {};
+
+template <>
+struct Reference<TwoBitSequence> : Value<TwoBitSequence> {};
+
+template <>
+struct Reference<TwoBitSequence const> : Value<TwoBitSequence> {};
+
+template <>
+struct Size<TwoBitSequence>
+{
+    typedef __uint32 Type;
+};
+
+template <>
+struct Size<TwoBitSequence const> : Size<TwoBitSequence> {};
+
+template <>
+struct Position<TwoBitSequence> : Size<TwoBitSequence> {};
+
+template <>
+struct Position<TwoBitSequence const> : Size<TwoBitSequence> {};
+
+template <>
+struct Difference<TwoBitSequence>
+{
+    typedef __int64 Type;
+};
+
+template <>
+struct Difference<TwoBitSequence const> : Difference<TwoBitSequence> {};
+
+template <typename TSpec>
+struct Iterator<TwoBitSequence, TSpec>
+{
+    typedef Iter<TwoBitSequence const, PositionIterator> Type;
+};
+
+template <typename TSpec>
+struct Iterator<TwoBitSequence const, TSpec>
+{
+    typedef Iter<TwoBitSequence const, PositionIterator> Type;
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function _twoBitUInt32()
+// ----------------------------------------------------------------------------
+
+// Reads a little-endian 32 bit integer from a possibly unaligned address.
+
+inline __uint32
+_twoBitUInt32(unsigned char const * ptr)
+{
+    __uint32 result;
+    std::memcpy(&result, ptr, sizeof(result));
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// Function _parseTwoBitSequence()
+// ----------------------------------------------------------------------------
+
+// Sets the view to the record in [ptr, ptrEnd) and returns the end of the record, or NULL if the record is truncated.
+
+inline unsigned char const *
+_parseTwoBitSequence(TwoBitSequence & seq, unsigned char const * ptr, unsigned char const * ptrEnd)
+{
+    if (ptrEnd - ptr < 8)
+        return NULL;
+    seq.dnaSize = _twoBitUInt32(ptr);
+    seq.nBlockCount = _twoBitUInt32(ptr + 4);
+    ptr += 8;
+
+    if ((__uint64)(ptrEnd - ptr) < 8ull * seq.nBlockCount + 4)
+        return NULL;
+    seq.nBlocks = ptr;
+    ptr += 8ull * seq.nBlockCount;
+    seq.maskBlockCount = _twoBitUInt32(ptr);
+    ptr += 4;
+
+    if ((__uint64)(ptrEnd - ptr) < 8ull * seq.maskBlockCount + 4 + (seq.dnaSize + 3ull) / 4)
+        return NULL;
+    seq.maskBlocks = ptr;
+    ptr += 8ull * seq.maskBlockCount + 4;   // skip the reserved word
+    seq.dna = ptr;
+    return ptr + (seq.dnaSize + 3ull) / 4;
+}
+
+// ----------------------------------------------------------------------------
+// Function length()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitSequence#length
+ * @brief Return the number of bases of a TwoBitSequence.
+ *
+ * @signature __uint32 length(seq);
+ *
+ * @param[in] seq The TwoBitSequence to query.
+ *
+ * @return __uint32 The length of the sequence.
+ */
+
+inline __uint32
+length(TwoBitSequence const & seq)
+{
+    return seq.dnaSize;
+}
+
+// ----------------------------------------------------------------------------
+// Function getObjectId()
+// ----------------------------------------------------------------------------
+
+inline void const *
+getObjectId(TwoBitSequence const & seq)
+{
+    return seq.dna;
+}
+
+// ----------------------------------------------------------------------------
+// Function numNBlocks()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitSequence#numNBlocks
+ * @brief Return the number of N blocks of a TwoBitSequence.
+ *
+ * @signature __uint32 numNBlocks(seq);
+ *
+ * @param[in] seq The TwoBitSequence to query.
+ *
+ * @return __uint32 The number of ranges of N characters.
+ */
+
+inline __uint32
+numNBlocks(TwoBitSequence const & seq)
+{
+    return seq.nBlockCount;
+}
+
+// ----------------------------------------------------------------------------
+// Function getNBlock()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitSequence#getNBlock
+ * @brief Return a range of N characters of a TwoBitSequence.
+ *
+ * @signature Pair<__uint32, __uint32> getNBlock(seq, i);
+ *
+ * @param[in] seq The TwoBitSequence to query.
+ * @param[in] i   The index of the N block, smaller than @link TwoBitSequence#numNBlocks @endlink.
+ *
+ * @return Pair<__uint32, __uint32> The begin and end position of the N block.
+ */
+
+inline Pair<__uint32, __uint32>
+getNBlock(TwoBitSequence const & seq, __uint32 i)
+{
+    SEQAN_ASSERT_LT(i, seq.nBlockCount);
+    __uint32 beginPos = _twoBitUInt32(seq.nBlocks + 4 * i);
+    return Pair<__uint32, __uint32>(beginPos, beginPos + _twoBitUInt32(seq.nBlocks + 4 * (seq.nBlockCount + i)));
+}
+
+// ----------------------------------------------------------------------------
+// Function numMaskBlocks()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitSequence#numMaskBlocks
+ * @brief Return the number of mask blocks of a TwoBitSequence.
+ *
+ * @signature __uint32 numMaskBlocks(seq);
+ *
+ * @param[in] seq The TwoBitSequence to query.
+ *
+ * @return __uint32 The number of ranges of soft-masked characters.
+ */
+
+inline __uint32
+numMaskBlocks(TwoBitSequence const & seq)
+{
+    return seq.maskBlockCount;
+}
+
+// ----------------------------------------------------------------------------
+// Function getMaskBlock()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitSequence#getMaskBlock
+ * @brief Return a range of soft-masked characters of a TwoBitSequence.
+ *
+ * @signature Pair<__uint32, __uint32> getMaskBlock(seq, i);
+ *
+ * @param[in] seq The TwoBitSequence to query.
+ * @param[in] i   The index of the mask block, smaller than @link TwoBitSequence#numMaskBlocks @endlink.
+ *
+ * @return Pair<__uint32, __uint32> The begin and end position of the mask block.
+ */
+
+inline Pair<__uint32, __uint32>
+getMaskBlock(TwoBitSequence const & seq, __uint32 i)
+{
+    SEQAN_ASSERT_LT(i, seq.maskBlockCount);
+    __uint32 beginPos = _twoBitUInt32(seq.maskBlocks + 4 * i);
+    return Pair<__uint32, __uint32>(beginPos,
+                                    beginPos + _twoBitUInt32(seq.maskBlocks + 4 * (seq.maskBlockCount + i)));
+}
+
+// ----------------------------------------------------------------------------
+// Function _isInTwoBitBlock()
+// ----------------------------------------------------------------------------
+
+// Binary search for the last block beginning at or before pos.
+
+inline bool
+_isInTwoBitBlock(unsigned char const * blocks, __uint32 blockCount, __uint32 pos)
+{
+    __uint32 lo = 0;
+    __uint32 hi = blockCount;
+    while (lo < hi)
+    {
+        __uint32 mid = lo + (hi - lo) / 2;
+        if (_twoBitUInt32(blocks + 4 * mid) <= pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0)
+        return false;
+    --lo;
+    return pos - _twoBitUInt32(blocks + 4 * lo) < _twoBitUInt32(blocks + 4 * (blockCount + lo));
+}
+
+// ----------------------------------------------------------------------------
+// Function getValue()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitSequence#getValue
+ * @brief Return the base at a position of a TwoBitSequence.
+ *
+ * @signature Dna5 getValue(seq, pos);
+ *
+ * @param[in] seq The TwoBitSequence to query.
+ * @param[in] pos The position of the base.
+ *
+ * @return Dna5 The base at <tt>pos</tt>, <tt>N</tt> inside of N blocks.
+ */
+
+template <typename TPos>
+inline Dna5
+getValue(TwoBitSequence const & seq, TPos pos)
+{
+    static unsigned char const DNA5_VALUE[4] = { 3, 1, 0, 2 };   // T, C, A, G
+
+    SEQAN_ASSERT_LT((__uint64)pos, (__uint64)seq.dnaSize);
+    if (seq.nBlockCount != 0 && _isInTwoBitBlock(seq.nBlocks, seq.nBlockCount, pos))
+        return Dna5('N');
+    return Dna5(DNA5_VALUE[(seq.dna[pos >> 2] >> (6 - 2 * (pos & 3))) & 3]);
+}
+
+template <typename TPos>
+inline Dna5
+value(TwoBitSequence const & seq, TPos pos)
+{
+    return getValue(seq, pos);
+}
+
+// ----------------------------------------------------------------------------
+// Function begin()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec>
+inline Iter<TwoBitSequence const, PositionIterator>
+begin(TwoBitSequence const & seq, Tag<TSpec> const)
+{
+    return Iter<TwoBitSequence const, PositionIterator>(seq, 0);
+}
+
+// ----------------------------------------------------------------------------
+// Function end()
+// ----------------------------------------------------------------------------
+
+template <typename TSpec>
+inline Iter<TwoBitSequence const, PositionIterator>
+end(TwoBitSequence const & seq, Tag<TSpec> const)
+{
+    return Iter<TwoBitSequence const, PositionIterator>(seq, length(seq));
+}
+
+// ----------------------------------------------------------------------------
+// Function _applyTwoBitMask()
+// ----------------------------------------------------------------------------
+
+// Lower-cases the soft-masked characters of [beginPos, endPos) in str, only for strings of characters.
+
+template <typename TString>
+inline void
+_applyTwoBitMask(TString &, TwoBitSequence const &, __uint32, __uint32, False)
+{}
+
+template <typename TString>
+inline void
+_applyTwoBitMask(TString & str, TwoBitSequence const & seq, __uint32 beginPos, __uint32 endPos, True)
+{
+    for (__uint32 i = 0; i < seq.maskBlockCount; ++i)
+    {
+        Pair<__uint32, __uint32> block = getMaskBlock(seq, i);
+        for (__uint32 pos = std::max(block.i1, beginPos); pos < std::min(block.i2, endPos); ++pos)
+            str[pos - beginPos] = tolower(str[pos - beginPos]);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _decodeTwoBit()
+// ----------------------------------------------------------------------------
+
+// Unpacks the bases of [beginPos, endPos) into str.  Strings of characters keep the soft-masking in lower case.
+
+template <typename TString>
+inline void
+_decodeTwoBit(TString & str, TwoBitSequence const & seq, __uint32 beginPos, __uint32 endPos)
+{
+    typedef typename Iterator<TString, Standard>::Type TIter;
+    typedef typename Value<TString>::Type TValue;
+
+    static char const BASES[4] = { 'T', 'C', 'A', 'G' };
+
+    clear(str);
+    if (endPos <= beginPos)
+        return;
+    resize(str, endPos - beginPos);
+
+    TIter it = begin(str, Standard());
+    unsigned char const * dna = seq.dna + (beginPos >> 2);
+    __uint32 pos = beginPos;
+
+    // Bases before the first byte boundary.
+    for (; (pos & 3) != 0 && pos < endPos; ++pos, ++it)
+        *it = BASES[(*dna >> (6 - 2 * (pos & 3))) & 3];
+    if ((beginPos & 3) != 0)
+        ++dna;
+
+    // Four bases per byte.
+    for (; pos + 4 <= endPos; pos += 4, ++dna)
+    {
+        *it = BASES[(*dna >> 6) & 3];
+        ++it;
+        *it = BASES[(*dna >> 4) & 3];
+        ++it;
+        *it = BASES[(*dna >> 2) & 3];
+        ++it;
+        *it = BASES[*dna & 3];
+        ++it;
+    }
+
+    // Remaining bases.
+    for (; pos < endPos; ++pos, ++it)
+        *it = BASES[(*dna >> (6 - 2 * (pos & 3))) & 3];
+
+    for (__uint32 i = 0; i < seq.nBlockCount; ++i)
+    {
+        Pair<__uint32, __uint32> block = getNBlock(seq, i);
+        for (pos = std::max(block.i1, beginPos); pos < std::min(block.i2, endPos); ++pos)
+            str[pos - beginPos] = 'N';
+    }
+
+    _applyTwoBitMask(str, seq, beginPos, endPos, typename IsSameType<TValue, char>::Type());
+}
+
+// ----------------------------------------------------------------------------
+// Function _readTwoBitBytes()
+// ----------------------------------------------------------------------------
+
+template <typename TFwdIterator, typename TSize>
+inline void
+_readTwoBitBytes(CharString & buffer, TFwdIterator & iter, TSize n)
+{
+    // write() would read past the end of the input
+    CountDownFunctor<> countDown(n);
+    readUntil(buffer, iter, countDown);
+    if (!countDown)
+        SEQAN_THROW(UnexpectedEnd());
+}
+
+// ----------------------------------------------------------------------------
+// Function _readTwoBitPod()
+// ----------------------------------------------------------------------------
+
+// Reads a little-endian header value, readRawPod() does not check for the end of the input.
+
+template <typename TValue, typename TFwdIterator>
+inline void
+_readTwoBitPod(TValue & value, TFwdIterator & iter)
+{
+    char * ptr = reinterpret_cast<char *>(&value);
+    for (unsigned i = 0; i < sizeof(TValue); ++i, ++iter)
+    {
+        if (atEnd(iter))
+            SEQAN_THROW(UnexpectedEnd());
+        ptr[i] = *iter;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Function _readTwoBitSequence()
+// ----------------------------------------------------------------------------
+
+// Reads one sequence record into the buffer, decodes it into seq, and returns the number of bytes read.
+
+template <typename TSeqString, typename TFwdIterator>
+inline __uint64
+_readTwoBitSequence(TSeqString & seq, CharString & buffer, TFwdIterator & iter)
+{
+    clear(buffer);
+    _readTwoBitBytes(buffer, iter, 8u);
+    __uint64 nBlockCount = _twoBitUInt32((unsigned char const *)begin(buffer, Standard()) + 4);
+    _readTwoBitBytes(buffer, iter, 8 * nBlockCount + 4);
+    __uint64 maskBlockCount = _twoBitUInt32((unsigned char const *)end(buffer, Standard()) - 4);
+    __uint64 dnaSize = _twoBitUInt32((unsigned char const *)begin(buffer, Standard()));
+    _readTwoBitBytes(buffer, iter, 8 * maskBlockCount + 4 + (dnaSize + 3) / 4);
+
+    TwoBitSequence view;
+    _parseTwoBitSequence(view,
+                         (unsigned char const *)begin(buffer, Standard()),
+                         (unsigned char const *)end(buffer, Standard()));
+    _decodeTwoBit(seq, view, 0u, length(view));
+    return length(buffer);
+}
+
+// ----------------------------------------------------------------------------
+// Function _readTwoBitHeader()
+// ----------------------------------------------------------------------------
+
+template <typename TFwdIterator>
+inline void
+_readTwoBitHeader(TwoBitContext_<Input> & context, TFwdIterator & iter)
+{
+    clear(context.names);
+    clear(context.offsets);
+
+    __uint32 signature, version, seqCount, reserved;
+    _readTwoBitPod(signature, iter);
+    if (signature == 0x4327411A)
+        SEQAN_THROW(ParseError("Big-endian 2bit files are not supported."));
+    if (signature != 0x1A412743)
+        SEQAN_THROW(ParseError("Not in 2bit format."));
+    _readTwoBitPod(version, iter);
+    if (version > 1)
+        SEQAN_THROW(ParseError("Unknown 2bit version."));
+    _readTwoBitPod(seqCount, iter);
+    _readTwoBitPod(reserved, iter);
+    context.position = 16;
+
+    for (__uint32 i = 0; i < seqCount; ++i)
+    {
+        unsigned char nameSize;
+        _readTwoBitPod(nameSize, iter);
+        clear(context.buffer);
+        _readTwoBitBytes(context.buffer, iter, nameSize);
+        appendValue(context.names, context.buffer);
+
+        if (version == 0)
+        {
+            __uint32 offset;
+            _readTwoBitPod(offset, iter);
+            appendValue(context.offsets, offset);
+            context.position += 5 + nameSize;
+        }
+        else
+        {
+            __uint64 offset;
+            _readTwoBitPod(offset, iter);
+            appendValue(context.offsets, offset);
+            context.position += 9 + nameSize;
+        }
+    }
+
+    context.nextId = 0;
+    context.headerRead = true;
+}
+
+// ----------------------------------------------------------------------------
+// Function _readTwoBitRecord()
+// ----------------------------------------------------------------------------
+
+// Reads the next sequence of a 2bit file, the names are taken from the index.  The records must be stored in the
+// order of the index, which is the case for files written by faToTwoBit or SeqFileOut.
+
+template <typename TIdString, typename TSeqString, typename TFwdIterator>
+inline void
+_readTwoBitRecord(TIdString & meta, TSeqString & seq, TwoBitContext_<Input> & context, TFwdIterator & iter)
+{
+    if (!context.headerRead)
+        _readTwoBitHeader(context, iter);
+    if (context.nextId >= length(context.offsets))
+        SEQAN_THROW(UnexpectedEnd());
+
+    __uint64 offset = context.offsets[context.nextId];
+    if (offset < context.position)
+        SEQAN_THROW(ParseError("2bit records are not in the order of the index, use a TwoBitIndex to read them."));
+    for (; context.position < offset; ++context.position, ++iter)
+        if (atEnd(iter))
+            SEQAN_THROW(UnexpectedEnd());
+
+    assign(meta, context.names[context.nextId]);
+    context.position += _readTwoBitSequence(seq, context.buffer, iter);
+
+    // Skip any bytes after the last record, so that the file is at its end.
+    if (++context.nextId == length(context.offsets))
+        for (; !atEnd(iter); ++iter) {}
+}
+
+// ----------------------------------------------------------------------------
+// Function readRecord(TwoBit)
+// ----------------------------------------------------------------------------
+
+// A single sequence record without the header and index of a 2bit file.  Use a SeqFileIn to read whole 2bit files.
+
+template <typename TIdString, typename TSeqString, typename TFwdIterator>
+inline void
+readRecord(TIdString & meta, TSeqString & seq, TFwdIterator & iter, TwoBit)
+{
+    CharString buffer;
+    clear(meta);
+    _readTwoBitSequence(seq, buffer, iter);
+}
+
+template <typename TIdString, typename TSeqString, typename TQualString, typename TFwdIterator>
+inline void
+readRecord(TIdString & meta, TSeqString & seq, TQualString & qual, TFwdIterator & iter, TwoBit)
+{
+    clear(qual);
+    readRecord(meta, seq, iter, TwoBit());
+}
+
+// ----------------------------------------------------------------------------
+// Function _appendTwoBitBlock()
+// ----------------------------------------------------------------------------
+
+// Extends the last block or starts a new one at pos.
+
+inline void
+_appendTwoBitBlock(String<Pair<__uint32, __uint32> > & blocks, __uint32 pos)
+{
+    if (!empty(blocks) && back(blocks).i1 + back(blocks).i2 == pos)
+        ++back(blocks).i2;
+    else
+        appendValue(blocks, Pair<__uint32, __uint32>(pos, 1));
+}
+
+// ----------------------------------------------------------------------------
+// Function _writeTwoBitBlocks()
+// ----------------------------------------------------------------------------
+
+template <typename TTarget>
+inline void
+_writeTwoBitBlocks(TTarget & target, String<Pair<__uint32, __uint32> > const & blocks)
+{
+    appendRawPod(target, (__uint32)length(blocks));
+    for (unsigned i = 0; i < length(blocks); ++i)
+        appendRawPod(target, blocks[i].i1);
+    for (unsigned i = 0; i < length(blocks); ++i)
+        appendRawPod(target, blocks[i].i2);
+}
+
+// ----------------------------------------------------------------------------
+// Function _writeTwoBitSequence()
+// ----------------------------------------------------------------------------
+
+// Writes one sequence record.  Characters other than A, C, G, T become N blocks, lower case characters mask blocks.
+
+template <typename TTarget, typename TSeqString>
+inline void
+_writeTwoBitSequence(TTarget & target, TSeqString const & seq)
+{
+    typedef typename Iterator<TSeqString const, Standard>::Type TIter;
+
+    static unsigned char const TWO_BIT_VALUE[5] = { 2, 1, 3, 0, 0 };   // A, C, G, T, N
+
+    if ((__uint64)length(seq) > MaxValue<__uint32>::VALUE)
+        SEQAN_THROW(ParseError("2bit sequences are limited to 2^32-1 bases."));
+
+    String<Pair<__uint32, __uint32> > nBlocks, maskBlocks;
+    String<unsigned char> dna;
+    resize(dna, (length(seq) + 3) / 4, 0);
+
+    __uint32 pos = 0;
+    TIter itEnd = end(seq, Standard());
+    for (TIter it = begin(seq, Standard()); it != itEnd; ++it, ++pos)
+    {
+        char c = convert<char>(*it);
+        if (c >= 'a' && c <= 'z')
+            _appendTwoBitBlock(maskBlocks, pos);
+        Dna5 base = c;
+        if (base == Dna5('N'))
+            _appendTwoBitBlock(nBlocks, pos);
+        dna[pos >> 2] |= TWO_BIT_VALUE[ordValue(base)] << (6 - 2 * (pos & 3));
+    }
+
+    appendRawPod(target, (__uint32)length(seq));
+    _writeTwoBitBlocks(target, nBlocks);
+    _writeTwoBitBlocks(target, maskBlocks);
+    appendRawPod(target, (__uint32)0);
+    write(target, dna);
+}
+
+// ----------------------------------------------------------------------------
+// Function writeRecord(TwoBit)
+// ----------------------------------------------------------------------------
+
+// A single sequence record without the header and index of a 2bit file.  Use a SeqFileOut to write whole 2bit files.
+
+template <typename TTarget, typename TIdString, typename TSeqString>
+inline void
+writeRecord(TTarget & target, TIdString const & /* meta */, TSeqString const & seq, TwoBit const &,
+            SequenceOutputOptions const & = SequenceOutputOptions())
+{
+    _writeTwoBitSequence(target, seq);
+}
+
+template <typename TTarget, typename TIdString, typename TSeqString, typename TQualString>
+inline void
+writeRecord(TTarget & target, TIdString const & /* meta */, TSeqString const & seq, TQualString const & /* qual */,
+            TwoBit const &, SequenceOutputOptions const & = SequenceOutputOptions())
+{
+    _writeTwoBitSequence(target, seq);
+}
+
+// ----------------------------------------------------------------------------
+// Function _appendTwoBitRecord()
+// ----------------------------------------------------------------------------
+
+template <typename TIdString, typename TSeqString>
+inline void
+_appendTwoBitRecord(TwoBitContext_<Output> & context, TIdString const & meta, TSeqString const & seq)
+{
+    if (length(meta) > 255u)
+        SEQAN_THROW(ParseError("2bit sequence names are limited to 255 characters."));
+
+    appendValue(context.names, meta);
+    appendValue(context.offsets, length(context.records));
+    _writeTwoBitSequence(context.records, seq);
+}
+
+// ----------------------------------------------------------------------------
+// Function _writeTwoBitFile()
+// ----------------------------------------------------------------------------
+
+// Writes the header, the index, and the buffered records.  Version 1 with 64 bit offsets is only used for files
+// larger than 4GB.
+
+template <typename TTarget>
+inline void
+_writeTwoBitFile(TTarget & target, TwoBitContext_<Output> const & context)
+{
+    __uint64 headerSize = 16;
+    for (unsigned i = 0; i < length(context.names); ++i)
+        headerSize += 5 + length(context.names[i]);
+    __uint32 version = (headerSize + length(context.records) > MaxValue<__uint32>::VALUE) ? 1 : 0;
+    if (version == 1)
+        headerSize += 4 * length(context.names);
+
+    appendRawPod(target, (__uint32)0x1A412743);
+    appendRawPod(target, version);
+    appendRawPod(target, (__uint32)length(context.names));
+    appendRawPod(target, (__uint32)0);
+
+    for (unsigned i = 0; i < length(context.names); ++i)
+    {
+        writeValue(target, (char)length(context.names[i]));
+        write(target, context.names[i]);
+        if (version == 0)
+            appendRawPod(target, (__uint32)(headerSize + context.offsets[i]));
+        else
+            appendRawPod(target, (__uint64)(headerSize + context.offsets[i]));
+    }
+
+    write(target, context.records);
+}
+
+}  // namespace seqan
+
+#endif  // INCLUDE_SEQAN_SEQ_IO_TWO_BIT_H_
@@ -0,0 +1,410 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Random access to the sequences of a memory-mapped 2bit file.
+// ==========================================================================
+
+#ifndef INCLUDE_SEQAN_SEQ_IO_TWO_BIT_INDEX_H_
+#define INCLUDE_SEQAN_SEQ_IO_TWO_BIT_INDEX_H_
+
+namespace seqan {
+
+// ============================================================================
+// Tags, Classes, Enums
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Class TwoBitIndex
+// ----------------------------------------------------------------------------
+
+/*!
+ * @class TwoBitIndex
+ * @headerfile <seqan/seq_io.h>
+ * @brief Random access to the sequences of a 2bit file.
+ *
+ * @signature class TwoBitIndex;
+ *
+ * The 2bit file is mapped into memory.  Opening it only reads the index and the record headers, the bases stay
+ * packed in the mapped file.  Each sequence is available as a @link TwoBitSequence @endlink view that decodes bases
+ * on access, or can be unpacked into a string with @link TwoBitIndex#readRegion @endlink.  The interface follows
+ * the one of @link FaiIndex @endlink.
+ *
+ * @fn TwoBitIndex::TwoBitIndex
+ * @brief Constructor.
+ *
+ * @signature TwoBitIndex::TwoBitIndex();
+ */
+
+class TwoBitIndex
+{
+public:
+    // The name of the 2bit file.
+    CharString twoBitFilename;
+
+    // A store for the sequence names.
+    StringSet<CharString> seqNameStore;
+    // A cache for fast access to the sequence name store.
+    NameStoreCache<StringSet<CharString> > seqNameStoreCache;
+    // Views of the sequence records, pointing into mmapString.
+    String<TwoBitSequence> sequences;
+    // The 2bit file mapped into memory.
+    String<char, MMap<> > mmapString;
+
+    TwoBitIndex() :
+        seqNameStoreCache(seqNameStore)
+    {}
+
+private:
+    // The views point into the mapping of this object.
+    TwoBitIndex(TwoBitIndex const &);
+    TwoBitIndex & operator=(TwoBitIndex const &);
+};
+
+// ============================================================================
+// Functions
+// ============================================================================
+
+// ----------------------------------------------------------------------------
+// Function clear()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitIndex#clear
+ * @brief Reset a TwoBitIndex object to the state after default construction.
+ *
+ * @signature void clear(twoBitIndex);
+ *
+ * @param[in,out] twoBitIndex The TwoBitIndex to clear.
+ */
+
+inline void clear(TwoBitIndex & index)
+{
+    clear(index.twoBitFilename);
+    clear(index.seqNameStore);
+    clear(index.seqNameStoreCache);
+    clear(index.sequences);
+    close(index.mmapString);
+}
+
+// ----------------------------------------------------------------------------
+// Function empty()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitIndex#empty
+ * @brief Returns whether the TwoBitIndex is empty.
+ *
+ * @signature bool empty(twoBitIndex);
+ *
+ * @param[in] twoBitIndex The TwoBitIndex to check.
+ *
+ * @return bool <tt>true</tt> if the index contains no sequences.
+ */
+
+inline bool empty(TwoBitIndex const & index)
+{
+    return empty(index.sequences);
+}
+
+// ----------------------------------------------------------------------------
+// Function getIdByName()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitIndex#getIdByName
+ * @brief Return the id (numeric index in the file) of a sequence in a 2bit file.
+ *
+ * @signature bool getIdByName(rID, twoBitIndex, name);
+ *
+ * @param[in]  twoBitIndex The TwoBitIndex to query.
+ * @param[in]  name        The name of the sequence to look the id up for.  Type: @link ContainerConcept @endlink.
+ * @param[out] rID         The id of the sequence is written here.
+ *
+ * @return bool <tt>true</tt> if a sequence with the given name is known in the index, <tt>false</tt> otherwise.
+ */
+
+template <typename TName, typename TId>
+inline bool getIdByName(TId & rID, TwoBitIndex const & index, TName const & name)
+{
+    return getIdByName(rID, index.seqNameStoreCache, name);
+}
+
+// ----------------------------------------------------------------------------
+// Function sequenceLength()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitIndex#sequenceLength
+ * @brief Return the length of the sequence with the given id in the TwoBitIndex.
+ *
+ * @signature __uint64 sequenceLength(twoBitIndex, rID);
+ *
+ * @param[in] twoBitIndex The TwoBitIndex to query.
+ * @param[in] rID         The id of the sequence to get the length of.
+ *
+ * @return __uint64 The length of the sequence with index rID in twoBitIndex.
+ */
+
+template <typename TSeqId>
+inline __uint64 sequenceLength(TwoBitIndex const & index, TSeqId rID)
+{
+    return length(index.sequences[rID]);
+}
+
+template <typename TSeqId>
+inline __uint64 sequenceLength(TwoBitIndex & index, TSeqId rID)
+{
+    return length(index.sequences[rID]);
+}
+
+// ----------------------------------------------------------------------------
+// Function sequenceName()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitIndex#sequenceName
+ * @brief Return the name of the sequence with the given id in the TwoBitIndex.
+ *
+ * @signature CharString sequenceName(twoBitIndex, rID);
+ *
+ * @param[in] twoBitIndex The TwoBitIndex to query.
+ * @param[in] rID         The index of the sequence.
+ *
+ * @return CharString The name of the sequence with the given id.
+ */
+
+inline CharString const & sequenceName(TwoBitIndex const & index, unsigned rID)
+{
+    return index.seqNameStore[rID];
+}
+
+// ----------------------------------------------------------------------------
+// Function numSeqs()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitIndex#numSeqs
+ * @brief Return the number of sequences known to a TwoBitIndex.
+ *
+ * @signature __uint64 numSeqs(twoBitIndex);
+ *
+ * @param[in] twoBitIndex The TwoBitIndex to query.
+ *
+ * @return __uint64 The number of sequences in the index.
+ */
+
+inline __uint64 numSeqs(TwoBitIndex const & index)
+{
+    return length(index.sequences);
+}
+
+// ----------------------------------------------------------------------------
+// Function sequenceView()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitIndex#sequenceView
+ * @brief Return a view of a sequence in the mapped 2bit file.
+ *
+ * @signature TwoBitSequence const & sequenceView(twoBitIndex, rID);
+ *
+ * @param[in] twoBitIndex The TwoBitIndex to query.
+ * @param[in] rID         The index of the sequence.
+ *
+ * @return TwoBitSequence The view of the sequence, valid until the index is closed.
+ */
+
+inline TwoBitSequence const & sequenceView(TwoBitIndex const & index, unsigned rID)
+{
+    return index.sequences[rID];
+}
+
+// ----------------------------------------------------------------------------
+// Function readRegion()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitIndex#readRegion
+ * @brief Unpack a region of a sequence in a 2bit file.
+ *
+ * @signature void readRegion(str, twoBitIndex, rID, beginPos, endPos);
+ * @signature bool readRegion(str, twoBitIndex, region);
+ *
+ * N blocks are unpacked as <tt>N</tt>.  Strings of <tt>char</tt> keep the soft-masked regions in lower case.
+ *
+ * @param[out] str         The @link String @endlink to read the sequence into.  Its capacity is reused.
+ * @param[in]  twoBitIndex The TwoBitIndex to read from.
+ * @param[in]  rID         The id of the sequence to read (Type: <tt>unsigned</tt>).
+ * @param[in]  beginPos    The begin position of the region to read (Type: <tt>unsigned</tt>).
+ * @param[in]  endPos      The end position of the region to read (Type: <tt>unsigned</tt>).
+ * @param[in]  region      The @link GenomicRegion @endlink to read.
+ *
+ * @return bool For <tt>region</tt>, <tt>false</tt> if the sequence name or id is unknown, <tt>true</tt> otherwise.
+ */
+
+template <typename TValue, typename TSpec, typename TSeqId, typename TBeginPos, typename TEndPos>
+inline void readRegion(String<TValue, TSpec> & str,
+                       TwoBitIndex const & index,
+                       TSeqId rID,
+                       TBeginPos beginPos,
+                       TEndPos endPos)
+{
+    TwoBitSequence const & seq = index.sequences[rID];
+
+    // Limit region to the sequence, make sure that beginPos <= endPos.
+    __uint64 seqLen = length(seq);
+    __uint64 beginPos_ = std::min((__uint64)beginPos, seqLen);
+    __uint64 endPos_ = std::min(std::max(beginPos_, (__uint64)endPos), seqLen);
+    _decodeTwoBit(str, seq, (__uint32)beginPos_, (__uint32)endPos_);
+}
+
+template <typename TValue, typename TSpec>
+inline bool readRegion(String<TValue, TSpec> & str,
+                       TwoBitIndex const & index,
+                       GenomicRegion const & region)
+{
+    int rID = region.rID;
+    if (rID == GenomicRegion::INVALID_ID)
+        if (!getIdByName(rID, index, region.seqName))
+            return false;  // Sequence with this name could not be found.
+    if (rID < 0 || (__uint64)rID >= numSeqs(index))
+        return false;  // Sequence with this id does not exist.
+
+    __uint64 beginPos = (region.beginPos != GenomicRegion::INVALID_POS) ? region.beginPos : 0;
+    __uint64 endPos = (region.endPos != GenomicRegion::INVALID_POS) ? region.endPos : sequenceLength(index, rID);
+    readRegion(str, index, rID, beginPos, endPos);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function readSequence()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitIndex#readSequence
+ * @brief Unpack a whole sequence of a 2bit file.
+ *
+ * @signature void readSequence(str, twoBitIndex, rID);
+ *
+ * @param[out] str         The @link String @endlink to read into.
+ * @param[in]  twoBitIndex The TwoBitIndex to read from.
+ * @param[in]  rID         The index of the sequence in the file.
+ */
+
+template <typename TValue, typename TSpec>
+inline void readSequence(String<TValue, TSpec> & str, TwoBitIndex const & index, unsigned rID)
+{
+    readRegion(str, index, rID, 0u, sequenceLength(index, rID));
+}
+
+// ----------------------------------------------------------------------------
+// Function _readTwoBitIndex()
+// ----------------------------------------------------------------------------
+
+// Parses the header, the index, and the record headers of the mapped file.
+
+inline bool _readTwoBitIndex(TwoBitIndex & index)
+{
+    unsigned char const * itBegin = (unsigned char const *)begin(index.mmapString, Standard());
+    unsigned char const * itEnd = (unsigned char const *)end(index.mmapString, Standard());
+    unsigned char const * it = itBegin;
+
+    if (itEnd - it < 16 || _twoBitUInt32(it) != 0x1A412743)
+        return false;  // Not a little-endian 2bit file.
+    __uint32 version = _twoBitUInt32(it + 4);
+    __uint32 seqCount = _twoBitUInt32(it + 8);
+    if (version > 1)
+        return false;
+    it += 16;
+
+    unsigned offsetSize = (version == 0) ? 4 : 8;
+    CharString name;
+    String<__uint64> offsets;
+    for (__uint32 i = 0; i < seqCount; ++i)
+    {
+        if (it == itEnd || (__uint64)(itEnd - it) < 1u + *it + offsetSize)
+            return false;
+        resize(name, *it);
+        std::copy(it + 1, it + 1 + *it, begin(name, Standard()));
+        appendValue(index.seqNameStore, name);
+        it += 1 + *it;
+
+        __uint64 offset = 0;
+        std::memcpy(&offset, it, offsetSize);
+        appendValue(offsets, offset);
+        it += offsetSize;
+    }
+
+    resize(index.sequences, seqCount);
+    for (__uint32 i = 0; i < seqCount; ++i)
+        if (offsets[i] > (__uint64)(itEnd - itBegin) ||
+            _parseTwoBitSequence(index.sequences[i], itBegin + offsets[i], itEnd) == NULL)
+            return false;
+
+    refresh(index.seqNameStoreCache);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Function open()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TwoBitIndex#open
+ * @brief Map a 2bit file into memory and read its index.
+ *
+ * @signature bool open(twoBitIndex, twoBitFilename);
+ *
+ * @param[out] twoBitIndex    The TwoBitIndex to open.
+ * @param[in]  twoBitFilename The path to the 2bit file.  Type: <tt>char const *</tt>.
+ *
+ * @return bool <tt>true</tt> on success, <tt>false</tt> if the file could not be mapped or is no valid 2bit file.
+ */
+
+inline bool open(TwoBitIndex & index, char const * twoBitFilename)
+{
+    clear(index);
+    index.twoBitFilename = twoBitFilename;
+
+    if (!open(index.mmapString, twoBitFilename, OPEN_RDONLY))
+        return false;  // Could not open file.
+
+    if (!_readTwoBitIndex(index))
+    {
+        clear(index);
+        return false;
+    }
+    return true;
+}
+
+}  // namespace seqan
+
+#endif  // INCLUDE_SEQAN_SEQ_IO_TWO_BIT_INDEX_H_
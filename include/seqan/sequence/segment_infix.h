@@ -195,6 +195,14 @@ SEQAN_CHECKPOINT
 //     setEndPosition(target, beginPosition(target));
 // }
 
+// An infix of a read-only host is a view; clearing it only empties the view.
+template <typename THost>
+inline void
+clear(Segment<THost const, InfixSegment> & target)
+{
+    setEndPosition(target, beginPosition(target));
+}
+
 ///Function.host.param.object.type:Class.Segment
 
 template <typename THost_>
@@ -95,12 +95,14 @@
 #include <seqan/stream/iostream_zip.h>
 #include <seqan/stream/iostream_zip_impl.h>
 #include <seqan/stream/iostream_bgzf.h>
+#include <seqan/stream/iostream_pzip.h>
 #endif
 
 #if SEQAN_HAS_BZIP2
 #include <seqan/stream/iostream_bzip2.h>
 #endif
 
+#include <seqan/stream/iostream_mmap.h>
 #include <seqan/stream/virtual_stream.h>
 #include <seqan/stream/formatted_file.h>
 
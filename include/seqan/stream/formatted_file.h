@@ -795,6 +795,29 @@ setPosition(FormattedFile<TFileFormat, Input, TSpec> & file, TPosition pos)
     return (TPosition)file.stream.rdbuf()->pubseekpos(pos, std::ios_base::in) == pos;
 }
 
+// ----------------------------------------------------------------------------
+// Function mappedContent()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn FormattedFileIn#mappedContent
+ * @brief Return the content of a memory-mapped FormattedFileIn.
+ *
+ * @signature TRange mappedContent(fileIn);
+ *
+ * @param[in] fileIn The FormattedFileIn opened with <tt>OPEN_MMAP</tt>.
+ * @return TRange    The mapped file as <tt>Range&lt;char const *&gt;</tt>, empty if the file is not mapped.
+ *
+ * See @link VirtualStream#mappedContent @endlink.
+ */
+
+template <typename TFileFormat, typename TSpec>
+inline Range<char const *> const &
+mappedContent(FormattedFile<TFileFormat, Input, TSpec> const & file)
+{
+    return mappedContent(file.stream);
+}
+
 // ----------------------------------------------------------------------------
 // Function context()
 // ----------------------------------------------------------------------------
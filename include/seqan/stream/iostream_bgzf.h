@@ -35,6 +35,196 @@ const unsigned BGZF_BLOCK_SIZE = BGZF_MAX_BLOCK_SIZE - BGZF_BLOCK_HEADER_LENGTH
 // Classes
 // ===========================================================================
 
+// --------------------------------------------------------------------------
+// Class BgzfJobClient_
+// --------------------------------------------------------------------------
+
+// Base class of the BGZF stream buffers, which submit their block jobs to a BgzfThreadPool.
+// The scheduling members are guarded by the critical section of the pool.
+
+class BgzfJobClient_
+{
+public:
+    std::deque<size_t>  pendingJobs;    // jobs submitted but not yet started
+    size_t              activeJobs;     // jobs submitted but not yet finished
+    bool                scheduled;      // true if the client is in the ready queue of the pool
+
+    BgzfJobClient_() :
+        activeJobs(0),
+        scheduled(false)
+    {}
+
+    virtual ~BgzfJobClient_()
+    {}
+
+    virtual void runJob(size_t jobId, CompressionContext<BgzfFile> & compressionCtx) = 0;
+};
+
+// --------------------------------------------------------------------------
+// Class BgzfThreadPool
+// --------------------------------------------------------------------------
+
+// A fixed number of worker threads that (de)compress the blocks of all BGZF streams.
+// Streams with pending jobs are served round-robin, one job at a time, so a stream
+// with many queued blocks cannot starve the others.
+
+class BgzfThreadPool
+{
+public:
+    struct WorkerThread
+    {
+        BgzfThreadPool                  *pool;
+        CompressionContext<BgzfFile>    compressionCtx;
+
+        void operator()()
+        {
+            BgzfThreadPool &p = *pool;
+            while (true)
+            {
+                BgzfJobClient_ *client;
+                size_t jobId;
+                {
+                    ScopedLock<CriticalSection> lock(p.cs);
+                    while (p.readyClients.empty() && !p.stop)
+                        waitFor(p.jobAvailable);
+                    if (p.readyClients.empty())
+                        return;
+
+                    // take the next job of the first client and requeue the client at the end
+                    client = p.readyClients.front();
+                    p.readyClients.pop_front();
+                    jobId = client->pendingJobs.front();
+                    client->pendingJobs.pop_front();
+                    if (client->pendingJobs.empty())
+                        client->scheduled = false;
+                    else
+                        p.readyClients.push_back(client);
+                }
+
+                client->runJob(jobId, compressionCtx);
+
+                {
+                    ScopedLock<CriticalSection> lock(p.cs);
+                    if (--client->activeJobs == 0)
+                        signal(p.jobDone);
+                }
+            }
+        }
+    };
+
+    CriticalSection                 cs;
+    Condition                       jobAvailable;
+    Condition                       jobDone;
+    std::deque<BgzfJobClient_ *>    readyClients;
+    bool                            stop;
+    size_t                          numThreads;
+    Thread<WorkerThread>            *threads;
+
+    explicit
+    BgzfThreadPool(size_t numThreads) :
+        jobAvailable(cs),
+        jobDone(cs),
+        stop(false),
+        numThreads(std::max(numThreads, (size_t)1))
+    {
+        threads = new Thread<WorkerThread>[this->numThreads];
+        for (unsigned i = 0; i < this->numThreads; ++i)
+        {
+            threads[i].worker.pool = this;
+            run(threads[i]);
+        }
+    }
+
+    ~BgzfThreadPool()
+    {
+        {
+            ScopedLock<CriticalSection> lock(cs);
+            stop = true;
+            signal(jobAvailable);
+        }
+        for (unsigned i = 0; i < numThreads; ++i)
+            waitFor(threads[i]);
+        delete[] threads;
+    }
+
+private:
+    BgzfThreadPool(BgzfThreadPool const &);
+    BgzfThreadPool & operator=(BgzfThreadPool const &);
+};
+
+// --------------------------------------------------------------------------
+// Function bgzfThreadPool()
+// --------------------------------------------------------------------------
+
+// The pool used by all BGZF streams that are not given their own pool.
+// It has one thread per core and is never destroyed, as static streams may
+// still use it during static destruction.
+
+inline BgzfThreadPool &
+bgzfThreadPool()
+{
+#ifdef SEQAN_CXX11_STL
+    static BgzfThreadPool * pool = new BgzfThreadPool(std::thread::hardware_concurrency() != 0 ?
+                                                      std::thread::hardware_concurrency() : 16);
+#else
+    static BgzfThreadPool * pool = new BgzfThreadPool(16);
+#endif
+    return *pool;
+}
+
+// --------------------------------------------------------------------------
+// Function submitJob()
+// --------------------------------------------------------------------------
+
+inline void
+submitJob(BgzfThreadPool & pool, BgzfJobClient_ & client, size_t jobId)
+{
+    ScopedLock<CriticalSection> lock(pool.cs);
+    client.pendingJobs.push_back(jobId);
+    ++client.activeJobs;
+    if (!client.scheduled)
+    {
+        client.scheduled = true;
+        pool.readyClients.push_back(&client);
+    }
+    signal(pool.jobAvailable);
+}
+
+// --------------------------------------------------------------------------
+// Function cancelJobs()
+// --------------------------------------------------------------------------
+
+// Removes all jobs of a client that have not been started yet.
+
+inline void
+cancelJobs(BgzfThreadPool & pool, BgzfJobClient_ & client)
+{
+    ScopedLock<CriticalSection> lock(pool.cs);
+    client.activeJobs -= client.pendingJobs.size();
+    client.pendingJobs.clear();
+    if (client.scheduled)
+    {
+        pool.readyClients.erase(std::find(pool.readyClients.begin(), pool.readyClients.end(), &client));
+        client.scheduled = false;
+    }
+    if (client.activeJobs == 0)
+        signal(pool.jobDone);
+}
+
+// --------------------------------------------------------------------------
+// Function waitForJobs()
+// --------------------------------------------------------------------------
+
+// Waits until all submitted jobs of a client are finished.
+
+inline void
+waitForJobs(BgzfThreadPool & pool, BgzfJobClient_ & client)
+{
+    ScopedLock<CriticalSection> lock(pool.cs);
+    while (client.activeJobs != 0)
+        waitFor(pool.jobDone);
+}
+
 // --------------------------------------------------------------------------
 // Class basic_bgzf_streambuf
 // --------------------------------------------------------------------------
@@ -46,7 +236,9 @@ template<
     typename ByteT = char,
     typename ByteAT = std::allocator<ByteT>
 >
-class basic_bgzf_streambuf : public std::basic_streambuf<Elem, Tr>
+class basic_bgzf_streambuf :
+    public std::basic_streambuf<Elem, Tr>,
+    public BgzfJobClient_
 {
 public:
     typedef std::basic_ostream<Elem, Tr>& ostream_reference;
@@ -96,10 +288,9 @@ public:
     };
 
     // string of recycable jobs
-    size_t                  numThreads;
+    BgzfThreadPool          &pool;
     size_t                  numJobs;
     String<CompressionJob>  jobs;
-    TJobQueue               jobQueue;
     TJobQueue               idleQueue;
     Serializer<
         OutputBuffer,
@@ -108,58 +299,36 @@ public:
     size_t                  currentJobId;
     bool                    currentJobAvail;
 
-
-    struct CompressionThread
+    // compress a block with zlib, called by a thread of the pool
+    void runJob(size_t jobId, CompressionContext<BgzfFile> & compressionCtx)
     {
-        basic_bgzf_streambuf            *streamBuf;
-        CompressionContext<BgzfFile>    compressionCtx;
-        size_t                          threadNum;
-
-        void operator()()
-        {
-            ScopedReadLock<TJobQueue> readLock(streamBuf->jobQueue);
-            ScopedWriteLock<TJobQueue> writeLock(streamBuf->idleQueue);
+        CompressionJob &job = jobs[jobId];
 
-            // wait for a new job to become available
-            bool success = true;
-            while (success)
-            {
-                size_t jobId = -1;
-                if (!popFront(jobId, streamBuf->jobQueue))
-                    return;
-
-                CompressionJob &job = streamBuf->jobs[jobId];
-
-                // compress block with zlib
-                job.outputBuffer->size = _compressBlock(
-                    job.outputBuffer->buffer, sizeof(job.outputBuffer->buffer),
-                    &job.buffer[0], job.size, compressionCtx);
-
-                success = releaseValue(streamBuf->serializer, job.outputBuffer);
-                appendValue(streamBuf->idleQueue, jobId);
-            }
-        }
-    };
+        job.outputBuffer->size = _compressBlock(
+            job.outputBuffer->buffer, sizeof(job.outputBuffer->buffer),
+            &job.buffer[0], job.size, compressionCtx);
 
-    // array of worker threads
-    Thread<CompressionThread>   *threads;
+        releaseValue(serializer, job.outputBuffer);
+        appendValue(idleQueue, jobId);
+    }
 
+    // numThreads * jobsPerThread blocks can be in flight, they are compressed by the shared pool
     basic_bgzf_streambuf(ostream_reference ostream_,
                          size_t numThreads = 16,
-                         size_t jobsPerThread = 8) :
-        numThreads(numThreads),
+                         size_t jobsPerThread = 8,
+                         BgzfThreadPool & pool = bgzfThreadPool()) :
+        pool(pool),
         numJobs(numThreads * jobsPerThread),
-        jobQueue(numJobs),
         idleQueue(numJobs),
         serializer(ostream_, numThreads * jobsPerThread)
     {
         resize(jobs, numJobs, Exact());
         currentJobId = 0;
 
-        lockWriting(jobQueue);
+        // the pool threads write into the idle queue on behalf of this stream
         lockReading(idleQueue);
-        setReaderWriterCount(jobQueue, numThreads, 1);
-        setReaderWriterCount(idleQueue, 1, numThreads);
+        lockWriting(idleQueue);
+        setReaderWriterCount(idleQueue, 1, 1);
 
         for (unsigned i = 0; i < numJobs; ++i)
         {
@@ -168,14 +337,6 @@ public:
             SEQAN_ASSERT(success);
         }
 
-        threads = new Thread<CompressionThread>[numThreads];
-        for (unsigned i = 0; i < numThreads; ++i)
-        {
-            threads[i].worker.streamBuf = this;
-            threads[i].worker.threadNum = i;
-            run(threads[i]);
-        }
-
         currentJobAvail = popFront(currentJobId, idleQueue);
         SEQAN_ASSERT(currentJobAvail);
 
@@ -188,13 +349,10 @@ public:
     {
         // the buffer is now (after addFooter()) and flush will append the empty EOF marker
         flush(true);
+        waitForJobs(pool, *this);
 
-        unlockWriting(jobQueue);
+        unlockWriting(idleQueue);
         unlockReading(idleQueue);
-
-        for (unsigned i = 0; i < numThreads; ++i)
-            waitFor(threads[i]);
-        delete[] threads;
     }
 
     bool compressBuffer(size_t size)
@@ -203,7 +361,7 @@ public:
         if (currentJobAvail)
         {
             jobs[currentJobId].size = size;
-            appendValue(jobQueue, currentJobId);
+            submitJob(pool, *this, currentJobId);
         }
 
         // recycle existing idle job
@@ -227,7 +385,7 @@ public:
         {
             CompressionJob &job = jobs[currentJobId];
             this->setp(&job.buffer[0], &job.buffer[0] + (job.buffer.size() - 1));
-            return c;
+            return Tr::not_eof(c);
         }
         else
         {
@@ -289,7 +447,8 @@ template<
     typename ByteAT = std::allocator<ByteT>
 >
 class basic_unbgzf_streambuf :
-    public std::basic_streambuf<Elem, Tr>
+    public std::basic_streambuf<Elem, Tr>,
+    public BgzfJobClient_
 {
 public:
     typedef std::basic_istream<Elem, Tr>& istream_reference;
@@ -313,12 +472,14 @@ public:
         Mutex               lock;
         IOError             *error;
         off_type            fileOfs;
+        bool                closing;
 
         Serializer(istream_reference istream) :
             istream(istream),
             lock(false),
             error(NULL),
-            fileOfs(0u)
+            fileOfs(0u),
+            closing(false)
         {}
 
         ~Serializer()
@@ -363,183 +524,163 @@ public:
     };
 
     // string of recycable jobs
-    size_t                      numThreads;
+    BgzfThreadPool              &pool;
     size_t                      numJobs;
     String<DecompressionJob>    jobs;
     TJobQueue                   runningQueue;
-    TJobQueue                   todoQueue;
     int                         currentJobId;
+    TBuffer                     putbackBuffer;
 
-    struct DecompressionThread
+    // read the next block and decompress it, called by a thread of the pool
+    void runJob(size_t jobId, CompressionContext<BgzfFile> & compressionCtx)
     {
-        basic_unbgzf_streambuf          *streamBuf;
-        CompressionContext<BgzfFile>    compressionCtx;
+        DecompressionJob &job = jobs[jobId];
+        size_t tailLen = 0;
 
-        void operator()()
+        // typically only ready jobs are submitted
+        // however, if seek() fast forwards running jobs and submits them again
+        // the caller defers the task of waiting to the pool thread
+        if (!job.ready)
         {
-            ScopedReadLock<TJobQueue> readLock(streamBuf->todoQueue);
-            ScopedWriteLock<TJobQueue> writeLock(streamBuf->runningQueue);
-
-            // wait for a new job to become available
-            while (true)
+            ScopedLock<CriticalSection> lock(job.cs);
+            if (!job.ready)
             {
-                int jobId = -1;
-                if (!popFront(jobId, streamBuf->todoQueue))
-                    return;
+                waitFor(job.readyEvent);
+                job.ready = true;
+            }
+        }
 
-                DecompressionJob &job = streamBuf->jobs[jobId];
-                size_t tailLen = 0;
+        {
+            ScopedLock<Mutex> scopedLock(serializer.lock);
 
-                // typically the idle queue contains only ready jobs
-                // however, if seek() fast forwards running jobs into the todoQueue
-                // the caller defers the task of waiting to the decompression threads
-                if (!job.ready)
+            if (serializer.error != NULL || serializer.closing)
+                return;
+
+            // remember start offset (for tellg later)
+            job.fileOfs = serializer.fileOfs;
+            job.size = -1;
+            job.compressedSize = 0;
+
+            // only load if not at EOF
+            if (job.fileOfs != -1)
+            {
+                // read header
+                serializer.istream.read(
+                    (char*)&job.inputBuffer[0],
+                    BGZF_BLOCK_HEADER_LENGTH);
+
+                if (!serializer.istream.good())
                 {
-                    ScopedLock<CriticalSection> lock(job.cs);
-                    if (!job.ready)
-                    {
-                        waitFor(job.readyEvent);
-                        job.ready = true;
-                    }
+                    serializer.fileOfs = -1;
+                    if (serializer.istream.eof())
+                        goto eofSkip;
+                    serializer.error = new IOError("Stream read error.");
+                    unlockWriting(runningQueue);
+                    return;
                 }
 
+                // check header
+                if (!_bgzfCheckHeader(&job.inputBuffer[0]))
                 {
-                    ScopedLock<Mutex> scopedLock(streamBuf->serializer.lock);
-
-                    if (streamBuf->serializer.error != NULL)
-                        return;
+                    serializer.fileOfs = -1;
+                    serializer.error = new IOError("Invalid BGZF block header.");
+                    unlockWriting(runningQueue);
+                    return;
+                }
 
-                    // remember start offset (for tellg later)
-                    job.fileOfs = streamBuf->serializer.fileOfs;
-                    job.size = -1;
-                    job.compressedSize = 0;
+                // extract length of compressed data
+                tailLen = _bgzfUnpack16(&job.inputBuffer[0] + 16) + 1u - BGZF_BLOCK_HEADER_LENGTH;
 
-                    // only load if not at EOF
-                    if (job.fileOfs != -1)
-                    {
-                        // read header
-                        streamBuf->serializer.istream.read(
-                            (char*)&job.inputBuffer[0],
-                            BGZF_BLOCK_HEADER_LENGTH);
-
-                        if (!streamBuf->serializer.istream.good())
-                        {
-                            streamBuf->serializer.fileOfs = -1;
-                            if (streamBuf->serializer.istream.eof())
-                                goto eofSkip;
-                            streamBuf->serializer.error = new IOError("Stream read error.");
-                            return;
-                        }
-
-                        // check header
-                        if (!_bgzfCheckHeader(&job.inputBuffer[0]))
-                        {
-                            streamBuf->serializer.fileOfs = -1;
-                            streamBuf->serializer.error = new IOError("Invalid BGZF block header.");
-                            return;
-                        }
-
-                        // extract length of compressed data
-                        tailLen = _bgzfUnpack16(&job.inputBuffer[0] + 16) + 1u - BGZF_BLOCK_HEADER_LENGTH;
-
-                        // read compressed data and tail
-                        streamBuf->serializer.istream.read(
-                            (char*)&job.inputBuffer[0] + BGZF_BLOCK_HEADER_LENGTH,
-                            tailLen);
-
-                        if (!streamBuf->serializer.istream.good())
-                        {
-                            streamBuf->serializer.fileOfs = -1;
-                            if (streamBuf->serializer.istream.eof())
-                                goto eofSkip;
-                            streamBuf->serializer.error = new IOError("Stream read error.");
-                            return;
-                        }
-
-                        job.compressedSize = BGZF_BLOCK_HEADER_LENGTH + tailLen;
-                        streamBuf->serializer.fileOfs += job.compressedSize;
-                        job.ready = false;
-
-                    eofSkip:
-                        streamBuf->serializer.istream.clear(
-                            streamBuf->serializer.istream.rdstate() & ~std::ios_base::failbit);
-                    }
+                // read compressed data and tail
+                serializer.istream.read(
+                    (char*)&job.inputBuffer[0] + BGZF_BLOCK_HEADER_LENGTH,
+                    tailLen);
 
-                    if (!appendValue(streamBuf->runningQueue, jobId))
-                    {
-                        // signal that job is ready
-                        {
-                            ScopedLock<CriticalSection> lock(job.cs);
-                            job.ready = true;
-                            signal(job.readyEvent);
-                        }
-                        return;
-                    }
+                if (!serializer.istream.good())
+                {
+                    serializer.fileOfs = -1;
+                    if (serializer.istream.eof())
+                        goto eofSkip;
+                    serializer.error = new IOError("Stream read error.");
+                    unlockWriting(runningQueue);
+                    return;
                 }
 
-                if (!job.ready)
-                {
-                    // decompress block
-                    job.size = _decompressBlock(
-                        &job.buffer[0] + MAX_PUTBACK, capacity(job.buffer),
-                        &job.inputBuffer[0], job.compressedSize, compressionCtx);
+                job.compressedSize = BGZF_BLOCK_HEADER_LENGTH + tailLen;
+                serializer.fileOfs += job.compressedSize;
+                job.ready = false;
 
-                    // signal that job is ready
-                    {
-                        ScopedLock<CriticalSection> lock(job.cs);
-                        job.ready = true;
-                        signal(job.readyEvent);
-                    }
+            eofSkip:
+                serializer.istream.clear(
+                    serializer.istream.rdstate() & ~std::ios_base::failbit);
+            }
+
+            if (!appendValue(runningQueue, (int)jobId))
+            {
+                // signal that job is ready
+                {
+                    ScopedLock<CriticalSection> lock(job.cs);
+                    job.ready = true;
+                    signal(job.readyEvent);
                 }
+                return;
             }
         }
-    };
 
-    // array of worker threads
-    Thread<DecompressionThread> *threads;
-    TBuffer                     putbackBuffer;
+        if (!job.ready)
+        {
+            // decompress block
+            job.size = _decompressBlock(
+                &job.buffer[0] + MAX_PUTBACK, capacity(job.buffer),
+                &job.inputBuffer[0], job.compressedSize, compressionCtx);
 
+            // signal that job is ready
+            {
+                ScopedLock<CriticalSection> lock(job.cs);
+                job.ready = true;
+                signal(job.readyEvent);
+            }
+        }
+    }
+
+    // numThreads * jobsPerThread blocks are read ahead, they are decompressed by the shared pool
     basic_unbgzf_streambuf(istream_reference istream_,
                            size_t numThreads = 16,
-                           size_t jobsPerThread = 8) :
+                           size_t jobsPerThread = 8,
+                           BgzfThreadPool & pool = bgzfThreadPool()) :
         serializer(istream_),
-        numThreads(numThreads),
+        pool(pool),
         numJobs(numThreads * jobsPerThread),
         runningQueue(numJobs),
-        todoQueue(numJobs),
         putbackBuffer(MAX_PUTBACK)
     {
         resize(jobs, numJobs, Exact());
         currentJobId = -1;
 
+        // the pool threads write into the running queue on behalf of this stream
         lockReading(runningQueue);
-        lockWriting(todoQueue);
-        setReaderWriterCount(runningQueue, 1, numThreads);
-        setReaderWriterCount(todoQueue, numThreads, 1);
+        lockWriting(runningQueue);
+        setReaderWriterCount(runningQueue, 1, 1);
 
         for (unsigned i = 0; i < numJobs; ++i)
-        {
-            bool success = appendValue(todoQueue, i);
-            ignoreUnusedVariableWarning(success);
-            SEQAN_ASSERT(success);
-        }
-
-        threads = new Thread<DecompressionThread>[numThreads];
-        for (unsigned i = 0; i < numThreads; ++i)
-        {
-            threads[i].worker.streamBuf = this;
-            run(threads[i]);
-        }
+            submitJob(pool, *this, i);
     }
 
     ~basic_unbgzf_streambuf()
     {
-        unlockWriting(todoQueue);
+        // stop reading ahead
+        {
+            ScopedLock<Mutex> scopedLock(serializer.lock);
+            serializer.closing = true;
+        }
         unlockReading(runningQueue);
 
-        for (unsigned i = 0; i < numThreads; ++i)
-            waitFor(threads[i]);
-        delete[] threads;
+        cancelJobs(pool, *this);
+        waitForJobs(pool, *this);
+
+        // after an error the running queue was already unlocked
+        if (serializer.error == NULL)
+            unlockWriting(runningQueue);
     }
 
     int_type underflow()
@@ -560,7 +701,7 @@ public:
                 &putbackBuffer[0]);
 
         if (currentJobId >= 0)
-            appendValue(todoQueue, currentJobId);
+            submitJob(pool, *this, currentJobId);
 
         while (true)
         {
@@ -662,7 +803,7 @@ public:
                     // find our seek target
 
                     if (currentJobId >= 0)
-                        appendValue(todoQueue, currentJobId);
+                        submitJob(pool, *this, currentJobId);
 
                     // Note that if we are here the current job does not represent the sought block.
                     // Hence if the running queue is empty we need to explicitly unset the jobId,
@@ -679,7 +820,7 @@ public:
                             break;
 
                         // push back useless job
-                        appendValue(todoQueue, currentJobId);
+                        submitJob(pool, *this, currentJobId);
                         currentJobId = -1;
                     }
 
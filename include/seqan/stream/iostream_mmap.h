@@ -0,0 +1,236 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Stream buffer that reads a memory-mapped file without copying.
+// ==========================================================================
+
+#ifndef INCLUDE_SEQAN_STREAM_IOSTREAM_MMAP_H_
+#define INCLUDE_SEQAN_STREAM_IOSTREAM_MMAP_H_
+
+namespace seqan {
+
+// ===========================================================================
+// Classes
+// ===========================================================================
+
+// --------------------------------------------------------------------------
+// Class basic_mmap_streambuf
+// --------------------------------------------------------------------------
+
+// Maps a whole file read-only and exposes the mapped memory as get area, so
+// stream iterators hand out chunks that point directly into the file.
+// The get area is limited to windows of MAX_WINDOW characters, as
+// basic_streambuf::gbump() takes an int.
+//
+// The whole mapping is also available as a Range of plain pointers. Readers
+// iterating over this range read without a stream buffer and can return
+// Infix views into the mapping (see readUntil() below).
+
+template<
+    typename Elem,
+    typename Tr = std::char_traits<Elem>
+>
+class basic_mmap_streambuf : public std::basic_streambuf<Elem, Tr>
+{
+public:
+    typedef typename Tr::char_type char_type;
+    typedef typename Tr::int_type int_type;
+    typedef typename Tr::off_type off_type;
+    typedef typename Tr::pos_type pos_type;
+
+    static const size_t MAX_WINDOW = 1024 * 1024 * 1024 / sizeof(Elem);
+
+    FileMapping<>                   mapping;
+    char_type                       *data;
+    size_t                          size;
+    bool                            isOpen;
+    Range<char_type const *>        content;
+
+    basic_mmap_streambuf() :
+        data(NULL),
+        size(0),
+        isOpen(false)
+    {}
+
+    ~basic_mmap_streambuf()
+    {
+        close();
+    }
+
+    bool open(const char *fileName)
+    {
+        close();
+        if (!seqan::open(mapping, fileName, OPEN_RDONLY | OPEN_QUIET))
+            return false;
+        isOpen = true;
+
+        size = length(mapping) / sizeof(char_type);
+        if (size != 0)
+        {
+            data = static_cast<char_type *>(mapFileSegment(mapping, 0, size * sizeof(char_type), MAP_RDONLY));
+            if (data == NULL)
+            {
+                close();
+                return false;
+            }
+            adviseFileSegment(mapping, MAP_SEQUENTIAL, data, 0, size * sizeof(char_type));
+        }
+        content.begin = data;
+        content.end = data + size;
+        _setWindow(0);
+        return true;
+    }
+
+    bool close()
+    {
+        if (!isOpen)
+            return true;
+
+        bool result = true;
+        if (data != NULL)
+            result = unmapFileSegment(mapping, data, size * sizeof(char_type));
+        result &= seqan::close(mapping);
+
+        data = NULL;
+        size = 0;
+        isOpen = false;
+        content.begin = content.end = NULL;
+        this->setg(NULL, NULL, NULL);
+        return result;
+    }
+
+    bool is_open() const
+    {
+        return isOpen;
+    }
+
+    // the mapped file content
+    char_type const * begin() const
+    {
+        return data;
+    }
+
+    char_type const * end() const
+    {
+        return data + size;
+    }
+
+    void _setWindow(size_t pos)
+    {
+        this->setg(data, data + pos, data + std::min(size, pos + MAX_WINDOW));
+    }
+
+    int_type underflow()
+    {
+        if (this->gptr() == this->egptr())
+            _setWindow(this->gptr() - data);
+
+        if (this->gptr() == this->egptr())
+            return Tr::eof();
+        return Tr::to_int_type(*this->gptr());
+    }
+
+    std::streamsize showmanyc()
+    {
+        return (data + size) - this->gptr();
+    }
+
+    pos_type seekoff(off_type ofs, std::ios_base::seekdir dir, std::ios_base::openmode openMode)
+    {
+        if ((openMode & std::ios_base::in) == 0)
+            return pos_type(off_type(-1));
+
+        off_type pos = ofs;
+        if (dir == std::ios_base::cur)
+            pos += this->gptr() - data;
+        else if (dir == std::ios_base::end)
+            pos += size;
+
+        if (pos < 0 || pos > (off_type)size)
+            return pos_type(off_type(-1));
+
+        _setWindow(pos);
+        return pos_type(pos);
+    }
+
+    pos_type seekpos(pos_type pos, std::ios_base::openmode openMode)
+    {
+        return seekoff(off_type(pos), std::ios_base::beg, openMode);
+    }
+};
+
+// ===========================================================================
+// Functions
+// ===========================================================================
+
+// --------------------------------------------------------------------------
+// Function mappedContent()
+// --------------------------------------------------------------------------
+
+template <typename TValue, typename TTraits>
+inline Range<TValue const *> const &
+mappedContent(basic_mmap_streambuf<TValue, TTraits> const & buf)
+{
+    return buf.content;
+}
+
+// --------------------------------------------------------------------------
+// Function readUntil(); Infix views
+// --------------------------------------------------------------------------
+
+// Reading from a rooted iterator into an infix of the same read-only host,
+// e.g. the mappedContent() of a memory-mapped file, copies nothing. The
+// infix is set to the characters up to the stop character or, if it is not
+// empty, extended by them. Only reads without an ignore functor qualify, as
+// a view cannot skip characters.
+
+template <typename THost, typename TIterator, typename TSpec, typename TStopFunctor>
+inline void
+readUntil(Segment<THost const, InfixSegment> & target,
+          Iter<THost const, AdaptorIterator<TIterator, TSpec> > & iter,
+          TStopFunctor & stopFunctor,
+          False & /* ignoreFunctor */)
+{
+    typedef typename Position<THost const>::Type TPosition;
+
+    TPosition beginPos = position(iter);
+    if (empty(target))
+        target = infix(container(iter), beginPos, beginPos);
+    else if (&host(target) != &container(iter) || endPosition(target) != beginPos)
+        SEQAN_THROW(ParseError("readUntil(): Infix views can only be extended by adjacent input."));
+
+    skipUntil(iter, stopFunctor);
+    setEndPosition(target, position(iter));
+}
+
+}  // namespace seqan
+
+#endif  // INCLUDE_SEQAN_STREAM_IOSTREAM_MMAP_H_
@@ -0,0 +1,509 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Parallel gzip compression of independent, dictionary-primed blocks.
+// ==========================================================================
+
+
+#ifndef INCLUDE_SEQAN_STREAM_IOSTREAM_PZIP_H_
+#define INCLUDE_SEQAN_STREAM_IOSTREAM_PZIP_H_
+
+namespace seqan {
+
+const unsigned PZIP_BLOCK_SIZE = 128 * 1024;
+const unsigned PZIP_DICT_SIZE = 32 * 1024;
+const unsigned PZIP_HEADER_LENGTH = 10;
+const unsigned PZIP_FOOTER_LENGTH = 8;
+
+// ===========================================================================
+// Classes
+// ===========================================================================
+
+// --------------------------------------------------------------------------
+// Class basic_pzip_streambuf
+// --------------------------------------------------------------------------
+
+// Writes a single gzip member whose deflate data is compressed block-wise by the
+// threads of a BgzfThreadPool. Each block is a raw deflate stream primed with the
+// last 32 KB of the preceding input and ends with a sync flush, so the blocks can
+// be concatenated in order. The last block is finished with Z_FINISH and followed
+// by the CRC and size of the whole input. A block that fails to compress is written
+// empty and its error is rethrown by sync(), flush() or finish() of the writing thread.
+
+template<
+    typename Elem,
+    typename Tr = std::char_traits<Elem>,
+    typename ElemA = std::allocator<Elem>,
+    typename ByteT = char,
+    typename ByteAT = std::allocator<ByteT>
+>
+class basic_pzip_streambuf :
+    public std::basic_streambuf<Elem, Tr>,
+    public BgzfJobClient_
+{
+public:
+    typedef std::basic_ostream<Elem, Tr>& ostream_reference;
+    typedef ElemA char_allocator_type;
+    typedef ByteT byte_type;
+    typedef ByteAT byte_allocator_type;
+    typedef byte_type* byte_buffer_type;
+    typedef typename Tr::char_type char_type;
+    typedef typename Tr::int_type int_type;
+
+    typedef ConcurrentQueue<size_t, Suspendable<Limit> > TJobQueue;
+
+    struct OutputBuffer
+    {
+        std::vector<char>   buffer;
+        size_t              size;
+        unsigned long       crc;        // crc32 of the uncompressed block
+        size_t              inSize;     // size of the uncompressed block in bytes
+    };
+
+    struct BufferWriter
+    {
+        ostream_reference   ostream;
+        unsigned long       crc;        // crc32 of all blocks written so far
+        unsigned long       inSize;     // uncompressed size of all blocks written so far
+
+        BufferWriter(ostream_reference ostream) :
+            ostream(ostream),
+            crc(crc32(0u, NULL, 0u)),
+            inSize(0)
+        {}
+
+        bool operator() (OutputBuffer const & outputBuffer)
+        {
+            crc = crc32_combine(crc, outputBuffer.crc, outputBuffer.inSize);
+            inSize += outputBuffer.inSize;
+            ostream.write(&outputBuffer.buffer[0], outputBuffer.size);
+            return ostream.good();
+        }
+    };
+
+    struct CompressionJob
+    {
+        typedef std::vector<char_type, char_allocator_type> TBuffer;
+
+        TBuffer         buffer;
+        size_t          size;
+        char            dict[PZIP_DICT_SIZE];
+        size_t          dictSize;
+        bool            last;
+        OutputBuffer    *outputBuffer;
+
+        CompressionJob() :
+            buffer(PZIP_BLOCK_SIZE / sizeof(char_type), 0),
+            size(0),
+            dictSize(0),
+            last(false),
+            outputBuffer(NULL)
+        {}
+    };
+
+    // string of recycable jobs
+    BgzfThreadPool          &pool;
+    int                     level;
+    size_t                  numJobs;
+    String<CompressionJob>  jobs;
+    TJobQueue               idleQueue;
+    Serializer<
+        OutputBuffer,
+        BufferWriter>       serializer;
+
+    size_t                  currentJobId;
+    bool                    currentJobAvail;
+
+    // the last 32 KB of the input submitted so far, used to prime the next block
+    char                    window[PZIP_DICT_SIZE];
+    size_t                  windowSize;
+    bool                    finished;
+
+    // the first error of a compression job
+    Mutex                   errorLock;
+    IOError                 *error;
+
+    // compress a block with zlib, called by a thread of the pool
+    void runJob(size_t jobId, CompressionContext<BgzfFile> & compressionCtx)
+    {
+        CompressionJob &job = jobs[jobId];
+        OutputBuffer &out = *job.outputBuffer;
+        z_stream &strm = compressionCtx.strm;
+        size_t inSize = job.size * sizeof(char_type);
+
+        // a sync flush appends at most 5 bytes to the bound of a raw deflate stream
+        out.buffer.resize(compressBound(PZIP_BLOCK_SIZE) + 16);
+
+        strm.zalloc = NULL;
+        strm.zfree = NULL;
+        strm.opaque = NULL;
+        out.size = 0;
+        out.crc = crc32(0u, NULL, 0u);
+        out.inSize = 0;
+
+        // exceptions must not leave the pool thread, the writing thread rethrows the error
+        if (deflateInit2(&strm, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            _setError("GZFile deflateInit2() failed.");
+        }
+        else
+        {
+            if (job.dictSize != 0)
+                deflateSetDictionary(&strm, (Bytef *)job.dict, job.dictSize);
+
+            strm.next_in = (Bytef *)&job.buffer[0];
+            strm.avail_in = inSize;
+            strm.next_out = (Bytef *)&out.buffer[0];
+            strm.avail_out = out.buffer.size();
+
+            int status = deflate(&strm, job.last ? Z_FINISH : Z_SYNC_FLUSH);
+            bool success = job.last ? status == Z_STREAM_END : (status == Z_OK && strm.avail_out != 0);
+            deflateEnd(&strm);
+
+            if (success)
+            {
+                out.size = out.buffer.size() - strm.avail_out;
+                out.crc = crc32(out.crc, (Bytef *)&job.buffer[0], inSize);
+                out.inSize = inSize;
+            }
+            else
+            {
+                _setError("GZFile deflate() failed.");
+            }
+        }
+
+        releaseValue(serializer, job.outputBuffer);
+        appendValue(idleQueue, jobId);
+    }
+
+    // numThreads * jobsPerThread blocks can be in flight, they are compressed by the shared pool
+    basic_pzip_streambuf(ostream_reference ostream_,
+                         int level_ = Z_DEFAULT_COMPRESSION,
+                         size_t numThreads = 16,
+                         size_t jobsPerThread = 2,
+                         BgzfThreadPool & pool = bgzfThreadPool()) :
+        pool(pool),
+        level(std::min(9, level_)),
+        numJobs(numThreads * jobsPerThread),
+        idleQueue(numJobs),
+        serializer(ostream_, numThreads * jobsPerThread),
+        windowSize(0),
+        finished(false),
+        errorLock(false),
+        error(NULL)
+    {
+        resize(jobs, numJobs, Exact());
+        currentJobId = 0;
+
+        // the pool threads write into the idle queue on behalf of this stream
+        lockReading(idleQueue);
+        lockWriting(idleQueue);
+        setReaderWriterCount(idleQueue, 1, 1);
+
+        for (unsigned i = 0; i < numJobs; ++i)
+        {
+            bool success = appendValue(idleQueue, i);
+            ignoreUnusedVariableWarning(success);
+            SEQAN_ASSERT(success);
+        }
+
+        // gzip header without file name and modification time
+        char header[PZIP_HEADER_LENGTH] =
+        {
+            MagicHeader<GZFile>::VALUE[0], MagicHeader<GZFile>::VALUE[1], MagicHeader<GZFile>::VALUE[2],
+            0, 0, 0, 0, 0, 0, '\xff'
+        };
+        ostream_.write(header, PZIP_HEADER_LENGTH);
+
+        currentJobAvail = popFront(currentJobId, idleQueue);
+        SEQAN_ASSERT(currentJobAvail);
+
+        CompressionJob &job = jobs[currentJobId];
+        job.outputBuffer = aquireValue(serializer);
+        this->setp(&job.buffer[0], &job.buffer[0] + (job.buffer.size() - 1));
+    }
+
+    ~basic_pzip_streambuf()
+    {
+        // call finish() before to see errors
+        SEQAN_TRY
+        {
+            finish();
+        }
+        SEQAN_CATCH(IOError const &)
+        {}
+        waitForJobs(pool, *this);
+
+        unlockWriting(idleQueue);
+        unlockReading(idleQueue);
+        delete error;
+    }
+
+    void _setError(char const * message)
+    {
+        ScopedLock<Mutex> lock(errorLock);
+        if (error == NULL)
+            error = new IOError(message);
+    }
+
+    // rethrows the error of a failed compression job
+    void _checkError()
+    {
+        ScopedLock<Mutex> lock(errorLock);
+        if (error != NULL)
+            throw *error;
+    }
+
+    bool compressBuffer(size_t size, bool last = false)
+    {
+        // submit current job
+        if (currentJobAvail)
+        {
+            CompressionJob &job = jobs[currentJobId];
+            job.size = size;
+            job.last = last;
+
+            // prime the block with the preceding input and append the block to the window
+            job.dictSize = windowSize;
+            std::copy(window, window + windowSize, job.dict);
+            _appendToWindow(reinterpret_cast<char const *>(&job.buffer[0]), size * sizeof(char_type));
+
+            submitJob(pool, *this, currentJobId);
+        }
+
+        if (last)
+        {
+            currentJobAvail = false;
+            return serializer;
+        }
+
+        // recycle existing idle job
+        if (!(currentJobAvail = popFront(currentJobId, idleQueue)))
+            return false;
+
+        jobs[currentJobId].outputBuffer = aquireValue(serializer);
+
+        return serializer;
+    }
+
+    void _appendToWindow(char const * data, size_t size)
+    {
+        if (size >= PZIP_DICT_SIZE)
+        {
+            std::copy(data + (size - PZIP_DICT_SIZE), data + size, window);
+            windowSize = PZIP_DICT_SIZE;
+            return;
+        }
+
+        size_t keep = std::min(windowSize, (size_t)PZIP_DICT_SIZE - size);
+        std::copy(window + (windowSize - keep), window + windowSize, window);
+        std::copy(data, data + size, window + keep);
+        windowSize = keep + size;
+    }
+
+    int_type overflow(int_type c)
+    {
+        int w = static_cast<int>(this->pptr() - this->pbase());
+        if (c != EOF)
+        {
+            *this->pptr() = c;
+            ++w;
+        }
+        if (compressBuffer(w))
+        {
+            CompressionJob &job = jobs[currentJobId];
+            this->setp(&job.buffer[0], &job.buffer[0] + (job.buffer.size() - 1));
+            return Tr::not_eof(c);
+        }
+        else
+        {
+            return EOF;
+        }
+    }
+
+    std::streamsize flush()
+    {
+        int w = static_cast<int>(this->pptr() - this->pbase());
+        if (w != 0 && compressBuffer(w))
+        {
+            CompressionJob &job = jobs[currentJobId];
+            this->setp(&job.buffer[0], &job.buffer[0] + (job.buffer.size() - 1));
+        }
+        else
+        {
+            w = 0;
+        }
+
+        // wait for running compressor threads
+        waitForMinSize(idleQueue, numJobs - 1);
+        _checkError();
+
+        serializer.worker.ostream.flush();
+        return w;
+    }
+
+    // compresses the remaining input as last block and writes the gzip footer
+    void finish()
+    {
+        if (finished)
+            return;
+        finished = true;
+
+        // the last block must be written before the footer
+        bool success = currentJobAvail && compressBuffer(this->pptr() - this->pbase(), true);
+        this->setp(NULL, NULL);
+        waitForJobs(pool, *this);
+        _checkError();
+        if (!success || !serializer)
+            throw IOError("GZFile write failed.");
+
+        BufferWriter &writer = serializer.worker;
+        char footer[PZIP_FOOTER_LENGTH];
+        for (unsigned i = 0; i < 4; ++i)
+        {
+            footer[i] = static_cast<char>((writer.crc >> (8 * i)) & 0xff);
+            footer[i + 4] = static_cast<char>((writer.inSize >> (8 * i)) & 0xff);
+        }
+        writer.ostream.write(footer, PZIP_FOOTER_LENGTH);
+        writer.ostream.flush();
+    }
+
+    int sync()
+    {
+        if (this->pptr() != this->pbase())
+        {
+            int c = overflow(EOF);
+            if (c == EOF)
+                return -1;
+        }
+
+        // wait for the submitted blocks to see their errors
+        if (!finished)
+            waitForMinSize(idleQueue, numJobs - 1);
+        _checkError();
+        return 0;
+    }
+
+    // returns a reference to the output stream
+    ostream_reference get_ostream() const    { return serializer.worker.ostream; };
+};
+
+// --------------------------------------------------------------------------
+// Class basic_pzip_ostreambase
+// --------------------------------------------------------------------------
+
+template<
+    typename Elem,
+    typename Tr = std::char_traits<Elem>,
+    typename ElemA = std::allocator<Elem>,
+    typename ByteT = char,
+    typename ByteAT = std::allocator<ByteT>
+>
+class basic_pzip_ostreambase : virtual public std::basic_ios<Elem,Tr>
+{
+public:
+    typedef std::basic_ostream<Elem, Tr>&                        ostream_reference;
+    typedef basic_pzip_streambuf<Elem, Tr, ElemA, ByteT, ByteAT> pzip_streambuf_type;
+
+    basic_pzip_ostreambase(ostream_reference ostream_, int level_)
+        : m_buf(ostream_, level_)
+    {
+        this->init(&m_buf );
+    };
+
+    // returns the underlying zip ostream object
+    pzip_streambuf_type* rdbuf()            { return &m_buf; };
+
+private:
+    pzip_streambuf_type m_buf;
+};
+
+// --------------------------------------------------------------------------
+// Class basic_pzip_ostream
+// --------------------------------------------------------------------------
+
+// A drop-in replacement for zlib_stream::basic_zip_ostream with gzip header and
+// footer that compresses on the threads of the shared BGZF thread pool.
+
+template<
+    typename Elem,
+    typename Tr = std::char_traits<Elem>,
+    typename ElemA = std::allocator<Elem>,
+    typename ByteT = char,
+    typename ByteAT = std::allocator<ByteT>
+>
+class basic_pzip_ostream :
+    public basic_pzip_ostreambase<Elem,Tr,ElemA,ByteT,ByteAT>,
+    public std::basic_ostream<Elem,Tr>
+{
+public:
+    typedef basic_pzip_ostreambase<Elem,Tr,ElemA,ByteT,ByteAT> pzip_ostreambase_type;
+    typedef std::basic_ostream<Elem,Tr>                        ostream_type;
+    typedef ostream_type&                                      ostream_reference;
+
+    basic_pzip_ostream(ostream_reference ostream_, int level_ = Z_DEFAULT_COMPRESSION) :
+        pzip_ostreambase_type(ostream_, level_),
+        ostream_type(pzip_ostreambase_type::rdbuf())
+    {}
+
+    // flush inner buffer and zipper buffer
+    basic_pzip_ostream<Elem,Tr>& zflush()
+    {
+        this->flush(); this->rdbuf()->flush(); return *this;
+    };
+
+    // call rdbuf()->finish() before to see errors
+    ~basic_pzip_ostream()
+    {
+        SEQAN_TRY
+        {
+            this->rdbuf()->finish();
+        }
+        SEQAN_CATCH(IOError const &)
+        {}
+    }
+
+private:
+#ifdef _WIN32
+    void _Add_vtordisp1() { } // Required to avoid VC++ warning C4250
+    void _Add_vtordisp2() { } // Required to avoid VC++ warning C4250
+#endif
+};
+
+// ===========================================================================
+// Typedefs
+// ===========================================================================
+
+typedef basic_pzip_ostream<char> pzip_ostream;
+
+}  // namespace seqan
+
+#endif  // INCLUDE_SEQAN_STREAM_IOSTREAM_PZIP_H_
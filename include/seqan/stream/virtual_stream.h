@@ -149,7 +149,7 @@ struct VirtualStreamSwitch_<TValue, Input, GZFile>
 template <typename TValue>
 struct VirtualStreamSwitch_<TValue, Output, GZFile>
 {
-    typedef zlib_stream::basic_zip_ostream<TValue> Type;
+    typedef basic_pzip_ostream<TValue> Type;
 };
 
 template <typename TValue>
@@ -264,11 +264,13 @@ public:
 //    typedef FileStream<TValue, TDirection>                          TFile;                  // if a real file should be opened
     typedef BufferedStream<TStream, TDirection>                     TBufferedStream;        // if input stream is not buffered
     typedef std::basic_streambuf<TValue, TTraits>                   TStreamBuffer;          // the streambuf to use
+    typedef basic_mmap_streambuf<TValue, TTraits>                   TMappedStreamBuffer;    // if OPEN_MMAP was given
     typedef VirtualStreamContextBase_<TValue, TTraits>              TVirtualStreamContext;  // the owner of the streambuf
     typedef typename StreamFormat<VirtualStream>::Type              TFormat;                // detected stream format
 
     TFile                   file;
     TBufferedStream         bufferedStream;
+    TMappedStreamBuffer     mappedBuf;
     TStreamBuffer           *streamBuf;
     TVirtualStreamContext   *context;
     TFormat                 format;
@@ -636,12 +638,24 @@ open(VirtualStream<TValue, TDirection, TTraits> &stream,
 
     typedef VirtualStream<TValue, TDirection, TTraits> TVirtualStream;
 
-    if (!open(stream.file, fileName, openMode))
-        return false;
-
     // detect compression type from file extension
     assign(stream.format, typename StreamFormat<TVirtualStream>::Type());
 
+    // uncompressed input files can be mapped into memory and read without copying
+    if (IsSameType<TDirection, Input>::VALUE && (openMode & OPEN_MMAP) && !_isPipe(fileName) &&
+        guessFormatFromFilename(fileName, stream.format) && isEqual(stream.format, Nothing()))
+    {
+        if (!stream.mappedBuf.open(fileName))
+            return false;
+        stream.streamBuf = &stream.mappedBuf;
+        stream._init();
+        return true;
+    }
+    assign(stream.format, typename StreamFormat<TVirtualStream>::Type());
+
+    if (!open(stream.file, fileName, openMode & ~OPEN_MMAP))
+        return false;
+
     if (IsSameType<TDirection, Input>::VALUE && _isPipe(fileName))
         open(stream, stream.file, stream.format);               // read from a pipe (without file extension)
     else
@@ -685,7 +699,8 @@ close(VirtualStream<TValue, TDirection, TTraits> &stream)
     stream.context = NULL;
     stream.streamBuf = NULL;
     assign(stream.format, typename StreamFormat<VirtualStream<TValue, TDirection, TTraits> >::Type());
-    return !stream.file.is_open() || close(stream.file);
+    bool result = stream.mappedBuf.close();
+    return (!stream.file.is_open() || close(stream.file)) && result;
 }
 
 // ----------------------------------------------------------------------------
@@ -709,6 +724,30 @@ format(VirtualStream<TValue, TDirection, TTraits> &stream)
     return stream.format;
 }
 
+// ----------------------------------------------------------------------------
+// Function mappedContent()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn VirtualStream#mappedContent
+ * @brief Return the content of a memory-mapped VirtualStream.
+ *
+ * @signature TRange mappedContent(stream);
+ *
+ * @param[in] stream The VirtualStream opened with <tt>OPEN_MMAP</tt>.
+ * @return TRange    The mapped file as <tt>Range&lt;TValue const *&gt;</tt>, empty if the stream is not mapped.
+ *
+ * Rooted iterators of the range read the file without a stream buffer.  Reading into an Infix of the range
+ * returns views into the mapping instead of copies.
+ */
+
+template <typename TValue, typename TTraits>
+inline Range<TValue const *> const &
+mappedContent(VirtualStream<TValue, Input, TTraits> const &stream)
+{
+    return mappedContent(stream.mappedBuf);
+}
+
 }  // namespace seqan
 
 #endif  // #ifndef SEQAN_STREAM_VIRTUAL_STREAM_
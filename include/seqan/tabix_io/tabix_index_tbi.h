@@ -36,11 +36,15 @@
 // A Tabix index (Heng Li) allows to randomly seek in a tab-seperated genome
 // related file, e.g. VCF, GFF, SAM, BED, etc. The corresponding file only
 // needs to be sorted by chromosomal position in advance and optionally
-// compressed with 'bgzip'. The resulting file must be indexed with 'tabix'.
+// compressed with 'bgzip'. The resulting file must be indexed with 'tabix'
+// or with build().
+//
+// Both the TBI format (fixed 16kb linear index and 512Mbp binning) and the
+// CSI format (configurable minimal bin size and number of levels, for
+// contigs longer than 2^29 bp) are supported.
 //
 // TODOs:
 //  - clean jumpToRegion(), I simply adapted the one from bam_index.h
-//  - implement Tabix index creation (and BAM index creation as well)
 // ==========================================================================
 
 #ifndef INCLUDE_SEQAN_TABIX_IO_TABIX_INDEX_TBI_H_
@@ -68,6 +72,10 @@ bool open(TabixIndex & index, char const * filename);
 struct TabixIndexBinData_
 {
     String<Pair<__uint64, __uint64> > chunkBegEnds;
+    __uint64 loffset;   // CSI only: smallest virtual offset of a record overlapping the bin
+
+    TabixIndexBinData_() : loffset(0)
+    {}
 };
 
 // ----------------------------------------------------------------------------
@@ -118,6 +126,9 @@ public:
     __int32 meta;               // Leading character for comment lines
     __int32 skip;               // # lines to skip at the beginning
     __uint64 unalignedCount;    // # unmapped reads without coordinates set
+    __int32 minShift;           // log2 of the size of the minimum bin (14 for TBI)
+    __int32 depth;              // Number of levels of the binning index (5 for TBI)
+    bool csi;                   // True for the CSI format, which has no linear index but a min offset per bin
 
     // 1<<14 is the size of the minimum bin.
     static const __int32 BAM_LIDX_SHIFT = 14;
@@ -135,6 +146,9 @@ public:
         meta('#'),
         skip(0),
         unalignedCount(maxValue<__uint64>()),
+        minShift(BAM_LIDX_SHIFT),
+        depth(5),
+        csi(false),
         _nameStoreCache(_nameStore)
     {}
 
@@ -146,6 +160,9 @@ public:
         meta('#'),
         skip(0),
         unalignedCount(maxValue<__uint64>()),
+        minShift(BAM_LIDX_SHIFT),
+        depth(5),
+        csi(false),
         _nameStoreCache(_nameStore)
     {
         if (!open(*this, fileName))
@@ -161,19 +178,106 @@ public:
 // Function _tbiReg2bins()
 // ----------------------------------------------------------------------------
 
+// Bin numbers are stored with 32 bits, which holds binning indices of up to 10 levels below the root.
+inline bool
+_tbiValidLayout(__int32 minShift, __int32 depth)
+{
+    return minShift >= 0 && depth >= 0 && depth <= 10 && minShift + 3 * depth < 64;
+}
+
+// Bins of all levels overlapping [beg, end), for a binning index with 2^minShift bp leaves and depth levels below
+// the root. minShift = 14 and depth = 5 is the fixed TBI/BAI layout.
 static inline void
-_tbiReg2bins(String<__uint16> & list, __uint32 beg, __uint32 end)
+_tbiReg2bins(String<__uint32> & list, __uint64 beg, __uint64 end, __int32 minShift, __int32 depth)
 {
-    unsigned k;
     if (beg >= end) return;
-    if (end >= 1u<<29) end = 1u<<29;
+    __int32 s = minShift + depth * 3;
+    if (end >= 1ull<<s) end = 1ull<<s;
     --end;
-    appendValue(list, 0);
-    for (k =    1 + (beg>>26); k <=    1 + (end>>26); ++k) appendValue(list, k);
-    for (k =    9 + (beg>>23); k <=    9 + (end>>23); ++k) appendValue(list, k);
-    for (k =   73 + (beg>>20); k <=   73 + (end>>20); ++k) appendValue(list, k);
-    for (k =  585 + (beg>>17); k <=  585 + (end>>17); ++k) appendValue(list, k);
-    for (k = 4681 + (beg>>14); k <= 4681 + (end>>14); ++k) appendValue(list, k);
+    __uint64 t = 0;
+    for (__int32 l = 0; l <= depth; ++l, s -= 3, t += 1ull<<(l * 3 - 3))
+        for (__uint64 k = t + (beg>>s); k <= t + (end>>s); ++k)
+            appendValue(list, static_cast<__uint32>(k));
+}
+
+// Smallest bin containing [beg, end).
+static inline __uint32
+_tbiReg2bin(__uint64 beg, __uint64 end, __int32 minShift, __int32 depth)
+{
+    --end;
+    __int32 s = minShift;
+    __uint64 t = ((1ull<<(depth * 3)) - 1) / 7;
+    for (__int32 l = depth; l > 0; t -= 1ull<<(l * 3), s += 3, --l)
+        if (beg>>s == end>>s)
+            return static_cast<__uint32>(t + (beg>>s));
+    return 0;
+}
+
+// Smallest virtual offset of a record overlapping position pos on reference refId.
+inline __uint64
+_tbiMinOffset(TabixIndex const & index, unsigned refId, __int32 pos)
+{
+    typedef TabixIndex::TBinIndex_::const_iterator TMapIter;
+
+    if (index.csi)
+    {
+        // Walk from the leaf bin of pos to the root, the first existing bin knows the min offset.
+        __uint32 bin = static_cast<__uint32>(((1ull<<(index.depth * 3)) - 1) / 7 +
+                                             (static_cast<__uint64>(pos)>>index.minShift));
+        while (true)
+        {
+            TMapIter mIt = index._binIndices[refId].find(bin);
+            if (mIt != index._binIndices[refId].end())
+                return mIt->second.loffset;
+            if (bin == 0)
+                return 0;
+            bin = (bin - 1) >> 3;
+        }
+    }
+
+    // Retrieve the smallest required offset from the linear index.
+    unsigned windowIdx = pos >> 14;  // Linear index consists of 16kb windows.
+    __uint64 linearMinOffset = 0;
+    if (windowIdx >= length(index._linearIndices[refId]))
+    {
+        // TODO(holtgrew): Can we simply always take case 1?
+
+        // This is the case were we want to jump in a non-existing window.
+        //
+        // If there are no linear indices for this reference then we use the linear min offset of the next
+        // reference that has an linear index.
+        if (empty(index._linearIndices[refId]))
+        {
+            for (unsigned i = refId; i < length(index._linearIndices); ++i)
+            {
+                if (!empty(index._linearIndices[i]))
+                {
+                    linearMinOffset = front(index._linearIndices[i]);
+                    if (linearMinOffset != 0u)
+                        break;
+                    for (unsigned j = 1; j < length(index._linearIndices[i]); ++j)
+                    {
+                        if (index._linearIndices[i][j] > linearMinOffset)
+                        {
+                            linearMinOffset = index._linearIndices[i][j];
+                            break;
+                        }
+                    }
+                    if (linearMinOffset != 0u)
+                        break;
+                }
+            }
+        }
+        else
+        {
+            linearMinOffset = back(index._linearIndices[refId]);
+        }
+    }
+    else
+    {
+        linearMinOffset = index._linearIndices[refId][windowIdx];
+    }
+    return linearMinOffset;
 }
 
 // ----------------------------------------------------------------------------
@@ -284,56 +388,16 @@ jumpToRegion(FormattedFile<TFileFormat, Input, TSpec> & fileIn,
     __uint64 offset = MaxValue<__uint64>::VALUE;
 
     // Retrieve the candidate bin identifiers for [posBeg, posEnd).
-    String<__uint16> candidateBins;
-    _tbiReg2bins(candidateBins, posBeg, posEnd);
+    String<__uint32> candidateBins;
+    _tbiReg2bins(candidateBins, posBeg, posEnd, index.minShift, index.depth);
 
-    // Retrieve the smallest required offset from the linear index.
-    unsigned windowIdx = posBeg >> 14;  // Linear index consists of 16kb windows.
-    __uint64 linearMinOffset = 0;
-    if (windowIdx >= length(index._linearIndices[refId]))
-    {
-        // TODO(holtgrew): Can we simply always take case 1?
-
-        // This is the case were we want to jump in a non-existing window.
-        //
-        // If there are no linear indices for this reference then we use the linear min offset of the next
-        // reference that has an linear index.
-        if (empty(index._linearIndices[refId]))
-        {
-            for (unsigned i = refId; i < length(index._linearIndices); ++i)
-            {
-                if (!empty(index._linearIndices[i]))
-                {
-                    linearMinOffset = front(index._linearIndices[i]);
-                    if (linearMinOffset != 0u)
-                        break;
-                    for (unsigned j = 1; j < length(index._linearIndices[i]); ++j)
-                    {
-                        if (index._linearIndices[i][j] > linearMinOffset)
-                        {
-                            linearMinOffset = index._linearIndices[i][j];
-                            break;
-                        }
-                    }
-                    if (linearMinOffset != 0u)
-                        break;
-                }
-            }
-        }
-        else
-        {
-            linearMinOffset = back(index._linearIndices[refId]);
-        }
-    }
-    else
-    {
-        linearMinOffset = index._linearIndices[refId][windowIdx];
-    }
+    // Retrieve the smallest required offset from the linear index (TBI) or the bins (CSI).
+    __uint64 linearMinOffset = _tbiMinOffset(index, refId, posBeg);
 
     // Combine candidate bins and smallest required offset from linear index into candidate offset.
     typedef std::set<__uint64> TOffsetCandidates;
     TOffsetCandidates offsetCandidates;
-    typedef typename Iterator<String<__uint16>, Rooted>::Type TCandidateIter;
+    typedef typename Iterator<String<__uint32>, Rooted>::Type TCandidateIter;
     for (TCandidateIter it = begin(candidateBins, Rooted()); !atEnd(it); goNext(it))
     {
         typedef typename std::map<__uint32, TabixIndexBinData_>::const_iterator TMapIter;
@@ -451,12 +515,33 @@ open(TabixIndex & index, char const * filename)
     // Read magic header.
     String<char, Array<4> > magic;
     read(magic, iter, 4);
-    if (magic != "TBI\1")
-        SEQAN_THROW(ParseError("Not in TBI format."));
+    if (magic == "TBI\1")
+    {
+        index.csi = false;
+        index.minShift = TabixIndex::BAM_LIDX_SHIFT;
+        index.depth = 5;
+    }
+    else if (magic == "CSI\1")
+    {
+        index.csi = true;
+        readRawPod(index.minShift, iter);
+        readRawPod(index.depth, iter);
+        __int32 lAux = 0;
+        readRawPod(lAux, iter);
+        if (!_tbiValidLayout(index.minShift, index.depth))
+            SEQAN_THROW(ParseError("CSI index has an invalid binning layout."));
+        if (lAux < 28)
+            SEQAN_THROW(ParseError("CSI index has no Tabix configuration."));
+    }
+    else
+    {
+        SEQAN_THROW(ParseError("Not in TBI or CSI format."));
+    }
 
-    // Read parameters.
+    // Read parameters. In CSI files the number of references follows the Tabix configuration.
     __int32 nRef = 0;
-    readRawPod(nRef, iter);
+    if (!index.csi)
+        readRawPod(nRef, iter);
     readRawPod(index.format, iter);
     readRawPod(index.colSeq, iter);
     readRawPod(index.colBeg, iter);
@@ -469,6 +554,8 @@ open(TabixIndex & index, char const * filename)
     CharString tmp;
     readRawPod(lNm, iter);
     read(tmp, iter, lNm);
+    if (index.csi)
+        readRawPod(nRef, iter);
 
     // Split concatenated names at \0's.
     clear(index._nameStore);
@@ -492,6 +579,8 @@ open(TabixIndex & index, char const * filename)
             __uint32 bin = 0;
             __int32 nChunk = 0;
             readRawPod(bin, iter);
+            if (index.csi)
+                readRawPod(data.loffset, iter);
             readRawPod(nChunk, iter);
 
             resize(data.chunkBegEnds, nChunk);
@@ -505,7 +594,10 @@ open(TabixIndex & index, char const * filename)
             index._binIndices[i][bin] = data;
         }
 
-        // Read linear index.
+        // Read linear index (TBI only).
+        if (index.csi)
+            continue;
+
         __int32 nIntv = 0;
         readRawPod(nIntv, iter);
 
@@ -524,6 +616,239 @@ open(TabixIndex & index, char const * filename)
     return true;
 }
 
+// ----------------------------------------------------------------------------
+// Function save()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TabixIndex#save
+ * @brief Save a Tabix index to a BGZF compressed file, in TBI or CSI format.
+ * @signature bool save(index, filename);
+ *
+ * @param[in] index    Index to save.
+ * @param[in] filename Path to file to write. Types: char const *
+ *
+ * @return    bool     Returns <tt>true</tt> on success, false otherwise.
+ *
+ * @section Remarks
+ *
+ * The CSI format is written if the index was loaded from a CSI file or built with a non-TBI layout.
+ */
+
+inline bool
+save(TabixIndex const & index, char const * filename)
+{
+    typedef TabixIndex::TBinIndex_::const_iterator TBinIter;
+
+    __int32 nRef = length(index._binIndices);
+
+    // Names are stored \0-terminated.
+    __int32 lNm = 0;
+    for (unsigned i = 0; i < length(index._nameStore); ++i)
+        lNm += length(index._nameStore[i]) + 1;
+
+    // Serialize the index into a buffer, written in one go to the compressed stream.
+    CharString buffer;
+    if (index.csi)
+    {
+        // The auxiliary data of CSI is the Tabix configuration, including the names.
+        append(buffer, "CSI\1");
+        appendRawPod(buffer, index.minShift);
+        appendRawPod(buffer, index.depth);
+        appendRawPod(buffer, static_cast<__int32>(7 * sizeof(__int32) + lNm));
+    }
+    else
+    {
+        append(buffer, "TBI\1");
+        appendRawPod(buffer, nRef);
+    }
+
+    appendRawPod(buffer, index.format);
+    appendRawPod(buffer, index.colSeq);
+    appendRawPod(buffer, index.colBeg);
+    appendRawPod(buffer, index.colEnd);
+    appendRawPod(buffer, index.meta);
+    appendRawPod(buffer, index.skip);
+    appendRawPod(buffer, lNm);
+    for (unsigned i = 0; i < length(index._nameStore); ++i)
+    {
+        append(buffer, index._nameStore[i]);
+        appendValue(buffer, '\0');
+    }
+
+    if (index.csi)
+        appendRawPod(buffer, nRef);
+
+    for (__int32 i = 0; i < nRef; ++i)  // For each reference.
+    {
+        appendRawPod(buffer, static_cast<__int32>(index._binIndices[i].size()));
+        for (TBinIter it = index._binIndices[i].begin(); it != index._binIndices[i].end(); ++it)
+        {
+            appendRawPod(buffer, it->first);
+            if (index.csi)
+                appendRawPod(buffer, it->second.loffset);
+            appendRawPod(buffer, static_cast<__int32>(length(it->second.chunkBegEnds)));
+            for (unsigned k = 0; k < length(it->second.chunkBegEnds); ++k)
+            {
+                appendRawPod(buffer, it->second.chunkBegEnds[k].i1);
+                appendRawPod(buffer, it->second.chunkBegEnds[k].i2);
+            }
+        }
+
+        if (index.csi)
+            continue;
+
+        appendRawPod(buffer, static_cast<__int32>(length(index._linearIndices[i])));
+        for (unsigned j = 0; j < length(index._linearIndices[i]); ++j)
+            appendRawPod(buffer, index._linearIndices[i][j]);
+    }
+
+    if (index.unalignedCount != maxValue<__uint64>())
+        appendRawPod(buffer, index.unalignedCount);
+
+    std::ofstream file(filename, std::ios::binary | std::ios::out);
+    if (!file.good())
+        return false;
+
+    VirtualStream<char, Output> out;
+    if (!open(out, file, BgzfFile()))
+        return false;
+
+    out.write(&buffer[0], length(buffer));
+    close(out);
+    return file.good();
+}
+
+// ----------------------------------------------------------------------------
+// Function build()
+// ----------------------------------------------------------------------------
+
+/*!
+ * @fn TabixIndex#build
+ * @brief Build a Tabix index for a BGZF compressed and sorted file.
+ *
+ * @signature bool build(index, fileIn[, minShift, depth]);
+ *
+ * @param[out]    index    The @link TabixIndex @endlink to build.
+ * @param[in,out] fileIn   The @link VcfFileIn @endlink, @link GffFileIn @endlink, or @link BedFileIn @endlink to index.
+ *                         The file must be positioned behind its header, it is read until the end.
+ * @param[in]     minShift log2 of the size of the minimal bin (<tt>__int32</tt>, default 14).
+ * @param[in]     depth    Number of levels of the binning index (<tt>__int32</tt>, default 5).
+ *
+ * @return bool true on success, false if the file is not sorted by position or the binning layout is invalid.
+ *
+ * @section Remarks
+ *
+ * The column layout (<tt>format</tt>, <tt>colSeq</tt>, <tt>colBeg</tt>, <tt>colEnd</tt>, <tt>meta</tt>) of
+ * <tt>index</tt> is used to parse the records and has to be set before.  With the default <tt>minShift</tt> and
+ * <tt>depth</tt> a TBI index is built, otherwise a CSI index.  A CSI index is required for contigs longer than
+ * 2^29 bp, it covers contigs of up to 2^(minShift + 3 * depth) bp.  Bin numbers are stored with 32 bits, which limits
+ * <tt>depth</tt> to 10.
+ */
+
+template <typename TFileFormat, typename TSpec>
+inline bool
+build(TabixIndex & index,
+      FormattedFile<TFileFormat, Input, TSpec> & fileIn,
+      __int32 minShift = TabixIndex::BAM_LIDX_SHIFT,
+      __int32 depth = 5)
+{
+    typedef TabixIndex::TBinIndex_ TBinIndex;
+
+    if (!_tbiValidLayout(minShift, depth))
+        return false;
+
+    index.minShift = minShift;
+    index.depth = depth;
+    index.csi = minShift != TabixIndex::BAM_LIDX_SHIFT || depth != 5;
+    index.unalignedCount = maxValue<__uint64>();
+    clear(index._binIndices);
+    clear(index._linearIndices);
+    clear(index._nameStore);
+    refresh(index._nameStoreCache);
+
+    __uint64 const maxPos = 1ull << (minShift + 3 * depth);
+    __uint64 const unset = maxValue<__uint64>();
+
+    CharString buffer;
+    TabixRecord_ record;
+    unsigned refId = 0;
+    bool hasRef = false;
+    __int32 lastPos = 0;
+
+    while (!atEnd(fileIn))
+    {
+        __uint64 begOffset = position(fileIn);
+        if (!_readTabixRecord(record, buffer, fileIn.iter, index))
+            break;
+        __uint64 endOffset = position(fileIn);
+
+        // A new contig must not have been seen before, positions must not decrease within a contig.
+        if (!hasRef || record.refName != index._nameStore[refId])
+        {
+            unsigned id = 0;
+            if (getIdByName(id, index._nameStoreCache, record.refName))
+                return false;
+            appendName(index._nameStoreCache, record.refName);
+            refId = length(index._nameStore) - 1;
+            resize(index._binIndices, refId + 1);
+            resize(index._linearIndices, refId + 1);
+            hasRef = true;
+            lastPos = 0;
+        }
+        if (record.posBeg < lastPos || record.posBeg < 0 || static_cast<__uint64>(record.posBeg) >= maxPos)
+            return false;
+        lastPos = record.posBeg;
+
+        __uint64 posBeg = record.posBeg;
+        __uint64 posEnd = std::min(std::max(static_cast<__uint64>(std::max(record.posEnd, 0)), posBeg + 1), maxPos);
+
+        // Append the record to the chunks of its bin, merging with the last chunk if it is adjacent.
+        TabixIndexBinData_ & binData = index._binIndices[refId][_tbiReg2bin(posBeg, posEnd, minShift, depth)];
+        if (!empty(binData.chunkBegEnds) && back(binData.chunkBegEnds).i2 == begOffset)
+            back(binData.chunkBegEnds).i2 = endOffset;
+        else
+            appendValue(binData.chunkBegEnds, Pair<__uint64, __uint64>(begOffset, endOffset));
+
+        // The linear index stores the offset of the first record overlapping each minimal bin.
+        TabixIndex::TLinearIndex_ & linearIndex = index._linearIndices[refId];
+        __uint64 windowEnd = ((posEnd - 1) >> minShift) + 1;
+        if (length(linearIndex) < windowEnd)
+            resize(linearIndex, windowEnd, unset);
+        for (__uint64 w = posBeg >> minShift; w < windowEnd; ++w)
+            if (linearIndex[w] == unset)
+                linearIndex[w] = begOffset;
+    }
+
+    for (unsigned i = 0; i < length(index._linearIndices); ++i)
+    {
+        // Windows without records get the offset of the closest window with records before or after them.
+        TabixIndex::TLinearIndex_ & linearIndex = index._linearIndices[i];
+        unsigned first = 0;
+        while (first < length(linearIndex) && linearIndex[first] == unset)
+            ++first;
+        for (unsigned w = 0; w < length(linearIndex); ++w)
+            if (linearIndex[w] == unset)
+                linearIndex[w] = (w < first) ? linearIndex[first] : linearIndex[w - 1];
+
+        if (!index.csi)
+            continue;
+
+        // CSI stores the linear index in the bins: the min offset of a bin is the one of its first minimal bin.
+        for (TBinIndex::iterator it = index._binIndices[i].begin(); it != index._binIndices[i].end(); ++it)
+        {
+            __int32 level = 0;
+            while (it->first >= ((1ull << (3 * (level + 1))) - 1) / 7)
+                ++level;
+            __uint64 window = static_cast<__uint64>(it->first - ((1ull << (3 * level)) - 1) / 7) << (3 * (depth - level));
+            it->second.loffset = linearIndex[std::min<__uint64>(window, length(linearIndex) - 1)];
+        }
+        clear(linearIndex);
+    }
+
+    return true;
+}
+
 }  // namespace seqan
 
 #endif  // #ifndef INCLUDE_SEQAN_TABIX_IO_TABIX_INDEX_TBI_H_
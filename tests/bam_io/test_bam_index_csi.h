@@ -0,0 +1,234 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for loading and saving CSI indices with BamIndex<Bai>.
+// ==========================================================================
+
+#ifndef TESTS_BAM_IO_TEST_BAM_INDEX_CSI_H_
+#define TESTS_BAM_IO_TEST_BAM_INDEX_CSI_H_
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include <seqan/bam_io.h>
+
+SEQAN_DEFINE_TEST(test_bam_io_bam_index_csi_open_save)
+{
+    seqan::CharString baiFilename = SEQAN_PATH_TO_ROOT();
+    append(baiFilename, "/tests/bam_io/small.bam.bai");
+
+    seqan::CharString tmpOutPath = SEQAN_TEMP_FILENAME();
+    append(tmpOutPath, ".csi");
+
+    // Convert the BAI index into a CSI index with the same binning, the min offsets come from the linear index.
+    seqan::BamIndex<seqan::Bai> baiIndex;
+    SEQAN_ASSERT(open(baiIndex, toCString(baiFilename)));
+    SEQAN_ASSERT_NOT(baiIndex._csi);
+    __uint64 linearMinOffset = seqan::_baiMinOffset(baiIndex, 0, 1);
+    baiIndex._binIndices[0][4681].loffset = linearMinOffset;
+    clear(baiIndex._linearIndices[0]);
+    baiIndex._csi = true;
+    SEQAN_ASSERT(save(baiIndex, toCString(tmpOutPath)));
+
+    seqan::BamIndex<seqan::Bai> csiIndex;
+    SEQAN_ASSERT(open(csiIndex, toCString(tmpOutPath)));
+    SEQAN_ASSERT(csiIndex._csi);
+    SEQAN_ASSERT_EQ(csiIndex._minShift, 14);
+    SEQAN_ASSERT_EQ(csiIndex._depth, 5);
+    SEQAN_ASSERT_EQ(length(csiIndex._binIndices), 1u);
+    SEQAN_ASSERT_EQ(csiIndex._binIndices[0].size(), baiIndex._binIndices[0].size());
+    SEQAN_ASSERT_EQ(csiIndex._binIndices[0][4681].loffset, linearMinOffset);
+    SEQAN_ASSERT(csiIndex._binIndices[0][4681].chunkBegEnds == baiIndex._binIndices[0][4681].chunkBegEnds);
+    SEQAN_ASSERT_EQ(getUnalignedCount(csiIndex), getUnalignedCount(baiIndex));
+
+    // The min offset of CSI is found in the leaf bin, as the one of BAI in the linear index.
+    SEQAN_ASSERT_EQ(seqan::_baiMinOffset(csiIndex, 0, 1), linearMinOffset);
+}
+
+SEQAN_DEFINE_TEST(test_bam_io_bam_index_csi_bins)
+{
+    // The classic BAI layout.
+    seqan::String<__uint32> bins;
+    seqan::_baiReg2bins(bins, 1, 10, 14, 5);
+    SEQAN_ASSERT_EQ(length(bins), 6u);
+    SEQAN_ASSERT_EQ(bins[0], 0u);
+    SEQAN_ASSERT_EQ(bins[1], 1u);
+    SEQAN_ASSERT_EQ(bins[2], 9u);
+    SEQAN_ASSERT_EQ(bins[3], 73u);
+    SEQAN_ASSERT_EQ(bins[4], 585u);
+    SEQAN_ASSERT_EQ(bins[5], 4681u);
+
+    // The deepest layout with 32 bit bin numbers, the last level starts at (8^10 - 1) / 7.
+    clear(bins);
+    __uint64 const lastPos = (1ull << 34) - 1;
+    seqan::_baiReg2bins(bins, lastPos, lastPos + 1, 4, 10);
+    SEQAN_ASSERT_EQ(length(bins), 11u);
+    SEQAN_ASSERT_EQ(bins[0], 0u);
+    SEQAN_ASSERT_EQ(bins[1], 8u);
+    SEQAN_ASSERT_EQ(bins[9], 153391688u);
+    SEQAN_ASSERT_EQ(bins[10], 1227133512u);
+
+    // The min offset is taken from the deepest existing bin on the path to the root.
+    seqan::BamIndex<seqan::Bai> index;
+    index._csi = true;
+    index._minShift = 4;
+    index._depth = 10;
+    resize(index._binIndices, 1);
+    resize(index._linearIndices, 1);
+    index._binIndices[0][0].loffset = 5;
+    index._binIndices[0][153391689u + (1000 >> 4)].loffset = 42;
+    SEQAN_ASSERT_EQ(seqan::_baiMinOffset(index, 0, 1000), 42u);
+    SEQAN_ASSERT_EQ(seqan::_baiMinOffset(index, 0, 2000), 5u);
+
+    // Save and load the deep index again.
+    seqan::CharString tmpOutPath = SEQAN_TEMP_FILENAME();
+    append(tmpOutPath, ".csi");
+    SEQAN_ASSERT(save(index, toCString(tmpOutPath)));
+    seqan::BamIndex<seqan::Bai> csiIndex;
+    SEQAN_ASSERT(open(csiIndex, toCString(tmpOutPath)));
+    SEQAN_ASSERT_EQ(csiIndex._minShift, 4);
+    SEQAN_ASSERT_EQ(csiIndex._depth, 10);
+    SEQAN_ASSERT_EQ(seqan::_baiMinOffset(csiIndex, 0, 1000), 42u);
+
+    // Bin numbers of 11 levels do not fit into 32 bits, such indices are rejected.
+    index._depth = 11;
+    SEQAN_ASSERT(save(index, toCString(tmpOutPath)));
+    SEQAN_ASSERT_NOT(open(csiIndex, toCString(tmpOutPath)));
+}
+
+SEQAN_DEFINE_TEST(test_bam_io_bam_index_csi_jump_orphans)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+    seqan::CharString outPath = SEQAN_TEMP_FILENAME();
+    append(outPath, ".bam");
+
+    // Copy the alignments of ex1.bam and append orphans without reference.
+    {
+        seqan::HtsFileIn in(toCString(bamPath));
+        seqan::HtsFileOut out(toCString(outPath), "wb");
+        copyHeader(out, in);
+        SEQAN_ASSERT(writeHeader(out));
+        seqan::BamAlignmentRecord record;
+        while (readRecord(record, in))
+            SEQAN_ASSERT(writeRecord(out, record));
+        for (unsigned i = 0; i < 3; ++i)
+        {
+            record.qName = "orphan";
+            appendNumber(record.qName, i);
+            record.flag = seqan::BAM_FLAG_UNMAPPED;
+            record.rID = record.rNextId = seqan::BamAlignmentRecord::INVALID_REFID;
+            record.beginPos = record.pNext = seqan::BamAlignmentRecord::INVALID_POS;
+            record.tLen = 0;
+            clear(record.cigar);
+            SEQAN_ASSERT(writeRecord(out, record));
+        }
+        SEQAN_ASSERT(close(out));
+    }
+
+    // A CSI index with all alignments of a reference in the root bin, and the pseudo bin with the offset range of the
+    // reference and the counts of mapped and unmapped alignments.  The count of mapped alignments is larger than any
+    // offset in the file, it must not be taken for a chunk begin.
+    seqan::BamIndex<seqan::Bai> index;
+    index._csi = true;
+    index._unalignedCount = 3;
+    resize(index._binIndices, 2);
+    resize(index._linearIndices, 2);
+    __uint32 const metaBin = 37450;
+    __uint64 const mappedCount = 1ull << 40;
+    seqan::String<__uint64> refBegins;
+    {
+        seqan::HtsFileIn file(toCString(outPath));
+        seqan::BamAlignmentRecord record;
+        __int32 rID = seqan::BamAlignmentRecord::INVALID_REFID;
+        __uint64 offset = bgzf_tell(file.fp->fp.bgzf);
+        while (readRecord(record, file))
+        {
+            if (record.rID != rID)
+            {
+                if (rID >= 0)
+                    index._binIndices[rID][0].chunkBegEnds[0].i2 = offset;
+                if (record.rID < 0)
+                    break;
+                rID = record.rID;
+                appendValue(refBegins, offset);
+                index._binIndices[rID][0].loffset = offset;
+                appendValue(index._binIndices[rID][0].chunkBegEnds, seqan::Pair<__uint64>(offset, 0));
+            }
+            offset = bgzf_tell(file.fp->fp.bgzf);
+        }
+        for (unsigned i = 0; i < 2; ++i)
+        {
+            appendValue(index._binIndices[i][metaBin].chunkBegEnds, index._binIndices[i][0].chunkBegEnds[0]);
+            appendValue(index._binIndices[i][metaBin].chunkBegEnds, seqan::Pair<__uint64>(mappedCount, 0));
+        }
+    }
+
+    // The pseudo bin survives saving and loading.
+    seqan::CharString csiPath = outPath;
+    append(csiPath, ".csi");
+    SEQAN_ASSERT(save(index, toCString(csiPath)));
+    seqan::BamIndex<seqan::Bai> csiIndex;
+    SEQAN_ASSERT(open(csiIndex, toCString(csiPath)));
+    SEQAN_ASSERT_EQ(length(csiIndex._binIndices[1][metaBin].chunkBegEnds), 2u);
+    SEQAN_ASSERT_EQ(csiIndex._binIndices[1][metaBin].chunkBegEnds[1].i1, mappedCount);
+
+    seqan::HtsFileIn file(toCString(outPath));
+    seqan::BamAlignmentRecord record;
+    bool hasAlignments = false;
+
+    // The orphans are found from the last chunk of the last reference.
+    SEQAN_ASSERT(jumpToOrphans(file, hasAlignments, csiIndex));
+    SEQAN_ASSERT(hasAlignments);
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        SEQAN_ASSERT(readRecord(record, file));
+        SEQAN_ASSERT_EQ(record.rID, -1);
+        seqan::CharString qName = "orphan";
+        appendNumber(qName, i);
+        SEQAN_ASSERT_EQ(record.qName, qName);
+    }
+    SEQAN_ASSERT_NOT(readRecord(record, file));
+
+    // Jumping to a region starts at the chunk of its reference.
+    SEQAN_ASSERT(jumpToRegion(file, hasAlignments, 1, 100, 200, csiIndex));
+    SEQAN_ASSERT(hasAlignments);
+    SEQAN_ASSERT(readRecord(record, file));
+    SEQAN_ASSERT_EQ(record.rID, 1);
+    SEQAN_ASSERT(jumpToRegion(file, hasAlignments, 0, 0, 10, csiIndex));
+    SEQAN_ASSERT(hasAlignments);
+    SEQAN_ASSERT(readRecord(record, file));
+    SEQAN_ASSERT_EQ(record.rID, 0);
+    SEQAN_ASSERT_EQ(record.qName, "B7_591:4:96:693:509");
+    SEQAN_ASSERT_NOT(jumpToRegion(file, hasAlignments, 2, 0, 10, csiIndex));
+}
+
+#endif  // TESTS_BAM_IO_TEST_BAM_INDEX_CSI_H_
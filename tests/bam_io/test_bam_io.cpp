@@ -41,6 +41,7 @@
 #include "test_bam_io_context.h"
 #include "test_bam_sam_conversion.h"
 #include "test_bam_tags_dict.h"
+#include "test_bam_sequence_codec.h"
 #include "test_read_sam.h"
 #include "test_write_sam.h"
 #include "test_read_bam.h"
@@ -143,10 +144,16 @@ SEQAN_BEGIN_TESTSUITE(test_bam_io)
     SEQAN_CALL_TEST(test_bam_tags_dict_erase_tag);
     SEQAN_CALL_TEST(test_bam_tags_dict_set_tag_value);
     SEQAN_CALL_TEST(test_bam_tags_dict_append_tag_value);
+    SEQAN_CALL_TEST(test_bam_tags_dict_edit_sequence);
     
+    // Test bulk BAM sequence and quality conversion.
+    SEQAN_CALL_TEST(test_bam_io_bam_sequence_codec_seq);
+    SEQAN_CALL_TEST(test_bam_io_bam_sequence_codec_qual);
+
     // Test SAM I/O.
     SEQAN_CALL_TEST(test_bam_io_sam_read_header);
     SEQAN_CALL_TEST(test_bam_io_sam_read_alignment);
+    SEQAN_CALL_TEST(test_bam_io_sam_read_alignment_fields);
     SEQAN_CALL_TEST(test_bam_io_sam_write_header);
     SEQAN_CALL_TEST(test_bam_io_sam_write_alignment);
 
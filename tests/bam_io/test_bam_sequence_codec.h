@@ -0,0 +1,104 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+
+#ifndef TESTS_BAM_IO_TEST_BAM_SEQUENCE_CODEC_H_
+#define TESTS_BAM_IO_TEST_BAM_SEQUENCE_CODEC_H_
+
+#include <seqan/basic.h>
+#include <seqan/sequence.h>
+
+#include <seqan/bam_io.h>
+
+// Lengths exercising empty input, the scalar tail only and the vectorized loop plus odd tails.
+static unsigned const TEST_BAM_SEQUENCE_CODEC_LENGTHS[] = {0, 1, 2, 15, 31, 32, 33, 64, 77};
+
+SEQAN_DEFINE_TEST(test_bam_io_bam_sequence_codec_seq)
+{
+    using namespace seqan;
+
+    char const * alphabet = "=ACMGRSVTWYHKDBN";
+
+    for (unsigned t = 0; t < sizeof(TEST_BAM_SEQUENCE_CODEC_LENGTHS) / sizeof(unsigned); ++t)
+    {
+        unsigned len = TEST_BAM_SEQUENCE_CODEC_LENGTHS[t];
+
+        IupacString seq;
+        CharString seqChars;
+        for (unsigned i = 0; i < len; ++i)
+        {
+            appendValue(seq, Iupac((i * 7 + 3) % 16));
+            appendValue(seqChars, alphabet[(i * 7 + 3) % 16]);
+        }
+
+        String<unsigned char> packed;
+        resize(packed, (len + 1) / 2, 0xff);
+        encodeBamSeq(begin(packed, Standard()), seq);
+        for (unsigned i = 0; i < len; ++i)
+            SEQAN_ASSERT_EQ((unsigned)((packed[i / 2] >> ((i & 1) ? 0 : 4)) & 0x0f), ordValue(seq[i]));
+        if (len & 1)
+            SEQAN_ASSERT_EQ(packed[len / 2] & 0x0f, 0);
+
+        IupacString decoded;
+        decodeBamSeq(decoded, begin(packed, Standard()), len);
+        SEQAN_ASSERT_EQ(decoded, seq);
+
+        CharString decodedChars;
+        decodeBamSeq(decodedChars, begin(packed, Standard()), len);
+        SEQAN_ASSERT_EQ(decodedChars, seqChars);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_bam_io_bam_sequence_codec_qual)
+{
+    using namespace seqan;
+
+    for (unsigned t = 0; t < sizeof(TEST_BAM_SEQUENCE_CODEC_LENGTHS) / sizeof(unsigned); ++t)
+    {
+        unsigned len = TEST_BAM_SEQUENCE_CODEC_LENGTHS[t];
+
+        CharString qual;
+        for (unsigned i = 0; i < len; ++i)
+            appendValue(qual, (char)('!' + (i * 5) % 42));
+
+        String<unsigned char> raw;
+        resize(raw, len, 0);
+        encodeBamQual(begin(raw, Standard()), qual);
+        for (unsigned i = 0; i < len; ++i)
+            SEQAN_ASSERT_EQ((unsigned)raw[i], (i * 5) % 42);
+
+        CharString decoded;
+        decodeBamQual(decoded, begin(raw, Standard()), len);
+        SEQAN_ASSERT_EQ(decoded, qual);
+    }
+}
+
+#endif  // TESTS_BAM_IO_TEST_BAM_SEQUENCE_CODEC_H_
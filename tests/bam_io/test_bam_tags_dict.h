@@ -573,4 +573,49 @@ SEQAN_DEFINE_TEST(test_bam_tags_dict_erase_tag)
     }
 }
 
+SEQAN_DEFINE_TEST(test_bam_tags_dict_edit_sequence)
+{
+    using namespace seqan;
+
+    CharString bamTags;
+    CharString samTags = "NM:i:3\tMD:Z:10A5\tAS:i:40\tXS:i:12\tRG:Z:grp1";
+    assignTagsSamToBam(bamTags, samTags);
+    BamTagsDict tags(bamTags);
+
+    // Lookups through the key index, including absent keys.
+    unsigned id = 0;
+    SEQAN_ASSERT(findTagKey(id, tags, "XS"));
+    SEQAN_ASSERT_EQ(id, 3u);
+    SEQAN_ASSERT(findTagKey(id, tags, "NM"));
+    SEQAN_ASSERT_EQ(id, 0u);
+    SEQAN_ASSERT_NOT(findTagKey(id, tags, "MC"));
+
+    // Same size (in place), different size, appended and erased tags.
+    __int32 x = 0;
+    SEQAN_ASSERT(setTagValue(tags, "NM", (__int32)5, 'i'));
+    SEQAN_ASSERT(setTagValue(tags, "MD", "16", 'Z'));
+    SEQAN_ASSERT(setTagValue(tags, "MC", "50M", 'Z'));
+    SEQAN_ASSERT(eraseTag(tags, "XS"));
+    SEQAN_ASSERT(setTagValue(tags, "AS", (__int32)38, 'i'));
+
+    SEQAN_ASSERT_EQ(length(tags), 5u);
+    SEQAN_ASSERT(findTagKey(id, tags, "AS"));
+    SEQAN_ASSERT(extractTagValue(x, tags, id));
+    SEQAN_ASSERT_EQ(x, 38);
+    SEQAN_ASSERT(findTagKey(id, tags, "RG"));
+    SEQAN_ASSERT_EQ(id, 3u);
+    SEQAN_ASSERT_NOT(findTagKey(id, tags, "XS"));
+
+    assignTagsBamToSam(samTags, bamTags);
+    SEQAN_ASSERT_EQ(CharString("NM:i:5\tMD:Z:16\tAS:i:38\tRG:Z:grp1\tMC:Z:50M"), CharString(samTags));
+
+    // The index must match a freshly built one.
+    BamTagsDict fresh(bamTags);
+    for (unsigned i = 0; i < length(fresh); ++i)
+    {
+        SEQAN_ASSERT(findTagKey(id, tags, getTagKey(fresh, i)));
+        SEQAN_ASSERT_EQ(id, i);
+    }
+}
+
 #endif  // TESTS_BAM_IO_TEST_BAM_TAGS_DICT_DICT_H_
@@ -160,4 +160,76 @@ SEQAN_DEFINE_TEST(test_bam_io_sam_read_alignment)
     // TODO(holtgrew): Check more alignments?
 }
 
+SEQAN_DEFINE_TEST(test_bam_io_sam_read_alignment_fields)
+{
+    using namespace seqan;
+
+    CharString input =
+            "READ1\t99\tREF2\t100\t*\t3S2=1X4M\t=\t300\t-250\tACGTNACGTA\tABCDEFGHIJ\tNM:i:1\tRG:Z:grp\r\n"
+            "READ2\t4\t*\t0\t0\t*\tREF1\t*\t*\t*\t*\n"
+            "READ3\t0\tREF1\t7\t60\t5M\t*\t0\t0\tACGTA\t*";
+
+    Iterator<CharString, Rooted>::Type iter = begin(input);
+
+    StringSet<CharString> referenceNameStore;
+    NameStoreCache<StringSet<CharString> > referenceNameStoreCache(referenceNameStore);
+    BamIOContext<StringSet<CharString> > bamIOContext(referenceNameStore, referenceNameStoreCache);
+    appendName(referenceNameStoreCache, "REF1");
+    appendName(referenceNameStoreCache, "REF2");
+
+    BamAlignmentRecord record;
+    readRecord(record, bamIOContext, iter, Sam());
+
+    SEQAN_ASSERT_EQ(record.qName, "READ1");
+    SEQAN_ASSERT_EQ(record.flag, 99u);
+    SEQAN_ASSERT_EQ(record.rID, 1);
+    SEQAN_ASSERT_EQ(record.beginPos, 99);
+    SEQAN_ASSERT_EQ(record.mapQ, 255u);
+    SEQAN_ASSERT_EQ(length(record.cigar), 4u);
+    SEQAN_ASSERT_EQ(record.cigar[0].count, 3u);
+    SEQAN_ASSERT_EQ(record.cigar[0].operation, 'S');
+    SEQAN_ASSERT_EQ(record.cigar[1].count, 2u);
+    SEQAN_ASSERT_EQ(record.cigar[1].operation, '=');
+    SEQAN_ASSERT_EQ(record.cigar[3].count, 4u);
+    SEQAN_ASSERT_EQ(record.cigar[3].operation, 'M');
+    SEQAN_ASSERT_EQ(record.rNextId, 1);
+    SEQAN_ASSERT_EQ(record.pNext, 299);
+    SEQAN_ASSERT_EQ(record.tLen, -250);
+    SEQAN_ASSERT_EQ(record.seq, "ACGTNACGTA");
+    SEQAN_ASSERT_EQ(record.qual, "ABCDEFGHIJ");
+
+    CharString samTags;
+    assignTagsBamToSam(samTags, record.tags);
+    SEQAN_ASSERT_EQ(samTags, "NM:i:1\tRG:Z:grp");
+
+    readRecord(record, bamIOContext, iter, Sam());
+    SEQAN_ASSERT_EQ(record.qName, "READ2");
+    SEQAN_ASSERT_EQ(record.rID, (__int32)BamAlignmentRecord::INVALID_REFID);
+    SEQAN_ASSERT_EQ(record.beginPos, (__int32)BamAlignmentRecord::INVALID_POS);
+    SEQAN_ASSERT_EQ(length(record.cigar), 0u);
+    SEQAN_ASSERT_EQ(record.rNextId, 0);
+    SEQAN_ASSERT_EQ(record.pNext, (__int32)BamAlignmentRecord::INVALID_POS);
+    SEQAN_ASSERT_EQ(record.tLen, MaxValue<__int32>::VALUE);
+    SEQAN_ASSERT(empty(record.seq));
+    SEQAN_ASSERT(empty(record.qual));
+    SEQAN_ASSERT(empty(record.tags));
+
+    readRecord(record, bamIOContext, iter, Sam());
+    SEQAN_ASSERT_EQ(record.qName, "READ3");
+    SEQAN_ASSERT_EQ(record.beginPos, 6);
+    SEQAN_ASSERT_EQ(record.mapQ, 60u);
+    SEQAN_ASSERT_EQ(record.seq, "ACGTA");
+    SEQAN_ASSERT(empty(record.qual));
+    SEQAN_ASSERT(atEnd(iter));
+
+    // Truncated lines and malformed numbers are rejected.
+    CharString truncated = "READ4\t0\tREF1\t7\t60\t5M\t*\t0\n";
+    Iterator<CharString, Rooted>::Type truncatedIter = begin(truncated);
+    SEQAN_TEST_EXCEPTION(ParseError, readRecord(record, bamIOContext, truncatedIter, Sam()));
+
+    CharString malformed = "READ5\t0\tREF1\t7x\t60\t5M\t*\t0\t0\tACGTA\t*\n";
+    Iterator<CharString, Rooted>::Type malformedIter = begin(malformed);
+    SEQAN_TEST_EXCEPTION(BadLexicalCast, readRecord(record, bamIOContext, malformedIter, Sam()));
+}
+
 #endif  // TESTS_BAM_IO_TEST_READ_SAM_H_
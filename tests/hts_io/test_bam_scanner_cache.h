@@ -0,0 +1,93 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for joining mates with the BAM scanner cache.
+// ==========================================================================
+
+
+#ifndef TESTS_HTS_IO_TEST_BAM_SCANNER_CACHE_H_
+#define TESTS_HTS_IO_TEST_BAM_SCANNER_CACHE_H_
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <seqan/bam_io.h>
+
+// Read all templates of ex1.bam, collects the names of joined pairs and returns the number of records.
+inline unsigned
+_readScannerTemplates(std::vector<std::string> & pairNames, bool & merged, seqan::BamScannerCache & cache)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+
+    seqan::HtsFileIn file(toCString(bamPath));
+    seqan::String<seqan::BamAlignmentRecord> records;
+    unsigned numRecords = 0;
+    merged = false;
+    while (true)
+    {
+        readMultiRecords(records, file, cache);
+        if (empty(records))
+            break;
+        merged |= cache.merging;
+        numRecords += length(records);
+        if (length(records) == 2u)
+        {
+            SEQAN_ASSERT_EQ(records[0].qName, records[1].qName);
+            SEQAN_ASSERT(hasFlagFirst(records[0]) != hasFlagFirst(records[1]));
+            pairNames.push_back(toCString(records[0].qName));
+        }
+    }
+    std::sort(pairNames.begin(), pairNames.end());
+    return numRecords;
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_bam_scanner_cache_spill)
+{
+    // Without a limit all pairs are joined in memory, first mates without mate remain in the cache.
+    std::vector<std::string> expected;
+    bool merged = true;
+    seqan::BamScannerCache unlimited;
+    _readScannerTemplates(expected, merged, unlimited);
+    SEQAN_ASSERT(!merged);
+    SEQAN_ASSERT_EQ(expected.size(), 1608u);
+
+    // A small limit spills most records, the merged runs must yield the same pairs and every record.
+    std::vector<std::string> pairNames;
+    seqan::BamScannerCache cache(16);
+    unsigned numRecords = _readScannerTemplates(pairNames, merged, cache);
+    SEQAN_ASSERT(merged);
+    SEQAN_ASSERT(pairNames == expected);
+    SEQAN_ASSERT_EQ(numRecords, 3307u);
+}
+
+#endif  // TESTS_HTS_IO_TEST_BAM_SCANNER_CACHE_H_
@@ -0,0 +1,151 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for the asynchronous record writer.
+// ==========================================================================
+
+#ifndef TESTS_HTS_IO_TEST_HTS_ASYNC_WRITER_H_
+#define TESTS_HTS_IO_TEST_HTS_ASYNC_WRITER_H_
+
+#include <cstdlib>
+
+#include <seqan/hts_io.h>
+#include <seqan/parallel.h>
+
+// Reads the records of ex1.bam and names them by their position in the file.
+inline void
+_readNumberedRecords(seqan::String<seqan::BamAlignmentRecord> & records, seqan::HtsFile & file)
+{
+    seqan::BamAlignmentRecord record;
+    while (readRecord(record, file))
+    {
+        clear(record.qName);
+        appendValue(record.qName, 'r');
+        appendNumber(record.qName, length(records));
+        appendValue(records, record);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_async_writer_order)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+    seqan::CharString outPath = SEQAN_TEMP_FILENAME();
+    append(outPath, ".bam");
+
+    seqan::String<seqan::BamAlignmentRecord> records;
+    {
+        seqan::HtsFileIn in(toCString(bamPath));
+        _readNumberedRecords(records, in);
+
+        // Copied and moved records are written in the order of submission, the queue is smaller than the input.
+        seqan::HtsFileOut out(toCString(outPath), "wb");
+        copyHeader(out, in);
+        SEQAN_ASSERT(writeHeader(out));
+        seqan::HtsAsyncWriter writer(out, 16);
+        for (unsigned i = 0; i < length(records); ++i)
+        {
+            if (i % 2 == 0)
+            {
+                SEQAN_ASSERT(writeRecord(writer, records[i]));
+            }
+            else
+            {
+                seqan::BamAlignmentRecord moved = records[i];
+                SEQAN_ASSERT(writeRecord(writer, std::move(moved)));
+            }
+        }
+        SEQAN_ASSERT(close(writer));
+        SEQAN_ASSERT_NOT(writeRecord(writer, records[0]));
+    }
+
+    seqan::HtsFileIn in(toCString(outPath));
+    seqan::BamAlignmentRecord record;
+    unsigned numRecords = 0;
+    while (readRecord(record, in))
+    {
+        SEQAN_ASSERT_LT(numRecords, length(records));
+        SEQAN_ASSERT_EQ(toString(record, in.hdr), toString(records[numRecords], in.hdr));
+        ++numRecords;
+    }
+    SEQAN_ASSERT_EQ(numRecords, length(records));
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_async_writer_producers)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+    seqan::CharString outPath = SEQAN_TEMP_FILENAME();
+    append(outPath, ".bam");
+
+    int const NUM_PRODUCERS = 4;
+    seqan::String<seqan::BamAlignmentRecord> records;
+    {
+        seqan::HtsFileIn in(toCString(bamPath));
+        _readNumberedRecords(records, in);
+
+        // Producer p submits the records p, p + NUM_PRODUCERS, ... in this order.
+        seqan::HtsFileOut out(toCString(outPath), "wb");
+        copyHeader(out, in);
+        SEQAN_ASSERT(writeHeader(out));
+        seqan::HtsAsyncWriter writer(out, 8);
+        bool ok = true;
+        SEQAN_OMP_PRAGMA(parallel for num_threads(NUM_PRODUCERS) schedule(static, 1) reduction(&& : ok))
+        for (int p = 0; p < NUM_PRODUCERS; ++p)
+            for (unsigned i = p; i < length(records); i += NUM_PRODUCERS)
+                ok = writeRecord(writer, records[i]) && ok;
+        SEQAN_ASSERT(ok);
+        SEQAN_ASSERT(close(writer));
+    }
+
+    // Every record is written once, and the records of each producer keep their order.
+    seqan::String<int> lastId;
+    resize(lastId, NUM_PRODUCERS, -1);
+    seqan::String<bool> seen;
+    resize(seen, length(records), false);
+    seqan::HtsFileIn in(toCString(outPath));
+    seqan::BamAlignmentRecord record;
+    unsigned numRecords = 0;
+    while (readRecord(record, in))
+    {
+        int id = std::atoi(toCString(record.qName) + 1);
+        SEQAN_ASSERT_LT(id, (int)length(records));
+        SEQAN_ASSERT_NOT(seen[id]);
+        seen[id] = true;
+        SEQAN_ASSERT_GT(id, lastId[id % NUM_PRODUCERS]);
+        lastId[id % NUM_PRODUCERS] = id;
+        SEQAN_ASSERT_EQ(toString(record, in.hdr), toString(records[id], in.hdr));
+        ++numRecords;
+    }
+    SEQAN_ASSERT_EQ(numRecords, length(records));
+}
+
+#endif  // TESTS_HTS_IO_TEST_HTS_ASYNC_WRITER_H_
@@ -0,0 +1,202 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for marking duplicate reads of HTS files.
+// ==========================================================================
+
+#ifndef TESTS_HTS_IO_TEST_HTS_DUPLICATE_MARKER_H_
+#define TESTS_HTS_IO_TEST_HTS_DUPLICATE_MARKER_H_
+
+#include <seqan/hts_io.h>
+
+// A mapped read of a pair with ten matches and base qualities qual.
+inline seqan::BamAlignmentRecord
+_testHtsDupMate(char const * qName, unsigned flag, int32_t beginPos, int32_t pNext, char qual)
+{
+    seqan::BamAlignmentRecord record;
+    record.qName = qName;
+    record.flag = seqan::BAM_FLAG_MULTIPLE | seqan::BAM_FLAG_ALL_PROPER | flag;
+    record.rID = 0;
+    record.beginPos = beginPos;
+    record.rNextId = 0;
+    record.pNext = pNext;
+    appendValue(record.cigar, seqan::CigarElement<>('M', 10));
+    record.seq = "ACGTACGTAC";
+    resize(record.qual, 10, qual);
+    return record;
+}
+
+// An unpaired mapped read with ten matches and base qualities qual.
+inline seqan::BamAlignmentRecord
+_testHtsDupRead(char const * qName, int32_t beginPos, char qual)
+{
+    seqan::BamAlignmentRecord record = _testHtsDupMate(qName, 0, beginPos, 0, qual);
+    record.flag = 0;
+    record.rNextId = seqan::BamAlignmentRecord::INVALID_REFID;
+    record.pNext = seqan::BamAlignmentRecord::INVALID_POS;
+    return record;
+}
+
+// Pushes the records and returns the duplicate flags of the records in input order.
+inline seqan::String<bool>
+_testHtsDupMark(seqan::String<seqan::BamAlignmentRecord> records)
+{
+    seqan::HtsDuplicateMarker marker(nullptr);
+    seqan::String<bool> duplicates;
+    seqan::BamAlignmentRecord record;
+
+    for (unsigned i = 0; i < length(records); ++i)
+    {
+        SEQAN_ASSERT(pushRecord(marker, records[i]));
+
+        while (popRecord(record, marker))
+            appendValue(duplicates, hasFlagDuplicate(record));
+    }
+
+    flush(marker);
+
+    while (popRecord(record, marker))
+        appendValue(duplicates, hasFlagDuplicate(record));
+
+    SEQAN_ASSERT(marker.mate_cache.empty());
+    SEQAN_ASSERT(marker.distant_mates.empty());
+    return duplicates;
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_duplicate_marker_same_position_mates)
+{
+    // Three pairs with both mates at position 100, in both orders of the mates. The pair C has lower qualities than A
+    // and is its duplicate. The first mate of B has two clipped bases, so only its second mate shares a 5' end with A.
+    for (unsigned lastFirst = 0; lastFirst < 2; ++lastFirst)
+    {
+        unsigned const flags1 = seqan::BAM_FLAG_FIRST;
+        unsigned const flags2 = seqan::BAM_FLAG_LAST | seqan::BAM_FLAG_RC;
+
+        seqan::String<seqan::BamAlignmentRecord> records;
+        for (char const * qName : {"A", "B", "C"})
+        {
+            seqan::BamAlignmentRecord mate1 = _testHtsDupMate(qName, flags1, 100, 100, *qName == 'A' ? 'I' : '5');
+            seqan::BamAlignmentRecord mate2 = _testHtsDupMate(qName, flags2, 100, 100, *qName == 'A' ? 'I' : '5');
+
+            if (*qName == 'B')
+            {
+                clear(mate1.cigar);
+                appendValue(mate1.cigar, seqan::CigarElement<>('S', 2));
+                appendValue(mate1.cigar, seqan::CigarElement<>('M', 8));
+            }
+
+            appendValue(records, lastFirst ? mate2 : mate1);
+            appendValue(records, lastFirst ? mate1 : mate2);
+        }
+
+        seqan::String<bool> duplicates = _testHtsDupMark(records);
+        SEQAN_ASSERT_EQ(length(duplicates), 6u);
+        SEQAN_ASSERT_NOT(duplicates[0]);
+        SEQAN_ASSERT_NOT(duplicates[1]);
+        SEQAN_ASSERT_NOT(duplicates[2]);
+        SEQAN_ASSERT_NOT(duplicates[3]);
+        SEQAN_ASSERT(duplicates[4]);
+        SEQAN_ASSERT(duplicates[5]);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_duplicate_marker_missing_distant_mate)
+{
+    // The mates of the first reads are 5000 bases away and missing from the input.
+    seqan::String<seqan::BamAlignmentRecord> records;
+    appendValue(records, _testHtsDupMate("A", seqan::BAM_FLAG_FIRST, 100, 5100, 'I'));
+    appendValue(records, _testHtsDupMate("B", seqan::BAM_FLAG_FIRST, 100, 5100, '5'));
+    appendValue(records, _testHtsDupMate("C", seqan::BAM_FLAG_FIRST, 6000, 6000, 'I'));
+    appendValue(records, _testHtsDupMate("C", seqan::BAM_FLAG_LAST | seqan::BAM_FLAG_RC, 6000, 6000, 'I'));
+
+    seqan::String<bool> duplicates = _testHtsDupMark(records);
+    SEQAN_ASSERT_EQ(length(duplicates), 4u);
+    SEQAN_ASSERT_NOT(duplicates[0]);
+    SEQAN_ASSERT(duplicates[1]);
+    SEQAN_ASSERT_NOT(duplicates[2]);
+    SEQAN_ASSERT_NOT(duplicates[3]);
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_duplicate_marker_longer_clipped_read)
+{
+    // Both reads have their 5' end at 100. B has 20 clipped bases, more than any read before it has bases, and starts
+    // 20 bases after A.
+    seqan::String<seqan::BamAlignmentRecord> records;
+    appendValue(records, _testHtsDupRead("A", 100, 'I'));
+    seqan::BamAlignmentRecord clipped = _testHtsDupRead("B", 120, '#');
+    insertValue(clipped.cigar, 0, seqan::CigarElement<>('S', 20));
+    clipped.seq = "ACGTACGTACGTACGTACGTACGTACGTAC";
+    resize(clipped.qual, 30, '#');
+    appendValue(records, clipped);
+    appendValue(records, _testHtsDupRead("C", 200, 'I'));
+
+    seqan::String<bool> duplicates = _testHtsDupMark(records);
+    SEQAN_ASSERT_EQ(length(duplicates), 3u);
+    SEQAN_ASSERT_NOT(duplicates[0]);
+    SEQAN_ASSERT(duplicates[1]);
+    SEQAN_ASSERT_NOT(duplicates[2]);
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_duplicate_marker_waiting_mate)
+{
+    // The first mate P and the unpaired read F have their 5' end at 100. The input passes the end of their group
+    // before the mate of P is expected at 400.
+    for (unsigned mateMissing = 0; mateMissing < 2; ++mateMissing)
+    {
+        seqan::String<seqan::BamAlignmentRecord> records;
+        appendValue(records, _testHtsDupMate("P", seqan::BAM_FLAG_FIRST, 100, 400, '5'));
+        appendValue(records, _testHtsDupRead("F", 100, 'I'));
+        appendValue(records, _testHtsDupRead("R", 300, 'I'));
+        if (!mateMissing)
+            appendValue(records, _testHtsDupMate("P", seqan::BAM_FLAG_LAST | seqan::BAM_FLAG_RC, 400, 100, '5'));
+        appendValue(records, _testHtsDupRead("S", 600, 'I'));
+
+        seqan::String<bool> duplicates = _testHtsDupMark(records);
+        SEQAN_ASSERT_EQ(length(duplicates), length(records));
+        if (mateMissing)
+        {
+            // P becomes an unpaired read and is a duplicate of F, which has higher qualities.
+            SEQAN_ASSERT(duplicates[0]);
+            SEQAN_ASSERT_NOT(duplicates[1]);
+        }
+        else
+        {
+            // F is a duplicate of the pair.
+            SEQAN_ASSERT_NOT(duplicates[0]);
+            SEQAN_ASSERT(duplicates[1]);
+            SEQAN_ASSERT_NOT(duplicates[3]);
+        }
+        SEQAN_ASSERT_NOT(duplicates[2]);
+        SEQAN_ASSERT_NOT(back(duplicates));
+    }
+}
+
+#endif  // TESTS_HTS_IO_TEST_HTS_DUPLICATE_MARKER_H_
@@ -0,0 +1,287 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for reading and writing HTS files.
+// ==========================================================================
+
+#ifndef TESTS_HTS_IO_TEST_HTS_FILE_H_
+#define TESTS_HTS_IO_TEST_HTS_FILE_H_
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <seqan/hts_io.h>
+
+// Reads all records of a file as SAM lines.
+inline std::vector<std::string>
+_readSamLines(char const * fileName)
+{
+    std::vector<std::string> lines;
+    seqan::HtsFileIn file(fileName);
+    seqan::BamAlignmentRecord record;
+    while (readRecord(record, file))
+        lines.push_back(toString(record, file.hdr));
+    return lines;
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_thread_pool_shared)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+    seqan::CharString outPath = SEQAN_TEMP_FILENAME();
+    append(outPath, ".bam");
+
+    // The reader and the writer (de)compress with the same pool.
+    seqan::HtsThreadPool pool(2);
+    SEQAN_ASSERT(isOpen(pool));
+    SEQAN_ASSERT_EQ(numThreads(pool), 2);
+    {
+        seqan::HtsFileIn in(toCString(bamPath), pool);
+        seqan::HtsFileOut out(toCString(outPath), pool);
+        SEQAN_ASSERT_EQ(in.thread_pool, &pool);
+        SEQAN_ASSERT_EQ(out.thread_pool, &pool);
+        copyHeader(out, in);
+        SEQAN_ASSERT(writeHeader(out));
+
+        seqan::BamAlignmentRecord record;
+        while (readRecord(record, in))
+            SEQAN_ASSERT(writeRecord(out, record));
+        SEQAN_ASSERT(close(out));
+    }
+
+    std::vector<std::string> expected = _readSamLines(toCString(bamPath));
+    SEQAN_ASSERT_EQ(expected.size(), 3307u);
+    SEQAN_ASSERT(_readSamLines(toCString(outPath)) == expected);
+
+    pool.close();
+    SEQAN_ASSERT_NOT(isOpen(pool));
+    SEQAN_ASSERT_EQ(numThreads(pool), 0);
+}
+
+// Reads all records of a file as SAM lines, in batches of the given size.
+inline std::vector<std::string>
+_readSamLinesInBatches(char const * fileName, size_t batchSize, std::vector<size_t> & batchSizes)
+{
+    std::vector<std::string> lines;
+    seqan::HtsFileIn file(fileName);
+    seqan::String<seqan::BamAlignmentRecord> records;
+    size_t numRecords;
+    do
+    {
+        numRecords = readRecords(records, file, batchSize);
+        SEQAN_ASSERT_GEQ(length(records), batchSize);
+        batchSizes.push_back(numRecords);
+        for (size_t i = 0; i < numRecords; ++i)
+            lines.push_back(toString(records[i], file.hdr));
+    }
+    while (numRecords == batchSize);
+    return lines;
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_read_records_batches)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+    std::vector<std::string> expected = _readSamLines(toCString(bamPath));
+    SEQAN_ASSERT_EQ(expected.size(), 3307u);
+
+    // The last batch is partial.
+    std::vector<size_t> batchSizes;
+    SEQAN_ASSERT(_readSamLinesInBatches(toCString(bamPath), 1000, batchSizes) == expected);
+    SEQAN_ASSERT_EQ(batchSizes.size(), 4u);
+    SEQAN_ASSERT_EQ(batchSizes[0], 1000u);
+    SEQAN_ASSERT_EQ(batchSizes[1], 1000u);
+    SEQAN_ASSERT_EQ(batchSizes[2], 1000u);
+    SEQAN_ASSERT_EQ(batchSizes[3], 307u);
+
+    // The file ends exactly at a batch boundary, the next batch is empty.
+    batchSizes.clear();
+    SEQAN_ASSERT(_readSamLinesInBatches(toCString(bamPath), 3307, batchSizes) == expected);
+    SEQAN_ASSERT_EQ(batchSizes.size(), 2u);
+    SEQAN_ASSERT_EQ(batchSizes[0], 3307u);
+    SEQAN_ASSERT_EQ(batchSizes[1], 0u);
+
+    // A single batch larger than the file.
+    batchSizes.clear();
+    SEQAN_ASSERT(_readSamLinesInBatches(toCString(bamPath), 5000, batchSizes) == expected);
+    SEQAN_ASSERT_EQ(batchSizes.size(), 1u);
+    SEQAN_ASSERT_EQ(batchSizes[0], 3307u);
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_read_records_parallel)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+
+    int const maxThreads = omp_get_max_threads();
+    for (int numThreads = 1; numThreads <= 4; numThreads *= 4)
+    {
+        omp_set_num_threads(numThreads);
+
+        // Batches are decoded in parallel and compared record by record with serial reading.
+        seqan::HtsFileIn batchFile(toCString(bamPath));
+        seqan::HtsFileIn serialFile(toCString(bamPath));
+        seqan::String<seqan::BamAlignmentRecord> records;
+        seqan::BamAlignmentRecord record;
+        size_t total = 0;
+        size_t numRecords;
+        while ((numRecords = readRecords(records, batchFile, 500)) != 0)
+        {
+            for (size_t i = 0; i < numRecords; ++i)
+            {
+                SEQAN_ASSERT(readRecord(record, serialFile));
+                SEQAN_ASSERT_EQ(records[i].qName, record.qName);
+                SEQAN_ASSERT_EQ(records[i].flag, record.flag);
+                SEQAN_ASSERT_EQ(records[i].rID, record.rID);
+                SEQAN_ASSERT_EQ(records[i].beginPos, record.beginPos);
+                SEQAN_ASSERT_EQ(records[i].mapQ, record.mapQ);
+                SEQAN_ASSERT_EQ(length(records[i].cigar), length(record.cigar));
+                SEQAN_ASSERT_EQ(records[i].rNextId, record.rNextId);
+                SEQAN_ASSERT_EQ(records[i].pNext, record.pNext);
+                SEQAN_ASSERT_EQ(records[i].tLen, record.tLen);
+                SEQAN_ASSERT_EQ(records[i].seq, record.seq);
+                SEQAN_ASSERT_EQ(records[i].qual, record.qual);
+                SEQAN_ASSERT_EQ(records[i].tags, record.tags);
+                SEQAN_ASSERT_EQ(toString(records[i], batchFile.hdr), toString(record, serialFile.hdr));
+            }
+            total += numRecords;
+        }
+        SEQAN_ASSERT_NOT(readRecord(record, serialFile));
+        SEQAN_ASSERT_EQ(total, 3307u);
+        SEQAN_ASSERT(batchFile.at_end);
+        SEQAN_ASSERT_EQ(length(batchFile.record_pool), 500u);
+    }
+    omp_set_num_threads(maxThreads);
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_batch_reader)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+    std::vector<std::string> expected = _readSamLines(toCString(bamPath));
+
+    size_t const batchSizes[] = { 1000, 3307, 5000 };
+    for (size_t prefetched = 1; prefetched <= 2; ++prefetched)
+    {
+        for (size_t b = 0; b < 3; ++b)
+        {
+            seqan::HtsFileIn file(toCString(bamPath));
+            seqan::HtsBatchReader reader(file, batchSizes[b], prefetched);
+
+            std::vector<std::string> lines;
+            seqan::String<seqan::BamAlignmentRecord> records;
+            size_t numBatches = 0;
+            size_t numRecords;
+            while ((numRecords = readRecords(records, reader)) != 0)
+            {
+                // Only the last batch may be partial.
+                SEQAN_ASSERT_EQ(lines.size() % batchSizes[b], 0u);
+                SEQAN_ASSERT_LEQ(numRecords, batchSizes[b]);
+                ++numBatches;
+                for (size_t i = 0; i < numRecords; ++i)
+                    lines.push_back(toString(records[i], file.hdr));
+            }
+
+            SEQAN_ASSERT(lines == expected);
+            SEQAN_ASSERT_EQ(numBatches, (expected.size() + batchSizes[b] - 1) / batchSizes[b]);
+            // Reading after the end of the file keeps returning no records.
+            SEQAN_ASSERT_EQ(readRecords(records, reader), 0u);
+        }
+    }
+
+    // Closing the reader before the end of the file stops the reader thread.
+    seqan::HtsFileIn file(toCString(bamPath));
+    seqan::HtsBatchReader reader(file, 100);
+    seqan::String<seqan::BamAlignmentRecord> records;
+    SEQAN_ASSERT_EQ(readRecords(records, reader), 100u);
+    reader.close();
+    SEQAN_ASSERT_EQ(readRecords(records, reader), 0u);
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_index_on_close)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+
+    // The records of seq2:100-600 in file order.  Like in htslib, unmapped records and records without CIGAR cover
+    // one base.
+    std::vector<std::string> expected;
+    {
+        seqan::HtsFileIn file(toCString(bamPath));
+        seqan::BamAlignmentRecord record;
+        while (readRecord(record, file))
+        {
+            __int32 endPos = record.beginPos + std::max(1u, (unsigned)getAlignmentLengthInRef(record));
+            if (hasFlagUnmapped(record))
+                endPos = record.beginPos + 1;
+            if (record.rID == 1 && record.beginPos < 600 && endPos > 99)
+                expected.push_back(toString(record, file.hdr));
+        }
+    }
+    SEQAN_ASSERT_GT(expected.size(), 0u);
+
+    // A BAI and a CSI index are built while writing and saved when the file is closed.
+    for (int minShift = 0; minShift <= 14; minShift += 14)
+    {
+        seqan::CharString outPath = SEQAN_TEMP_FILENAME();
+        append(outPath, ".bam");
+        std::string indexPath = toCString(outPath);
+        indexPath += minShift > 0 ? ".csi" : ".bai";
+        {
+            seqan::HtsFileIn in(toCString(bamPath));
+            seqan::HtsFileOut out(toCString(outPath), "wb");
+            copyHeader(out, in);
+            SEQAN_ASSERT(writeHeader(out));
+            SEQAN_ASSERT(initIndex(out, minShift));
+
+            seqan::BamAlignmentRecord record;
+            while (readRecord(record, in))
+                SEQAN_ASSERT(writeRecord(out, record));
+            SEQAN_ASSERT_NOT(std::ifstream(indexPath.c_str()).good());
+            SEQAN_ASSERT(close(out));
+        }
+        SEQAN_ASSERT(std::ifstream(indexPath.c_str()).good());
+
+        // The written index is used to query a region.
+        seqan::HtsFileIn file(toCString(outPath));
+        SEQAN_ASSERT(loadIndex(file, indexPath.c_str()));
+        SEQAN_ASSERT(setRegion(file, "seq2:100-600"));
+        std::vector<std::string> lines;
+        seqan::BamAlignmentRecord record;
+        while (readRegion(record, file))
+            lines.push_back(toString(record, file.hdr));
+        SEQAN_ASSERT(lines == expected);
+    }
+}
+
+#endif  // TESTS_HTS_IO_TEST_HTS_FILE_H_
@@ -0,0 +1,93 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for the hts_io module.
+// ==========================================================================
+
+#include <seqan/basic.h>
+
+#include "test_bam_scanner_cache.h"
+#include "test_hts_async_writer.h"
+#include "test_hts_duplicate_marker.h"
+#include "test_hts_file.h"
+#include "test_hts_pileup.h"
+#include "test_hts_record_batch.h"
+#include "test_hts_record_view.h"
+#include "test_hts_region_reader.h"
+#include "test_hts_sam_format.h"
+#include "test_hts_sort.h"
+
+SEQAN_BEGIN_TESTSUITE(test_hts_io)
+{
+    // Reading and writing.
+    SEQAN_CALL_TEST(test_hts_io_thread_pool_shared);
+    SEQAN_CALL_TEST(test_hts_io_read_records_batches);
+    SEQAN_CALL_TEST(test_hts_io_read_records_parallel);
+    SEQAN_CALL_TEST(test_hts_io_batch_reader);
+    SEQAN_CALL_TEST(test_hts_io_index_on_close);
+    SEQAN_CALL_TEST(test_hts_io_async_writer_order);
+    SEQAN_CALL_TEST(test_hts_io_async_writer_producers);
+
+    // SAM text.
+    SEQAN_CALL_TEST(test_hts_io_sam_format_all_tag_types);
+    SEQAN_CALL_TEST(test_hts_io_sam_format_errors);
+
+    // Record batches.
+    SEQAN_CALL_TEST(test_hts_io_record_batch_round_trip);
+    SEQAN_CALL_TEST(test_hts_io_record_batch_fields);
+    SEQAN_CALL_TEST(test_hts_io_record_batch_assign_record);
+
+    // Record views.
+    SEQAN_CALL_TEST(test_hts_io_record_view_known_record);
+    SEQAN_CALL_TEST(test_hts_io_record_view_matches_parse);
+
+    // Reading regions.
+    SEQAN_CALL_TEST(test_hts_io_read_regions);
+    SEQAN_CALL_TEST(test_hts_io_read_regions_failure);
+
+    // Pileup.
+    SEQAN_CALL_TEST(test_hts_io_pileup_read_column);
+    SEQAN_CALL_TEST(test_hts_io_pileup_regions);
+
+    // Sorting.
+    SEQAN_CALL_TEST(test_hts_io_sort_tmp_file_error);
+    SEQAN_CALL_TEST(test_hts_io_sort_queryname);
+
+    // Joining mates.
+    SEQAN_CALL_TEST(test_hts_io_bam_scanner_cache_spill);
+
+    // Duplicate marking.
+    SEQAN_CALL_TEST(test_hts_io_duplicate_marker_same_position_mates);
+    SEQAN_CALL_TEST(test_hts_io_duplicate_marker_missing_distant_mate);
+    SEQAN_CALL_TEST(test_hts_io_duplicate_marker_longer_clipped_read);
+    SEQAN_CALL_TEST(test_hts_io_duplicate_marker_waiting_mate);
+}
+SEQAN_END_TESTSUITE
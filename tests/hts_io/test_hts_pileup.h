@@ -0,0 +1,134 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for the pileup of HTS files.
+// ==========================================================================
+
+#ifndef TESTS_HTS_IO_TEST_HTS_PILEUP_H_
+#define TESTS_HTS_IO_TEST_HTS_PILEUP_H_
+
+#include <vector>
+
+#include <seqan/hts_io.h>
+
+// small.bam has three reads with the CIGAR 5M1I4M at the positions 0, 1 and 2 of REFERENCE.
+SEQAN_DEFINE_TEST(test_hts_io_pileup_read_column)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/small.bam");
+
+    seqan::HtsFileIn file(toCString(bamPath));
+    seqan::HtsPileup pileup(file);
+    seqan::PileupColumn column;
+
+    unsigned const expectedDepths[] = {1, 2, 3, 3, 3, 3, 3, 3, 3, 2, 1};
+    seqan::String<uint32_t> counts;
+    int32_t pos = 0;
+    while (readColumn(column, pileup))
+    {
+        SEQAN_ASSERT_LT(pos, 11);
+        SEQAN_ASSERT_EQ(column.rID, 0);
+        SEQAN_ASSERT_EQ(column.pos, pos);
+        SEQAN_ASSERT_EQ(length(column), expectedDepths[pos]);
+
+        countBases(counts, column);
+        SEQAN_ASSERT_EQ(counts[seqan::ordValue(seqan::Iupac('A'))], expectedDepths[pos]);
+        SEQAN_ASSERT_EQ(counts[seqan::PILEUP_DELETION], 0u);
+
+        // The insertion follows the fifth base of each read.
+        unsigned numBegins = 0, numInsertions = 0;
+        for (unsigned i = 0; i < length(column); ++i)
+        {
+            SEQAN_ASSERT_EQ(column.quals[i], 0u);
+            numBegins += (column.flags[i] & seqan::PILEUP_READ_BEGIN) != 0;
+            numInsertions += column.indels[i] == 1;
+        }
+        SEQAN_ASSERT_EQ(numBegins, pos < 3 ? 1u : 0u);
+        SEQAN_ASSERT_EQ(numInsertions, pos >= 4 && pos < 7 ? 1u : 0u);
+        ++pos;
+    }
+    SEQAN_ASSERT_EQ(pos, 11);
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_pileup_regions)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/small.bam");
+
+    seqan::HtsFileIn file(toCString(bamPath));
+
+    seqan::StringSet<seqan::CharString> regions;
+    appendValue(regions, "REFERENCE:1-5");
+    appendValue(regions, "REFERENCE:6-11");
+    appendValue(regions, "REFERENCE");
+
+    // Each region is only passed to one thread at a time.
+    std::vector<std::vector<int32_t> > positions(length(regions));
+    std::vector<std::vector<size_t> > depths(length(regions));
+    auto callback = [&](int regionId, seqan::PileupColumn const & column)
+    {
+        positions[regionId].push_back(column.pos);
+        depths[regionId].push_back(length(column));
+    };
+
+    // No threads are treated like one.
+    SEQAN_ASSERT(pileupRegions(file, regions, callback, 0));
+    SEQAN_ASSERT_EQ(positions[0].size(), 5u);
+    SEQAN_ASSERT_EQ(positions[0].front(), 0);
+    SEQAN_ASSERT_EQ(positions[0].back(), 4);
+    SEQAN_ASSERT_EQ(depths[0][1], 2u);
+    SEQAN_ASSERT_EQ(positions[1].size(), 6u);
+    SEQAN_ASSERT_EQ(positions[1].front(), 5);
+    SEQAN_ASSERT_EQ(positions[1].back(), 10);
+    SEQAN_ASSERT_EQ(depths[1][0], 3u);
+    SEQAN_ASSERT_EQ(positions[2].size(), 11u);
+
+    std::vector<std::vector<int32_t> > serialPositions = positions;
+    for (unsigned i = 0; i < length(regions); ++i)
+    {
+        positions[i].clear();
+        depths[i].clear();
+    }
+    SEQAN_ASSERT(pileupRegions(file, regions, callback, 3));
+    SEQAN_ASSERT(positions == serialPositions);
+
+    // Unknown contigs fail, the other regions are still processed.
+    appendValue(regions, "NO_SUCH_CONTIG");
+    positions.resize(length(regions));
+    depths.resize(length(regions));
+    for (unsigned i = 0; i < length(regions); ++i)
+        positions[i].clear();
+    SEQAN_ASSERT_NOT(pileupRegions(file, regions, callback, 2));
+    SEQAN_ASSERT_EQ(positions[2].size(), 11u);
+    SEQAN_ASSERT(positions[3].empty());
+}
+
+#endif  // TESTS_HTS_IO_TEST_HTS_PILEUP_H_
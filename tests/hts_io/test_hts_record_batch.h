@@ -0,0 +1,154 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for column-wise batches of alignment records.
+// ==========================================================================
+
+#ifndef TESTS_HTS_IO_TEST_HTS_RECORD_BATCH_H_
+#define TESTS_HTS_IO_TEST_HTS_RECORD_BATCH_H_
+
+#include <string>
+#include <vector>
+
+#include <seqan/hts_io.h>
+
+SEQAN_DEFINE_TEST(test_hts_io_record_batch_round_trip)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+    seqan::CharString outPath = SEQAN_TEMP_FILENAME();
+    append(outPath, ".bam");
+
+    // Batches are read and written without decoding the records, the batch object is reused.
+    size_t total = 0;
+    {
+        seqan::HtsFileIn in(toCString(bamPath));
+        seqan::HtsFileOut out(toCString(outPath), "wb");
+        copyHeader(out, in);
+        SEQAN_ASSERT(writeHeader(out));
+
+        seqan::BamRecordBatch batch;
+        size_t numRecords;
+        while ((numRecords = readRecords(batch, in, 1000u)) != 0)
+        {
+            SEQAN_ASSERT_EQ(length(batch), numRecords);
+            SEQAN_ASSERT(writeRecords(out, batch));
+            total += numRecords;
+        }
+        SEQAN_ASSERT(close(out));
+    }
+    SEQAN_ASSERT_EQ(total, 3307u);
+
+    seqan::HtsFileIn expectedFile(toCString(bamPath));
+    seqan::HtsFileIn actualFile(toCString(outPath));
+    seqan::BamAlignmentRecord expected, actual;
+    while (readRecord(expected, expectedFile))
+    {
+        SEQAN_ASSERT(readRecord(actual, actualFile));
+        SEQAN_ASSERT_EQ(toString(actual, actualFile.hdr), toString(expected, expectedFile.hdr));
+        SEQAN_ASSERT_EQ(actual.bin, expected.bin);
+    }
+    SEQAN_ASSERT_NOT(readRecord(actual, actualFile));
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_record_batch_fields)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+
+    seqan::HtsFileIn batchFile(toCString(bamPath));
+    seqan::BamRecordBatch batch;
+    SEQAN_ASSERT_EQ(readRecords(batch, batchFile, 500u), 500u);
+
+    seqan::HtsFileIn file(toCString(bamPath));
+    seqan::BamAlignmentRecord record;
+    seqan::String<seqan::CigarElement<> > cigar;
+    seqan::IupacString iupacSeq;
+    seqan::CharString charSeq;
+    seqan::Dna5String dna5Seq;
+    seqan::CharString qual;
+    seqan::CharString tags;
+    for (size_t i = 0; i < length(batch); ++i)
+    {
+        SEQAN_ASSERT(readRecord(record, file));
+        SEQAN_ASSERT_EQ(getQName(batch, i), record.qName);
+        SEQAN_ASSERT_EQ(batch.flag[i], record.flag);
+        SEQAN_ASSERT_EQ(batch.rID[i], record.rID);
+        SEQAN_ASSERT_EQ(batch.beginPos[i], record.beginPos);
+        SEQAN_ASSERT_EQ(batch.mapQ[i], record.mapQ);
+        SEQAN_ASSERT_EQ(batch.tLen[i], record.tLen);
+
+        assignCigar(cigar, batch, i);
+        SEQAN_ASSERT(cigar == record.cigar);
+
+        // Sequences are decoded into Iupac and char strings directly, other alphabets are converted.
+        assignSeq(iupacSeq, batch, i);
+        SEQAN_ASSERT_EQ(iupacSeq, record.seq);
+        assignSeq(charSeq, batch, i);
+        SEQAN_ASSERT_EQ(charSeq, seqan::CharString(record.seq));
+        assignSeq(dna5Seq, batch, i);
+        SEQAN_ASSERT_EQ(dna5Seq, seqan::Dna5String(record.seq));
+
+        assignQual(qual, batch, i);
+        SEQAN_ASSERT_EQ(qual, record.qual);
+        assignTags(tags, batch, i);
+        SEQAN_ASSERT_EQ(tags, record.tags);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_record_batch_assign_record)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+
+    seqan::HtsFileIn file(toCString(bamPath));
+    seqan::BamRecordBatch batch;
+    SEQAN_ASSERT_EQ(readRecords(batch, file, 100u), 100u);
+
+    seqan::HtsFileIn expectedFile(toCString(bamPath));
+    seqan::BamAlignmentRecord expected;
+    seqan::BamAlignmentRecord actual;
+
+    // The record buffer starts empty and is grown by htslib for longer records.
+    bam1_t * hts_record = bam_init1();
+    for (size_t i = 0; i < length(batch); ++i)
+    {
+        SEQAN_ASSERT(assignRecord(hts_record, batch, i));
+        SEQAN_ASSERT_GEQ(hts_record->m_data, static_cast<uint32_t>(hts_record->l_data));
+        SEQAN_ASSERT_EQ(hts_record->core.l_qname % 4, 0);
+        SEQAN_ASSERT(readRecord(expected, expectedFile));
+        parse(actual, hts_record);
+        SEQAN_ASSERT_EQ(toString(actual, file.hdr), toString(expected, expectedFile.hdr));
+    }
+    bam_destroy1(hts_record);
+}
+
+#endif  // TESTS_HTS_IO_TEST_HTS_RECORD_BATCH_H_
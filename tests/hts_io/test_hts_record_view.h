@@ -0,0 +1,132 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for the zero-copy record view.
+// ==========================================================================
+
+#ifndef TESTS_HTS_IO_TEST_HTS_RECORD_VIEW_H_
+#define TESTS_HTS_IO_TEST_HTS_RECORD_VIEW_H_
+
+#include <seqan/hts_io.h>
+
+SEQAN_DEFINE_TEST(test_hts_io_record_view_known_record)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+
+    seqan::HtsFileIn file(toCString(bamPath));
+    seqan::HtsRecordView view;
+    SEQAN_ASSERT(empty(view));
+    SEQAN_ASSERT(readRecord(view, file));
+    SEQAN_ASSERT_NOT(empty(view));
+
+    SEQAN_ASSERT_EQ(seqan::CharString(view.qName()), "B7_591:4:96:693:509");
+    SEQAN_ASSERT_EQ(view.flag(), 73u);
+    SEQAN_ASSERT_EQ(view.rID(), 0);
+    SEQAN_ASSERT_EQ(view.beginPos(), 0);
+    SEQAN_ASSERT_EQ(view.mapQ(), 99u);
+    SEQAN_ASSERT_EQ(view.rNextId(), -1);
+    SEQAN_ASSERT_EQ(view.pNext(), -1);
+    SEQAN_ASSERT_EQ(view.tLen(), 0);
+    SEQAN_ASSERT(hasFlagMultiple(view));
+    SEQAN_ASSERT(hasFlagFirst(view));
+    SEQAN_ASSERT(hasFlagNextUnmapped(view));
+    SEQAN_ASSERT_NOT(hasFlagRC(view));
+    SEQAN_ASSERT_EQ(getAlignmentLengthInRef(view), 36u);
+
+    seqan::String<seqan::CigarElement<> > cigar;
+    assignCigar(cigar, view);
+    SEQAN_ASSERT_EQ(length(cigar), 1u);
+    SEQAN_ASSERT_EQ(cigar[0].operation, 'M');
+    SEQAN_ASSERT_EQ(cigar[0].count, 36u);
+
+    char const * expectedSeq = "CACTAGTGGCTCATTGTAAATGTGTGGTTTAACTCG";
+    char const * expectedQual = "<<<<<<<<<<<<<<<;<<<<<<<<<5<<<<<;:<;7";
+    seqan::IupacString iupacSeq;
+    seqan::CharString charSeq;
+    seqan::Dna5String dnaSeq;
+    assignSeq(iupacSeq, view);
+    assignSeq(charSeq, view);
+    assignSeq(dnaSeq, view);
+    SEQAN_ASSERT_EQ(charSeq, expectedSeq);
+    SEQAN_ASSERT_EQ(iupacSeq, seqan::IupacString(expectedSeq));
+    SEQAN_ASSERT_EQ(dnaSeq, seqan::Dna5String(expectedSeq));
+    SEQAN_ASSERT_EQ(view.seqAt(1), seqan::Iupac('A'));
+
+    seqan::CharString qual;
+    assignQual(qual, view);
+    SEQAN_ASSERT_EQ(qual, expectedQual);
+    SEQAN_ASSERT_EQ(view.qualAt(15), ';');
+
+    // MF:i:18 is the first of six integer tags.
+    seqan::CharString tags;
+    assignTags(tags, view);
+    SEQAN_ASSERT_EQ(length(tags), 24u);
+    seqan::BamTagsDict tagsDict(tags);
+    unsigned id = 0;
+    SEQAN_ASSERT(findTagKey(id, tagsDict, "Aq"));
+    int value = 0;
+    SEQAN_ASSERT(extractTagValue(value, tagsDict, id));
+    SEQAN_ASSERT_EQ(value, 73);
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_record_view_matches_parse)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+
+    // Decode every record once through the view and once through parse().
+    seqan::HtsFileIn file(toCString(bamPath));
+    seqan::HtsRecordView view;
+    seqan::BamAlignmentRecord record;
+    seqan::CharString qName, seq, qual, tags;
+    seqan::IupacString iupacSeq;
+    unsigned numRecords = 0;
+    while (readRecord(view, file))
+    {
+        parse(record, file.hts_record);
+        assignQName(qName, view);
+        assignSeq(seq, view);
+        assignSeq(iupacSeq, view);
+        assignQual(qual, view);
+        assignTags(tags, view);
+        SEQAN_ASSERT_EQ(qName, record.qName);
+        SEQAN_ASSERT_EQ(iupacSeq, record.seq);
+        SEQAN_ASSERT_EQ(seq, seqan::CharString(record.seq));
+        SEQAN_ASSERT_EQ(qual, record.qual);
+        SEQAN_ASSERT_EQ(tags, record.tags);
+        ++numRecords;
+    }
+    SEQAN_ASSERT_EQ(numRecords, 3307u);
+    SEQAN_ASSERT(empty(view));
+}
+
+#endif  // TESTS_HTS_IO_TEST_HTS_RECORD_VIEW_H_
@@ -0,0 +1,138 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for reading regions of indexed HTS files in parallel.
+// ==========================================================================
+
+#ifndef TESTS_HTS_IO_TEST_HTS_REGION_READER_H_
+#define TESTS_HTS_IO_TEST_HTS_REGION_READER_H_
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+#include <seqan/hts_io.h>
+
+// Copies ex1.bam into a temporary file and indexes the copy.
+inline seqan::CharString
+_indexedBamCopy()
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+    seqan::CharString copyPath = SEQAN_TEMP_FILENAME();
+    append(copyPath, ".bam");
+    {
+        std::ifstream in(toCString(bamPath), std::ios_base::in | std::ios_base::binary);
+        std::ofstream out(toCString(copyPath), std::ios_base::out | std::ios_base::binary);
+        out << in.rdbuf();
+    }
+
+    seqan::HtsFileIn file(toCString(copyPath));
+    SEQAN_ASSERT(buildIndex(file));
+    return copyPath;
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_read_regions)
+{
+    seqan::CharString bamPath = _indexedBamCopy();
+
+    seqan::StringSet<seqan::CharString> regions;
+    appendValue(regions, "seq1:100-200");
+    appendValue(regions, "seq2:1-500");
+    appendValue(regions, "seq1");
+    appendValue(regions, "seq2:1500-1500");
+
+    // The records of each region, in file order, collected by a serial scan.  Like in htslib, unmapped records and
+    // records without CIGAR cover one base.
+    unsigned const begins[] = { 99, 0, 0, 1499 };
+    unsigned const ends[] = { 200, 500, 1u << 29, 1500 };
+    int const rIDs[] = { 0, 1, 0, 1 };
+    seqan::String<seqan::String<seqan::BamAlignmentRecord> > expected;
+    resize(expected, length(regions));
+    {
+        seqan::HtsFileIn file(toCString(bamPath));
+        seqan::BamAlignmentRecord record;
+        while (readRecord(record, file))
+        {
+            __int32 endPos = record.beginPos + std::max(1u, (unsigned)getAlignmentLengthInRef(record));
+            if (hasFlagUnmapped(record))
+                endPos = record.beginPos + 1;
+            for (unsigned i = 0; i < length(regions); ++i)
+                if (record.rID == rIDs[i] && record.beginPos < (__int32)ends[i] && endPos > (__int32)begins[i])
+                    appendValue(expected[i], record);
+        }
+    }
+
+    for (unsigned numThreads = 1; numThreads <= 3; numThreads += 2)
+    {
+        seqan::HtsFileIn file(toCString(bamPath));
+        seqan::String<seqan::String<seqan::BamAlignmentRecord> > batches;
+        SEQAN_ASSERT(readRegions(batches, file, regions, numThreads));
+        SEQAN_ASSERT_EQ(length(batches), length(regions));
+        for (unsigned i = 0; i < length(regions); ++i)
+        {
+            SEQAN_ASSERT_GT(length(expected[i]), 0u);
+            SEQAN_ASSERT_EQ(length(batches[i]), length(expected[i]));
+            for (unsigned j = 0; j < length(batches[i]); ++j)
+                SEQAN_ASSERT_EQ(toString(batches[i][j], file.hdr), toString(expected[i][j], file.hdr));
+        }
+    }
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_read_regions_failure)
+{
+    seqan::CharString bamPath = _indexedBamCopy();
+
+    // A region of an unknown contig fails, the other regions are read anyway.
+    seqan::StringSet<seqan::CharString> regions;
+    appendValue(regions, "seq1:100-200");
+    appendValue(regions, "noSuchContig:1-10");
+    appendValue(regions, "seq2:1-500");
+
+    seqan::String<seqan::String<seqan::BamAlignmentRecord> > batches;
+    {
+        seqan::HtsFileIn file(toCString(bamPath));
+        SEQAN_ASSERT_NOT(readRegions(batches, file, regions, 2));
+        SEQAN_ASSERT_GT(length(batches[0]), 0u);
+        SEQAN_ASSERT_EQ(length(batches[1]), 0u);
+        SEQAN_ASSERT_GT(length(batches[2]), 0u);
+    }
+
+    // The workers cannot open a file that was removed after its index was loaded.
+    seqan::HtsFileIn file(toCString(bamPath));
+    SEQAN_ASSERT(loadIndex(file));
+    std::remove(toCString(bamPath));
+    SEQAN_ASSERT_NOT(readRegions(batches, file, regions, 2));
+    for (unsigned i = 0; i < length(regions); ++i)
+        SEQAN_ASSERT_EQ(length(batches[i]), 0u);
+}
+
+#endif  // TESTS_HTS_IO_TEST_HTS_REGION_READER_H_
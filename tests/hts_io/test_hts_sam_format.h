@@ -0,0 +1,181 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for formatting records as SAM text.
+// ==========================================================================
+
+#ifndef TESTS_HTS_IO_TEST_HTS_SAM_FORMAT_H_
+#define TESTS_HTS_IO_TEST_HTS_SAM_FORMAT_H_
+
+#include <cstring>
+#include <string>
+
+#include <seqan/hts_io.h>
+
+// Appends the little-endian bytes of a value.
+template <typename TValue>
+inline void
+_appendRawValue(seqan::CharString & tags, TValue value)
+{
+    char raw[sizeof(TValue)];
+    std::memcpy(raw, &value, sizeof(TValue));
+    for (unsigned i = 0; i < sizeof(TValue); ++i)
+        appendValue(tags, raw[i]);
+}
+
+// Appends a raw BAM tag with a value of the given type.
+template <typename TValue>
+inline void
+_appendRawTag(seqan::CharString & tags, char const * key, char type, TValue value)
+{
+    append(tags, key);
+    appendValue(tags, type);
+    _appendRawValue(tags, value);
+}
+
+// Appends a raw BAM array tag.
+template <typename TValue>
+inline void
+_appendRawArrayTag(seqan::CharString & tags, char const * key, char subtype, TValue const * values, __uint32 count)
+{
+    _appendRawTag(tags, key, 'B', subtype);
+    _appendRawValue(tags, count);
+    for (__uint32 i = 0; i < count; ++i)
+        _appendRawValue(tags, values[i]);
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_sam_format_all_tag_types)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+    seqan::HtsFileIn file(toCString(bamPath));
+
+    seqan::BamAlignmentRecord record;
+    record.qName = "r1";
+    record.flag = 99;
+    record.rID = 0;
+    record.beginPos = 9;
+    record.mapQ = 60;
+    appendValue(record.cigar, seqan::CigarElement<>('M', 3));
+    appendValue(record.cigar, seqan::CigarElement<>('I', 1));
+    appendValue(record.cigar, seqan::CigarElement<>('M', 2));
+    record.rNextId = 0;
+    record.pNext = 99;
+    record.tLen = -150;
+    record.seq = "ACGTNN";
+    record.qual = "IIII#!";
+
+    _appendRawTag(record.tags, "XA", 'A', 'x');
+    _appendRawTag(record.tags, "Xc", 'c', (__int8)-100);
+    _appendRawTag(record.tags, "XC", 'C', (__uint8)200);
+    _appendRawTag(record.tags, "Xs", 's', (__int16)-30000);
+    _appendRawTag(record.tags, "XS", 'S', (__uint16)60000);
+    _appendRawTag(record.tags, "Xi", 'i', (__int32)-2000000000);
+    _appendRawTag(record.tags, "XI", 'I', (__uint32)4000000000u);
+    _appendRawTag(record.tags, "Xf", 'f', 1.5f);
+    append(record.tags, "XZZhello world");
+    appendValue(record.tags, '\0');
+    append(record.tags, "XHH1AE301");
+    appendValue(record.tags, '\0');
+    __int8 const int8s[] = { -128, 0, 127 };
+    _appendRawArrayTag(record.tags, "Bc", 'c', int8s, 3);
+    __uint8 const uint8s[] = { 255 };
+    _appendRawArrayTag(record.tags, "BC", 'C', uint8s, 1);
+    __int16 const int16s[] = { -32768, 32767 };
+    _appendRawArrayTag(record.tags, "Bs", 's', int16s, 2);
+    __uint16 const uint16s[] = { 65535 };
+    _appendRawArrayTag(record.tags, "BS", 'S', uint16s, 1);
+    __int32 const int32s[] = { -2147483647 - 1, 2147483647 };
+    _appendRawArrayTag(record.tags, "Bi", 'i', int32s, 2);
+    __uint32 const uint32s[] = { 4294967295u };
+    _appendRawArrayTag(record.tags, "BI", 'I', uint32s, 1);
+    float const floats[] = { 0.25f, -3.0f };
+    _appendRawArrayTag(record.tags, "Bf", 'f', floats, 2);
+    _appendRawArrayTag(record.tags, "Be", 'i', int32s, 0);
+
+    std::string const expected =
+        "r1\t99\tseq1\t10\t60\t3M1I2M\t=\t100\t-150\tACGTNN\tIIII#!"
+        "\tXA:A:x\tXc:i:-100\tXC:i:200\tXs:i:-30000\tXS:i:60000\tXi:i:-2000000000\tXI:I:4000000000\tXf:f:1.5"
+        "\tXZ:Z:hello world\tXH:H:1AE301\tBc:B:c,-128,0,127\tBC:B:C,255\tBs:B:s,-32768,32767\tBS:B:S,65535"
+        "\tBi:B:i,-2147483648,2147483647\tBI:B:I,4294967295\tBf:B:f,0.25,-3\tBe:B:i";
+
+    // appendSamRecord() appends to a reused buffer, toString() returns the same text.
+    seqan::CharString buffer = "previous line\n";
+    size_t appended = appendSamRecord(buffer, record, file.hdr);
+    SEQAN_ASSERT_EQ(appended, expected.size());
+    SEQAN_ASSERT_EQ(buffer, seqan::CharString(std::string("previous line\n") + expected));
+    SEQAN_ASSERT_EQ(toString(record, file.hdr), expected);
+
+    // A mate on another contig and an unmapped record without CIGAR, sequence and qualities.
+    record.rNextId = 1;
+    clear(record.tags);
+    SEQAN_ASSERT_EQ(toString(record, file.hdr), "r1\t99\tseq1\t10\t60\t3M1I2M\tseq2\t100\t-150\tACGTNN\tIIII#!");
+    seqan::BamAlignmentRecord unmapped;
+    unmapped.qName = "u";
+    unmapped.flag = 4;
+    SEQAN_ASSERT_EQ(toString(unmapped, file.hdr), "u\t4\t*\t0\t255\t*\t*\t0\t0\t\t");
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_sam_format_errors)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+    seqan::HtsFileIn file(toCString(bamPath));
+
+    seqan::BamAlignmentRecord record;
+    record.qName = "r1";
+    seqan::CharString buffer;
+
+    bool thrown = false;
+    try
+    {
+        appendSamRecord(buffer, record, nullptr);
+    }
+    catch (seqan::IOError const &)
+    {
+        thrown = true;
+    }
+    SEQAN_ASSERT(thrown);
+
+    record.rID = 2;
+    thrown = false;
+    try
+    {
+        appendSamRecord(buffer, record, file.hdr);
+    }
+    catch (seqan::ParseError const &)
+    {
+        thrown = true;
+    }
+    SEQAN_ASSERT(thrown);
+}
+
+#endif  // TESTS_HTS_IO_TEST_HTS_SAM_FORMAT_H_
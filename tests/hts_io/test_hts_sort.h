@@ -0,0 +1,121 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for sorting HTS files.
+// ==========================================================================
+
+#ifndef TESTS_HTS_IO_TEST_HTS_SORT_H_
+#define TESTS_HTS_IO_TEST_HTS_SORT_H_
+
+#include <seqan/hts_io.h>
+
+SEQAN_DEFINE_TEST(test_hts_io_sort_tmp_file_error)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/small.bam");
+    seqan::CharString outPath = SEQAN_TEMP_FILENAME();
+    append(outPath, ".bam");
+    seqan::CharString tmpPrefix = SEQAN_TEMP_FILENAME();
+    append(tmpPrefix, "/no_such_directory/run");
+
+    // A memory limit of one byte spills every record into a temporary file, which cannot be created.
+    seqan::HtsFileIn file(toCString(bamPath));
+    bool thrown = false;
+    try
+    {
+        sortRecords(file, toCString(outPath), seqan::HTS_SORT_COORDINATE, 1u, 1, toCString(tmpPrefix));
+    }
+    catch (seqan::IOError const &)
+    {
+        thrown = true;
+    }
+    SEQAN_ASSERT(thrown);
+}
+
+SEQAN_DEFINE_TEST(test_hts_io_sort_queryname)
+{
+    seqan::CharString bamPath = SEQAN_PATH_TO_ROOT();
+    append(bamPath, "/tests/bam_io/ex1.bam");
+    seqan::CharString inPath = SEQAN_TEMP_FILENAME();
+    append(inPath, ".bam");
+
+    // Read names with numbers and reads with the same name and different flags, in unsorted order.
+    char const * names[] = { "p1", "a10", "p1", "A2", "p1", "a9", "a009", "p1", "a1b", "p01" };
+    unsigned const flags[] = { 0x81, 0, 0x841, 0, 0x141, 0, 0, 0x41, 0, 0 };
+    {
+        seqan::HtsFileIn in(toCString(bamPath));
+        seqan::HtsFileOut out(toCString(inPath), "wb");
+        copyHeader(out, in);
+        SEQAN_ASSERT(writeHeader(out));
+        seqan::BamAlignmentRecord record;
+        SEQAN_ASSERT(readRecord(record, in));
+        for (unsigned i = 0; i < 10; ++i)
+        {
+            record.qName = names[i];
+            record.flag = flags[i];
+            SEQAN_ASSERT(writeRecord(out, record));
+        }
+        SEQAN_ASSERT(close(out));
+    }
+
+    // Numbers in names are compared by value, equal names are ordered by mate, then primary before secondary
+    // before supplementary.  Equivalent records keep their input order.
+    char const * expectedNames[] = { "A2", "a1b", "a9", "a009", "a10", "p01", "p1", "p1", "p1", "p1" };
+    unsigned const expectedFlags[] = { 0, 0, 0, 0, 0, 0, 0x41, 0x141, 0x841, 0x81 };
+
+    // In memory and with one temporary file per record.
+    unsigned long long const memoryLimits[] = { 1ull << 20, 1 };
+    for (unsigned m = 0; m < 2; ++m)
+    {
+        for (unsigned numThreads = 1; numThreads <= 2; ++numThreads)
+        {
+            seqan::CharString outPath = SEQAN_TEMP_FILENAME();
+            append(outPath, ".bam");
+            {
+                seqan::HtsFileIn in(toCString(inPath));
+                SEQAN_ASSERT(sortRecords(in, toCString(outPath), seqan::HTS_SORT_QUERYNAME, memoryLimits[m],
+                                         numThreads));
+            }
+
+            seqan::HtsFileIn sorted(toCString(outPath));
+            seqan::BamAlignmentRecord record;
+            for (unsigned i = 0; i < 10; ++i)
+            {
+                SEQAN_ASSERT(readRecord(record, sorted));
+                SEQAN_ASSERT_EQ(record.qName, expectedNames[i]);
+                SEQAN_ASSERT_EQ(record.flag, expectedFlags[i]);
+            }
+            SEQAN_ASSERT_NOT(readRecord(record, sorted));
+        }
+    }
+}
+
+#endif  // TESTS_HTS_IO_TEST_HTS_SORT_H_
@@ -139,4 +139,167 @@ SEQAN_DEFINE_TEST(test_seq_io_genomic_fai_index_read_region)
     }
 }
 
+SEQAN_DEFINE_TEST(test_seq_io_genomic_fai_index_mmap)
+{
+    seqan::CharString filePath = SEQAN_PATH_TO_ROOT();
+    append(filePath, "/tests/seq_io/adeno_genome.fa");
+
+    seqan::FaiIndex faiIndex;
+    SEQAN_ASSERT_EQ(open(faiIndex, toCString(filePath)), true);
+    seqan::FaiIndex mappedIndex;
+    SEQAN_ASSERT_EQ(open(mappedIndex, toCString(filePath), seqan::OPEN_RDONLY | seqan::OPEN_MMAP), true);
+    SEQAN_ASSERT_NOT(empty(mappedIndex.mmapString));
+
+    // Copies from the mapped file.
+    seqan::Dna5String expected, str;
+    for (unsigned beginPos = 0; beginPos < 4730u; beginPos += 89)
+    {
+        for (unsigned len = 0; len < 300; len += 37)
+        {
+            readRegion(expected, faiIndex, 0, beginPos, beginPos + len);
+            readRegion(str, mappedIndex, 0, beginPos, beginPos + len);
+            SEQAN_ASSERT_EQ(str, expected);
+        }
+    }
+    readSequence(str, mappedIndex, 1);
+    SEQAN_ASSERT_EQ(str, "CGATCGAT");
+
+    // Infixes of single lines.
+    seqan::Infix<seqan::String<char, seqan::MMap<> > const>::Type infix;
+    SEQAN_ASSERT_EQ(readRegion(infix, mappedIndex, 0, 100, 110), true);
+    SEQAN_ASSERT_EQ(infix, "GAGCGCGCAG");
+    SEQAN_ASSERT_EQ(readRegion(infix, mappedIndex, 0, 4708, 10000), true);
+    SEQAN_ASSERT_EQ(infix, "GAGTGGGCAA");
+    SEQAN_ASSERT_EQ(readRegion(infix, mappedIndex, 0, 50, 80), false);
+    SEQAN_ASSERT_EQ(readRegion(infix, faiIndex, 0, 100, 110), false);
+}
+
+#if SEQAN_HAS_ZLIB
+SEQAN_DEFINE_TEST(test_seq_io_genomic_fai_index_bgzf)
+{
+    seqan::CharString filePath = SEQAN_PATH_TO_ROOT();
+    append(filePath, "/tests/seq_io/adeno_genome.fa");
+
+    // Compress the FASTA file with one BGZF block per line.
+    seqan::CharString bgzfPath = SEQAN_TEMP_FILENAME();
+    append(bgzfPath, ".fa.gz");
+    {
+        std::ifstream in(toCString(filePath));
+        std::ofstream out(toCString(bgzfPath), std::ios_base::out | std::ios_base::binary);
+        seqan::basic_bgzf_ostream<char> bgzfOut(out);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            bgzfOut << line << '\n';
+            bgzfOut.zflush();
+        }
+    }
+
+    seqan::FaiIndex faiIndex;
+    SEQAN_ASSERT_EQ(build(faiIndex, toCString(filePath)), true);
+    seqan::FaiIndex bgzfIndex;
+    SEQAN_ASSERT_EQ(build(bgzfIndex, toCString(bgzfPath)), true);
+    SEQAN_ASSERT(bgzfIndex.compressed);
+    SEQAN_ASSERT_GT(length(bgzfIndex.gziEntries), 50u);
+
+    // The FAI entries refer to the uncompressed file.
+    seqan::CharString faiPath = SEQAN_TEMP_FILENAME();
+    SEQAN_ASSERT_EQ(save(bgzfIndex, toCString(faiPath)), true);
+    seqan::CharString pathToExpected = SEQAN_PATH_TO_ROOT();
+    append(pathToExpected, "/tests/seq_io/adeno_genome.fa.fai");
+    SEQAN_ASSERT(seqan::_compareTextFiles(toCString(pathToExpected), toCString(faiPath)));
+
+    // Write the FAI and GZI files and read them back.
+    SEQAN_ASSERT_EQ(save(bgzfIndex), true);
+    seqan::FaiIndex openedIndex;
+    SEQAN_ASSERT_EQ(open(openedIndex, toCString(bgzfPath)), true);
+    SEQAN_ASSERT(openedIndex.compressed);
+    SEQAN_ASSERT(openedIndex.gziEntries == bgzfIndex.gziEntries);
+
+    seqan::Dna5String expected, str;
+    readRegion(str, openedIndex, 0, 0, 1);
+    char const * blockBuffer = begin(openedIndex.block, seqan::Standard());
+    for (unsigned beginPos = 0; beginPos < 4718u; beginPos += 97)
+    {
+        for (unsigned len = 1; len < 400; len += 57)
+        {
+            readRegion(expected, faiIndex, 0, beginPos, beginPos + len);
+            readRegion(str, openedIndex, 0, beginPos, beginPos + len);
+            SEQAN_ASSERT_EQ(str, expected);
+        }
+    }
+    readSequence(str, openedIndex, 1);
+    SEQAN_ASSERT_EQ(str, "CGATCGAT");
+
+    // The block buffers are reused between calls.
+    SEQAN_ASSERT(begin(openedIndex.block, seqan::Standard()) == blockBuffer);
+}
+
+SEQAN_DEFINE_TEST(test_seq_io_genomic_fai_index_gzi_offsets)
+{
+    // Blocks start at the compressed offsets 0, 100 and 250.
+    seqan::FaiIndex faiIndex;
+    appendValue(faiIndex.gziEntries, seqan::Pair<__uint64, __uint64>(100u, 65280u));
+    appendValue(faiIndex.gziEntries, seqan::Pair<__uint64, __uint64>(250u, 130560u));
+
+    __uint64 offset = 0;
+    SEQAN_ASSERT(seqan::_gziUncompressedOffset(offset, faiIndex, 7u));
+    SEQAN_ASSERT_EQ(offset, 7u);
+    SEQAN_ASSERT(seqan::_gziUncompressedOffset(offset, faiIndex, (100ull << 16) | 5u));
+    SEQAN_ASSERT_EQ(offset, 65285u);
+    SEQAN_ASSERT(seqan::_gziUncompressedOffset(offset, faiIndex, 250ull << 16));
+    SEQAN_ASSERT_EQ(offset, 130560u);
+
+    // Offsets of unknown blocks are rejected.
+    offset = 1;
+    SEQAN_ASSERT_NOT(seqan::_gziUncompressedOffset(offset, faiIndex, (150ull << 16) | 5u));
+    SEQAN_ASSERT_NOT(seqan::_gziUncompressedOffset(offset, faiIndex, 300ull << 16));
+    SEQAN_ASSERT_EQ(offset, 1u);
+}
+
+SEQAN_DEFINE_TEST(test_seq_io_genomic_fai_index_bgzf_empty_blocks)
+{
+    seqan::CharString filePath = SEQAN_PATH_TO_ROOT();
+    append(filePath, "/tests/seq_io/adeno_genome.fa");
+
+    // Concatenate two BGZF files, so that the EOF marker of the first one is an empty block within the sequence.
+    seqan::CharString bgzfPath = SEQAN_TEMP_FILENAME();
+    append(bgzfPath, ".fa.gz");
+    {
+        std::ifstream in(toCString(filePath));
+        std::ofstream out(toCString(bgzfPath), std::ios_base::out | std::ios_base::binary);
+        std::string line;
+        for (unsigned part = 0; part < 2; ++part)
+        {
+            seqan::basic_bgzf_ostream<char> bgzfOut(out);
+            for (unsigned i = 0; (part == 1 || i < 30) && std::getline(in, line); ++i)
+            {
+                bgzfOut << line << '\n';
+                bgzfOut.zflush();
+            }
+        }
+    }
+
+    seqan::FaiIndex faiIndex;
+    SEQAN_ASSERT_EQ(build(faiIndex, toCString(filePath)), true);
+    seqan::FaiIndex bgzfIndex;
+    SEQAN_ASSERT_EQ(build(bgzfIndex, toCString(bgzfPath)), true);
+    SEQAN_ASSERT(bgzfIndex.compressed);
+
+    // Regions before, across and after the empty block.
+    seqan::Dna5String expected, str;
+    for (unsigned beginPos = 0; beginPos < 4718u; beginPos += 131)
+    {
+        readRegion(expected, faiIndex, 0, beginPos, beginPos + 1000);
+        readRegion(str, bgzfIndex, 0, beginPos, beginPos + 1000);
+        SEQAN_ASSERT_EQ(str, expected);
+    }
+    readSequence(expected, faiIndex, 0);
+    readSequence(str, bgzfIndex, 0);
+    SEQAN_ASSERT_EQ(str, expected);
+    readSequence(str, bgzfIndex, 1);
+    SEQAN_ASSERT_EQ(str, "CGATCGAT");
+}
+#endif  // #if SEQAN_HAS_ZLIB
+
 #endif  // #ifndef TESTS_SEQ_IO_TEST_FAI_INDEX_H_
@@ -42,6 +42,7 @@
 
 #include "test_genomic_region.h"
 #include "test_fai_index.h"
+#include "test_two_bit.h"
 
 #include "test_sequence_file.h"
 #include "test_stream_read_embl.h"
@@ -60,6 +61,10 @@ SEQAN_BEGIN_TESTSUITE(test_seq_io)
     // Test reading with different interfaces.
     SEQAN_CALL_TEST(test_seq_io_sequence_file_read_record_text_fasta);
     SEQAN_CALL_TEST(test_seq_io_sequence_file_read_all_text_fasta);
+    SEQAN_CALL_TEST(test_seq_io_sequence_file_read_mmap);
+    SEQAN_CALL_TEST(test_seq_io_sequence_file_read_mmap_views);
+    SEQAN_CALL_TEST(test_seq_io_sequence_file_read_batches_text_fastq_concat);
+    SEQAN_CALL_TEST(test_seq_io_sequence_file_read_batches);
 
     // Test writing with different interfaces.
     SEQAN_CALL_TEST(test_seq_io_sequence_file_write_record_text_fasta);
@@ -85,6 +90,16 @@ SEQAN_BEGIN_TESTSUITE(test_seq_io)
     SEQAN_CALL_TEST(test_seq_io_genomic_fai_index_read);
     SEQAN_CALL_TEST(test_seq_io_genomic_fai_index_read_sequence);
     SEQAN_CALL_TEST(test_seq_io_genomic_fai_index_read_region);
+    SEQAN_CALL_TEST(test_seq_io_genomic_fai_index_mmap);
+#if SEQAN_HAS_ZLIB
+    SEQAN_CALL_TEST(test_seq_io_genomic_fai_index_bgzf);
+    SEQAN_CALL_TEST(test_seq_io_genomic_fai_index_bgzf_empty_blocks);
+    SEQAN_CALL_TEST(test_seq_io_genomic_fai_index_gzi_offsets);
+#endif
+
+    // Test 2bit files.
+    SEQAN_CALL_TEST(test_seq_io_two_bit_write_read);
+    SEQAN_CALL_TEST(test_seq_io_two_bit_index);
 
     // Tests for EMBL
     SEQAN_CALL_TEST(test_stream_read_embl_single_char_array_stream);
@@ -169,6 +169,184 @@ SEQAN_DEFINE_TEST(test_seq_io_sequence_file_read_all_text_fasta)
     SEQAN_ASSERT(atEnd(seqIO));
 }
 
+SEQAN_DEFINE_TEST(test_seq_io_sequence_file_read_mmap)
+{
+    char const * fileNames[] = { "adeno_genome.fa", "test_dna.fa", "test_dna.fq" };
+
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        seqan::CharString filePath = SEQAN_PATH_TO_ROOT();
+        append(filePath, "/tests/seq_io/");
+        append(filePath, fileNames[i]);
+
+        // Read all records through the regular file stream.
+        seqan::StringSet<seqan::CharString> ids, quals;
+        seqan::StringSet<seqan::Dna5String> seqs;
+        SeqFileIn seqIO(toCString(filePath));
+        readRecords(ids, seqs, quals, seqIO);
+        SEQAN_ASSERT(atEnd(seqIO));
+        SEQAN_ASSERT_NOT(seqIO.stream.mappedBuf.is_open());
+
+        // Read them again from the memory-mapped file.
+        seqan::StringSet<seqan::CharString> mmapIds, mmapQuals;
+        seqan::StringSet<seqan::Dna5String> mmapSeqs;
+        SeqFileIn mmapIO(toCString(filePath), seqan::OPEN_RDONLY | seqan::OPEN_MMAP);
+        SEQAN_ASSERT(mmapIO.stream.mappedBuf.is_open());
+        readRecords(mmapIds, mmapSeqs, mmapQuals, mmapIO);
+        SEQAN_ASSERT(atEnd(mmapIO));
+
+        SEQAN_ASSERT_GT(length(ids), 0u);
+        SEQAN_ASSERT(mmapIds == ids);
+        SEQAN_ASSERT(mmapSeqs == seqs);
+        SEQAN_ASSERT(mmapQuals == quals);
+    }
+}
+
+SEQAN_DEFINE_TEST(test_seq_io_sequence_file_read_mmap_views)
+{
+    typedef seqan::Range<char const *> TContent;
+    typedef seqan::Iterator<TContent const, seqan::Rooted>::Type TContentIter;
+    typedef seqan::Infix<TContent const>::Type TView;
+
+    char const * fileNames[] = { "adeno_genome.fa", "test_dna.fa" };
+
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        seqan::CharString filePath = SEQAN_PATH_TO_ROOT();
+        append(filePath, "/tests/seq_io/");
+        append(filePath, fileNames[i]);
+
+        seqan::StringSet<seqan::CharString> ids;
+        seqan::StringSet<seqan::Dna5String> seqs;
+        SeqFileIn seqIO(toCString(filePath));
+        readRecords(ids, seqs, seqIO);
+
+        // Parse the mapped file with a plain pointer iterator, ids are views into the mapping.
+        SeqFileIn mmapIO(toCString(filePath), seqan::OPEN_RDONLY | seqan::OPEN_MMAP);
+        TContent const & content = mappedContent(mmapIO);
+        SEQAN_ASSERT_NOT(empty(content));
+
+        TContentIter iter = begin(content, seqan::Rooted());
+        TView id;
+        seqan::Dna5String seq;
+        unsigned n = 0;
+        for (; !atEnd(iter); ++n)
+        {
+            readRecord(id, seq, iter, seqan::Fasta());
+            SEQAN_ASSERT_LT(n, length(ids));
+            SEQAN_ASSERT_EQ(id, ids[n]);
+            SEQAN_ASSERT_EQ(seq, seqs[n]);
+            SEQAN_ASSERT(begin(id, seqan::Standard()) > content.begin);
+            SEQAN_ASSERT(end(id, seqan::Standard()) < content.end);
+        }
+        SEQAN_ASSERT_EQ(n, length(ids));
+    }
+
+    // Files that are not mapped have no content.
+    seqan::CharString filePath = SEQAN_PATH_TO_ROOT();
+    append(filePath, "/tests/seq_io/test_dna.fa");
+    SeqFileIn seqIO(toCString(filePath));
+    SEQAN_ASSERT(empty(mappedContent(seqIO)));
+}
+
+SEQAN_DEFINE_TEST(test_seq_io_sequence_file_read_batches_text_fastq_concat)
+{
+    typedef seqan::StringSet<seqan::CharString, seqan::Owner<seqan::ConcatDirect<> > > TCharStringSet;
+    typedef seqan::StringSet<seqan::Dna5String, seqan::Owner<seqan::ConcatDirect<> > > TDnaStringSet;
+
+    // Build path to file.
+    seqan::CharString filePath = SEQAN_PATH_TO_ROOT();
+    append(filePath, "/tests/seq_io/test_dna.fq");
+
+    SeqFileIn seqIO(toCString(filePath));
+
+    TCharStringSet ids;
+    TDnaStringSet seqs;
+    TCharStringSet quals;
+
+    readRecords(ids, seqs, quals, seqIO, 2);
+    SEQAN_ASSERT_EQ(length(seqs), 2u);
+    SEQAN_ASSERT_EQ(ids[0], "seq1");
+    SEQAN_ASSERT_EQ(seqs[0], "CGATCGATAAT");
+    SEQAN_ASSERT_EQ(quals[0], "IIIIIIIIIII");
+    SEQAN_ASSERT_EQ(ids[1], "seq2");
+    SEQAN_ASSERT_EQ(seqs[1], "CCTCTCTCTCCCT");
+    SEQAN_ASSERT_EQ(quals[1], "IIIIIIIIIIIII");
+
+    // The next batch reuses the memory of the cleared sets.
+    char * idsBegin = begin(ids.concat, seqan::Standard());
+    seqan::Dna5 * seqsBegin = begin(seqs.concat, seqan::Standard());
+    char * qualsBegin = begin(quals.concat, seqan::Standard());
+    clear(ids);
+    clear(seqs);
+    clear(quals);
+
+    readRecords(ids, seqs, quals, seqIO, 2);
+    SEQAN_ASSERT_EQ(length(seqs), 1u);
+    SEQAN_ASSERT_EQ(ids[0], "seq3");
+    SEQAN_ASSERT_EQ(seqs[0], "CCCCCCCC");
+    SEQAN_ASSERT_EQ(quals[0], "IIIIIIII");
+    SEQAN_ASSERT(begin(ids.concat, seqan::Standard()) == idsBegin);
+    SEQAN_ASSERT(begin(seqs.concat, seqan::Standard()) == seqsBegin);
+    SEQAN_ASSERT(begin(quals.concat, seqan::Standard()) == qualsBegin);
+
+    SEQAN_ASSERT(atEnd(seqIO));
+}
+
+// ---------------------------------------------------------------------------
+// Test reading batches in parallel.
+// ---------------------------------------------------------------------------
+
+template <typename TSeqAlphabet>
+void testSeqIOSequenceFileReadBatches(char const * fileName, size_t numThreads, size_t chunkSize)
+{
+    typedef seqan::SeqBatchReader<TSeqAlphabet>    TReader;
+
+    // Build path to file.
+    seqan::CharString filePath = SEQAN_PATH_TO_ROOT();
+    append(filePath, fileName);
+
+    // Read all records sequentially.
+    seqan::StringSet<seqan::CharString> expectedIds;
+    seqan::StringSet<seqan::String<TSeqAlphabet> > expectedSeqs;
+    seqan::StringSet<seqan::CharString> expectedQuals;
+    {
+        SeqFileIn seqIO(toCString(filePath));
+        readRecords(expectedIds, expectedSeqs, expectedQuals, seqIO);
+    }
+
+    // Read all records in batches and compare.
+    SeqFileIn seqIO(toCString(filePath));
+    TReader reader(seqIO, numThreads, chunkSize);
+
+    typename TReader::TIdSet ids;
+    typename TReader::TSeqSet seqs;
+    typename TReader::TQualSet quals;
+    size_t numRecords = 0;
+
+    while (readBatch(ids, seqs, quals, reader))
+    {
+        for (size_t i = 0; i < length(ids); ++i, ++numRecords)
+        {
+            SEQAN_ASSERT_LT(numRecords, length(expectedIds));
+            SEQAN_ASSERT_EQ(ids[i], expectedIds[numRecords]);
+            SEQAN_ASSERT_EQ(seqs[i], expectedSeqs[numRecords]);
+            SEQAN_ASSERT_EQ(quals[i], expectedQuals[numRecords]);
+        }
+    }
+    SEQAN_ASSERT_EQ(numRecords, length(expectedIds));
+}
+
+SEQAN_DEFINE_TEST(test_seq_io_sequence_file_read_batches)
+{
+    // small chunks contain no complete record and have to be extended
+    testSeqIOSequenceFileReadBatches<seqan::Dna5>("/tests/seq_io/test_dna.fq", 2, 7);
+    testSeqIOSequenceFileReadBatches<seqan::Dna5>("/tests/seq_io/test_dna.fq", 1, 1024);
+    testSeqIOSequenceFileReadBatches<seqan::Dna5Q>("/tests/seq_io/test_dna.fq", 3, 30);
+    testSeqIOSequenceFileReadBatches<seqan::Dna5>("/tests/seq_io/test_dna.fa", 2, 10);
+    testSeqIOSequenceFileReadBatches<seqan::Dna5>("/tests/seq_io/test_dna.fq.gz", 4, 1000);
+}
+
 // ---------------------------------------------------------------------------
 // Test writing with different interfaces.
 // ---------------------------------------------------------------------------
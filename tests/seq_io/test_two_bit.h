@@ -0,0 +1,213 @@
+// ==========================================================================
+//                 SeqAn - The Library for Sequence Analysis
+// ==========================================================================
+// Copyright (c) 2006-2015, Knut Reinert, FU Berlin
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of Knut Reinert or the FU Berlin nor the names of
+//       its contributors may be used to endorse or promote products derived
+//       from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL KNUT REINERT OR THE FU BERLIN BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+// OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH
+// DAMAGE.
+//
+// ==========================================================================
+// Tests for reading and writing 2bit files.
+// ==========================================================================
+
+#ifndef TESTS_SEQ_IO_TEST_TWO_BIT_H_
+#define TESTS_SEQ_IO_TEST_TWO_BIT_H_
+
+#include <seqan/seq_io.h>
+
+SEQAN_DEFINE_TEST(test_seq_io_two_bit_write_read)
+{
+    seqan::CharString filePath = SEQAN_TEMP_FILENAME();
+    append(filePath, ".2bit");
+
+    seqan::StringSet<seqan::CharString> ids;
+    appendValue(ids, "seq1");
+    appendValue(ids, "seq2");
+    appendValue(ids, "seq3");
+    seqan::StringSet<seqan::CharString> seqs;
+    appendValue(seqs, "CGATCGATAAT");
+    appendValue(seqs, "NNCCTCTcTCtcccTNNNAGNn");
+    appendValue(seqs, "");
+
+    {
+        seqan::SeqFileOut seqOut(toCString(filePath));
+        SEQAN_ASSERT(isEqual(format(seqOut), seqan::TwoBit()));
+        writeRecords(seqOut, ids, seqs);
+    }
+
+    // Read sequentially, with and without soft-masking.
+    seqan::SeqFileIn seqIn(toCString(filePath));
+    SEQAN_ASSERT(isEqual(format(seqIn), seqan::TwoBit()));
+    seqan::StringSet<seqan::CharString> readIds, readSeqs;
+    readRecords(readIds, readSeqs, seqIn);
+    SEQAN_ASSERT(atEnd(seqIn));
+    SEQAN_ASSERT(readIds == ids);
+    SEQAN_ASSERT(readSeqs == seqs);
+
+    close(seqIn);
+    SEQAN_ASSERT(open(seqIn, toCString(filePath)));
+    seqan::CharString id;
+    seqan::Dna5String seq;
+    readRecord(id, seq, seqIn);
+    SEQAN_ASSERT_EQ(id, "seq1");
+    SEQAN_ASSERT_EQ(seq, "CGATCGATAAT");
+    readRecord(id, seq, seqIn);
+    SEQAN_ASSERT_EQ(id, "seq2");
+    SEQAN_ASSERT_EQ(seq, "NNCCTCTCTCTCCCTNNNAGNN");
+    close(seqIn);
+
+    // A truncated header is a parse error, the header of 3 records with 4 character names has 16 + 3 * 9 bytes.
+    seqan::CharString file;
+    {
+        std::ifstream in(toCString(filePath), std::ios_base::in | std::ios_base::binary);
+        std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        file = content;
+    }
+    for (unsigned headerLength = 0; headerLength <= 43u; ++headerLength)
+    {
+        seqan::CharString header = prefix(file, headerLength);
+        seqan::DirectionIterator<seqan::CharString, seqan::Input>::Type iter = directionIterator(header, seqan::Input());
+        seqan::TwoBitContext_<seqan::Input> context;
+        bool parseError = false;
+        try
+        {
+            _readTwoBitHeader(context, iter);
+        }
+        catch (seqan::ParseError const &)
+        {
+            parseError = true;
+        }
+        SEQAN_ASSERT_EQ(parseError, headerLength < 43u);
+    }
+
+    // So is a truncated record.
+    seqan::CharString truncatedPath = SEQAN_TEMP_FILENAME();
+    append(truncatedPath, ".2bit");
+    {
+        std::ofstream out(toCString(truncatedPath), std::ios_base::out | std::ios_base::binary);
+        out.write(toCString(file), length(file) - 20);
+    }
+    SEQAN_ASSERT(open(seqIn, toCString(truncatedPath)));
+    readRecord(id, seq, seqIn);
+    SEQAN_ASSERT_EQ(id, "seq1");
+    bool parseError = false;
+    try
+    {
+        readRecord(id, seq, seqIn);
+    }
+    catch (seqan::ParseError const &)
+    {
+        parseError = true;
+    }
+    SEQAN_ASSERT(parseError);
+}
+
+SEQAN_DEFINE_TEST(test_seq_io_two_bit_index)
+{
+    seqan::CharString filePath = SEQAN_PATH_TO_ROOT();
+    append(filePath, "/tests/seq_io/adeno_genome.fa");
+
+    seqan::FaiIndex faiIndex;
+    SEQAN_ASSERT_EQ(open(faiIndex, toCString(filePath)), true);
+
+    // Convert the FASTA file into a 2bit file with N and mask blocks.
+    seqan::CharString twoBitPath = SEQAN_TEMP_FILENAME();
+    append(twoBitPath, ".2bit");
+    seqan::String<seqan::CharString> seqs;
+    resize(seqs, numSeqs(faiIndex));
+    {
+        seqan::SeqFileOut seqOut(toCString(twoBitPath));
+        for (unsigned rID = 0; rID < numSeqs(faiIndex); ++rID)
+        {
+            readSequence(seqs[rID], faiIndex, rID);
+            for (unsigned pos = 0; pos < length(seqs[rID]); ++pos)
+                if (pos % 1000 < 10)
+                    seqs[rID][pos] = 'N';
+                else if (pos % 700 < 100)
+                    seqs[rID][pos] = tolower(seqs[rID][pos]);
+            writeRecord(seqOut, sequenceName(faiIndex, rID), seqs[rID]);
+        }
+    }
+
+    seqan::TwoBitIndex twoBitIndex;
+    SEQAN_ASSERT_EQ(open(twoBitIndex, toCString(twoBitPath)), true);
+    SEQAN_ASSERT_EQ(numSeqs(twoBitIndex), numSeqs(faiIndex));
+
+    unsigned rID = 0;
+    SEQAN_ASSERT(getIdByName(rID, twoBitIndex, sequenceName(faiIndex, 1)));
+    SEQAN_ASSERT_EQ(rID, 1u);
+    SEQAN_ASSERT_EQ(sequenceLength(twoBitIndex, 0), sequenceLength(faiIndex, 0));
+
+    // Unpacked regions.
+    seqan::CharString str;
+    seqan::Dna5String dna;
+    for (unsigned beginPos = 0; beginPos < 4730u; beginPos += 89)
+    {
+        for (unsigned len = 0; len < 300; len += 37)
+        {
+            readRegion(str, twoBitIndex, 0, beginPos, beginPos + len);
+            SEQAN_ASSERT_EQ(str, infix(seqs[0], std::min(beginPos, (unsigned)length(seqs[0])),
+                                       std::min(beginPos + len, (unsigned)length(seqs[0]))));
+            readRegion(dna, twoBitIndex, 0, beginPos, beginPos + len);
+            SEQAN_ASSERT_EQ(dna, seqan::Dna5String(str));
+        }
+    }
+    readSequence(str, twoBitIndex, 1);
+    SEQAN_ASSERT_EQ(str, "NNNNNNNN");
+
+    // Regions by name and id, unknown sequences are rejected.
+    seqan::GenomicRegion region;
+    region.seqName = sequenceName(faiIndex, 1);
+    SEQAN_ASSERT(readRegion(str, twoBitIndex, region));
+    SEQAN_ASSERT_EQ(str, "NNNNNNNN");
+    region.seqName = "unknown";
+    SEQAN_ASSERT_NOT(readRegion(str, twoBitIndex, region));
+    region.rID = 1;
+    region.beginPos = 2;
+    region.endPos = 5;
+    SEQAN_ASSERT(readRegion(str, twoBitIndex, region));
+    SEQAN_ASSERT_EQ(str, "NNN");
+    region.rID = numSeqs(twoBitIndex);
+    SEQAN_ASSERT_NOT(readRegion(str, twoBitIndex, region));
+    region.rID = -2;
+    SEQAN_ASSERT_NOT(readRegion(str, twoBitIndex, region));
+
+    // The view of the mapped sequence.
+    seqan::TwoBitSequence const & view = sequenceView(twoBitIndex, 0);
+    seqan::Dna5String expected = seqs[0];
+    SEQAN_ASSERT_EQ(length(view), length(expected));
+    for (unsigned pos = 0; pos < length(view); ++pos)
+        SEQAN_ASSERT_EQ(view[pos], expected[pos]);
+    dna = view;
+    SEQAN_ASSERT_EQ(dna, expected);
+
+    SEQAN_ASSERT_EQ(numNBlocks(view), 5u);
+    SEQAN_ASSERT_EQ(getNBlock(view, 1), (seqan::Pair<__uint32, __uint32>(1000, 1010)));
+    SEQAN_ASSERT_EQ(numMaskBlocks(view), 7u);
+    SEQAN_ASSERT_EQ(getMaskBlock(view, 0), (seqan::Pair<__uint32, __uint32>(10, 100)));
+    SEQAN_ASSERT_EQ(getMaskBlock(view, 1), (seqan::Pair<__uint32, __uint32>(700, 800)));
+}
+
+#endif  // TESTS_SEQ_IO_TEST_TWO_BIT_H_
@@ -134,6 +134,68 @@ SEQAN_TYPED_TEST(VStreamTest, Decompression)
     close(vstream);
 }
 
+SEQAN_TYPED_TEST(VStreamTest, MemoryMapped)
+{
+    typedef typename TestFixture::Type TCompressionTag;
+    CharString fileName = SEQAN_PATH_TO_ROOT();
+    append(fileName, "/tests/seq_io/test_dna.fq");
+    append(fileName, FileExtensions<TCompressionTag>::VALUE[0]);
+
+    // compressed files fall back to the regular file stream
+    VirtualStream<char, Input> vstream(toCString(fileName), OPEN_RDONLY | OPEN_MMAP);
+    SEQAN_ASSERT((bool)vstream);
+    SEQAN_ASSERT_EQ(vstream.mappedBuf.is_open(), (bool)(IsSameType<TCompressionTag, Nothing>::VALUE));
+
+    std::stringstream sstr;
+    sstr << vstream.streamBuf;
+    SEQAN_ASSERT_EQ(CharString(sstr.str()), CharString(FASTQ_EXAMPLE));
+
+    if (vstream.mappedBuf.is_open())
+    {
+        // seek back into the mapped file and read again
+        vstream.clear();
+        vstream.seekg(6);
+        std::string line;
+        std::getline(vstream, line);
+        SEQAN_ASSERT_EQ(line, std::string("CGATCGATAAT"));
+
+        // read lines as views into the mapping
+        typedef Range<char const *> TContent;
+        TContent const & content = mappedContent(vstream);
+        SEQAN_ASSERT_EQ(length(content), length(FASTQ_EXAMPLE));
+
+        typename Iterator<TContent const, Rooted>::Type iter = begin(content, Rooted());
+        typename Infix<TContent const>::Type id, seq;
+        readLine(id, iter);
+        readUntil(seq, iter, EqualsChar<'T'>());
+        SEQAN_ASSERT_EQ(id, "@seq1");
+        SEQAN_ASSERT_EQ(seq, "CGA");
+        SEQAN_ASSERT(begin(id, Standard()) == content.begin);
+        SEQAN_ASSERT(begin(seq, Standard()) == content.begin + 6);
+
+        // adjacent input extends a view
+        readUntil(seq, iter, IsNewline());
+        SEQAN_ASSERT_EQ(seq, "CGATCGATAAT");
+        skipLine(iter);
+
+        // other input cannot be appended to a view
+        try
+        {
+            readLine(id, iter);
+            SEQAN_FAIL("The expected exception was not caught.");
+        }
+        catch (ParseError const &)
+        {}
+
+        clear(id);
+        readLine(id, iter);
+        SEQAN_ASSERT_EQ(id, "+");
+        SEQAN_ASSERT(begin(id, Standard()) == content.begin + 18);
+    }
+    close(vstream);
+    SEQAN_ASSERT_NOT((bool)vstream);
+}
+
 SEQAN_TYPED_TEST(VStreamTest, Compression)
 {
     CharString buffer;
@@ -179,4 +241,126 @@ SEQAN_TYPED_TEST(VStreamTest, AutoDetection)
     SEQAN_ASSERT_NOT((bool)vstream);
 }
 
+#if SEQAN_HAS_ZLIB
+SEQAN_TEST(BgzfStreamTest, Flush)
+{
+    std::stringstream compressed;
+    {
+        bgzf_ostream zout(compressed);
+
+        // flushing a buffer that is not full calls overflow(EOF), which must not report an error
+        zout << "@seq1\nCGATCGATAAT\n" << std::flush;
+        SEQAN_ASSERT(zout.good());
+        SEQAN_ASSERT_EQ(zout.rdbuf()->pubsync(), 0);
+
+        zout << "+\nIIIIIIIIIII\n" << std::flush;
+        SEQAN_ASSERT(zout.good());
+    }
+
+    VirtualStream<char, Input> vstream(compressed);
+    std::stringstream sstr;
+    sstr << vstream.streamBuf;
+    SEQAN_ASSERT_EQ(sstr.str(), std::string("@seq1\nCGATCGATAAT\n+\nIIIIIIIIIII\n"));
+}
+
+// Inflates a complete gzip member, zlib checks its CRC and size.
+inline bool
+_gunzip(std::string & output, std::string const & input)
+{
+    z_stream strm;
+    std::memset(&strm, 0, sizeof(strm));
+    if (inflateInit2(&strm, 16 + MAX_WBITS) != Z_OK)
+        return false;
+
+    strm.next_in = (Bytef *)input.data();
+    strm.avail_in = input.size();
+    char buffer[4096];
+    int status;
+    do
+    {
+        strm.next_out = (Bytef *)buffer;
+        strm.avail_out = sizeof(buffer);
+        status = inflate(&strm, Z_NO_FLUSH);
+        output.append(buffer, sizeof(buffer) - strm.avail_out);
+    }
+    while (status == Z_OK);
+    inflateEnd(&strm);
+    return status == Z_STREAM_END && strm.avail_in == 0;
+}
+
+SEQAN_TEST(PZipStreamTest, RoundTrip)
+{
+    // The empty stream, a stream that ends exactly on a block boundary and streams with a partial last block.
+    unsigned const sizes[] = { 0, 1, PZIP_BLOCK_SIZE, 2 * PZIP_BLOCK_SIZE, 3 * PZIP_BLOCK_SIZE + 17 };
+    int const levels[] = { Z_DEFAULT_COMPRESSION, Z_NO_COMPRESSION, Z_BEST_COMPRESSION };
+
+    for (unsigned i = 0; i != sizeof(sizes) / sizeof(sizes[0]); ++i)
+    {
+        std::string input;
+        for (unsigned j = 0; j != sizes[i]; ++j)
+            input.push_back("ACGTN\n"[(j * 7 + j / 13) % 6]);
+
+        for (unsigned l = 0; l != sizeof(levels) / sizeof(levels[0]); ++l)
+        {
+            std::stringstream compressed;
+            {
+                basic_pzip_ostream<char> zout(compressed, levels[l]);
+                zout.write(input.data(), input.size());
+            }
+
+            std::string output;
+            SEQAN_ASSERT(_gunzip(output, compressed.str()));
+            SEQAN_ASSERT(output == input);
+        }
+    }
+}
+SEQAN_TEST(PZipStreamTest, JobError)
+{
+    std::string input(PZIP_BLOCK_SIZE + 17, 'A');
+
+    // sync() rethrows the error of a block compressed on the pool
+    std::stringstream compressed;
+    basic_pzip_ostream<char> zout(compressed, -5);      // an invalid level fails in deflateInit2()
+    zout.write(input.data(), input.size());
+    try
+    {
+        zout.rdbuf()->sync();
+        SEQAN_FAIL("The expected exception was not caught.");
+    }
+    catch (IOError const &)
+    {}
+
+    // finish() rethrows it without writing the footer
+    try
+    {
+        zout.rdbuf()->finish();
+        SEQAN_FAIL("The expected exception was not caught.");
+    }
+    catch (IOError const &)
+    {}
+    SEQAN_ASSERT_EQ(compressed.str().size(), PZIP_HEADER_LENGTH);
+}
+
+SEQAN_TEST(PZipStreamTest, SyncAndFinish)
+{
+    std::string input(PZIP_BLOCK_SIZE + 17, 'A');
+
+    std::stringstream compressed;
+    basic_pzip_ostream<char> zout(compressed);
+    zout.write(input.data(), input.size());
+
+    // sync() writes all blocks but the last one stays open
+    SEQAN_ASSERT_EQ(zout.rdbuf()->sync(), 0);
+    std::string output;
+    SEQAN_ASSERT_NOT(_gunzip(output, compressed.str()));
+    SEQAN_ASSERT(output == input);
+
+    // finish() writes the last block before the footer
+    zout.rdbuf()->finish();
+    output.clear();
+    SEQAN_ASSERT(_gunzip(output, compressed.str()));
+    SEQAN_ASSERT(output == input);
+}
+#endif
+
 #endif // ndef TEST_STREAM_TEST_VIRTUAL_STREAM_H_
@@ -117,4 +117,80 @@ SEQAN_DEFINE_TEST(test_tabix_io_read_indexed_vcf)
 }
 
 
+void testTabixIoBuiltIndex(__int32 minShift, __int32 depth, bool csi)
+{
+    seqan::CharString vcfPath = SEQAN_PATH_TO_ROOT();
+    append(vcfPath, "/tests/tabix_io/test.vcf.gz");
+    seqan::VcfFileIn vcfFile(toCString(vcfPath));
+
+    seqan::VcfHeader header;
+    readHeader(header, vcfFile);
+
+    // Build the index with the VCF column layout.
+    seqan::TabixIndex builtIndex;
+    builtIndex.format = 2;
+    builtIndex.colSeq = 1;
+    builtIndex.colBeg = 2;
+    builtIndex.colEnd = 0;
+    SEQAN_ASSERT(build(builtIndex, vcfFile, minShift, depth));
+    SEQAN_ASSERT_EQ(builtIndex.csi, csi);
+
+    // Save and load it again.
+    seqan::CharString indexPath = SEQAN_TEMP_FILENAME();
+    append(indexPath, csi ? ".csi" : ".tbi");
+    SEQAN_ASSERT(save(builtIndex, toCString(indexPath)));
+    seqan::TabixIndex tabixIndex(toCString(indexPath));
+    SEQAN_ASSERT_EQ(tabixIndex.csi, csi);
+    SEQAN_ASSERT_EQ(tabixIndex.minShift, minShift);
+    SEQAN_ASSERT_EQ(tabixIndex.depth, depth);
+    SEQAN_ASSERT_EQ(tabixIndex.colEnd, 0);
+    SEQAN_ASSERT_EQ(length(tabixIndex._nameStore), length(builtIndex._nameStore));
+
+    bool hasEntries = false;
+    seqan::VcfRecord record;
+    SEQAN_ASSERT(jumpToRegion(vcfFile, hasEntries, "chr1", 66441, 66442, tabixIndex));
+    SEQAN_ASSERT(hasEntries);
+    readRecord(record, vcfFile);
+    SEQAN_ASSERT_EQ(record.beginPos, 66441);
+    readRecord(record, vcfFile);
+    SEQAN_ASSERT_EQ(record.beginPos, 66441);
+    readRecord(record, vcfFile);
+    SEQAN_ASSERT_EQ(record.beginPos, 66479);
+
+    SEQAN_ASSERT(jumpToRegion(vcfFile, hasEntries, "chr7", 62368, 62370, tabixIndex));
+    SEQAN_ASSERT(hasEntries);
+    readRecord(record, vcfFile);
+    SEQAN_ASSERT_EQ(record.beginPos, 62369);
+
+    SEQAN_ASSERT(jumpToRegion(vcfFile, hasEntries, "chr7", 62368, 62369, tabixIndex));
+    SEQAN_ASSERT_NOT(hasEntries);
+
+    SEQAN_ASSERT_NOT(jumpToRegion(vcfFile, hasEntries, "chr8", 62368, 62370, tabixIndex));
+    SEQAN_ASSERT_NOT(hasEntries);
+}
+
+SEQAN_DEFINE_TEST(test_tabix_io_build_tbi)
+{
+    testTabixIoBuiltIndex(14, 5, false);
+}
+
+SEQAN_DEFINE_TEST(test_tabix_io_build_csi)
+{
+    testTabixIoBuiltIndex(10, 7, true);
+}
+
+SEQAN_DEFINE_TEST(test_tabix_io_build_csi_deep)
+{
+    testTabixIoBuiltIndex(4, 10, true);
+
+    // Bin numbers of 11 levels do not fit into 32 bits.
+    seqan::CharString vcfPath = SEQAN_PATH_TO_ROOT();
+    append(vcfPath, "/tests/tabix_io/test.vcf.gz");
+    seqan::VcfFileIn vcfFile(toCString(vcfPath));
+    seqan::VcfHeader header;
+    readHeader(header, vcfFile);
+    seqan::TabixIndex builtIndex;
+    SEQAN_ASSERT_NOT(build(builtIndex, vcfFile, 4, 11));
+}
+
 #endif  // SEQAN_TESTS_TABIX_TEST_TABIX_IO_H_